@@ -0,0 +1,26 @@
+if(NOT BUILD_CLIENT_SWARM)
+    return()
+endif()
+
+if(WIN32)
+    message(FATAL_ERROR "The client swarm tool uses POSIX sockets and is not supported on Windows")
+endif()
+
+include(utils/set_output_dirs)
+
+set(CLIENT_SWARM_BINARY client_swarm)
+
+set(CLIENT_SWARM_SOURCES
+    ${SOURCE_DIR}/tools/clientswarm/client_swarm.c
+    ${SOURCE_DIR}/qcommon/net_chan.c
+    ${SOURCE_DIR}/qcommon/msg.c
+    ${SOURCE_DIR}/qcommon/huffman.c
+    ${SOURCE_DIR}/qcommon/q_math.c
+    ${SOURCE_DIR}/qcommon/q_shared.c
+)
+
+add_executable(${CLIENT_SWARM_BINARY} ${CLIENT_SWARM_SOURCES})
+
+target_link_libraries(${CLIENT_SWARM_BINARY} PRIVATE ${COMMON_LIBRARIES})
+
+set_output_dirs(${CLIENT_SWARM_BINARY})
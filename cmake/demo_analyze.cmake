@@ -0,0 +1,28 @@
+if(NOT BUILD_DEMO_ANALYZE)
+    return()
+endif()
+
+include(utils/set_output_dirs)
+
+set(DEMO_ANALYZE_BINARY demo_analyze)
+
+set(DEMO_ANALYZE_SOURCES
+    ${SOURCE_DIR}/tools/demoanalyze/demo_analyze.c
+    ${SOURCE_DIR}/qcommon/msg.c
+    ${SOURCE_DIR}/qcommon/huffman.c
+    ${SOURCE_DIR}/qcommon/q_math.c
+    ${SOURCE_DIR}/qcommon/q_shared.c
+)
+
+if(BUILD_ELITEFORCE)
+    list(APPEND DEMO_ANALYZE_SOURCES ${SOURCE_DIR}/cmod/cmod_threads.c)
+endif()
+
+add_executable(${DEMO_ANALYZE_BINARY} ${DEMO_ANALYZE_SOURCES})
+
+target_link_libraries(${DEMO_ANALYZE_BINARY} PRIVATE ${COMMON_LIBRARIES})
+if(BUILD_ELITEFORCE)
+    target_link_libraries(${DEMO_ANALYZE_BINARY} PRIVATE Threads::Threads)
+endif()
+
+set_output_dirs(${DEMO_ANALYZE_BINARY})
@@ -26,19 +26,33 @@ add_compile_definitions(RENDERER_PREFIX="${ELITEFORCE_RENDERER_PREFIX}")
 
 find_package(Threads REQUIRED)
 list(APPEND CLIENT_LIBRARIES Threads::Threads)
+list(APPEND SERVER_LIBRARIES Threads::Threads)
 
 set(ELITEFORCE_COMMON_SOURCES
     ${SOURCE_DIR}/cmod/cmod_cmd.c
     ${SOURCE_DIR}/cmod/cmod_cvar.c
     ${SOURCE_DIR}/cmod/cmod_logging.c
     ${SOURCE_DIR}/cmod/cmod_misc.c
+    ${SOURCE_DIR}/cmod/cmod_patch_cache.c
+    ${SOURCE_DIR}/cmod/cmod_threads.c
+    ${SOURCE_DIR}/cmod/cmod_trace_cache.c
+    ${SOURCE_DIR}/cmod/cmod_frame_trace.c
     ${SOURCE_DIR}/cmod/vm_extensions.c
+    ${SOURCE_DIR}/cmod/server/sv_bandwidth_profile.c
+    ${SOURCE_DIR}/cmod/server/sv_benchmark.c
+    ${SOURCE_DIR}/cmod/server/sv_bot_stats.c
     ${SOURCE_DIR}/cmod/server/sv_cmd_tools.c
+    ${SOURCE_DIR}/cmod/server/sv_entity_priority.c
+    ${SOURCE_DIR}/cmod/server/sv_frame_scheduler.c
+    ${SOURCE_DIR}/cmod/server/sv_gamestate_cache.c
+    ${SOURCE_DIR}/cmod/server/sv_hitch_log.c
     ${SOURCE_DIR}/cmod/server/sv_maptable.c
+    ${SOURCE_DIR}/cmod/server/sv_metrics.c
     ${SOURCE_DIR}/cmod/server/sv_misc.c
     ${SOURCE_DIR}/cmod/server/sv_record_common.c
     ${SOURCE_DIR}/cmod/server/sv_record_convert.c
     ${SOURCE_DIR}/cmod/server/sv_record_main.c
+    ${SOURCE_DIR}/cmod/server/sv_record_replay.c
     ${SOURCE_DIR}/cmod/server/sv_record_spectator.c
     ${SOURCE_DIR}/cmod/server/sv_record_writer.c
 )
@@ -64,14 +78,27 @@ set(ELITEFORCE_CLIENT_SOURCES
     ${SOURCE_DIR}/cmod/aspect_correct.c
     ${SOURCE_DIR}/cmod/cmod_crosshair.c
     ${SOURCE_DIR}/cmod/cmod_crosshair_builtins.c
+    ${SOURCE_DIR}/cmod/cmod_demo_render.c
+    ${SOURCE_DIR}/cmod/cmod_demo_seek.c
     ${SOURCE_DIR}/cmod/cmod_map_adjust.c
     ${SOURCE_DIR}/cmod/snd_codec_mp3.c
+    ${SOURCE_DIR}/cmod/snd_mix_simd.c
+    ${SOURCE_DIR}/cmod/snd_mix_thread.c
+    ${SOURCE_DIR}/cmod/snd_async.c
+    ${SOURCE_DIR}/cmod/snd_cache.c
     ${ELITEFORCE_MAD_SOURCES}
 )
 
 list(APPEND CLIENT_BINARY_SOURCES ${ELITEFORCE_COMMON_SOURCES} ${ELITEFORCE_CLIENT_SOURCES})
 list(APPEND SERVER_BINARY_SOURCES ${ELITEFORCE_COMMON_SOURCES})
 list(APPEND RENDERER_GL1_BINARY_SOURCES "${SOURCE_DIR}/cmod/cmod_fbo.c")
+list(APPEND RENDERER_GL1_BINARY_SOURCES "${SOURCE_DIR}/cmod/cmod_video_capture.c")
+list(APPEND RENDERER_GL1_BINARY_SOURCES "${SOURCE_DIR}/cmod/cmod_image_loader.c")
+list(APPEND RENDERER_GL2_BINARY_SOURCES "${SOURCE_DIR}/cmod/cmod_image_loader.c")
+list(APPEND RENDERER_GL1_BINARY_SOURCES "${SOURCE_DIR}/cmod/cmod_image_simd.c")
+list(APPEND RENDERER_GL1_BINARY_SOURCES "${SOURCE_DIR}/cmod/cmod_image_simd_kernels.c")
+list(APPEND RENDERER_GL2_BINARY_SOURCES "${SOURCE_DIR}/cmod/cmod_image_simd.c")
+list(APPEND RENDERER_GL2_BINARY_SOURCES "${SOURCE_DIR}/cmod/cmod_image_simd_kernels.c")
 
 function(set_forced_include_global HEADER_PATH)
     # Convert relative path to absolute path if needed
@@ -0,0 +1,24 @@
+if(NOT BUILD_IMAGE_SIMD_BENCH)
+    return()
+endif()
+
+if(NOT BUILD_ELITEFORCE)
+    message(FATAL_ERROR "The image SIMD benchmark requires BUILD_ELITEFORCE")
+endif()
+
+include(utils/set_output_dirs)
+
+set(IMAGE_SIMD_BENCH_BINARY image_simd_bench)
+
+set(IMAGE_SIMD_BENCH_SOURCES
+    ${SOURCE_DIR}/tools/imagesimdbench/image_simd_bench.c
+    ${SOURCE_DIR}/cmod/cmod_image_simd_kernels.c
+    ${SOURCE_DIR}/qcommon/q_math.c
+    ${SOURCE_DIR}/qcommon/q_shared.c
+)
+
+add_executable(${IMAGE_SIMD_BENCH_BINARY} ${IMAGE_SIMD_BENCH_SOURCES})
+
+target_link_libraries(${IMAGE_SIMD_BENCH_BINARY} PRIVATE ${COMMON_LIBRARIES})
+
+set_output_dirs(${IMAGE_SIMD_BENCH_BINARY})
@@ -127,6 +127,9 @@ typedef struct aas_routingcache_s
 {
 	byte type;									//portal or area cache
 	float time;									//last time accessed or updated
+#ifdef CMOD_BOT_ROUTE_CACHE_BUDGET
+	int hits;									//number of accesses, halved periodically
+#endif
 	int size;									//size of the routing cache
 	int cluster;								//cluster the cache is for
 	int areanum;								//area the cache is created for
@@ -263,6 +266,10 @@ typedef struct aas_s
 	//areas the reachabilities go through
 	int *reachabilityareaindex;
 	aas_reachabilityareas_t *reachabilityareas;
+#ifdef CMOD_BOT_ROUTE_CACHE_BUDGET
+	//ROUTECACHE_EVICTED_* flags for every area
+	byte *routingcacheevicted;
+#endif
 } aas_t;
 
 #define AASINTERN
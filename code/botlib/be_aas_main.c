@@ -156,6 +156,9 @@ int AAS_StartFrame(float time)
 	AAS_ContinueInit(time);
 	//
 	aasworld.frameroutingupdates = 0;
+#ifdef CMOD_BOT_ROUTE_CACHE_BUDGET
+	AAS_RoutingCacheFrame();
+#endif
 	//
 	if (botDeveloper)
 	{
@@ -84,6 +84,32 @@ int numportalcacheupdates;
 int routingcachesize;
 int max_routingcachesize;
 
+#ifdef CMOD_BOT_ROUTE_CACHE_BUDGET
+//number of the oldest caches considered for eviction
+#define ROUTECACHE_EVICT_SAMPLES	32
+//seconds between halving the cache hit counts
+#define ROUTECACHE_DECAY_TIME		10.0f
+
+#define ROUTECACHE_EVICTED_AREA		1
+#define ROUTECACHE_EVICTED_PORTAL	2
+
+typedef struct routingcachestats_s
+{
+	int hits;
+	int misses;
+	int recomputes;						//misses for caches that were evicted before
+	int evictions;
+} routingcachestats_t;
+
+static routingcachestats_t routingcacheframe;		//current frame
+static routingcachestats_t routingcachelastframe;	//last complete frame
+static routingcachestats_t routingcachetotal;		//since map load or reset
+static routingcachestats_t routingcachepeak;		//highest single frame values
+static float routingcachedecaytime;
+static libvar_t *routecachestats;
+static libvar_t *routecachemb;				//routing cache budget in megabytes, 0 for unlimited
+#endif
+
 //===========================================================================
 //
 // Parameter:			-
@@ -727,21 +753,231 @@ int AAS_FreeOldestCache(void)
 	}
 	return qfalse;
 } //end of the function AAS_FreeOldestCache
+#ifdef CMOD_BOT_ROUTE_CACHE_BUDGET
+//===========================================================================
+// unlinks the given cache from the cluster area or portal cache lists
+// and frees it
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_EvictRoutingCache(aas_routingcache_t *cache)
+{
+	int clusterareanum;
+
+	if (cache->type == CACHETYPE_AREA) {
+		//number of the area in the cluster
+		clusterareanum = AAS_ClusterAreaNum(cache->cluster, cache->areanum);
+		// unlink from cluster area cache
+		if (cache->prev) cache->prev->next = cache->next;
+		else aasworld.clusterareacache[cache->cluster][clusterareanum] = cache->next;
+		if (cache->next) cache->next->prev = cache->prev;
+		aasworld.routingcacheevicted[cache->areanum] |= ROUTECACHE_EVICTED_AREA;
+	}
+	else {
+		// unlink from portal cache
+		if (cache->prev) cache->prev->next = cache->next;
+		else aasworld.portalcache[cache->areanum] = cache->next;
+		if (cache->next) cache->next->prev = cache->prev;
+		aasworld.routingcacheevicted[cache->areanum] |= ROUTECACHE_EVICTED_PORTAL;
+	}
+	AAS_FreeRoutingCache(cache);
+	routingcacheframe.evictions++;
+} //end of the function AAS_EvictRoutingCache
+//===========================================================================
+// frees the least frequently used of the oldest caches, so caches that are
+// hit often survive even if they haven't been used very recently
+//
+// Parameter:			-
+// Returns:				qtrue if a cache was freed
+// Changes Globals:		-
+//===========================================================================
+static int AAS_FreeColdestCache(void)
+{
+	int samples;
+	aas_routingcache_t *cache, *bestcache;
+
+	bestcache = NULL;
+	samples = 0;
+	for (cache = aasworld.oldestcache; cache && samples < ROUTECACHE_EVICT_SAMPLES; cache = cache->time_next) {
+		// never free area cache leading towards a portal
+		if (cache->type == CACHETYPE_AREA && aasworld.areasettings[cache->areanum].cluster < 0) {
+			continue;
+		}
+		samples++;
+		if (!bestcache || cache->hits < bestcache->hits) {
+			bestcache = cache;
+		}
+	}
+	if (bestcache) {
+		AAS_EvictRoutingCache(bestcache);
+		return qtrue;
+	}
+	return qfalse;
+} //end of the function AAS_FreeColdestCache
+//===========================================================================
+// frees caches until the routing cache fits in the memory budget
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_EnforceRoutingCacheBudget(void)
+{
+	int budget = routecachemb->value > 0 ? (int) routecachemb->value * 1024 * 1024 : 0;
+
+	//without a budget keep the original oldest first eviction on memory shortage
+	if (!budget) {
+		while(AvailableMemory() < 1 * 1024 * 1024) {
+			if (!AAS_FreeOldestCache()) break;
+		}
+		return;
+	} //end if
+
+	while (routingcachesize > budget || AvailableMemory() < 1 * 1024 * 1024) {
+		if (!AAS_FreeColdestCache()) break;
+	}
+} //end of the function AAS_EnforceRoutingCacheBudget
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_PrintRoutingCacheStats(void)
+{
+	int numcaches, lookups;
+	aas_routingcache_t *cache;
+
+	numcaches = 0;
+	for (cache = aasworld.oldestcache; cache; cache = cache->time_next) numcaches++;
+	if (routecachemb->value > 0)
+	{
+		botimport.Print(PRT_MESSAGE, "%d routing caches using %d KB of %d KB budget\n",
+				numcaches, routingcachesize / 1024, (int) routecachemb->value * 1024);
+	} //end if
+	else
+	{
+		botimport.Print(PRT_MESSAGE, "%d routing caches using %d KB\n", numcaches, routingcachesize / 1024);
+	} //end else
+	botimport.Print(PRT_MESSAGE, "last frame: %d hits, %d misses, %d recomputes, %d evictions\n",
+			routingcachelastframe.hits, routingcachelastframe.misses,
+			routingcachelastframe.recomputes, routingcachelastframe.evictions);
+	botimport.Print(PRT_MESSAGE, "peak frame: %d hits, %d misses, %d recomputes, %d evictions\n",
+			routingcachepeak.hits, routingcachepeak.misses,
+			routingcachepeak.recomputes, routingcachepeak.evictions);
+	lookups = routingcachetotal.hits + routingcachetotal.misses;
+	botimport.Print(PRT_MESSAGE, "total: %d hits, %d misses, %d recomputes, %d evictions (%.1f%% hit rate)\n",
+			routingcachetotal.hits, routingcachetotal.misses, routingcachetotal.recomputes,
+			routingcachetotal.evictions, lookups ? 100.0f * routingcachetotal.hits / lookups : 0.0f);
+} //end of the function AAS_PrintRoutingCacheStats
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_ResetRoutingCacheStats(void)
+{
+	Com_Memset(&routingcacheframe, 0, sizeof(routingcacheframe));
+	Com_Memset(&routingcachelastframe, 0, sizeof(routingcachelastframe));
+	Com_Memset(&routingcachetotal, 0, sizeof(routingcachetotal));
+	Com_Memset(&routingcachepeak, 0, sizeof(routingcachepeak));
+} //end of the function AAS_ResetRoutingCacheStats
+//===========================================================================
+// called at the start of every frame
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+void AAS_RoutingCacheFrame(void)
+{
+	aas_routingcache_t *cache;
+	routingcachestats_t *frame = &routingcacheframe;
+
+	if (!aasworld.initialized) return;
+	//finish the stats for the last frame
+	routingcachelastframe = *frame;
+	routingcachetotal.hits += frame->hits;
+	routingcachetotal.misses += frame->misses;
+	routingcachetotal.recomputes += frame->recomputes;
+	routingcachetotal.evictions += frame->evictions;
+	if (frame->hits > routingcachepeak.hits) routingcachepeak.hits = frame->hits;
+	if (frame->misses > routingcachepeak.misses) routingcachepeak.misses = frame->misses;
+	if (frame->recomputes > routingcachepeak.recomputes) routingcachepeak.recomputes = frame->recomputes;
+	if (frame->evictions > routingcachepeak.evictions) routingcachepeak.evictions = frame->evictions;
+	Com_Memset(frame, 0, sizeof(*frame));
+	//1 = print stats, 2 = print and reset stats
+	if (routecachestats->value)
+	{
+		AAS_PrintRoutingCacheStats();
+		if (routecachestats->value == 2) AAS_ResetRoutingCacheStats();
+		LibVarSet("routecachestats", "0");
+	} //end if
+	//age the hit counts so caches that were only hot in the past become cold
+	if (AAS_RoutingTime() - routingcachedecaytime > ROUTECACHE_DECAY_TIME ||
+			AAS_RoutingTime() < routingcachedecaytime)
+	{
+		for (cache = aasworld.oldestcache; cache; cache = cache->time_next)
+		{
+			cache->hits >>= 1;
+		} //end for
+		routingcachedecaytime = AAS_RoutingTime();
+	} //end if
+} //end of the function AAS_RoutingCacheFrame
+//===========================================================================
+// updates the stats for a routing cache lookup
+//
+// Parameter:			cache		: the cache found, or NULL if it has to be created
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_RoutingCacheLookup(aas_routingcache_t *cache, int areanum, int evictedflag)
+{
+	if (cache)
+	{
+		cache->hits++;
+		routingcacheframe.hits++;
+	} //end if
+	else
+	{
+		routingcacheframe.misses++;
+		if (aasworld.routingcacheevicted[areanum] & evictedflag)
+		{
+			routingcacheframe.recomputes++;
+		} //end if
+	} //end else
+} //end of the function AAS_RoutingCacheLookup
+#endif
 //===========================================================================
 //
 // Parameter:			-
 // Returns:				-
 // Changes Globals:		-
 //===========================================================================
+#ifdef CMOD_BOT_ROUTE_PRECACHE
+static int AAS_RoutingCacheSize(int numtraveltimes)
+{
+	return sizeof(aas_routingcache_t)
+						+ numtraveltimes * sizeof(unsigned short int)
+						+ numtraveltimes * sizeof(unsigned char);
+} //end of the function AAS_RoutingCacheSize
+#endif
 aas_routingcache_t *AAS_AllocRoutingCache(int numtraveltimes)
 {
 	aas_routingcache_t *cache;
 	int size;
 
 	//
+#ifdef CMOD_BOT_ROUTE_PRECACHE
+	size = AAS_RoutingCacheSize(numtraveltimes);
+#else
 	size = sizeof(aas_routingcache_t)
 						+ numtraveltimes * sizeof(unsigned short int)
 						+ numtraveltimes * sizeof(unsigned char);
+#endif
 	//
 	routingcachesize += size;
 	//
@@ -1243,8 +1479,23 @@ void AAS_InitRouting(void)
 	//
 	routingcachesize = 0;
 	max_routingcachesize = 1024 * (int) LibVarValue("max_routingcache", "4096");
+#ifdef CMOD_BOT_ROUTE_CACHE_BUDGET
+	if (aasworld.routingcacheevicted) FreeMemory(aasworld.routingcacheevicted);
+	aasworld.routingcacheevicted = (byte *) GetClearedMemory(aasworld.numareas * sizeof(byte));
+	routecachestats = LibVar("routecachestats", "0");
+	routecachemb = LibVar("routecachemb", "0");
+	routingcachedecaytime = AAS_RoutingTime();
+	AAS_ResetRoutingCacheStats();
+#endif
 	// read any routing cache if available
+#ifdef CMOD_BOT_ROUTE_PRECACHE
+	if (!AAS_ReadRouteCache())
+	{
+		AAS_PrecacheRouting();
+	} //end if
+#else
 	AAS_ReadRouteCache();
+#endif
 } //end of the function AAS_InitRouting
 //===========================================================================
 //
@@ -1281,16 +1532,28 @@ void AAS_FreeRoutingCaches(void)
 	// free area contents travel flags look up table
 	if (aasworld.areacontentstravelflags) FreeMemory(aasworld.areacontentstravelflags);
 	aasworld.areacontentstravelflags = NULL;
+#ifdef CMOD_BOT_ROUTE_CACHE_BUDGET
+	if (aasworld.routingcacheevicted) FreeMemory(aasworld.routingcacheevicted);
+	aasworld.routingcacheevicted = NULL;
+#endif
 } //end of the function AAS_FreeRoutingCaches
 //===========================================================================
 // update the given routing cache
 //
 // Parameter:			areacache		: routing cache to update
+//						areaupdate		: routing update fields (cmod: may be a per-thread buffer)
 // Returns:				-
 // Changes Globals:		-
 //===========================================================================
+#ifdef CMOD_BOT_ROUTE_PRECACHE
+static void AAS_UpdateAreaRoutingCacheBuffer(aas_routingcache_t *areacache, aas_routingupdate_t *areaupdate)
+#else
 void AAS_UpdateAreaRoutingCache(aas_routingcache_t *areacache)
+#endif
 {
+#ifndef CMOD_BOT_ROUTE_PRECACHE
+	aas_routingupdate_t *areaupdate = aasworld.areaupdate;
+#endif
 	int i, nextareanum, cluster, badtravelflags, clusterareanum, linknum;
 	int numreachabilityareas;
 	unsigned short int t, startareatraveltimes[128]; //NOTE: not more than 128 reachabilities per area allowed
@@ -1299,13 +1562,17 @@ void AAS_UpdateAreaRoutingCache(aas_routingcache_t *areacache)
 	aas_reversedreachability_t *revreach;
 	aas_reversedlink_t *revlink;
 
+#ifndef CMOD_BOT_ROUTE_PRECACHE
 #ifdef ROUTING_DEBUG
 	numareacacheupdates++;
 #endif //ROUTING_DEBUG
+#endif
 	//number of reachability areas within this cluster
 	numreachabilityareas = aasworld.clusters[areacache->cluster].numreachabilityareas;
 	//
+#ifndef CMOD_BOT_ROUTE_PRECACHE
 	aasworld.frameroutingupdates++;
+#endif
 	//clear the routing update fields
 //	Com_Memset(aasworld.areaupdate, 0, aasworld.numareas * sizeof(aas_routingupdate_t));
 	//
@@ -1316,7 +1583,7 @@ void AAS_UpdateAreaRoutingCache(aas_routingcache_t *areacache)
 	//
 	Com_Memset(startareatraveltimes, 0, sizeof(startareatraveltimes));
 	//
-	curupdate = &aasworld.areaupdate[clusterareanum];
+	curupdate = &areaupdate[clusterareanum];
 	curupdate->areanum = areacache->areanum;
 	//VectorCopy(areacache->origin, curupdate->start);
 	curupdate->areatraveltimes = startareatraveltimes;
@@ -1372,7 +1639,7 @@ void AAS_UpdateAreaRoutingCache(aas_routingcache_t *areacache)
 			{
 				areacache->traveltimes[clusterareanum] = t;
 				areacache->reachabilities[clusterareanum] = linknum - aasworld.areasettings[nextareanum].firstreachablearea;
-				nextupdate = &aasworld.areaupdate[clusterareanum];
+				nextupdate = &areaupdate[clusterareanum];
 				nextupdate->areanum = nextareanum;
 				nextupdate->tmptraveltime = t;
 				//VectorCopy(reach->start, nextupdate->start);
@@ -1394,6 +1661,41 @@ void AAS_UpdateAreaRoutingCache(aas_routingcache_t *areacache)
 		} //end for
 	} //end while
 } //end of the function AAS_UpdateAreaRoutingCache
+#ifdef CMOD_BOT_ROUTE_PRECACHE
+//===========================================================================
+// update the given routing cache using the shared routing update fields
+//
+// Parameter:			areacache		: routing cache to update
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+void AAS_UpdateAreaRoutingCache(aas_routingcache_t *areacache)
+{
+#ifdef ROUTING_DEBUG
+	numareacacheupdates++;
+#endif //ROUTING_DEBUG
+	aasworld.frameroutingupdates++;
+	AAS_UpdateAreaRoutingCacheBuffer(areacache, aasworld.areaupdate);
+} //end of the function AAS_UpdateAreaRoutingCache
+//===========================================================================
+// returns the existing area routing cache with the given travel flags
+// without allocating or touching the cache time list, or NULL if not found
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static aas_routingcache_t *AAS_FindAreaRoutingCache(int clusternum, int areanum, int travelflags)
+{
+	aas_routingcache_t *cache;
+
+	for (cache = aasworld.clusterareacache[clusternum][AAS_ClusterAreaNum(clusternum, areanum)]; cache; cache = cache->next)
+	{
+		if (cache->travelflags == travelflags) return cache;
+	} //end for
+	return NULL;
+} //end of the function AAS_FindAreaRoutingCache
+#endif
 //===========================================================================
 //
 // Parameter:			-
@@ -1415,6 +1717,9 @@ aas_routingcache_t *AAS_GetAreaRoutingCache(int clusternum, int areanum, int tra
 		//if there aren't used any undesired travel types for the cache
 		if (cache->travelflags == travelflags) break;
 	} //end for
+#ifdef CMOD_BOT_ROUTE_CACHE_BUDGET
+	AAS_RoutingCacheLookup(cache, areanum, ROUTECACHE_EVICTED_AREA);
+#endif
 	//if there was no cache
 	if (!cache)
 	{
@@ -1442,12 +1747,22 @@ aas_routingcache_t *AAS_GetAreaRoutingCache(int clusternum, int areanum, int tra
 } //end of the function AAS_GetAreaRoutingCache
 //===========================================================================
 //
-// Parameter:			-
-// Returns:				-
+// Parameter:			portalcache		: routing cache to update
+//						portalupdate	: routing update fields (cmod: may be a per-thread buffer)
+//						threaded		: if true, only existing area caches are used and
+//										  no global state is modified
+// Returns:				cmod: qfalse if threaded and a required area cache doesn't exist
 // Changes Globals:		-
 //===========================================================================
+#ifdef CMOD_BOT_ROUTE_PRECACHE
+static qboolean AAS_UpdatePortalRoutingCacheBuffer(aas_routingcache_t *portalcache, aas_routingupdate_t *portalupdate, qboolean threaded)
+#else
 void AAS_UpdatePortalRoutingCache(aas_routingcache_t *portalcache)
+#endif
 {
+#ifndef CMOD_BOT_ROUTE_PRECACHE
+	aas_routingupdate_t *portalupdate = aasworld.portalupdate;
+#endif
 	int i, portalnum, clusterareanum, clusternum;
 	unsigned short int t;
 	aas_portal_t *portal;
@@ -1455,13 +1770,15 @@ void AAS_UpdatePortalRoutingCache(aas_routingcache_t *portalcache)
 	aas_routingcache_t *cache;
 	aas_routingupdate_t *updateliststart, *updatelistend, *curupdate, *nextupdate;
 
+#ifndef CMOD_BOT_ROUTE_PRECACHE
 #ifdef ROUTING_DEBUG
 	numportalcacheupdates++;
 #endif //ROUTING_DEBUG
+#endif
 	//clear the routing update fields
 //	Com_Memset(aasworld.portalupdate, 0, (aasworld.numportals+1) * sizeof(aas_routingupdate_t));
 	//
-	curupdate = &aasworld.portalupdate[aasworld.numportals];
+	curupdate = &portalupdate[aasworld.numportals];
 	curupdate->cluster = portalcache->cluster;
 	curupdate->areanum = portalcache->areanum;
 	curupdate->tmptraveltime = portalcache->starttraveltime;
@@ -1489,6 +1806,23 @@ void AAS_UpdatePortalRoutingCache(aas_routingcache_t *portalcache)
 		//
 		cluster = &aasworld.clusters[curupdate->cluster];
 		//
+#ifdef CMOD_BOT_ROUTE_PRECACHE
+		if (threaded)
+		{
+			cache = AAS_FindAreaRoutingCache(curupdate->cluster,
+								curupdate->areanum, portalcache->travelflags);
+			if (!cache)
+			{
+				//clear the remaining updates so the buffer can be reused
+				for (; updateliststart; updateliststart = updateliststart->next)
+				{
+					updateliststart->inlist = qfalse;
+				} //end for
+				return qfalse;
+			} //end if
+		} //end if
+		else
+#endif
 		cache = AAS_GetAreaRoutingCache(curupdate->cluster,
 								curupdate->areanum, portalcache->travelflags);
 		//take all portals of the cluster
@@ -1510,7 +1844,7 @@ void AAS_UpdatePortalRoutingCache(aas_routingcache_t *portalcache)
 					portalcache->traveltimes[portalnum] > t)
 			{
 				portalcache->traveltimes[portalnum] = t;
-				nextupdate = &aasworld.portalupdate[portalnum];
+				nextupdate = &portalupdate[portalnum];
 				if (portal->frontcluster == curupdate->cluster)
 				{
 					nextupdate->cluster = portal->backcluster;
@@ -1537,7 +1871,25 @@ void AAS_UpdatePortalRoutingCache(aas_routingcache_t *portalcache)
 			} //end if
 		} //end for
 	} //end while
+#ifdef CMOD_BOT_ROUTE_PRECACHE
+	return qtrue;
+#endif
+} //end of the function AAS_UpdatePortalRoutingCache
+#ifdef CMOD_BOT_ROUTE_PRECACHE
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+void AAS_UpdatePortalRoutingCache(aas_routingcache_t *portalcache)
+{
+#ifdef ROUTING_DEBUG
+	numportalcacheupdates++;
+#endif //ROUTING_DEBUG
+	AAS_UpdatePortalRoutingCacheBuffer(portalcache, aasworld.portalupdate, qfalse);
 } //end of the function AAS_UpdatePortalRoutingCache
+#endif
 //===========================================================================
 //
 // Parameter:			-
@@ -1553,6 +1905,9 @@ aas_routingcache_t *AAS_GetPortalRoutingCache(int clusternum, int areanum, int t
 	{
 		if (cache->travelflags == travelflags) break;
 	} //end for
+#ifdef CMOD_BOT_ROUTE_CACHE_BUDGET
+	AAS_RoutingCacheLookup(cache, areanum, ROUTECACHE_EVICTED_PORTAL);
+#endif
 	//if the portal routing isn't cached
 	if (!cache)
 	{
@@ -1580,6 +1935,457 @@ aas_routingcache_t *AAS_GetPortalRoutingCache(int clusternum, int areanum, int t
 	AAS_LinkCache(cache);
 	return cache;
 } //end of the function AAS_GetPortalRoutingCache
+#ifdef CMOD_BOT_ROUTE_PRECACHE
+//===========================================================================
+// cmod: routing cache precomputation
+//
+// routing caches are normally created on demand the first time a bot routes
+// towards a goal area, which stalls the frame it happens in. when enabled by
+// the "routeprecache" libvar all the area and portal caches for the default
+// travel flags are computed at map load in worker threads and written to a
+// cache file keyed by the aas data checksum, so later loads of the same map
+// only need to read the file
+//
+// the worker threads use their own routing update fields and only read the
+// aas world, area caches are all computed before any portal caches so the
+// portal updates can look them up without allocating
+//===========================================================================
+
+#define ROUTEPRECACHE_ID				(('C'<<24)+('P'<<16)+('R'<<8)+'B')
+#define ROUTEPRECACHE_VERSION			1
+#define ROUTEPRECACHE_HEADER_WORDS		8
+#define ROUTEPRECACHE_MAX_THREADS		16
+//memory to leave available to the rest of the bot library
+#define ROUTEPRECACHE_MEMORY_RESERVE	(8 * 1024 * 1024)
+
+typedef struct routeprecache_s
+{
+	aas_routingcache_t **caches;		//area caches followed by portal caches
+	int numareacache;
+	int numportalcache;
+	int filesize;						//size of the cache file in bytes
+	qboolean *failed;					//portal caches to update in the main thread
+	int numthreads;
+	aas_routingupdate_t *areaupdate[ROUTEPRECACHE_MAX_THREADS];
+	aas_routingupdate_t *portalupdate[ROUTEPRECACHE_MAX_THREADS];
+} routeprecache_t;
+
+//===========================================================================
+// returns the number of travel times stored in the given precache entry
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static int AAS_RoutePrecacheNumTravelTimes(aas_routingcache_t *cache)
+{
+	if (cache->type == CACHETYPE_PORTAL) return aasworld.numportals;
+	return aasworld.clusters[cache->cluster].numreachabilityareas;
+} //end of the function AAS_RoutePrecacheNumTravelTimes
+//===========================================================================
+// returns the largest number of travel times in any precache entry
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static int AAS_RoutePrecacheMaxTravelTimes(void)
+{
+	int i, maxtraveltimes;
+
+	maxtraveltimes = aasworld.numportals;
+	for (i = 0; i < aasworld.numclusters; i++)
+	{
+		if (aasworld.clusters[i].numreachabilityareas > maxtraveltimes)
+			maxtraveltimes = aasworld.clusters[i].numreachabilityareas;
+	} //end for
+	return maxtraveltimes;
+} //end of the function AAS_RoutePrecacheMaxTravelTimes
+//===========================================================================
+// allocates a routing cache and links it the same way as
+// AAS_GetAreaRoutingCache and AAS_GetPortalRoutingCache do
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static aas_routingcache_t *AAS_RoutePrecacheAlloc(int clusternum, int areanum, int type)
+{
+	aas_routingcache_t *cache, **list;
+
+	if (type == CACHETYPE_PORTAL)
+	{
+		cache = AAS_AllocRoutingCache(aasworld.numportals);
+		list = &aasworld.portalcache[areanum];
+	} //end if
+	else
+	{
+		cache = AAS_AllocRoutingCache(aasworld.clusters[clusternum].numreachabilityareas);
+		list = &aasworld.clusterareacache[clusternum][AAS_ClusterAreaNum(clusternum, areanum)];
+	} //end else
+	cache->cluster = clusternum;
+	cache->areanum = areanum;
+	VectorCopy(aasworld.areas[areanum].center, cache->origin);
+	cache->starttraveltime = 1;
+	cache->travelflags = TFL_DEFAULT;
+	cache->prev = NULL;
+	cache->next = *list;
+	if (*list) (*list)->prev = cache;
+	*list = cache;
+	cache->time = AAS_RoutingTime();
+	cache->type = type;
+	AAS_LinkCache(cache);
+	return cache;
+} //end of the function AAS_RoutePrecacheAlloc
+//===========================================================================
+// counts the routing caches to precompute, and allocates them if
+// rp->caches is set
+//
+// Parameter:			-
+// Returns:				total memory size of the caches
+// Changes Globals:		-
+//===========================================================================
+static int AAS_RoutePrecacheCreate(routeprecache_t *rp)
+{
+	int i, j, n, pass, type, numclusters, clusters[2], numtraveltimes, size;
+	aas_portal_t *portal;
+
+	size = 0;
+	n = 0;
+	rp->numareacache = 0;
+	rp->numportalcache = 0;
+	rp->filesize = ROUTEPRECACHE_HEADER_WORDS * 4;
+	//first pass creates the area caches, second pass the portal caches
+	for (pass = 0; pass < 2; pass++)
+	{
+		type = pass ? CACHETYPE_PORTAL : CACHETYPE_AREA;
+		for (i = 1; i < aasworld.numareas; i++)
+		{
+			//routing towards areas without reachabilities always fails
+			if (!aasworld.areasettings[i].numreachableareas) continue;
+			//
+			numclusters = 1;
+			clusters[0] = aasworld.areasettings[i].cluster;
+			if (clusters[0] < 0)
+			{
+				//portal areas have an area cache in both clusters, and the
+				//portal cache uses the front cluster as in AAS_AreaRouteToGoalArea
+				portal = &aasworld.portals[-clusters[0]];
+				clusters[0] = portal->frontcluster;
+				clusters[1] = portal->backcluster;
+				if (type == CACHETYPE_AREA && clusters[1] != clusters[0]) numclusters = 2;
+			} //end if
+			for (j = 0; j < numclusters; j++)
+			{
+				numtraveltimes = pass ? aasworld.numportals : aasworld.clusters[clusters[j]].numreachabilityareas;
+				if (rp->caches) rp->caches[n] = AAS_RoutePrecacheAlloc(clusters[j], i, type);
+				size += AAS_RoutingCacheSize(numtraveltimes);
+				rp->filesize += numtraveltimes * (sizeof(unsigned short int) + sizeof(unsigned char));
+				n++;
+				if (pass) rp->numportalcache++;
+				else rp->numareacache++;
+			} //end for
+		} //end for
+	} //end for
+	return size;
+} //end of the function AAS_RoutePrecacheCreate
+//===========================================================================
+// 32 bit FNV-1a hash
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static unsigned int AAS_RoutePrecacheBlockChecksum(const void *buffer, int length)
+{
+	int i;
+	unsigned int hash = 2166136261u;
+	const byte *data = (const byte *) buffer;
+
+	for (i = 0; i < length; i++)
+	{
+		hash = (hash ^ data[i]) * 16777619u;
+	} //end for
+	return hash;
+} //end of the function AAS_RoutePrecacheBlockChecksum
+//===========================================================================
+// checksum of all the aas data the routing caches are derived from
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static unsigned int AAS_RoutePrecacheChecksum(void)
+{
+	unsigned int checksums[6];
+
+	checksums[0] = AAS_RoutePrecacheBlockChecksum(aasworld.areas, aasworld.numareas * sizeof(aas_area_t));
+	checksums[1] = AAS_RoutePrecacheBlockChecksum(aasworld.areasettings, aasworld.numareasettings * sizeof(aas_areasettings_t));
+	checksums[2] = AAS_RoutePrecacheBlockChecksum(aasworld.reachability, aasworld.reachabilitysize * sizeof(aas_reachability_t));
+	checksums[3] = AAS_RoutePrecacheBlockChecksum(aasworld.portals, aasworld.numportals * sizeof(aas_portal_t));
+	checksums[4] = AAS_RoutePrecacheBlockChecksum(aasworld.portalindex, aasworld.portalindexsize * sizeof(aas_portalindex_t));
+	checksums[5] = AAS_RoutePrecacheBlockChecksum(aasworld.clusters, aasworld.numclusters * sizeof(aas_cluster_t));
+	return AAS_RoutePrecacheBlockChecksum(checksums, sizeof(checksums));
+} //end of the function AAS_RoutePrecacheChecksum
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static const char *AAS_RoutePrecachePath(unsigned int checksum)
+{
+	return va("routecache/%08x.rcd", checksum);
+} //end of the function AAS_RoutePrecachePath
+//===========================================================================
+// reads the cache file into the allocated caches
+//
+// Parameter:			-
+// Returns:				qtrue if the file exists and matches the aas data
+// Changes Globals:		-
+//===========================================================================
+static qboolean AAS_RoutePrecacheRead(routeprecache_t *rp, unsigned int checksum)
+{
+	int i, j, n, size, maxtraveltimes, words[ROUTEPRECACHE_HEADER_WORDS];
+	byte *buffer;
+	aas_routingcache_t *cache;
+	fileHandle_t fp;
+
+	size = botimport.CacheFileOpenRead(AAS_RoutePrecachePath(checksum), &fp);
+	if (!fp) return qfalse;
+	if (size != rp->filesize || botimport.FS_Read(words, sizeof(words), fp) != sizeof(words))
+	{
+		botimport.FS_FCloseFile(fp);
+		return qfalse;
+	} //end if
+	for (i = 0; i < ROUTEPRECACHE_HEADER_WORDS; i++)
+	{
+		words[i] = LittleLong(words[i]);
+	} //end for
+	if (words[0] != ROUTEPRECACHE_ID || words[1] != ROUTEPRECACHE_VERSION ||
+			(unsigned int) words[2] != checksum || words[3] != aasworld.numareas ||
+			words[4] != aasworld.numclusters || words[5] != aasworld.numportals ||
+			words[6] != rp->numareacache || words[7] != rp->numportalcache)
+	{
+		botimport.FS_FCloseFile(fp);
+		return qfalse;
+	} //end if
+	//
+	maxtraveltimes = AAS_RoutePrecacheMaxTravelTimes();
+	buffer = (byte *) GetMemory(maxtraveltimes * 3);
+	for (i = 0; i < rp->numareacache + rp->numportalcache; i++)
+	{
+		cache = rp->caches[i];
+		n = AAS_RoutePrecacheNumTravelTimes(cache);
+		if (botimport.FS_Read(buffer, n * 3, fp) != n * 3) break;
+		for (j = 0; j < n; j++)
+		{
+			cache->traveltimes[j] = buffer[j * 2] | (buffer[j * 2 + 1] << 8);
+		} //end for
+		Com_Memcpy(cache->reachabilities, buffer + n * 2, n);
+	} //end for
+	FreeMemory(buffer);
+	botimport.FS_FCloseFile(fp);
+	return i == rp->numareacache + rp->numportalcache ? qtrue : qfalse;
+} //end of the function AAS_RoutePrecacheRead
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_RoutePrecacheWrite(routeprecache_t *rp, unsigned int checksum)
+{
+	int i, j, n, maxtraveltimes, words[ROUTEPRECACHE_HEADER_WORDS];
+	const char *path = AAS_RoutePrecachePath(checksum);
+	byte *buffer;
+	aas_routingcache_t *cache;
+	fileHandle_t fp;
+
+	fp = botimport.CacheFileOpenWrite(path);
+	if (!fp)
+	{
+		if (botDeveloper) botimport.Print(PRT_MESSAGE, "AAS_RoutePrecacheWrite: failed to open %s\n", path);
+		return;
+	} //end if
+	words[0] = ROUTEPRECACHE_ID;
+	words[1] = ROUTEPRECACHE_VERSION;
+	words[2] = (int) checksum;
+	words[3] = aasworld.numareas;
+	words[4] = aasworld.numclusters;
+	words[5] = aasworld.numportals;
+	words[6] = rp->numareacache;
+	words[7] = rp->numportalcache;
+	for (i = 0; i < ROUTEPRECACHE_HEADER_WORDS; i++)
+	{
+		words[i] = LittleLong(words[i]);
+	} //end for
+	botimport.FS_Write(words, sizeof(words), fp);
+	//
+	maxtraveltimes = AAS_RoutePrecacheMaxTravelTimes();
+	buffer = (byte *) GetMemory(maxtraveltimes * 3);
+	for (i = 0; i < rp->numareacache + rp->numportalcache; i++)
+	{
+		cache = rp->caches[i];
+		n = AAS_RoutePrecacheNumTravelTimes(cache);
+		for (j = 0; j < n; j++)
+		{
+			buffer[j * 2] = cache->traveltimes[j] & 255;
+			buffer[j * 2 + 1] = cache->traveltimes[j] >> 8;
+		} //end for
+		Com_Memcpy(buffer + n * 2, cache->reachabilities, n);
+		botimport.FS_Write(buffer, n * 3, fp);
+	} //end for
+	FreeMemory(buffer);
+	botimport.FS_FCloseFile(fp);
+	if (botDeveloper) botimport.Print(PRT_MESSAGE, "wrote routing cache %s\n", path);
+} //end of the function AAS_RoutePrecacheWrite
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_RoutePrecacheAreaThread(int threadnum, void *context)
+{
+	int i;
+	routeprecache_t *rp = (routeprecache_t *) context;
+
+	for (i = threadnum; i < rp->numareacache; i += rp->numthreads)
+	{
+		AAS_UpdateAreaRoutingCacheBuffer(rp->caches[i], rp->areaupdate[threadnum]);
+	} //end for
+} //end of the function AAS_RoutePrecacheAreaThread
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_RoutePrecachePortalThread(int threadnum, void *context)
+{
+	int i;
+	routeprecache_t *rp = (routeprecache_t *) context;
+
+	for (i = threadnum; i < rp->numportalcache; i += rp->numthreads)
+	{
+		if (!AAS_UpdatePortalRoutingCacheBuffer(rp->caches[rp->numareacache + i],
+				rp->portalupdate[threadnum], qtrue))
+		{
+			rp->failed[i] = qtrue;
+		} //end if
+	} //end for
+} //end of the function AAS_RoutePrecachePortalThread
+//===========================================================================
+// computes all the allocated caches
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_RoutePrecacheCompute(routeprecache_t *rp)
+{
+	int i, maxreachabilityareas;
+	aas_routingcache_t *cache;
+
+	rp->numthreads = 1;
+	if (botimport.RunParallel)
+	{
+		rp->numthreads = botimport.ProcessorCount();
+		if (rp->numthreads > ROUTEPRECACHE_MAX_THREADS) rp->numthreads = ROUTEPRECACHE_MAX_THREADS;
+		if (rp->numthreads < 1) rp->numthreads = 1;
+	} //end if
+	//
+	maxreachabilityareas = 0;
+	for (i = 0; i < aasworld.numclusters; i++)
+	{
+		if (aasworld.clusters[i].numreachabilityareas > maxreachabilityareas)
+			maxreachabilityareas = aasworld.clusters[i].numreachabilityareas;
+	} //end for
+	for (i = 0; i < rp->numthreads; i++)
+	{
+		rp->areaupdate[i] = (aas_routingupdate_t *) GetClearedMemory(
+									maxreachabilityareas * sizeof(aas_routingupdate_t));
+		rp->portalupdate[i] = (aas_routingupdate_t *) GetClearedMemory(
+									(aasworld.numportals+1) * sizeof(aas_routingupdate_t));
+	} //end for
+	rp->failed = (qboolean *) GetClearedMemory((rp->numportalcache + 1) * sizeof(qboolean));
+	//
+	if (botimport.RunParallel)
+	{
+		botimport.RunParallel(rp->numthreads, AAS_RoutePrecacheAreaThread, rp);
+		botimport.RunParallel(rp->numthreads, AAS_RoutePrecachePortalThread, rp);
+	} //end if
+	else
+	{
+		AAS_RoutePrecacheAreaThread(0, rp);
+		AAS_RoutePrecachePortalThread(0, rp);
+	} //end else
+	//portal caches that depend on area caches which weren't precomputed
+	for (i = 0; i < rp->numportalcache; i++)
+	{
+		if (!rp->failed[i]) continue;
+		cache = rp->caches[rp->numareacache + i];
+		Com_Memset(cache->traveltimes, 0, aasworld.numportals * sizeof(unsigned short int));
+		AAS_UpdatePortalRoutingCache(cache);
+	} //end for
+	//
+	for (i = 0; i < rp->numthreads; i++)
+	{
+		FreeMemory(rp->areaupdate[i]);
+		FreeMemory(rp->portalupdate[i]);
+	} //end for
+	FreeMemory(rp->failed);
+} //end of the function AAS_RoutePrecacheCompute
+//===========================================================================
+// creates all the routing caches for the default travel flags, either from
+// the cache file or by computing them
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+void AAS_PrecacheRouting(void)
+{
+	int size, budget, starttime;
+	unsigned int checksum;
+	routeprecache_t rp;
+
+	budget = (int) LibVarValue("routeprecache", "0");
+	if (budget <= 0) return;
+	//
+	Com_Memset(&rp, 0, sizeof(rp));
+	size = AAS_RoutePrecacheCreate(&rp);
+	if (!rp.numareacache) return;
+	if (size / (1024 * 1024) >= budget ||
+#ifdef CMOD_BOT_ROUTE_CACHE_BUDGET
+			(routecachemb->value > 0 && size / (1024 * 1024) >= (int) routecachemb->value) ||
+#endif
+			size > AvailableMemory() - ROUTEPRECACHE_MEMORY_RESERVE)
+	{
+		botimport.Print(PRT_MESSAGE, "skipping routing cache precompute: %d KB exceeds memory budget\n", size / 1024);
+		return;
+	} //end if
+	//
+	starttime = botimport.Milliseconds();
+	rp.caches = (aas_routingcache_t **) GetMemory((rp.numareacache + rp.numportalcache) * sizeof(aas_routingcache_t *));
+	AAS_RoutePrecacheCreate(&rp);
+	checksum = AAS_RoutePrecacheChecksum();
+	if (AAS_RoutePrecacheRead(&rp, checksum))
+	{
+		botimport.Print(PRT_MESSAGE, "loaded %d area and %d portal routing caches (%d KB) in %d msec\n",
+				rp.numareacache, rp.numportalcache, size / 1024, botimport.Milliseconds() - starttime);
+	} //end if
+	else
+	{
+		AAS_RoutePrecacheCompute(&rp);
+		botimport.Print(PRT_MESSAGE, "computed %d area and %d portal routing caches (%d KB) in %d msec using %d threads\n",
+				rp.numareacache, rp.numportalcache, size / 1024, botimport.Milliseconds() - starttime, rp.numthreads);
+		AAS_RoutePrecacheWrite(&rp, checksum);
+	} //end else
+	FreeMemory(rp.caches);
+} //end of the function AAS_PrecacheRouting
+#endif
 //===========================================================================
 //
 // Parameter:			-
@@ -1625,9 +2431,13 @@ int AAS_AreaRouteToGoalArea(int areanum, vec3_t origin, int goalareanum, int tra
 		return qfalse;
 	} //end if
 	// make sure the routing cache doesn't grow to large
+#ifdef CMOD_BOT_ROUTE_CACHE_BUDGET
+	AAS_EnforceRoutingCacheBudget();
+#else
 	while(AvailableMemory() < 1 * 1024 * 1024) {
 		if (!AAS_FreeOldestCache()) break;
 	}
+#endif
 	//
 	if (AAS_AreaDoNotEnter(areanum) || AAS_AreaDoNotEnter(goalareanum))
 	{
@@ -39,6 +39,14 @@ unsigned short int AAS_AreaTravelTime(int areanum, vec3_t start, vec3_t end);
 //
 void AAS_CreateAllRoutingCache(void);
 void AAS_WriteRouteCache(void);
+#ifdef CMOD_BOT_ROUTE_PRECACHE
+//compute or load all routing caches for the default travel flags
+void AAS_PrecacheRouting(void);
+#endif
+#ifdef CMOD_BOT_ROUTE_CACHE_BUDGET
+//update routing cache stats and hit counts at the start of every frame
+void AAS_RoutingCacheFrame(void);
+#endif
 //
 void AAS_RoutingInfo(void);
 #endif //AASINTERN
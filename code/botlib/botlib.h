@@ -225,6 +225,14 @@ typedef struct botlib_import_s
 	//
 	int			(*DebugPolygonCreate)(int color, int numPoints, vec3_t *points);
 	void		(*DebugPolygonDelete)(int id);
+#ifdef CMOD_BOT_ROUTE_PRECACHE
+	//routing cache precompute
+	int			(*Milliseconds)(void);		// wall clock time, unlike Sys_MilliSeconds
+	int			(*ProcessorCount)(void);
+	void		(*RunParallel)(int numthreads, void (*func)(int threadnum, void *context), void *context);	// may be null
+	int			(*CacheFileOpenRead)(const char *qpath, fileHandle_t *file);	// returns size, or -1 on error
+	fileHandle_t (*CacheFileOpenWrite)(const char *qpath);
+#endif
 } botlib_import_t;
 
 typedef struct aas_export_s
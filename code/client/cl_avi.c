@@ -601,6 +601,12 @@ qboolean CL_CloseAVI( void )
   if( !afd.fileOpen )
     return qfalse;
 
+#ifdef CMOD_ASYNC_VIDEO_CAPTURE
+  // Write any frames the renderer is still reading back or encoding
+  if( re.FlushVideoFrames )
+    re.FlushVideoFrames( );
+#endif
+
   afd.fileOpen = qfalse;
 
   FS_Seek( afd.idxF, 4, FS_SEEK_SET );
@@ -3337,6 +3337,10 @@ void CL_Frame ( int msec ) {
 		VM_Call( uivm, UI_SET_ACTIVE_MENU, UIMENU_MAIN );
 	}
 
+#ifdef CMOD_DEMO_RENDER
+	CMDemoRender_Frame();
+#endif
+
 	// if recording an avi, lock to a fixed fps
 	if ( CL_VideoRecording( ) && cl_aviFrameRate->integer && msec) {
 		// save the current screen
@@ -3484,6 +3488,10 @@ void CL_ShutdownRef( void ) {
 
 #ifdef USE_RENDERER_DLOPEN
 	if ( rendererLib ) {
+#ifdef CMOD_FRAME_TRACE
+		// recorded renderer span names point into the library
+		CMTrace_DiscardEvents();
+#endif
 		Sys_UnloadLibrary( rendererLib );
 		rendererLib = NULL;
 	}
@@ -3715,6 +3723,15 @@ void CL_InitRef( void ) {
 	ri.FS_GetFileExtension = FS_GetFileExtension;
 	ri.FS_CheckFilesFromSamePk3 = FS_CheckFilesFromSamePk3;
 #endif
+#if defined(CMOD_ASYNC_VIDEO_CAPTURE) || defined(CMOD_PARALLEL_IMAGE_LOAD)
+	ri.Thread_Create = CMThread_Create;
+	ri.Thread_Join = CMThread_Join;
+	ri.Thread_ProcessorCount = CMThread_ProcessorCount;
+#endif
+#ifdef CMOD_FRAME_TRACE
+	ri.Trace_BeginSpan = CMTrace_BeginSpan;
+	ri.Trace_EndSpan = CMTrace_EndSpan;
+#endif
 
 	ret = GetRefAPI( REF_API_VERSION, &ri );
 
@@ -4129,6 +4146,12 @@ void CL_Init( void ) {
 	Cmd_AddCommand ("record", CL_Record_f);
 	Cmd_AddCommand ("demo", CL_PlayDemo_f);
 	Cmd_SetCommandCompletionFunc( "demo", CL_CompleteDemoName );
+#ifdef CMOD_DEMO_SEEK
+	Cmd_AddCommand ("demo_seek", CMDemoSeek_Cmd);
+#endif
+#ifdef CMOD_DEMO_RENDER
+	Cmd_AddCommand ("demo_render", CMDemoRender_Cmd);
+#endif
 	Cmd_AddCommand ("cinematic", CL_PlayCinematic_f);
 	Cmd_AddCommand ("stoprecord", CL_StopRecord_f);
 	Cmd_AddCommand ("connect", CL_Connect_f);
@@ -4209,6 +4232,12 @@ void CL_Shutdown(char *finalmsg, qboolean disconnect, qboolean quit)
 	Cmd_RemoveCommand ("disconnect");
 	Cmd_RemoveCommand ("record");
 	Cmd_RemoveCommand ("demo");
+#ifdef CMOD_DEMO_SEEK
+	Cmd_RemoveCommand ("demo_seek");
+#endif
+#ifdef CMOD_DEMO_RENDER
+	Cmd_RemoveCommand ("demo_render");
+#endif
 	Cmd_RemoveCommand ("cinematic");
 	Cmd_RemoveCommand ("stoprecord");
 	Cmd_RemoveCommand ("connect");
@@ -598,6 +598,11 @@ void CL_ParseGamestate( msg_t *msg ) {
 	FS_ConditionalRestart(clc.checksumFeed, qfalse);
 #endif
 
+#ifdef CMOD_DEMO_SEEK
+	// save gamestate for demo seeking
+	CMDemoSeek_OnGamestate();
+#endif
+
 	// This used to call CL_StartHunkUsers, but now we enter the download state before loading the
 	// cgame
 	CL_InitDownloads();
@@ -322,7 +322,120 @@ S_CodecUtilClose
 */
 void S_CodecUtilClose(snd_stream_t **stream)
 {
+#ifdef CMOD_SOUND_ASYNC_LOAD
+	if((*stream)->file)
+		FS_FCloseFile((*stream)->file);
+	free((*stream)->memData);
+#else
 	FS_FCloseFile((*stream)->file);
+#endif
 	Z_Free(*stream);
 	*stream = NULL;
 }
+
+#ifdef CMOD_SOUND_ASYNC_LOAD
+/*
+=================
+S_CodecUtilLoadToMemory
+
+Reads the rest of the stream file into memory and closes the file handle, so the stream
+can be decoded on sound loader threads without filesystem access.
+=================
+*/
+qboolean S_CodecUtilLoadToMemory(snd_stream_t *stream)
+{
+	int pos;
+
+	if(stream->memData)
+		return qtrue;
+	if(stream->length <= 0)
+		return qfalse;
+
+	stream->memData = malloc(stream->length);
+	if(!stream->memData)
+		return qfalse;
+
+	pos = FS_FTell(stream->file);
+	FS_Seek(stream->file, 0, FS_SEEK_SET);
+	if(FS_Read(stream->memData, stream->length, stream->file) != stream->length)
+	{
+		free(stream->memData);
+		stream->memData = NULL;
+		FS_Seek(stream->file, pos, FS_SEEK_SET);
+		return qfalse;
+	}
+
+	stream->memPos = pos;
+	FS_FCloseFile(stream->file);
+	stream->file = 0;
+	return qtrue;
+}
+
+/*
+=================
+S_CodecUtilRead
+
+Codec file read that works for both file and memory streams.
+=================
+*/
+int S_CodecUtilRead(snd_stream_t *stream, void *buffer, int len)
+{
+	if(!stream->memData)
+		return FS_Read(buffer, len, stream->file);
+
+	if(len > stream->length - stream->memPos)
+		len = stream->length - stream->memPos;
+	if(len <= 0)
+		return 0;
+
+	Com_Memcpy(buffer, stream->memData + stream->memPos, len);
+	stream->memPos += len;
+	return len;
+}
+
+/*
+=================
+S_CodecUtilSeek
+=================
+*/
+int S_CodecUtilSeek(snd_stream_t *stream, long offset, int origin)
+{
+	long pos;
+
+	if(!stream->memData)
+		return FS_Seek(stream->file, offset, origin);
+
+	switch(origin)
+	{
+		case FS_SEEK_SET:
+			pos = offset;
+			break;
+		case FS_SEEK_CUR:
+			pos = stream->memPos + offset;
+			break;
+		case FS_SEEK_END:
+			pos = stream->length + offset;
+			break;
+		default:
+			return -1;
+	}
+
+	if(pos < 0 || pos > stream->length)
+		return -1;
+
+	stream->memPos = (int)pos;
+	return 0;
+}
+
+/*
+=================
+S_CodecUtilTell
+=================
+*/
+int S_CodecUtilTell(snd_stream_t *stream)
+{
+	if(!stream->memData)
+		return FS_FTell(stream->file);
+	return stream->memPos;
+}
+#endif
@@ -47,6 +47,10 @@ typedef struct snd_stream_s
 	int length;
 	int pos;
 	void *ptr;
+#ifdef CMOD_SOUND_ASYNC_LOAD
+	byte *memData;		// file contents, if loaded into memory for decoding on other threads
+	int memPos;
+#endif
 } snd_stream_t;
 
 // Codec functions
@@ -78,6 +82,12 @@ int S_CodecReadStream(snd_stream_t *stream, int bytes, void *buffer);
 // Util functions (used by codecs)
 snd_stream_t *S_CodecUtilOpen(const char *filename, snd_codec_t *codec);
 void S_CodecUtilClose(snd_stream_t **stream);
+#ifdef CMOD_SOUND_ASYNC_LOAD
+qboolean S_CodecUtilLoadToMemory(snd_stream_t *stream);
+int S_CodecUtilRead(snd_stream_t *stream, void *buffer, int len);
+int S_CodecUtilSeek(snd_stream_t *stream, long offset, int origin);
+int S_CodecUtilTell(snd_stream_t *stream);
+#endif
 
 // WAV Codec
 extern snd_codec_t wav_codec;
@@ -86,7 +86,11 @@ size_t S_OGG_Callback_read(void *ptr, size_t size, size_t nmemb, void *datasourc
 	byteSize = nmemb * size;
 
 	// read it with the Q3 function FS_Read()
+#ifdef CMOD_SOUND_ASYNC_LOAD
+	bytesRead = S_CodecUtilRead(stream, ptr, byteSize);
+#else
 	bytesRead = FS_Read(ptr, byteSize, stream->file);
+#endif
 
 	// update the file position
 	stream->pos += bytesRead;
@@ -126,7 +130,11 @@ int S_OGG_Callback_seek(void *datasource, ogg_int64_t offset, int whence)
 		case SEEK_SET :
 		{
 			// set the file position in the actual file with the Q3 function
+#ifdef CMOD_SOUND_ASYNC_LOAD
+			retVal = S_CodecUtilSeek(stream, (long) offset, FS_SEEK_SET);
+#else
 			retVal = FS_Seek(stream->file, (long) offset, FS_SEEK_SET);
+#endif
 
 			// something has gone wrong, so we return here
 			if(retVal < 0)
@@ -142,7 +150,11 @@ int S_OGG_Callback_seek(void *datasource, ogg_int64_t offset, int whence)
 		case SEEK_CUR :
 		{
 			// set the file position in the actual file with the Q3 function
+#ifdef CMOD_SOUND_ASYNC_LOAD
+			retVal = S_CodecUtilSeek(stream, (long) offset, FS_SEEK_CUR);
+#else
 			retVal = FS_Seek(stream->file, (long) offset, FS_SEEK_CUR);
+#endif
 
 			// something has gone wrong, so we return here
 			if(retVal < 0)
@@ -158,7 +170,11 @@ int S_OGG_Callback_seek(void *datasource, ogg_int64_t offset, int whence)
 		case SEEK_END :
 		{
 			// set the file position in the actual file with the Q3 function
+#ifdef CMOD_SOUND_ASYNC_LOAD
+			retVal = S_CodecUtilSeek(stream, (long) offset, FS_SEEK_END);
+#else
 			retVal = FS_Seek(stream->file, (long) offset, FS_SEEK_END);
+#endif
 
 			// something has gone wrong, so we return here
 			if(retVal < 0)
@@ -208,7 +224,11 @@ long S_OGG_Callback_tell(void *datasource)
 	// snd_stream_t in the generic pointer
 	stream = (snd_stream_t *) datasource;
 
+#ifdef CMOD_SOUND_ASYNC_LOAD
+	return (long) S_CodecUtilTell(stream);
+#else
 	return (long) FS_FTell(stream->file);
+#endif
 }
 
 // the callback structure
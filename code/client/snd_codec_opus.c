@@ -85,7 +85,11 @@ int S_OggOpus_Callback_read(void *datasource, unsigned char *ptr, int size )
 	stream = (snd_stream_t *) datasource;
 
 	// read it with the Q3 function FS_Read()
+#ifdef CMOD_SOUND_ASYNC_LOAD
+	bytesRead = S_CodecUtilRead(stream, ptr, size);
+#else
 	bytesRead = FS_Read(ptr, size, stream->file);
+#endif
 
 	// update the file position
 	stream->pos += bytesRead;
@@ -115,7 +119,11 @@ int S_OggOpus_Callback_seek(void *datasource, opus_int64 offset, int whence)
 		case SEEK_SET :
 		{
 			// set the file position in the actual file with the Q3 function
+#ifdef CMOD_SOUND_ASYNC_LOAD
+			retVal = S_CodecUtilSeek(stream, (long) offset, FS_SEEK_SET);
+#else
 			retVal = FS_Seek(stream->file, (long) offset, FS_SEEK_SET);
+#endif
 
 			// something has gone wrong, so we return here
 			if(retVal < 0)
@@ -131,7 +139,11 @@ int S_OggOpus_Callback_seek(void *datasource, opus_int64 offset, int whence)
 		case SEEK_CUR :
 		{
 			// set the file position in the actual file with the Q3 function
+#ifdef CMOD_SOUND_ASYNC_LOAD
+			retVal = S_CodecUtilSeek(stream, (long) offset, FS_SEEK_CUR);
+#else
 			retVal = FS_Seek(stream->file, (long) offset, FS_SEEK_CUR);
+#endif
 
 			// something has gone wrong, so we return here
 			if(retVal < 0)
@@ -147,7 +159,11 @@ int S_OggOpus_Callback_seek(void *datasource, opus_int64 offset, int whence)
 		case SEEK_END :
 		{
 			// set the file position in the actual file with the Q3 function
+#ifdef CMOD_SOUND_ASYNC_LOAD
+			retVal = S_CodecUtilSeek(stream, (long) offset, FS_SEEK_END);
+#else
 			retVal = FS_Seek(stream->file, (long) offset, FS_SEEK_END);
+#endif
 
 			// something has gone wrong, so we return here
 			if(retVal < 0)
@@ -197,7 +213,11 @@ opus_int64 S_OggOpus_Callback_tell(void *datasource)
 	// snd_stream_t in the generic pointer
 	stream = (snd_stream_t *) datasource;
 
+#ifdef CMOD_SOUND_ASYNC_LOAD
+	return (opus_int64) S_CodecUtilTell(stream);
+#else
 	return (opus_int64) FS_FTell(stream->file);
+#endif
 }
 
 // the callback structure
@@ -311,7 +311,11 @@ int S_WAV_CodecReadStream(snd_stream_t *stream, int bytes, void *buffer)
 		bytes = remaining;
 	stream->pos += bytes;
 	samples = (bytes / stream->info.width) / stream->info.channels;
+#ifdef CMOD_SOUND_ASYNC_LOAD
+	S_CodecUtilRead(stream, buffer, bytes);
+#else
 	FS_Read(buffer, bytes, stream->file);
+#endif
 	S_ByteSwapRawSamples(samples, stream->info.width, stream->info.channels, buffer);
 	return bytes;
 }
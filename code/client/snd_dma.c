@@ -203,6 +203,10 @@ void S_ResetStaleSounds( void ) {
 					++resetCount;
 					Com_DPrintf( "Resetting sound %s\n", sfx->soundName );
 
+#ifdef CMOD_SOUND_MIX_THREAD
+					S_MixThread_StopSfx( sfx );
+#endif
+
 					buffer = sfx->soundData;
 					while ( buffer != NULL ) {
 						nbuffer = buffer->next;
@@ -443,10 +447,22 @@ sfxHandle_t	S_Base_RegisterSound( const char *name, qboolean compressed ) {
 		return sfx - s_knownSfx;
 	}
 
+#ifdef CMOD_SOUND_ASYNC_LOAD
+	if ( sfx->loadPending ) {
+		return sfx - s_knownSfx;
+	}
+#endif
+
 	sfx->inMemory = qfalse;
 	sfx->soundCompressed = compressed;
 
+#ifdef CMOD_SOUND_ASYNC_LOAD
+	if ( !S_AsyncLoad_QueueSound( sfx ) ) {
+		S_memoryLoad( sfx );
+	}
+#else
   S_memoryLoad(sfx);
+#endif
 
 	if ( sfx->defaultSound ) {
 #ifdef ELITEFORCE
@@ -490,6 +506,12 @@ void S_Base_BeginRegistration( void ) {
 }
 
 void S_memoryLoad(sfx_t	*sfx) {
+#ifdef CMOD_SOUND_CACHE
+	if ( S_SoundCache_Load( sfx ) ) {
+		return;
+	}
+#endif
+
 	// load the sound file
 	if ( !S_LoadSound ( sfx ) ) {
 //		Com_Printf( S_COLOR_YELLOW "WARNING: couldn't load sound: %s\n", sfx->soundName );
@@ -499,6 +521,9 @@ void S_memoryLoad(sfx_t	*sfx) {
 #ifdef CMOD_FAST_SOUND_RESET
 	sfx->soundFile = S_PredictSoundFileForPath( sfx->soundName );
 #endif
+#ifdef CMOD_SOUND_CACHE
+	S_SoundCache_Store( sfx );
+#endif
 }
 
 //=============================================================================
@@ -639,6 +664,12 @@ static void S_Base_StartSoundEx( vec3_t origin, int entityNum, int entchannel, s
 		S_memoryLoad(sfx);
 	}
 
+#ifdef CMOD_SOUND_ASYNC_LOAD
+	if ( sfx->loadPending ) {
+		S_AsyncLoad_Prioritize( sfx );
+	}
+#endif
+
 	if ( s_show->integer == 1 ) {
 		Com_Printf( "%i : %s\n", s_paintedtime, sfx->soundName );
 	}
@@ -749,6 +780,10 @@ static void S_Base_StartSoundEx( vec3_t origin, int entityNum, int entchannel, s
 	ch->rightvol = ch->master_vol;		// unless the game isn't running
 	ch->doppler = qfalse;
 	ch->fullVolume = fullVolume;
+
+#ifdef CMOD_SOUND_MIX_THREAD
+	S_MixThread_StartChannel( ch );
+#endif
 }
 
 /*
@@ -810,6 +845,9 @@ void S_Base_ClearSoundBuffer( void ) {
 		clear = 0;
 
 	SNDDMA_BeginPainting ();
+#ifdef CMOD_SOUND_MIX_THREAD
+	S_MixThread_Clear();
+#endif
 	if (dma.buffer)
 		Com_Memset(dma.buffer, clear, dma.samples * dma.samplebits/8);
 	SNDDMA_Submit ();
@@ -854,7 +892,12 @@ S_ClearLoopingSounds
 void S_Base_ClearLoopingSounds( qboolean killall ) {
 	int i;
 	for ( i = 0 ; i < MAX_GENTITIES ; i++) {
+#ifdef CMOD_SOUND_ASYNC_LOAD
+		if (killall || loopSounds[i].kill == qtrue || (loopSounds[i].sfx && loopSounds[i].sfx->soundLength == 0 &&
+				!loopSounds[i].sfx->loadPending)) {
+#else
 		if (killall || loopSounds[i].kill == qtrue || (loopSounds[i].sfx && loopSounds[i].sfx->soundLength == 0)) {
+#endif
 			S_Base_StopLoopingSound(i);
 		}
 	}
@@ -887,6 +930,11 @@ void S_Base_AddLoopingSound( int entityNum, const vec3_t origin, const vec3_t ve
 		S_memoryLoad(sfx);
 	}
 
+#ifdef CMOD_SOUND_ASYNC_LOAD
+	if ( sfx->loadPending ) {
+		S_AsyncLoad_Prioritize( sfx );
+	} else
+#endif
 	if ( !sfx->soundLength ) {
 		Com_Error( ERR_DROP, "%s has length 0", sfx->soundName );
 	}
@@ -950,6 +998,11 @@ void S_Base_AddRealLoopingSound( int entityNum, const vec3_t origin, const vec3_
 		S_memoryLoad(sfx);
 	}
 
+#ifdef CMOD_SOUND_ASYNC_LOAD
+	if ( sfx->loadPending ) {
+		S_AsyncLoad_Prioritize( sfx );
+	} else
+#endif
 	if ( !sfx->soundLength ) {
 		Com_Error( ERR_DROP, "%s has length 0", sfx->soundName );
 	}
@@ -1087,6 +1140,12 @@ void S_Base_RawSamples( int stream, int samples, int rate, int width, int numCha
 	float	scale;
 	int		intVolumeLeft, intVolumeRight;
 	portable_samplepair_t *rawsamples;
+#ifdef CMOD_SOUND_MIX_THREAD
+	// may be mixing in the audio thread, which updates s_soundtime
+	int		soundtime = S_MixThread_SoundTime();
+#else
+	int		soundtime = s_soundtime;
+#endif
 
 	if ( !s_soundStarted || s_soundMuted ) {
 		return;
@@ -1114,9 +1173,9 @@ void S_Base_RawSamples( int stream, int samples, int rate, int width, int numCha
 		intVolumeRight = rightvol * volume * s_volume->value;
 	}
 
-	if ( s_rawend[stream] < s_soundtime ) {
-		Com_DPrintf( "S_Base_RawSamples: resetting minimum: %i < %i\n", s_rawend[stream], s_soundtime );
-		s_rawend[stream] = s_soundtime;
+	if ( s_rawend[stream] < soundtime ) {
+		Com_DPrintf( "S_Base_RawSamples: resetting minimum: %i < %i\n", s_rawend[stream], soundtime );
+		s_rawend[stream] = soundtime;
 	}
 
 	scale = (float)rate / dma.speed;
@@ -1194,8 +1253,8 @@ void S_Base_RawSamples( int stream, int samples, int rate, int width, int numCha
 		}
 	}
 
-	if ( s_rawend[stream] > s_soundtime + MAX_RAW_SAMPLES ) {
-		Com_DPrintf( "S_Base_RawSamples: overflowed %i > %i\n", s_rawend[stream], s_soundtime );
+	if ( s_rawend[stream] > soundtime + MAX_RAW_SAMPLES ) {
+		Com_DPrintf( "S_Base_RawSamples: overflowed %i > %i\n", s_rawend[stream], soundtime );
 	}
 }
 
@@ -1261,6 +1320,10 @@ void S_Base_Respatialize( int entityNum, const vec3_t head, vec3_t axis[3], int
 
 	// add loopsounds
 	S_AddLoopSounds ();
+
+#ifdef CMOD_SOUND_MIX_THREAD
+	S_MixThread_Respatialize();
+#endif
 }
 
 
@@ -1275,6 +1338,12 @@ qboolean S_ScanChannelStarts( void ) {
 	channel_t		*ch;
 	int				i;
 	qboolean		newSamples;
+#ifdef CMOD_SOUND_MIX_THREAD
+	// may be mixing in the audio thread, which updates s_paintedtime
+	int				paintedtime = S_MixThread_PaintedTime();
+#else
+	int				paintedtime = s_paintedtime;
+#endif
 
 	newSamples = qfalse;
 	ch = s_channels;
@@ -1283,17 +1352,30 @@ qboolean S_ScanChannelStarts( void ) {
 		if ( !ch->thesfx ) {
 			continue;
 		}
+#ifdef CMOD_SOUND_ASYNC_LOAD
+		// don't start the sound until it finishes loading, and drop it
+		// if it would be delayed too long
+		if ( ch->thesfx->loadPending ) {
+			if ( Com_Milliseconds() - ch->allocTime > S_ASYNC_MAX_DEFER_MSEC ) {
+				S_ChannelFree( ch );
+#ifdef CMOD_SOUND_MIX_THREAD
+				S_MixThread_StartChannel( ch );
+#endif
+			}
+			continue;
+		}
+#endif
 		// if this channel was just started this frame,
 		// set the sample count to it begins mixing
 		// into the very first sample
 		if ( ch->startSample == START_SAMPLE_IMMEDIATE ) {
-			ch->startSample = s_paintedtime;
+			ch->startSample = paintedtime;
 			newSamples = qtrue;
 			continue;
 		}
 
 		// if it is completely finished by now, clear it
-		if ( ch->startSample + (ch->thesfx->soundLength) <= s_paintedtime ) {
+		if ( ch->startSample + (ch->thesfx->soundLength) <= paintedtime ) {
 			S_ChannelFree(ch);
 		}
 	}
@@ -1318,6 +1400,13 @@ void S_Base_Update( void ) {
 		return;
 	}
 
+#ifdef CMOD_SOUND_MIX_SIMD
+	// select kernels here rather than in the mixer, which may be running in the audio thread
+	if ( s_mixSimd->modified ) {
+		S_MixSimd_Select();
+	}
+#endif
+
 	//
 	// debugging output
 	//
@@ -1334,9 +1423,22 @@ void S_Base_Update( void ) {
 		Com_Printf ("----(%i)---- painted: %i\n", total, s_paintedtime);
 	}
 
+#ifdef CMOD_SOUND_ASYNC_LOAD
+	// finish sounds loaded in the background
+	S_AsyncLoad_Update();
+#endif
+
 	// add raw data from streamed samples
 	S_UpdateBackgroundTrack();
 
+#ifdef CMOD_SOUND_MIX_THREAD
+	// if mixing in the audio thread, just free finished channels
+	if ( S_MixThread_Update() ) {
+		S_ScanChannelStarts();
+		return;
+	}
+#endif
+
 	// mix some sound
 	S_Update_();
 }
@@ -1442,6 +1544,18 @@ void S_Update_(void) {
 	if (endtime - s_soundtime > dma.fullsamples)
 		endtime = s_soundtime + dma.fullsamples;
 
+#ifdef CMOD_DEMO_RENDER
+	// When rendering a demo offline, paint exactly up to the current frame time so the audio
+	// written for each frame matches the frame duration. The first frame discards any sound
+	// already mixed ahead.
+	if ( CMDemoRender_Active() ) {
+		if ( s_paintedtime > s_soundtime ) {
+			s_paintedtime = s_soundtime;
+		}
+		endtime = s_soundtime;
+	}
+#endif
+
 
 
 	SNDDMA_BeginPainting ();
@@ -1471,6 +1585,9 @@ S_StopBackgroundTrack
 void S_Base_StopBackgroundTrack( void ) {
 	if(!s_backgroundStream)
 		return;
+#ifdef CMOD_SOUND_ASYNC_LOAD
+	S_AsyncStream_Stop();
+#endif
 	S_CodecCloseStream(s_backgroundStream);
 	s_backgroundStream = NULL;
 	s_rawend[0] = 0;
@@ -1486,6 +1603,9 @@ static void S_OpenBackgroundStream( const char *filename ) {
 	// if restarting the same back ground track
 	if(s_backgroundStream)
 	{
+#ifdef CMOD_SOUND_ASYNC_LOAD
+		S_AsyncStream_Stop();
+#endif
 		S_CodecCloseStream(s_backgroundStream);
 		s_backgroundStream = NULL;
 	}
@@ -1511,6 +1631,10 @@ static void S_OpenBackgroundStream( const char *filename ) {
 		Com_Printf(S_COLOR_YELLOW "WARNING: music file %s is not 22k stereo\n", filename );
 	}
 #endif
+
+#ifdef CMOD_SOUND_ASYNC_LOAD
+	S_AsyncStream_Start( s_backgroundStream );
+#endif
 }
 
 /*
@@ -1549,6 +1673,12 @@ void S_UpdateBackgroundTrack( void ) {
 	byte	raw[30000];		// just enough to fit in a mac stack frame
 	int		fileBytes;
 	int		r;
+#ifdef CMOD_SOUND_MIX_THREAD
+	// may be mixing in the audio thread, which updates s_soundtime
+	int		soundtime = S_MixThread_SoundTime();
+#else
+	int		soundtime = s_soundtime;
+#endif
 
 	if(!s_backgroundStream) {
 		return;
@@ -1560,12 +1690,12 @@ void S_UpdateBackgroundTrack( void ) {
 	}
 
 	// see how many samples should be copied into the raw buffer
-	if ( s_rawend[0] < s_soundtime ) {
-		s_rawend[0] = s_soundtime;
+	if ( s_rawend[0] < soundtime ) {
+		s_rawend[0] = soundtime;
 	}
 
-	while ( s_rawend[0] < s_soundtime + MAX_RAW_SAMPLES ) {
-		bufferSamples = MAX_RAW_SAMPLES - (s_rawend[0] - s_soundtime);
+	while ( s_rawend[0] < soundtime + MAX_RAW_SAMPLES ) {
+		bufferSamples = MAX_RAW_SAMPLES - (s_rawend[0] - soundtime);
 
 		// decide how much data needs to be read from the file
 		fileSamples = bufferSamples * s_backgroundStream->info.rate / dma.speed;
@@ -1581,7 +1711,15 @@ void S_UpdateBackgroundTrack( void ) {
 		}
 
 		// Read
+#ifdef CMOD_SOUND_ASYNC_LOAD
+		r = S_AsyncStream_Read(s_backgroundStream, fileBytes, raw);
+		if ( r < 0 ) {
+			// still decoding
+			return;
+		}
+#else
 		r = S_CodecReadStream(s_backgroundStream, fileBytes, raw);
+#endif
 		if(r < fileBytes)
 		{
 			fileSamples = r / (s_backgroundStream->info.width * s_backgroundStream->info.channels);
@@ -1629,6 +1767,11 @@ void S_FreeOldestSound( void ) {
 
 	for (i=1 ; i < s_numSfx ; i++) {
 		sfx = &s_knownSfx[i];
+#ifdef CMOD_SOUND_ASYNC_LOAD
+		if ( sfx->loadPending ) {
+			continue;
+		}
+#endif
 		if (sfx->inMemory && sfx->lastTimeUsed<oldest) {
 			used = i;
 			oldest = sfx->lastTimeUsed;
@@ -1639,6 +1782,10 @@ void S_FreeOldestSound( void ) {
 
 	Com_DPrintf("S_FreeOldestSound: freeing sound %s\n", sfx->soundName);
 
+#ifdef CMOD_SOUND_MIX_THREAD
+	S_MixThread_StopSfx( sfx );
+#endif
+
 	buffer = sfx->soundData;
 	while(buffer != NULL) {
 		nbuffer = buffer->next;
@@ -1658,13 +1805,22 @@ void S_Base_Shutdown( void ) {
 		return;
 	}
 
+#ifdef CMOD_SOUND_ASYNC_LOAD
+	S_AsyncLoad_Shutdown();
+#endif
 	SNDDMA_Shutdown();
+#ifdef CMOD_SOUND_MIX_THREAD
+	S_MixThread_Shutdown();
+#endif
 	SND_shutdown();
 
 	s_soundStarted = 0;
 	s_numSfx = 0;
 
 	Cmd_RemoveCommand("s_info");
+#ifdef CMOD_SOUND_MIX_SIMD
+	Cmd_RemoveCommand("s_mixBenchmark");
+#endif
 }
 
 /*
@@ -1696,7 +1852,22 @@ qboolean S_Base_Init( soundInterface_t *si ) {
 		s_soundtime = 0;
 		s_paintedtime = 0;
 
+#ifdef CMOD_SOUND_MIX_THREAD
+		S_MixThread_Init( );
+#endif
+#ifdef CMOD_SOUND_ASYNC_LOAD
+		S_AsyncLoad_Init( );
+#endif
+#ifdef CMOD_SOUND_CACHE
+		S_SoundCache_Init( );
+#endif
+
 		S_Base_StopAllSounds( );
+
+#ifdef CMOD_SOUND_MIX_SIMD
+		S_MixSimd_Select( );
+		Cmd_AddCommand( "s_mixBenchmark", S_MixSimd_Benchmark_f );
+#endif
 	} else {
 		return qfalse;
 	}
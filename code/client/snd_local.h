@@ -60,6 +60,9 @@ typedef struct sfx_s {
 	char 			soundName[MAX_QPATH];
 #ifdef CMOD_FAST_SOUND_RESET
 	const fsc_file_t *soundFile;
+#endif
+#ifdef CMOD_SOUND_ASYNC_LOAD
+	qboolean		loadPending;			// queued for decoding by sound loader threads
 #endif
 	int				lastTimeUsed;
 	struct sfx_s	*next;
@@ -272,3 +275,65 @@ qboolean S_AL_Init( soundInterface_t *si );
 #ifdef idppc_altivec
 void S_PaintChannelFrom16_altivec( portable_samplepair_t paintbuffer[PAINTBUFFER_SIZE], int snd_vol, channel_t *ch, const sfx_t *sc, int count, int sampleOffset, int bufferOffset );
 #endif
+
+#ifdef CMOD_SOUND_MIX_SIMD
+typedef struct {
+	const char *name;
+	// adds count frames of mono or stereo samples, scaled by volume, to samp
+	void ( *paint16 )( portable_samplepair_t *samp, const short *samples, int count, int leftvol, int rightvol, int channels );
+	// converts count paint buffer values to clamped 16-bit samples
+	void ( *transfer16 )( const int *src, short *dst, int count );
+} sndMixKernels_t;
+
+extern sndMixKernels_t sndMixKernels;
+void S_MixSimd_Select( void );
+void S_MixSimd_Apply( void );
+void S_MixSimd_Benchmark_f( void );
+#endif
+
+#ifdef CMOD_FAST_SOUND_RESET
+const fsc_file_t *S_PredictSoundFileForPath( const char *path );
+#endif
+
+#if defined(CMOD_SOUND_ASYNC_LOAD) || defined(CMOD_SOUND_CACHE)
+sndBuffer *S_CopyToSoundMemory( const short *samples, int count );
+#endif
+
+#ifdef CMOD_SOUND_CACHE
+qboolean S_SoundCache_Load( sfx_t *sfx );
+void S_SoundCache_Store( const sfx_t *sfx );
+void S_SoundCache_Init( void );
+#endif
+
+#ifdef CMOD_SOUND_ASYNC_LOAD
+// sounds still loading when started are dropped if not ready within this time
+#define S_ASYNC_MAX_DEFER_MSEC 250
+
+struct snd_stream_s;
+void S_DefaultSound( sfx_t *sfx );
+short *S_ResampleToBuffer( int channels, int inrate, int inwidth, int samples, const byte *data, int *outcount );
+qboolean S_AsyncLoad_QueueSound( sfx_t *sfx );
+void S_AsyncLoad_Prioritize( sfx_t *sfx );
+void S_AsyncStream_Start( struct snd_stream_s *stream );
+void S_AsyncStream_Stop( void );
+int S_AsyncStream_Read( struct snd_stream_s *stream, int bytes, void *buffer );
+void S_AsyncLoad_Update( void );
+void S_AsyncLoad_Init( void );
+void S_AsyncLoad_Shutdown( void );
+#endif
+
+#ifdef CMOD_SOUND_MIX_THREAD
+extern int s_soundtime;
+void S_PaintChannelsFrom( int endtime, channel_t *channels, channel_t *loopChannels, int numLoops, const int *rawend );
+qboolean S_MixThread_Active( void );
+int S_MixThread_PaintedTime( void );
+int S_MixThread_SoundTime( void );
+void S_MixThread_StartChannel( const channel_t *ch );
+void S_MixThread_Respatialize( void );
+void S_MixThread_StopSfx( const sfx_t *sfx );
+void S_MixThread_Clear( void );
+qboolean S_MixThread_Update( void );
+void S_MixThread_Init( void );
+void S_MixThread_Shutdown( void );
+int S_MixThread_Paint( int samples );
+#endif
@@ -229,6 +229,18 @@ S_Update
 */
 void S_Update( void )
 {
+#ifdef CMOD_DEMO_RENDER
+	// don't mute offline demo renders when running in the background
+	if( CMDemoRender_Active() )
+	{
+		if(s_muted->integer)
+		{
+			s_muted->integer = qfalse;
+			s_muted->modified = qtrue;
+		}
+	}
+	else
+#endif
 	if(s_muted->integer)
 	{
 		if(!(s_muteWhenMinimized->integer && com_minimized->integer) &&
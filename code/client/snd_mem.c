@@ -202,6 +202,81 @@ static int ResampleSfxRaw( short *sfx, int channels, int inrate, int inwidth, in
 	return outcount;
 }
 
+#ifdef CMOD_SOUND_ASYNC_LOAD
+/*
+================
+S_ResampleToBuffer
+
+Same as ResampleSfx, but writes to a new malloc'd buffer instead of sound memory, so it can
+be called from sound loader threads. Returns NULL on error.
+================
+*/
+short *S_ResampleToBuffer( int channels, int inrate, int inwidth, int samples, const byte *data, int *outcount ) {
+	int		srcsample;
+	float	stepscale;
+	int		i, j;
+	int		samplefrac, fracstep;
+	short	*out;
+
+	stepscale = (float)inrate / dma.speed;	// this is usually 0.5, 1, or 2
+
+	*outcount = samples / stepscale;
+	out = malloc( ( *outcount * channels + 1 ) * sizeof( *out ) );
+	if ( !out ) {
+		return NULL;
+	}
+
+	srcsample = 0;
+	samplefrac = 0;
+	fracstep = stepscale * 256 * channels;
+
+	for (i=0 ; i<*outcount ; i++)
+	{
+		srcsample += samplefrac >> 8;
+		samplefrac &= 255;
+		samplefrac += fracstep;
+		for (j=0 ; j<channels ; j++)
+		{
+			if( inwidth == 2 ) {
+				out[i*channels+j] = ( ((const short *)data)[srcsample+j] );
+			} else {
+				out[i*channels+j] = (unsigned int)( (unsigned char)(data[srcsample+j]) - 128) << 8;
+			}
+		}
+	}
+
+	return out;
+}
+#endif
+
+#if defined(CMOD_SOUND_ASYNC_LOAD) || defined(CMOD_SOUND_CACHE)
+/*
+================
+S_CopyToSoundMemory
+
+Copies samples into a new sound memory chunk list.
+================
+*/
+sndBuffer *S_CopyToSoundMemory( const short *samples, int count ) {
+	sndBuffer	*first = NULL;
+	sndBuffer	*chunk = NULL;
+	int			i;
+
+	for ( i = 0; i < count; i += SND_CHUNK_SIZE ) {
+		sndBuffer *newchunk = SND_malloc();
+		Com_Memcpy( newchunk->sndChunk, &samples[i], MIN( count - i, SND_CHUNK_SIZE ) * sizeof( short ) );
+		if ( chunk ) {
+			chunk->next = newchunk;
+		} else {
+			first = newchunk;
+		}
+		chunk = newchunk;
+	}
+
+	return first;
+}
+#endif
+
 //=============================================================================
 
 /*
@@ -35,6 +35,9 @@ short*   snd_out;
 
 void S_WriteLinearBlastStereo16 (void)
 {
+#ifdef CMOD_SOUND_MIX_SIMD
+	sndMixKernels.transfer16( snd_p, snd_out, snd_linear_count );
+#else
 	int		i;
 	int		val;
 
@@ -56,6 +59,7 @@ void S_WriteLinearBlastStereo16 (void)
 		else
 			snd_out[i+1] = val;
 	}
+#endif
 }
 
 #else   // MSVC on i386
@@ -133,7 +137,12 @@ void S_TransferStereo16 (unsigned long *pbuf, int endtime)
 		snd_p += snd_linear_count;
 		ls_paintedtime += (snd_linear_count>>1); // snd_linear_count / dma.channels
 
+#ifdef CMOD_SOUND_MIX_THREAD
+		// video recording switches to main thread mixing on the next update
+		if( CL_VideoRecording( ) && !S_MixThread_Active( ) )
+#else
 		if( CL_VideoRecording( ) )
+#endif
 			CL_WriteAVIAudioFrame( (byte *)snd_out, snd_linear_count << 1 ); // snd_linear_count * (dma.samplebits/8)
 	}
 }
@@ -259,7 +268,11 @@ CHANNEL MIXING
 */
 
 static void S_PaintChannelFrom16_scalar( channel_t *ch, const sfx_t *sc, int count, int sampleOffset, int bufferOffset ) {
+#ifdef CMOD_SOUND_MIX_SIMD
+	int						aoff, boff;
+#else
 	int						data, aoff, boff;
+#endif
 	int						leftvol, rightvol;
 	int						i, j;
 	portable_samplepair_t	*samp;
@@ -298,6 +311,25 @@ static void S_PaintChannelFrom16_scalar( channel_t *ch, const sfx_t *sc, int cou
 		leftvol = ch->leftvol*snd_vol;
 		rightvol = ch->rightvol*snd_vol;
 		samples = chunk->sndChunk;
+#ifdef CMOD_SOUND_MIX_SIMD
+		// mix each run of samples up to the end of a chunk
+		while ( count > 0 ) {
+			int run = ( SND_CHUNK_SIZE - sampleOffset ) / sc->soundChannels;
+			if ( run > count ) {
+				run = count;
+			}
+			sndMixKernels.paint16( samp, samples + sampleOffset, run, leftvol, rightvol, sc->soundChannels );
+			samp += run;
+			count -= run;
+			sampleOffset += run * sc->soundChannels;
+
+			if ( sampleOffset == SND_CHUNK_SIZE && count > 0 ) {
+				chunk = chunk->next;
+				samples = chunk->sndChunk;
+				sampleOffset = 0;
+			}
+		}
+#else
 		for ( i=0 ; i<count ; i++ ) {
 			data  = samples[sampleOffset++];
 			samp[i].left += (data * leftvol)>>8;
@@ -313,6 +345,7 @@ static void S_PaintChannelFrom16_scalar( channel_t *ch, const sfx_t *sc, int cou
 				sampleOffset = 0;
 			}
 		}
+#endif
 	} else {
 		fleftvol = ch->leftvol*snd_vol;
 		frightvol = ch->rightvol*snd_vol;
@@ -365,7 +398,9 @@ static void S_PaintChannelFrom16( channel_t *ch, const sfx_t *sc, int count, int
 }
 
 void S_PaintChannelFromWavelet( channel_t *ch, sfx_t *sc, int count, int sampleOffset, int bufferOffset ) {
+#ifndef CMOD_SOUND_MIX_SIMD
 	int						data;
+#endif
 	int						leftvol, rightvol;
 	int						i;
 	portable_samplepair_t	*samp;
@@ -392,6 +427,25 @@ void S_PaintChannelFromWavelet( channel_t *ch, sfx_t *sc, int count, int sampleO
 
 	samples = sfxScratchBuffer;
 
+#ifdef CMOD_SOUND_MIX_SIMD
+	while ( count > 0 ) {
+		int run = SND_CHUNK_SIZE*2 - sampleOffset;
+		if ( run > count ) {
+			run = count;
+		}
+		sndMixKernels.paint16( samp, samples + sampleOffset, run, leftvol, rightvol, 1 );
+		samp += run;
+		count -= run;
+		sampleOffset += run;
+
+		if (sampleOffset == SND_CHUNK_SIZE*2) {
+			chunk = chunk->next;
+			decodeWavelet(chunk, sfxScratchBuffer);
+			sfxScratchIndex++;
+			sampleOffset = 0;
+		}
+	}
+#else
 	for ( i=0 ; i<count ; i++ ) {
 		data  = samples[sampleOffset++];
 		samp[i].left += (data * leftvol)>>8;
@@ -404,10 +458,13 @@ void S_PaintChannelFromWavelet( channel_t *ch, sfx_t *sc, int count, int sampleO
 			sampleOffset = 0;
 		}
 	}
+#endif
 }
 
 void S_PaintChannelFromADPCM( channel_t *ch, sfx_t *sc, int count, int sampleOffset, int bufferOffset ) {
+#ifndef CMOD_SOUND_MIX_SIMD
 	int						data;
+#endif
 	int						leftvol, rightvol;
 	int						i;
 	portable_samplepair_t	*samp;
@@ -439,6 +496,25 @@ void S_PaintChannelFromADPCM( channel_t *ch, sfx_t *sc, int count, int sampleOff
 
 	samples = sfxScratchBuffer;
 
+#ifdef CMOD_SOUND_MIX_SIMD
+	while ( count > 0 ) {
+		int run = SND_CHUNK_SIZE*4 - sampleOffset;
+		if ( run > count ) {
+			run = count;
+		}
+		sndMixKernels.paint16( samp, samples + sampleOffset, run, leftvol, rightvol, 1 );
+		samp += run;
+		count -= run;
+		sampleOffset += run;
+
+		if (sampleOffset == SND_CHUNK_SIZE*4) {
+			chunk = chunk->next;
+			S_AdpcmGetSamples( chunk, sfxScratchBuffer);
+			sampleOffset = 0;
+			sfxScratchIndex++;
+		}
+	}
+#else
 	for ( i=0 ; i<count ; i++ ) {
 		data  = samples[sampleOffset++];
 		samp[i].left += (data * leftvol)>>8;
@@ -451,6 +527,7 @@ void S_PaintChannelFromADPCM( channel_t *ch, sfx_t *sc, int count, int sampleOff
 			sfxScratchIndex++;
 		}
 	}
+#endif
 }
 
 void S_PaintChannelFromMuLaw( channel_t *ch, sfx_t *sc, int count, int sampleOffset, int bufferOffset ) {
@@ -477,6 +554,28 @@ void S_PaintChannelFromMuLaw( channel_t *ch, sfx_t *sc, int count, int sampleOff
 
 	if (!ch->doppler) {
 		samples = (byte *)chunk->sndChunk + sampleOffset;
+#ifdef CMOD_SOUND_MIX_SIMD
+		// decode each run up to the end of a chunk, then mix it
+		while ( count > 0 ) {
+			short decoded[SND_CHUNK_SIZE*2];
+			int run = (byte *)chunk->sndChunk + (SND_CHUNK_SIZE*2) - samples;
+			if ( run > count ) {
+				run = count;
+			}
+			for ( i=0 ; i<run ; i++ ) {
+				decoded[i] = mulawToShort[samples[i]];
+			}
+			sndMixKernels.paint16( samp, decoded, run, leftvol, rightvol, 1 );
+			samp += run;
+			count -= run;
+			samples += run;
+
+			if ( count > 0 ) {
+				chunk = chunk->next;
+				samples = (byte *)chunk->sndChunk;
+			}
+		}
+#else
 		for ( i=0 ; i<count ; i++ ) {
 			data  = mulawToShort[*samples];
 			samp[i].left += (data * leftvol)>>8;
@@ -487,6 +586,7 @@ void S_PaintChannelFromMuLaw( channel_t *ch, sfx_t *sc, int count, int sampleOff
 				samples = (byte *)chunk->sndChunk;
 			}
 		}
+#endif
 	} else {
 		ooff = sampleOffset;
 		samples = (byte *)chunk->sndChunk;
@@ -512,7 +612,26 @@ void S_PaintChannelFromMuLaw( channel_t *ch, sfx_t *sc, int count, int sampleOff
 S_PaintChannels
 ===================
 */
+#ifdef CMOD_SOUND_MIX_THREAD
 void S_PaintChannels( int endtime ) {
+	S_PaintChannelsFrom( endtime, s_channels, loop_channels, numLoopChannels, s_rawend );
+}
+
+/*
+===================
+S_PaintChannelsFrom
+
+Paints the given channel set, so the mixer thread can paint from its own copy.
+===================
+*/
+void S_PaintChannelsFrom( int endtime, channel_t *channels, channel_t *loopChannels, int numLoops, const int *rawend ) {
+#else
+void S_PaintChannels( int endtime ) {
+	channel_t *channels = s_channels;
+	channel_t *loopChannels = loop_channels;
+	int numLoops = numLoopChannels;
+	const int *rawend = s_rawend;
+#endif
 	int 	i;
 	int 	end;
 	int 	stream;
@@ -526,6 +645,10 @@ void S_PaintChannels( int endtime ) {
 	else
 		snd_vol = s_volume->value*255;
 
+#ifdef CMOD_SOUND_MIX_SIMD
+	S_MixSimd_Apply();
+#endif
+
 //Com_Printf ("%i to %i\n", s_paintedtime, endtime);
 	while ( s_paintedtime < endtime ) {
 		// if paintbuffer is smaller than DMA buffer
@@ -538,10 +661,10 @@ void S_PaintChannels( int endtime ) {
 		// clear the paint buffer and mix any raw samples...
 		Com_Memset(paintbuffer, 0, sizeof (paintbuffer));
 		for (stream = 0; stream < MAX_RAW_STREAMS; stream++) {
-			if ( s_rawend[stream] >= s_paintedtime ) {
+			if ( rawend[stream] >= s_paintedtime ) {
 				// copy from the streaming sound source
 				const portable_samplepair_t *rawsamples = s_rawsamples[stream];
-				const int stop = (end < s_rawend[stream]) ? end : s_rawend[stream];
+				const int stop = (end < rawend[stream]) ? end : rawend[stream];
 				for ( i = s_paintedtime ; i < stop ; i++ ) {
 					const int s = i&(MAX_RAW_SAMPLES-1);
 					paintbuffer[i-s_paintedtime].left += rawsamples[s].left;
@@ -551,7 +674,7 @@ void S_PaintChannels( int endtime ) {
 		}
 
 		// paint in the channels.
-		ch = s_channels;
+		ch = channels;
 		for ( i = 0; i < MAX_CHANNELS ; i++, ch++ ) {		
 			if ( !ch->thesfx || (ch->leftvol<0.25 && ch->rightvol<0.25 )) {
 				continue;
@@ -584,8 +707,8 @@ void S_PaintChannels( int endtime ) {
 		}
 
 		// paint in the looped channels.
-		ch = loop_channels;
-		for ( i = 0; i < numLoopChannels ; i++, ch++ ) {		
+		ch = loopChannels;
+		for ( i = 0; i < numLoops ; i++, ch++ ) {		
 			if ( !ch->thesfx || (!ch->leftvol && !ch->rightvol )) {
 				continue;
 			}
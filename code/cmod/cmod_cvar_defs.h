@@ -41,6 +41,11 @@ CVAR_DEF(in_mouse_warping, "0", CVAR_ARCHIVE);
 CVAR_DEF(cmod_anti_burnin, "0", CVAR_ARCHIVE);
 #endif
 
+#ifdef CMOD_SOUND_MIX_SIMD
+// 0 = scalar mixing, 1 = fastest SIMD mixing supported by the CPU (default)
+CVAR_DEF(s_mixSimd, "1", CVAR_ARCHIVE);
+#endif
+
 #ifdef CMOD_FILTER_OVERLAPPING_SOUNDS
 // 0 = no filtering (original ioEF behavior)
 // 1 = filter weapon channel only (default)
@@ -123,3 +128,54 @@ CVAR_DEF( sv_maxModelLength, "48", 0 )
 #ifdef CMOD_CONSOLE_KEY_DEBUG
 CVAR_DEF( in_keyboardDebug, "0", 0 )
 #endif
+
+#ifdef CMOD_TRACE_CACHE
+CVAR_DEF( cm_traceCache, "0", 0 )
+#endif
+
+#ifdef CMOD_SERVER_HITCH_LOG
+// Frame duration in msec that triggers a hitch log entry, or 0 to disable.
+CVAR_DEF( sv_hitchThreshold, "0", 0 )
+#endif
+
+#ifdef CMOD_METRICS_ENDPOINT
+// TCP port for metrics endpoint, or 0 to disable.
+CVAR_DEF( net_metricsPort, "0", 0 )
+// Address to bind metrics endpoint. Defaults to local connections only.
+CVAR_DEF( net_metricsAddress, "127.0.0.1", 0 )
+#endif
+
+#ifdef CMOD_BANDWIDTH_PROFILE
+// Record bandwidth profile stats for messages sent to clients.
+CVAR_DEF( sv_bandwidthProfile, "0", 0 )
+#endif
+
+#ifdef CMOD_SNAPSHOT_ENTITY_PRIORITY
+// Defer low priority entity updates when a snapshot exceeds the client's rate.
+CVAR_DEF( sv_entityPriority, "0", 0 )
+// Maximum consecutive snapshots an entity update can be deferred.
+CVAR_DEF( sv_entityPriorityMaxDefer, "3", 0 )
+#endif
+
+#ifdef CMOD_SERVER_FRAME_SCHEDULER
+// Schedule dedicated server frames against microsecond deadlines.
+CVAR_DEF( sv_preciseFrames, "0", 0 )
+#endif
+
+#ifdef CMOD_FRAME_TRACE
+CVAR_DEF( com_frameTrace, "0", 0 )
+// Events per thread trace buffer, rounded up to a power of 2. Fixed after first use.
+CVAR_DEF( com_frameTraceEvents, "262144", 0 )
+#endif
+
+#ifdef CMOD_PATCH_COLLIDE_CACHE
+CVAR_DEF( cm_patchCache, "1", CVAR_ARCHIVE )
+#endif
+
+#ifdef CMOD_BOT_ROUTE_PRECACHE
+CVAR_DEF( bot_routePrecache, "0", CVAR_ARCHIVE )
+#endif
+
+#ifdef CMOD_BOT_ROUTE_CACHE_BUDGET
+CVAR_DEF( bot_routeCacheMB, "0", CVAR_ARCHIVE )
+#endif
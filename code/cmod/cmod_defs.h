@@ -102,6 +102,22 @@
 #define CMOD_ENGINE_ASPECT_CORRECT
 #endif
 
+// [FEATURE] Read back and encode cl_avi video frames asynchronously to reduce recording overhead
+// Enabled by "r_aviAsyncCapture" cvar (number of frames in flight, default 0 = disabled)
+#if !defined( __EMSCRIPTEN__ )	// requires CMOD_COMMON_THREADS
+#define CMOD_ASYNC_VIDEO_CAPTURE
+#endif
+
+// [FEATURE] Process and upload map textures using background threads during image registration
+// Controlled by "r_parallelImageLoad" cvar
+#if !defined( __EMSCRIPTEN__ )	// requires CMOD_COMMON_THREADS
+#define CMOD_PARALLEL_IMAGE_LOAD
+#endif
+
+// [FEATURE] SSE2/NEON kernels for texture resampling, mipmap generation, and light scaling
+// Controlled by "r_imageSimd" cvar; "r_imageBenchmark" command and BUILD_IMAGE_SIMD_BENCH tool compare kernels
+#define CMOD_IMAGE_SIMD
+
 // [FEATURE] Support fading HUD graphics to reduce potential burn-in on OLED displays
 #define CMOD_ANTI_BURNIN
 
@@ -193,6 +209,26 @@
 // [TWEAK] Increase concurrent sound limit to reduce rapidfire weapon stuttering.
 #define CMOD_CONCURRENT_SOUNDS
 
+// [FEATURE] SSE2/AVX2/NEON sound mixing kernels for the DMA sound backend, selected at runtime
+// Controlled by "s_mixSimd" cvar; "s_mixBenchmark" command compares kernels
+#define CMOD_SOUND_MIX_SIMD
+
+// [FEATURE] Optional mixing in the SDL audio callback, decoupled from the client frame loop
+// Controlled by "s_mixThread" cvar; main thread submits channel updates through a message ring
+#define CMOD_SOUND_MIX_THREAD
+
+// [FEATURE] Asynchronous sound loading and music decode-ahead on a shared worker pool
+// Controlled by "s_asyncLoad" cvar
+#if !defined(__EMSCRIPTEN__)
+#define CMOD_SOUND_ASYNC_LOAD
+#endif
+
+// [FEATURE] Cache resampled sound data on disk to speed up sound loading after restarts
+// Controlled by "s_soundCache" cvar
+#ifdef CMOD_FAST_SOUND_RESET
+#define CMOD_SOUND_CACHE
+#endif
+
 // [BUGFIX] Fix for possible sound buffer synchronization issues due to time overflow condition.
 // Not sure if this is actually necessary, but it shouldn't hurt.
 #define CMOD_SOUND_DMA_BUFFER_TWEAK
@@ -263,6 +299,13 @@
 // Saves ~10ms startup time.
 #define CMOD_DEFER_HTTP
 
+// [FEATURE] Support "demo_seek" command to jump to a given time during demo playback.
+#define CMOD_DEMO_SEEK
+
+// [FEATURE] Support "demo_render" command to record a demo to video offline at a fixed frame
+// rate, as fast as frames can be rendered and with deterministic audio
+#define CMOD_DEMO_RENDER
+
 #endif	// !DEDICATED
 
 /* ******************************************************************************** */
@@ -272,6 +315,10 @@
 // [FEATURE] Server-side game recording and admin spectator support
 #define CMOD_RECORD
 
+// [FEATURE] Benchmark server performance by replaying record files as synthetic clients
+// Requires CMOD_RECORD and CMOD_SERVER_BENCHMARK
+#define CMOD_RECORD_REPLAY
+
 // [FEATURE] Allow scripts to override map command behavior via "sv_mapscript" cvar
 #define CMOD_MAP_SCRIPT
 
@@ -323,6 +370,53 @@
 // [BUGFIX] Workaround to allow bots to join password-protected server
 #define CMOD_BOT_PASSWORD_FIX
 
+// [FEATURE] Precompute bot routing caches in worker threads when the map loads, and store
+// them to disk keyed by aas checksum so later loads can skip the computation entirely
+// Memory budget controlled by "bot_routePrecache" cvar (in megabytes, 0 to disable)
+#if defined(NEW_FILESYSTEM)	// required
+#define CMOD_BOT_ROUTE_PRECACHE
+#endif
+
+// [FEATURE] Limit bot routing cache memory to "bot_routeCacheMB" cvar value (0 = unlimited, the
+// default), evicting the least frequently used caches first, with hit/miss/recompute stats via
+// "bot_routeCacheStats" command
+#define CMOD_BOT_ROUTE_CACHE_BUDGET
+
+// [FEATURE] Measure time spent running bot AI each server frame, reported by
+// "bot_thinkStats" command
+#define CMOD_BOT_THINK_STATS
+
+// [FEATURE] Support "sv_benchmark" command to run a map with bots at full speed on a dedicated
+// server and report frame time percentiles broken down by frame phase
+#define CMOD_SERVER_BENCHMARK
+
+// [FEATURE] Keep a per-frame time breakdown on dedicated servers, and write the recent frames
+// to the hitch log when a frame exceeds "sv_hitchThreshold" msec
+// Requires CMOD_SERVER_BENCHMARK and CMOD_LOGGING_SYSTEM
+#define CMOD_SERVER_HITCH_LOG
+
+// [FEATURE] Serve server metrics in Prometheus text format on TCP port "net_metricsPort"
+#define CMOD_METRICS_ENDPOINT
+
+// [FEATURE] Break down bandwidth sent to clients by message section, entity type, and field
+// when "sv_bandwidthProfile" is enabled, and report it with the "bandwidthProfile" command
+#define CMOD_BANDWIDTH_PROFILE
+
+// [FEATURE] Support "sv_entityPriority" option to defer low priority entity updates when a
+// snapshot would exceed the client's rate
+#define CMOD_SNAPSHOT_ENTITY_PRIORITY
+
+// [FEATURE] Support "sv_preciseFrames" option to schedule dedicated server frames against
+// microsecond deadlines using a timerfd, and "sv_frameJitter" command to report frame timing
+// Requires CMOD_MICROSECOND_TIMER
+#if defined( __linux__ )
+#define CMOD_SERVER_FRAME_SCHEDULER
+#endif
+
+// [TWEAK] Encode the configstring and baseline sections of the gamestate message once and
+// reuse them for each connecting client until a configstring or the baselines change
+#define CMOD_GAMESTATE_CACHE
+
 // [BUGFIX] Workaround for game code bug when creating EV_SHIELD_HIT event
 // This fixes an issue with the original game code in which EV_SHIELD_HIT events are created
 // with r.origin set to vec3_origin instead of the origin of the player being hit. Due to
@@ -396,6 +490,16 @@
 // in various mods
 #define CMOD_VMFLOATCAST
 
+// [FEATURE] Optional per-frame cache of CM_BoxTrace results (enabled by "cm_traceCache" cvar),
+// plus "cm_traceCapture" and "cm_traceBenchmark" commands to record and replay trace logs
+#define CMOD_TRACE_CACHE
+
+// [FEATURE] Cache generated patch collision data to disk, keyed by bsp collision checksum,
+// to reduce map load times on curve-heavy maps (controlled by "cm_patchCache" cvar)
+#if defined(NEW_FILESYSTEM)	// required
+#define CMOD_PATCH_COLLIDE_CACHE
+#endif
+
 // [BUGFIX] Reverse an ioef change which appears to be no longer necessary, and may potentially
 // cause issues such as photons disappearing on impact
 #define CMOD_NOIMPACT_TRACEFIX
@@ -494,6 +598,24 @@
 // [COMMON] Restructure server serverinfo and systeminfo handling to use common access functions
 #define CMOD_COMMON_SERVER_INFOSTRING_HOOKS
 
+// [COMMON] Portable thread creation functions
+#if !defined( __EMSCRIPTEN__ )
+#define CMOD_COMMON_THREADS
+#endif
+
+// [COMMON] Keep Huffman bit position per thread, so messages can be read and written on
+// multiple threads at once
+#if defined( CMOD_COMMON_THREADS )
+#define CMOD_HUFFMAN_THREAD_LOCAL
+#endif
+
+// [COMMON] High resolution Sys_Microseconds timer for profiling purposes
+#define CMOD_MICROSECOND_TIMER
+
+// [COMMON] Per-thread frame phase trace spans (enabled by "com_frameTrace" cvar), with
+// "frameTraceDump" command to write recent spans as Chrome trace JSON
+#define CMOD_FRAME_TRACE
+
 // [COMMON] Support extra VM interface functions for compatible VMs
 #define CMOD_VM_EXTENSIONS
 
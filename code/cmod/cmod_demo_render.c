@@ -0,0 +1,171 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+Copyright (C) 2017 Noah Metzger (chomenor@gmail.com)
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+
+#ifdef CMOD_DEMO_RENDER
+#include "../client/client.h"
+
+/*
+###############################################################################################
+
+Offline Demo Rendering
+
+The "demo_render" command plays a demo and records it to video, running frames as fast as
+they can be rendered instead of in real time. Video recording already locks the client to a
+fixed frame duration based on cl_aviFrameRate. This mode also removes the com_maxfps frame
+limiter and paints sound exactly up to the current frame time each frame, so the audio
+written to the video doesn't depend on real time.
+
+Recording starts once the demo becomes active, so no audio is written for loading frames
+that have no video. Setting "nextdemo" to "quit" before running the command will exit when
+the demo is finished, for batch rendering.
+
+###############################################################################################
+*/
+
+static struct {
+	qboolean pending;		// waiting for demo to become active to start recording
+	qboolean recording;
+	char videoName[MAX_QPATH];
+	int startTime;
+	int frames;
+} demoRender;
+
+/*
+=================
+CMDemoRender_Active
+
+Returns qtrue if an offline demo render is in progress.
+=================
+*/
+qboolean CMDemoRender_Active( void ) {
+	return demoRender.pending || demoRender.recording;
+}
+
+/*
+=================
+CMDemoRender_Finish
+=================
+*/
+static void CMDemoRender_Finish( void ) {
+	if ( demoRender.recording ) {
+		int time = Sys_Milliseconds() - demoRender.startTime;
+		Com_Printf( "Demo render finished: %i frames in %.1f seconds (%.1f fps)\n", demoRender.frames,
+				time / 1000.0, time > 0 ? demoRender.frames * 1000.0 / time : 0.0 );
+	}
+
+	Com_Memset( &demoRender, 0, sizeof( demoRender ) );
+}
+
+/*
+=================
+CMDemoRender_Frame
+
+Called each client frame, before video frames are captured.
+=================
+*/
+void CMDemoRender_Frame( void ) {
+	if ( !CMDemoRender_Active() ) {
+		return;
+	}
+
+	if ( !clc.demoplaying ) {
+		CMDemoRender_Finish();
+		return;
+	}
+
+	if ( demoRender.pending && clc.state == CA_ACTIVE ) {
+		if ( *demoRender.videoName ) {
+			Cbuf_ExecuteText( EXEC_NOW, va( "video \"%s\"\n", demoRender.videoName ) );
+		} else {
+			Cbuf_ExecuteText( EXEC_NOW, "video\n" );
+		}
+
+		if ( !CL_VideoRecording() ) {
+			Com_Printf( "Demo render failed to start video recording.\n" );
+			CMDemoRender_Finish();
+			return;
+		}
+
+		demoRender.pending = qfalse;
+		demoRender.recording = qtrue;
+		demoRender.startTime = Sys_Milliseconds();
+	}
+
+	if ( demoRender.recording ) {
+		if ( !CL_VideoRecording() ) {
+			CMDemoRender_Finish();
+			return;
+		}
+		++demoRender.frames;
+	}
+}
+
+/*
+=================
+CMDemoRender_Cmd
+
+demo_render <demo> [video name]
+=================
+*/
+void CMDemoRender_Cmd( void ) {
+	char demoName[MAX_QPATH];
+
+	if ( Cmd_Argc() < 2 ) {
+		Com_Printf( "Usage: demo_render <demo> [video name]\n"
+				"Plays a demo and records it to video at cl_aviFrameRate as fast as possible.\n" );
+		return;
+	}
+
+	if ( cl_aviFrameRate->integer <= 0 ) {
+		Com_Printf( "cl_aviFrameRate must be >= 1\n" );
+		return;
+	}
+
+	if ( CL_VideoRecording() ) {
+		Com_Printf( "Already recording video.\n" );
+		return;
+	}
+
+	// copy arguments before executing other commands
+	Q_strncpyz( demoName, Cmd_Argv( 1 ), sizeof( demoName ) );
+	Com_Memset( &demoRender, 0, sizeof( demoRender ) );
+	Q_strncpyz( demoRender.videoName, Cmd_Argv( 2 ), sizeof( demoRender.videoName ) );
+
+	Cbuf_ExecuteText( EXEC_NOW, va( "demo \"%s\"\n", demoName ) );
+	if ( !clc.demoplaying ) {
+		return;
+	}
+
+	demoRender.pending = qtrue;
+
+	if ( Cvar_VariableIntegerValue( "r_swapInterval" ) ) {
+		Com_Printf( S_COLOR_YELLOW "WARNING: r_swapInterval is enabled, which will limit "
+				"rendering speed to the display refresh rate\n" );
+	}
+	if ( !Cvar_VariableIntegerValue( "s_initsound" ) ) {
+		Com_Printf( S_COLOR_YELLOW "WARNING: sound is disabled, so the video will have no audio. "
+				"On a system with no audio device, set SDL_AUDIODRIVER=dummy to enable sound.\n" );
+	}
+}
+
+#endif
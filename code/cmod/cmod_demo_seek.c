@@ -0,0 +1,481 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+Copyright (C) 2017 Noah Metzger (chomenor@gmail.com)
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+
+#ifdef CMOD_DEMO_SEEK
+#include "../client/client.h"
+
+/*
+###############################################################################################
+
+Demo Seeking
+
+The "demo_seek" command jumps to a given time in the demo currently playing. Snapshots in a
+demo are delta compressed against earlier ones, so parsing can only start from a keyframe:
+the gamestate at the start of the demo, or a later snapshot which was sent without delta
+compression. The first seek scans the demo to index the keyframe positions.
+
+A seek skips to the last keyframe before the target time, reading only the server commands
+from the skipped messages. It then parses the remaining messages up to the target without
+rendering, and reloads the cgame so it starts cleanly from the new position. Server commands
+are executed by the engine as they are read, so configstring changes are kept and transient
+commands like prints are dropped.
+
+Seeking is limited to the current map. The index ends at the next gamestate in the demo.
+
+###############################################################################################
+*/
+
+typedef struct {
+	int offset;			// file offset of the message containing the snapshot
+	int serverTime;
+} demoKeyframe_t;
+
+typedef struct {
+	qboolean valid;
+
+	// state following the most recent gamestate message
+	gameState_t gameState;
+	entityState_t entityBaselines[MAX_GENTITIES];
+	int serverCommandSequence;
+	int serverMessageSequence;
+	int startOffset;
+
+	// index built on first seek
+	qboolean indexed;
+	int endOffset;		// offset of the next gamestate or end of file
+	int firstTime;		// server time of first and last snapshot, or -1 if no snapshots
+	int lastTime;
+	demoKeyframe_t *keyframes;
+	int numKeyframes;
+	int maxKeyframes;
+} demoSeekState_t;
+
+static demoSeekState_t *demoSeek;
+
+qboolean CL_GetServerCommand( int serverCommandNumber );
+void CL_ParseCommandString( msg_t *msg );
+
+/*
+=================
+CMDemoSeek_ClearIndex
+=================
+*/
+static void CMDemoSeek_ClearIndex( void ) {
+	if ( demoSeek->keyframes ) {
+		Z_Free( demoSeek->keyframes );
+	}
+	demoSeek->keyframes = NULL;
+	demoSeek->numKeyframes = 0;
+	demoSeek->maxKeyframes = 0;
+	demoSeek->indexed = qfalse;
+}
+
+/*
+=================
+CMDemoSeek_OnGamestate
+
+Called when a gamestate has been parsed, before the cgame is loaded.
+=================
+*/
+void CMDemoSeek_OnGamestate( void ) {
+	if ( !clc.demoplaying || !clc.demofile ) {
+		if ( demoSeek ) {
+			demoSeek->valid = qfalse;
+			CMDemoSeek_ClearIndex();
+		}
+		return;
+	}
+
+	if ( !demoSeek ) {
+		demoSeek = (demoSeekState_t *)Z_Malloc( sizeof( *demoSeek ) );
+	}
+	CMDemoSeek_ClearIndex();
+
+	demoSeek->gameState = cl.gameState;
+	Com_Memcpy( demoSeek->entityBaselines, cl.entityBaselines, sizeof( demoSeek->entityBaselines ) );
+	demoSeek->serverCommandSequence = clc.serverCommandSequence;
+	demoSeek->serverMessageSequence = clc.serverMessageSequence;
+	demoSeek->startOffset = FS_FTell( clc.demofile );
+	demoSeek->valid = qtrue;
+}
+
+/*
+=================
+CMDemoSeek_ReadMessage
+
+Reads the next message from the demo file. Returns qfalse at end of demo or on error.
+=================
+*/
+static qboolean CMDemoSeek_ReadMessage( msg_t *msg, byte *data, int dataSize ) {
+	int sequence;
+	int length;
+
+	if ( FS_Read( &sequence, 4, clc.demofile ) != 4 ) {
+		return qfalse;
+	}
+	if ( FS_Read( &length, 4, clc.demofile ) != 4 ) {
+		return qfalse;
+	}
+	length = LittleLong( length );
+	if ( length < 0 || length > dataSize ) {
+		return qfalse;
+	}
+
+#ifdef ELITEFORCE
+	if ( clc.compat ) {
+		MSG_InitOOB( msg, data, dataSize );
+		msg->compat = qtrue;
+	} else
+#endif
+	MSG_Init( msg, data, dataSize );
+
+	if ( FS_Read( data, length, clc.demofile ) != length ) {
+		return qfalse;
+	}
+	msg->cursize = length;
+
+	clc.serverMessageSequence = LittleLong( sequence );
+	clc.lastPacketTime = cls.realtime;
+	return qtrue;
+}
+
+/*
+=================
+CMDemoSeek_ReadCommands
+
+Reads the message header and any server commands at the start of the message. Returns the
+first other message command (normally svc_snapshot or svc_gamestate), or svc_EOF. Server
+commands are stored as usual if store is set, otherwise they are discarded.
+=================
+*/
+static int CMDemoSeek_ReadCommands( msg_t *msg, qboolean store ) {
+	int cmd;
+
+#ifdef ELITEFORCE
+	if ( !msg->compat )
+#endif
+	{
+		MSG_Bitstream( msg );
+		MSG_ReadLong( msg );	// reliable acknowledge
+	}
+
+	while ( 1 ) {
+		if ( msg->readcount > msg->cursize ) {
+			return svc_EOF;
+		}
+
+		cmd = MSG_ReadByte( msg );
+#ifdef ELITEFORCE
+		if ( cmd == svc_EOF || ( msg->compat && cmd == -1 ) ) {
+#else
+		if ( cmd == svc_EOF ) {
+#endif
+			return svc_EOF;
+		}
+
+		if ( cmd == svc_serverCommand ) {
+			if ( store ) {
+				CL_ParseCommandString( msg );
+			} else {
+				MSG_ReadLong( msg );
+				MSG_ReadString( msg );
+			}
+		} else if ( cmd != svc_nop ) {
+			return cmd;
+		}
+	}
+}
+
+/*
+=================
+CMDemoSeek_ExecuteCommands
+
+Executes all received server commands the cgame hasn't retrieved yet.
+=================
+*/
+static void CMDemoSeek_ExecuteCommands( void ) {
+	if ( clc.lastExecutedServerCommand < clc.serverCommandSequence - MAX_RELIABLE_COMMANDS ) {
+		clc.lastExecutedServerCommand = clc.serverCommandSequence - MAX_RELIABLE_COMMANDS;
+	}
+	while ( clc.lastExecutedServerCommand < clc.serverCommandSequence ) {
+		CL_GetServerCommand( clc.lastExecutedServerCommand + 1 );
+	}
+}
+
+/*
+=================
+CMDemoSeek_AddKeyframe
+=================
+*/
+static void CMDemoSeek_AddKeyframe( int offset, int serverTime ) {
+	if ( demoSeek->numKeyframes >= demoSeek->maxKeyframes ) {
+		int newMax = demoSeek->maxKeyframes ? demoSeek->maxKeyframes * 2 : 64;
+		demoKeyframe_t *newKeyframes = (demoKeyframe_t *)Z_Malloc( newMax * sizeof( *newKeyframes ) );
+		if ( demoSeek->keyframes ) {
+			Com_Memcpy( newKeyframes, demoSeek->keyframes, demoSeek->numKeyframes * sizeof( *newKeyframes ) );
+			Z_Free( demoSeek->keyframes );
+		}
+		demoSeek->keyframes = newKeyframes;
+		demoSeek->maxKeyframes = newMax;
+	}
+
+	demoSeek->keyframes[demoSeek->numKeyframes].offset = offset;
+	demoSeek->keyframes[demoSeek->numKeyframes].serverTime = serverTime;
+	++demoSeek->numKeyframes;
+}
+
+/*
+=================
+CMDemoSeek_BuildIndex
+
+Scans the demo from the current gamestate to the next gamestate or end of file. Only the
+snapshot headers are decoded, so this is much faster than parsing the demo.
+=================
+*/
+static void CMDemoSeek_BuildIndex( void ) {
+	msg_t msg;
+	byte data[MAX_MSGLEN];
+	int position = FS_FTell( clc.demofile );
+	int messageSequence = clc.serverMessageSequence;
+	int startTime = Sys_Milliseconds();
+	int messages = 0;
+
+	CMDemoSeek_ClearIndex();
+	demoSeek->firstTime = -1;
+	demoSeek->lastTime = -1;
+
+	FS_Seek( clc.demofile, demoSeek->startOffset, FS_SEEK_SET );
+	while ( 1 ) {
+		int offset = FS_FTell( clc.demofile );
+		int cmd;
+
+		demoSeek->endOffset = offset;
+		if ( !CMDemoSeek_ReadMessage( &msg, data, sizeof( data ) ) ) {
+			break;
+		}
+
+		cmd = CMDemoSeek_ReadCommands( &msg, qfalse );
+		if ( cmd == svc_gamestate ) {
+			break;
+		}
+
+		if ( cmd == svc_snapshot ) {
+			int serverTime;
+			int deltaNum;
+
+#ifdef ELITEFORCE
+			if ( msg.compat ) {
+				MSG_ReadLong( &msg );
+			}
+#endif
+			serverTime = MSG_ReadLong( &msg );
+			deltaNum = MSG_ReadByte( &msg );
+
+			if ( demoSeek->firstTime < 0 ) {
+				demoSeek->firstTime = serverTime;
+			}
+			demoSeek->lastTime = serverTime;
+			if ( !deltaNum ) {
+				CMDemoSeek_AddKeyframe( offset, serverTime );
+			}
+		}
+
+		++messages;
+	}
+
+	FS_Seek( clc.demofile, position, FS_SEEK_SET );
+	clc.serverMessageSequence = messageSequence;
+	demoSeek->indexed = qtrue;
+
+	Com_Printf( "Indexed %i demo messages with %i keyframes in %i msec\n", messages,
+			demoSeek->numKeyframes, Sys_Milliseconds() - startTime );
+}
+
+/*
+=================
+CMDemoSeek_RestoreStart
+
+Resets client state to the most recent gamestate.
+=================
+*/
+static void CMDemoSeek_RestoreStart( void ) {
+	CL_ClearState();
+	cl.gameState = demoSeek->gameState;
+	Com_Memcpy( cl.entityBaselines, demoSeek->entityBaselines, sizeof( cl.entityBaselines ) );
+	clc.serverCommandSequence = demoSeek->serverCommandSequence;
+	clc.lastExecutedServerCommand = demoSeek->serverCommandSequence;
+	clc.serverMessageSequence = demoSeek->serverMessageSequence;
+	FS_Seek( clc.demofile, demoSeek->startOffset, FS_SEEK_SET );
+}
+
+/*
+=================
+CMDemoSeek_ReloadCGame
+
+Restarts the cgame at the current demo position, the same way as a level load.
+=================
+*/
+static void CMDemoSeek_ReloadCGame( void ) {
+	clc.state = CA_LOADING;
+	CL_FlushMemory();
+	cls.cgameStarted = qtrue;
+	CL_InitCGame();
+
+	// let CL_SetCGameTime pick up the next snapshot like at the start of a demo
+	clc.firstDemoFrameSkipped = qfalse;
+	cl.oldFrameServerTime = 0;
+	cl.oldServerTime = 0;
+}
+
+/*
+=================
+CMDemoSeek_SeekTo
+=================
+*/
+static void CMDemoSeek_SeekTo( int targetTime ) {
+	msg_t msg;
+	byte data[MAX_MSGLEN];
+	const demoKeyframe_t *keyframe = NULL;
+	int position = FS_FTell( clc.demofile );
+	int startTime = Sys_Milliseconds();
+	int skipped = 0;
+	int parsed = 0;
+	qboolean reload = qfalse;
+	int i;
+
+	// seeking backwards requires starting over from the gamestate
+	if ( targetTime < cl.snap.serverTime ) {
+		CMDemoSeek_RestoreStart();
+		position = demoSeek->startOffset;
+		reload = qtrue;
+	}
+
+	// find the last keyframe at or before the target that is ahead of the current position
+	for ( i = 0; i < demoSeek->numKeyframes; ++i ) {
+		if ( demoSeek->keyframes[i].serverTime > targetTime ) {
+			break;
+		}
+		if ( demoSeek->keyframes[i].offset >= position ) {
+			keyframe = &demoSeek->keyframes[i];
+		}
+	}
+
+	// skip to the keyframe, keeping only the server commands
+	if ( keyframe ) {
+		while ( FS_FTell( clc.demofile ) < keyframe->offset ) {
+			if ( !CMDemoSeek_ReadMessage( &msg, data, sizeof( data ) ) ) {
+				break;
+			}
+			CMDemoSeek_ReadCommands( &msg, qtrue );
+			CMDemoSeek_ExecuteCommands();
+			reload = qtrue;
+			++skipped;
+		}
+	}
+
+	// parse the remaining messages up to the target
+	while ( cl.snap.serverTime < targetTime && FS_FTell( clc.demofile ) < demoSeek->endOffset ) {
+		if ( !CMDemoSeek_ReadMessage( &msg, data, sizeof( data ) ) ) {
+			break;
+		}
+		CL_ParseServerMessage( &msg );
+		++parsed;
+
+		// execute commands before they can be cycled out, since the cgame won't see them
+		if ( reload || clc.serverCommandSequence - clc.lastExecutedServerCommand >= MAX_RELIABLE_COMMANDS / 2 ) {
+			CMDemoSeek_ExecuteCommands();
+			reload = qtrue;
+		}
+	}
+
+	cl.newSnapshots = qfalse;
+	S_StopAllSounds();
+
+	if ( reload ) {
+		CMDemoSeek_ReloadCGame();
+	} else {
+		// the cgame can catch up from here on its own
+		cl.serverTimeDelta = cl.snap.serverTime - cls.realtime;
+		cl.extrapolatedSnapshot = qfalse;
+	}
+
+	Com_Printf( "Demo seek to %i.%03i: skipped %i and parsed %i messages in %i msec\n",
+			( cl.snap.serverTime - demoSeek->firstTime ) / 1000, ( cl.snap.serverTime - demoSeek->firstTime ) % 1000,
+			skipped, parsed, Sys_Milliseconds() - startTime );
+}
+
+/*
+=================
+CMDemoSeek_Cmd
+
+demo_seek <time>
+Time is seconds or minutes:seconds from the start of the demo, or +/- seconds relative to
+the current position.
+=================
+*/
+void CMDemoSeek_Cmd( void ) {
+	char arg[64];
+	const char *colon;
+	int targetTime;
+
+	if ( Cmd_Argc() != 2 ) {
+		Com_Printf( "usage: demo_seek <time>\n"
+				"time can be seconds or minutes:seconds from the start of the demo, or +/- seconds\n"
+				"from the current position\n" );
+		return;
+	}
+
+	if ( !clc.demoplaying || !clc.demofile || clc.state != CA_ACTIVE || !demoSeek || !demoSeek->valid ) {
+		Com_Printf( "demo_seek: no demo playing\n" );
+		return;
+	}
+
+	Q_strncpyz( arg, Cmd_Argv( 1 ), sizeof( arg ) );
+
+	if ( !demoSeek->indexed ) {
+		CMDemoSeek_BuildIndex();
+	}
+	if ( demoSeek->firstTime < 0 ) {
+		Com_Printf( "demo_seek: no snapshots in demo\n" );
+		return;
+	}
+
+	if ( arg[0] == '+' || arg[0] == '-' ) {
+		targetTime = cl.snap.serverTime + (int)( atof( arg ) * 1000.0 );
+	} else if ( ( colon = strchr( arg, ':' ) ) != NULL ) {
+		targetTime = demoSeek->firstTime + (int)( ( atoi( arg ) * 60 + atof( colon + 1 ) ) * 1000.0 );
+	} else {
+		targetTime = demoSeek->firstTime + (int)( atof( arg ) * 1000.0 );
+	}
+
+	if ( targetTime < demoSeek->firstTime ) {
+		targetTime = demoSeek->firstTime;
+	}
+	if ( targetTime > demoSeek->lastTime ) {
+		targetTime = demoSeek->lastTime;
+	}
+
+	CMDemoSeek_SeekTo( targetTime );
+}
+
+#endif
@@ -0,0 +1,408 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+Copyright (C) 2017 Noah Metzger (chomenor@gmail.com)
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+
+#ifdef CMOD_FRAME_TRACE
+#include "../qcommon/q_shared.h"
+#include "../qcommon/qcommon.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/*
+###############################################################################################
+
+Frame Trace
+
+Records begin/end spans with static names from instrumented parts of the engine, such as
+Com_Frame, SV_Frame, VM_Call, and the renderer, so individual slow frames can be inspected
+rather than just the averages reported by com_speeds. Recording is enabled by the
+com_frameTrace cvar, and "frameTraceDump" writes the most recent spans to a Chrome trace
+JSON file which can be opened in Perfetto (ui.perfetto.dev) or chrome://tracing.
+
+Each thread that records spans claims its own ring buffer on first use, so recording never
+takes a lock. Completed spans overwrite the oldest events once the buffer is full. When
+tracing is disabled, instrumented call sites only test cmTraceActive.
+
+Span names must be static strings, since only the pointer is stored until the dump.
+
+###############################################################################################
+*/
+
+#define TRACE_MAX_THREADS 16
+#define TRACE_MAX_DEPTH 32
+#define TRACE_MIN_EVENTS 1024
+#define TRACE_MAX_EVENTS ( 1 << 24 )
+
+// fraction of other threads' buffers, at the old end, which is skipped in the dump since it
+// may be overwritten while the dump is reading it
+#define TRACE_DUMP_SLACK( size ) ( ( size ) / 4 )
+
+#ifdef _MSC_VER
+#define TRACE_THREADLOCAL __declspec( thread )
+#define TRACE_ATOMIC_INCREMENT( value ) ( _InterlockedIncrement( (volatile long *)( value ) ) - 1 )
+#define TRACE_ATOMIC_STORE_RELEASE( ptr, value ) _InterlockedExchange( (volatile long *)( ptr ), (long)( value ) )
+#define TRACE_ATOMIC_LOAD_ACQUIRE( ptr ) ( (unsigned int)_InterlockedOr( (volatile long *)( ptr ), 0 ) )
+#else
+#define TRACE_THREADLOCAL __thread
+#define TRACE_ATOMIC_INCREMENT( value ) __sync_fetch_and_add( value, 1 )
+#define TRACE_ATOMIC_STORE_RELEASE( ptr, value ) __atomic_store_n( ptr, value, __ATOMIC_RELEASE )
+#define TRACE_ATOMIC_LOAD_ACQUIRE( ptr ) __atomic_load_n( ptr, __ATOMIC_ACQUIRE )
+#endif
+
+typedef struct {
+	const char *name;
+	int64_t start;
+	int duration;
+} traceEvent_t;
+
+typedef struct {
+	traceEvent_t *events;
+	unsigned int mask;
+	unsigned int head;				// total events written; published with release ordering
+
+	// open spans; only accessed by the owning thread
+	unsigned int generation;
+	int depth;
+	const char *stackNames[TRACE_MAX_DEPTH];
+	int64_t stackStart[TRACE_MAX_DEPTH];
+} traceBuffer_t;
+
+qboolean cmTraceActive;
+
+static struct {
+	traceBuffer_t buffers[TRACE_MAX_THREADS];
+	volatile long bufferCount;		// slots claimed, may exceed TRACE_MAX_THREADS
+	unsigned int bufferEvents;		// power of 2
+
+	// advanced when tracing is enabled, to discard spans left open from a previous session
+	volatile unsigned int generation;
+
+	// spans starting before this time are not dumped
+	volatile int64_t discardTime;
+} trace;
+
+static TRACE_THREADLOCAL traceBuffer_t *traceLocal;
+static TRACE_THREADLOCAL qboolean traceClaimFailed;
+
+/*
+=================
+CMTrace_ClaimBuffer
+
+Returns buffer for the calling thread, or NULL if no buffer is available.
+=================
+*/
+static traceBuffer_t *CMTrace_ClaimBuffer( void ) {
+	long index;
+	traceBuffer_t *buffer;
+
+	if ( traceLocal || traceClaimFailed ) {
+		return traceLocal;
+	}
+
+	traceClaimFailed = qtrue;
+	index = TRACE_ATOMIC_INCREMENT( &trace.bufferCount );
+	if ( index >= TRACE_MAX_THREADS ) {
+		return NULL;
+	}
+
+	// use malloc since this may be called from any thread
+	buffer = &trace.buffers[index];
+	buffer->events = (traceEvent_t *)calloc( trace.bufferEvents, sizeof( *buffer->events ) );
+	if ( !buffer->events ) {
+		return NULL;
+	}
+	buffer->generation = trace.generation;
+	buffer->mask = trace.bufferEvents - 1;
+	traceLocal = buffer;
+	traceClaimFailed = qfalse;
+	return buffer;
+}
+
+/*
+=================
+CMTrace_BeginSpan
+
+Opens a span on the calling thread. Span name must be a static string.
+=================
+*/
+void CMTrace_BeginSpan( const char *name ) {
+	traceBuffer_t *buffer;
+
+	if ( !cmTraceActive ) {
+		return;
+	}
+	buffer = CMTrace_ClaimBuffer();
+	if ( !buffer ) {
+		return;
+	}
+
+	if ( buffer->generation != trace.generation ) {
+		buffer->generation = trace.generation;
+		buffer->depth = 0;
+	}
+
+	if ( buffer->depth < TRACE_MAX_DEPTH ) {
+		buffer->stackNames[buffer->depth] = name;
+		buffer->stackStart[buffer->depth] = Sys_Microseconds();
+	}
+	++buffer->depth;
+}
+
+/*
+=================
+CMTrace_EndSpan
+
+Closes the most recent span opened on the calling thread and records it.
+=================
+*/
+void CMTrace_EndSpan( void ) {
+	traceBuffer_t *buffer = traceLocal;
+	traceEvent_t *event;
+
+	if ( !cmTraceActive || !buffer || buffer->generation != trace.generation || buffer->depth <= 0 ) {
+		return;
+	}
+
+	--buffer->depth;
+	if ( buffer->depth >= TRACE_MAX_DEPTH ) {
+		return;
+	}
+
+	event = &buffer->events[buffer->head & buffer->mask];
+	event->name = buffer->stackNames[buffer->depth];
+	event->start = buffer->stackStart[buffer->depth];
+	event->duration = (int)( Sys_Microseconds() - event->start );
+
+	// make the event visible to the dump before the new head
+	TRACE_ATOMIC_STORE_RELEASE( &buffer->head, buffer->head + 1 );
+}
+
+/*
+=================
+CMTrace_BeginFrame
+
+Called from the main thread at the start of each Com_Frame. Updates the active state and
+discards any spans left open by an error, then opens the frame span.
+=================
+*/
+void CMTrace_BeginFrame( void ) {
+	qboolean active = com_frameTrace->integer ? qtrue : qfalse;
+
+	if ( active && !cmTraceActive ) {
+		if ( !trace.bufferEvents ) {
+			// buffer size is fixed once the first buffer is allocated
+			int events = com_frameTraceEvents->integer;
+			if ( events < TRACE_MIN_EVENTS ) {
+				events = TRACE_MIN_EVENTS;
+			}
+			if ( events > TRACE_MAX_EVENTS ) {
+				events = TRACE_MAX_EVENTS;
+			}
+			trace.bufferEvents = TRACE_MIN_EVENTS;
+			while ( trace.bufferEvents < (unsigned int)events ) {
+				trace.bufferEvents <<= 1;
+			}
+		}
+		++trace.generation;
+	}
+	cmTraceActive = active;
+
+	if ( active ) {
+		traceBuffer_t *buffer = CMTrace_ClaimBuffer();
+		if ( buffer ) {
+			buffer->depth = 0;
+		}
+		CMTrace_BeginSpan( "Com_Frame" );
+	}
+}
+
+/*
+=================
+CMTrace_DiscardEvents
+
+Prevents events recorded up to this point from being dumped. Used when the renderer library
+is unloaded, since renderer span names point into its memory.
+=================
+*/
+void CMTrace_DiscardEvents( void ) {
+	trace.discardTime = Sys_Microseconds();
+}
+
+/*
+###############################################################################################
+
+Trace Dump
+
+###############################################################################################
+*/
+
+#define TRACE_WRITE_BUFFER_SIZE 65536
+
+typedef struct {
+	fileHandle_t fp;
+	char data[TRACE_WRITE_BUFFER_SIZE];
+	int position;
+	qboolean firstEvent;
+} traceWriter_t;
+
+/*
+=================
+CMTrace_Flush
+=================
+*/
+static void CMTrace_Flush( traceWriter_t *writer ) {
+	if ( writer->position ) {
+		FS_Write( writer->data, writer->position, writer->fp );
+		writer->position = 0;
+	}
+}
+
+/*
+=================
+CMTrace_WriteEvent
+
+Writes one JSON event object to the trace array.
+=================
+*/
+static void QDECL CMTrace_WriteEvent( traceWriter_t *writer, const char *fmt, ... ) Q_PRINTF_FUNC( 2, 3 );
+static void QDECL CMTrace_WriteEvent( traceWriter_t *writer, const char *fmt, ... ) {
+	va_list argptr;
+	int length;
+
+	if ( writer->position > TRACE_WRITE_BUFFER_SIZE - 1024 ) {
+		CMTrace_Flush( writer );
+	}
+
+	if ( !writer->firstEvent ) {
+		writer->data[writer->position++] = ',';
+		writer->data[writer->position++] = '\n';
+	}
+	writer->firstEvent = qfalse;
+
+	va_start( argptr, fmt );
+	length = Q_vsnprintf( writer->data + writer->position, TRACE_WRITE_BUFFER_SIZE - writer->position, fmt, argptr );
+	va_end( argptr );
+	if ( length > 0 ) {
+		writer->position += length;
+	}
+}
+
+/*
+=================
+CMTrace_Dump_f
+=================
+*/
+static void CMTrace_Dump_f( void ) {
+	char path[MAX_QPATH];
+	int seconds = Cmd_Argc() > 1 ? atoi( Cmd_Argv( 1 ) ) : 10;
+	int64_t now = Sys_Microseconds();
+	int64_t cutoff;
+	traceWriter_t *writer;
+	int bufferCount = (int)trace.bufferCount;
+	int eventCount = 0;
+	int i;
+
+	if ( seconds <= 0 ) {
+		Com_Printf( "Usage: frameTraceDump [seconds] [output file]\n" );
+		return;
+	}
+	if ( !trace.bufferEvents || !bufferCount ) {
+		Com_Printf( "No trace events recorded. Set com_frameTrace to 1 to enable recording.\n" );
+		return;
+	}
+	if ( bufferCount > TRACE_MAX_THREADS ) {
+		Com_Printf( "WARNING: %i threads were not traced due to buffer limit.\n", bufferCount - TRACE_MAX_THREADS );
+		bufferCount = TRACE_MAX_THREADS;
+	}
+
+	Q_strncpyz( path, Cmd_Argc() > 2 ? Cmd_Argv( 2 ) : "frametrace", sizeof( path ) );
+	COM_DefaultExtension( path, sizeof( path ), ".json" );
+
+	writer = (traceWriter_t *)Z_Malloc( sizeof( *writer ) );
+	writer->fp = FS_FOpenFileWrite_HomeData( path );
+	if ( !writer->fp ) {
+		Com_Printf( "Failed to open %s for writing.\n", path );
+		Z_Free( writer );
+		return;
+	}
+	writer->firstEvent = qtrue;
+
+	cutoff = now - (int64_t)seconds * 1000000;
+	if ( cutoff < trace.discardTime ) {
+		cutoff = trace.discardTime;
+	}
+
+	writer->position = Com_sprintf( writer->data, sizeof( writer->data ), "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n" );
+
+	for ( i = 0; i < bufferCount; ++i ) {
+		traceBuffer_t *buffer = &trace.buffers[i];
+		unsigned int head = TRACE_ATOMIC_LOAD_ACQUIRE( &buffer->head );
+		unsigned int tail = 0;
+		unsigned int size = buffer->mask + 1;
+		unsigned int j;
+
+		if ( !buffer->events ) {
+			continue;
+		}
+
+		// skip events that could be overwritten by other threads while reading
+		if ( head > size ) {
+			tail = head - size;
+			if ( buffer != traceLocal ) {
+				tail += TRACE_DUMP_SLACK( size );
+			}
+		}
+
+		CMTrace_WriteEvent( writer, "{\"ph\":\"M\",\"pid\":1,\"tid\":%i,\"name\":\"thread_name\","
+				"\"args\":{\"name\":\"%s\"}}", i, buffer == traceLocal ? "main" : va( "thread %i", i ) );
+
+		for ( j = tail; j != head; ++j ) {
+			const traceEvent_t *event = &buffer->events[j & buffer->mask];
+			if ( event->start < cutoff ) {
+				continue;
+			}
+			CMTrace_WriteEvent( writer, "{\"ph\":\"X\",\"pid\":1,\"tid\":%i,\"name\":\"%s\",\"ts\":%lld,\"dur\":%i}",
+					i, event->name, (long long)event->start, event->duration );
+			++eventCount;
+		}
+	}
+
+	writer->position += Com_sprintf( writer->data + writer->position, sizeof( writer->data ) - writer->position, "\n]}\n" );
+	CMTrace_Flush( writer );
+	FS_FCloseFile( writer->fp );
+	Z_Free( writer );
+
+	Com_Printf( "Wrote %i trace events from the last %i seconds to %s\n", eventCount, seconds, path );
+}
+
+/*
+=================
+CMTrace_Init
+=================
+*/
+void CMTrace_Init( void ) {
+	Cmd_AddCommand( "frameTraceDump", CMTrace_Dump_f );
+}
+
+#endif
@@ -0,0 +1,251 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+Copyright (C) 2017 Noah Metzger (chomenor@gmail.com)
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+
+#ifdef CMOD_PARALLEL_IMAGE_LOAD
+#include "../renderercommon/tr_common.h"
+#include "SDL.h"
+
+/*
+###############################################################################################
+
+Image Loader Threads
+
+Used by both renderers to move the CPU side of texture creation (resampling, light scaling,
+and mipmap generation) off the render thread while images are being registered. Image files
+are still read and decoded on the render thread, since the filesystem and zone allocator
+aren't thread safe.
+
+Each job is processed on a loader thread and then finished on the render thread, which does
+the GL upload. Finished jobs are collected by R_ImageJobs_Poll, which the renderer calls as
+it registers more images, and R_ImageJobs_Flush waits for all outstanding jobs before any
+render commands are executed.
+
+###############################################################################################
+*/
+
+#define MAX_IMAGE_LOADER_THREADS 8
+
+static struct {
+	int numThreads;
+	struct cmThread_s *threads[MAX_IMAGE_LOADER_THREADS];
+	SDL_sem *queueSemaphore;		// posted once for each queued job
+	SDL_sem *finishedSemaphore;		// posted once for each processed job
+	int outstanding;				// jobs queued but not yet finished; render thread only
+
+	// lock protects the fields below
+	SDL_SpinLock lock;
+	qboolean shutdown;
+	imageJob_t *queue;
+	imageJob_t **queueTail;
+	imageJob_t *finished;
+	imageJob_t **finishedTail;
+} imageLoader;
+
+/*
+=================
+R_ImageJobs_ThreadMain
+=================
+*/
+static void R_ImageJobs_ThreadMain( void *arg ) {
+	while ( 1 ) {
+		imageJob_t *job;
+
+		SDL_SemWait( imageLoader.queueSemaphore );
+
+		SDL_AtomicLock( &imageLoader.lock );
+		if ( imageLoader.shutdown ) {
+			SDL_AtomicUnlock( &imageLoader.lock );
+			break;
+		}
+		job = imageLoader.queue;
+		imageLoader.queue = job->next;
+		if ( !imageLoader.queue ) {
+			imageLoader.queueTail = &imageLoader.queue;
+		}
+		SDL_AtomicUnlock( &imageLoader.lock );
+
+		job->process( job );
+
+		job->next = NULL;
+		SDL_AtomicLock( &imageLoader.lock );
+		*imageLoader.finishedTail = job;
+		imageLoader.finishedTail = &job->next;
+		SDL_AtomicUnlock( &imageLoader.lock );
+
+		SDL_SemPost( imageLoader.finishedSemaphore );
+	}
+}
+
+/*
+=================
+R_ImageJobs_Active
+
+Returns qtrue if jobs can be queued.
+=================
+*/
+qboolean R_ImageJobs_Active( void ) {
+	return imageLoader.numThreads > 0 ? qtrue : qfalse;
+}
+
+/*
+=================
+R_ImageJobs_Queue
+=================
+*/
+void R_ImageJobs_Queue( imageJob_t *job ) {
+	job->next = NULL;
+	SDL_AtomicLock( &imageLoader.lock );
+	*imageLoader.queueTail = job;
+	imageLoader.queueTail = &job->next;
+	SDL_AtomicUnlock( &imageLoader.lock );
+
+	++imageLoader.outstanding;
+	SDL_SemPost( imageLoader.queueSemaphore );
+}
+
+/*
+=================
+R_ImageJobs_Poll
+
+Finishes any jobs that have been processed. Returns without waiting.
+=================
+*/
+void R_ImageJobs_Poll( void ) {
+	imageJob_t *job;
+
+	if ( !imageLoader.outstanding ) {
+		return;
+	}
+
+	SDL_AtomicLock( &imageLoader.lock );
+	job = imageLoader.finished;
+	imageLoader.finished = NULL;
+	imageLoader.finishedTail = &imageLoader.finished;
+	SDL_AtomicUnlock( &imageLoader.lock );
+
+	while ( job ) {
+		imageJob_t *next = job->next;
+		--imageLoader.outstanding;
+		job->finish( job );
+		job = next;
+	}
+}
+
+/*
+=================
+R_ImageJobs_Flush
+
+Waits for all outstanding jobs and finishes them.
+=================
+*/
+void R_ImageJobs_Flush( void ) {
+	while ( imageLoader.outstanding ) {
+		SDL_SemWait( imageLoader.finishedSemaphore );
+		R_ImageJobs_Poll();
+	}
+
+	// reset semaphore count for jobs that were finished by earlier polls
+	while ( imageLoader.finishedSemaphore && !SDL_SemTryWait( imageLoader.finishedSemaphore ) ) {
+	}
+}
+
+/*
+=================
+R_ImageJobs_Init
+=================
+*/
+void R_ImageJobs_Init( void ) {
+	int numThreads;
+
+	if ( imageLoader.numThreads || !r_parallelImageLoad->integer ) {
+		return;
+	}
+
+	Com_Memset( &imageLoader, 0, sizeof( imageLoader ) );
+	imageLoader.queueTail = &imageLoader.queue;
+	imageLoader.finishedTail = &imageLoader.finished;
+
+	imageLoader.queueSemaphore = SDL_CreateSemaphore( 0 );
+	imageLoader.finishedSemaphore = SDL_CreateSemaphore( 0 );
+	if ( !imageLoader.queueSemaphore || !imageLoader.finishedSemaphore ) {
+		R_ImageJobs_Shutdown();
+		return;
+	}
+
+	numThreads = ri.Thread_ProcessorCount() - 1;
+	if ( numThreads < 1 ) {
+		numThreads = 1;
+	}
+	if ( numThreads > MAX_IMAGE_LOADER_THREADS ) {
+		numThreads = MAX_IMAGE_LOADER_THREADS;
+	}
+
+	while ( imageLoader.numThreads < numThreads ) {
+		struct cmThread_s *thread = ri.Thread_Create( R_ImageJobs_ThreadMain, NULL );
+		if ( !thread ) {
+			break;
+		}
+		imageLoader.threads[imageLoader.numThreads++] = thread;
+	}
+
+	if ( !imageLoader.numThreads ) {
+		R_ImageJobs_Shutdown();
+		return;
+	}
+
+	ri.Printf( PRINT_DEVELOPER, "Image loader started with %i threads.\n", imageLoader.numThreads );
+}
+
+/*
+=================
+R_ImageJobs_Shutdown
+
+Finishes outstanding jobs and stops loader threads.
+=================
+*/
+void R_ImageJobs_Shutdown( void ) {
+	int i;
+
+	R_ImageJobs_Flush();
+
+	SDL_AtomicLock( &imageLoader.lock );
+	imageLoader.shutdown = qtrue;
+	SDL_AtomicUnlock( &imageLoader.lock );
+
+	for ( i = 0; i < imageLoader.numThreads; ++i ) {
+		SDL_SemPost( imageLoader.queueSemaphore );
+	}
+	for ( i = 0; i < imageLoader.numThreads; ++i ) {
+		ri.Thread_Join( imageLoader.threads[i] );
+	}
+
+	if ( imageLoader.queueSemaphore ) {
+		SDL_DestroySemaphore( imageLoader.queueSemaphore );
+	}
+	if ( imageLoader.finishedSemaphore ) {
+		SDL_DestroySemaphore( imageLoader.finishedSemaphore );
+	}
+	Com_Memset( &imageLoader, 0, sizeof( imageLoader ) );
+}
+
+#endif
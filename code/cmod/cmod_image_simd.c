@@ -0,0 +1,211 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+Copyright (C) 2017 Noah Metzger (chomenor@gmail.com)
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+
+
+#ifdef CMOD_IMAGE_SIMD
+#include "../renderercommon/tr_common.h"
+#include "SDL.h"
+
+/*
+###############################################################################################
+
+SIMD Image Kernel Selection
+
+The kernels themselves are in cmod_image_simd_kernels.c. The kernel set is selected at
+startup from the "r_imageSimd" cvar. The "r_imageBenchmark" command compares the available
+kernel sets on textures from a directory; the image_simd_bench tool runs the same comparison
+outside the game.
+
+###############################################################################################
+*/
+
+imageSimdKernels_t imageSimdKernels;
+
+/*
+=================
+R_ImageSimd_Select
+
+Selects image kernels based on r_imageSimd. Kernels missing from the selected set are filled
+in from the scalar set. Should not be called while image loader threads are running.
+=================
+*/
+void R_ImageSimd_Select( void ) {
+	const imageSimdKernels_t *available[IMAGE_SIMD_MAX_SETS];
+	R_ImageSimd_Available( available );
+
+	imageSimdKernels = r_imageSimd->integer ? *available[0] : imageSimdKernels_scalar;
+	if ( !imageSimdKernels.remapRGB ) {
+		imageSimdKernels.remapRGB = imageSimdKernels_scalar.remapRGB;
+	}
+	if ( !imageSimdKernels.remapBytes ) {
+		imageSimdKernels.remapBytes = imageSimdKernels_scalar.remapBytes;
+	}
+	ri.Printf( PRINT_DEVELOPER, "Using %s image kernels\n", imageSimdKernels.name );
+}
+
+/* ******************************************************************************** */
+// Benchmark
+/* ******************************************************************************** */
+
+#define IMAGE_BENCHMARK_MAX_IMAGES 256
+
+/*
+=================
+R_ImageSimd_BenchClock
+=================
+*/
+static uint64_t R_ImageSimd_BenchClock( void ) {
+	return SDL_GetPerformanceCounter();
+}
+
+/*
+=================
+R_ImageSimd_LoadBenchImage
+
+Returns image allocated with ri.Malloc, or NULL on error.
+=================
+*/
+static byte *R_ImageSimd_LoadBenchImage( const char *path, int *width, int *height ) {
+	const char *ext = COM_GetExtension( path );
+	byte *pic = NULL;
+
+	if ( !Q_stricmp( ext, "tga" ) ) {
+		R_LoadTGA( path, &pic, width, height );
+	} else if ( !Q_stricmp( ext, "jpg" ) || !Q_stricmp( ext, "jpeg" ) ) {
+		R_LoadJPG( path, &pic, width, height );
+	} else if ( !Q_stricmp( ext, "png" ) ) {
+		R_LoadPNG( path, &pic, width, height );
+	}
+
+	if ( pic && ( *width < 2 || *height < 2 ) ) {
+		ri.Free( pic );
+		pic = NULL;
+	}
+	return pic;
+}
+
+/*
+=================
+R_ImageSimd_Benchmark_f
+
+Usage: r_imageBenchmark [directory]
+Runs the image kernels over the textures in a directory, or a synthetic image if none are
+found, and compares time and output of each kernel set with the scalar version.
+=================
+*/
+void R_ImageSimd_Benchmark_f( void ) {
+	static const char *extensions[] = { "tga", "jpg", "png" };
+	const char *directory = ri.Cmd_Argc() > 1 ? ri.Cmd_Argv( 1 ) : "textures/base_wall";
+	const imageSimdKernels_t *available[IMAGE_SIMD_MAX_SETS];
+	int count = R_ImageSimd_Available( available );
+	imageBenchResult_t results[IMAGE_SIMD_MAX_SETS];
+	char *paths[IMAGE_BENCHMARK_MAX_IMAGES];
+	int numPaths = 0;
+	int numImages = 0;
+	int64_t totalPixels = 0;
+	double tickMsec = 1000.0 / (double)SDL_GetPerformanceFrequency();
+	byte table[256];
+	int i, j, k;
+
+	Com_Memset( results, 0, sizeof( results ) );
+
+	// arbitrary lookup table
+	for ( i = 0; i < 256; ++i ) {
+		table[i] = (byte)( ( i * 167 + 13 ) ^ ( i >> 3 ) );
+	}
+
+	for ( i = 0; i < ARRAY_LEN( extensions ); ++i ) {
+		int numFiles;
+		char **files = ri.FS_ListFiles( directory, extensions[i], &numFiles );
+		for ( j = 0; j < numFiles && numPaths < IMAGE_BENCHMARK_MAX_IMAGES; ++j ) {
+			char path[MAX_QPATH];
+			Com_sprintf( path, sizeof( path ), "%s/%s", directory, files[j] );
+			paths[numPaths] = ri.Malloc( strlen( path ) + 1 );
+			strcpy( paths[numPaths++], path );
+		}
+		ri.FS_FreeFileList( files );
+	}
+
+	for ( i = 0; i < numPaths || ( numPaths == 0 && i == 0 ); ++i ) {
+		byte *pic;
+		int width, height;
+
+		if ( numPaths ) {
+			pic = R_ImageSimd_LoadBenchImage( paths[i], &width, &height );
+			if ( !pic ) {
+				continue;
+			}
+		} else {
+			// synthetic noise image
+			unsigned int seed = 1;
+			ri.Printf( PRINT_ALL, "No images found in %s; using a synthetic 512x512 image\n", directory );
+			width = height = 512;
+			pic = ri.Malloc( width * height * 4 );
+			for ( j = 0; j < width * height * 4; ++j ) {
+				seed = seed * 1103515245 + 12345;
+				pic[j] = (byte)( seed >> 16 );
+			}
+		}
+
+		if ( R_ImageSimd_BenchImage( available, count, R_ImageSimd_BenchClock, pic, width, height,
+				table, results ) ) {
+			++numImages;
+			totalPixels += width * height;
+		}
+
+		ri.Free( pic );
+	}
+
+	for ( i = 0; i < numPaths; ++i ) {
+		ri.Free( paths[i] );
+	}
+
+	if ( !numImages ) {
+		ri.Printf( PRINT_ALL, "No images could be loaded from %s\n", directory );
+		return;
+	}
+
+	ri.Printf( PRINT_ALL, "%i images, %.1f megapixels, %i iterations\n", numImages,
+			totalPixels / 1000000.0, IMAGE_BENCHMARK_ITERATIONS );
+	for ( j = 0; j < count; ++j ) {
+		ri.Printf( PRINT_ALL, "%s:\n", available[j]->name );
+		for ( k = 0; k < IMAGE_BENCH_COUNT; ++k ) {
+			double msec = results[j].ticks[k] * tickMsec;
+			double scalarMsec = results[count - 1].ticks[k] * tickMsec;
+			if ( !R_ImageSimd_HasStage( available[j], (imageBenchStage_t)k ) ) {
+				continue;
+			}
+			if ( j == count - 1 ) {
+				ri.Printf( PRINT_ALL, "  %-12s %9.3f ms\n", imageBenchStageNames[k], msec );
+			} else {
+				ri.Printf( PRINT_ALL, "  %-12s %9.3f ms  speedup %.2fx  %s\n", imageBenchStageNames[k], msec,
+						msec > 0.0 ? scalarMsec / msec : 0.0,
+						results[j].mismatch[k] ? S_COLOR_RED "MISMATCH" : "matches scalar" );
+			}
+		}
+	}
+
+	ri.Printf( PRINT_ALL, "Current kernels: %s\n", imageSimdKernels.name ? imageSimdKernels.name : "none" );
+}
+
+#endif
@@ -0,0 +1,73 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+Copyright (C) 2017 Noah Metzger (chomenor@gmail.com)
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+
+// SIMD image kernels, shared by the renderers and the image_simd_bench tool
+
+#ifndef CMOD_IMAGE_SIMD_H
+#define CMOD_IMAGE_SIMD_H
+
+#include "../qcommon/q_shared.h"
+
+typedef struct {
+	const char *name;
+	// 2x2 box filter from rows with inStride bytes to packed output; out may equal in
+	void ( *mipMapBox )( byte *out, const byte *in, int outWidth, int outHeight, int inStride );
+	// 4x4 filter with wraparound, as used by R_MipMap2; out must not overlap in
+	void ( *mipMapFilter )( byte *out, const byte *in, int inWidth, int inHeight );
+	// one output row of ResampleTexture
+	void ( *resampleRow )( byte *out, const byte *inrow, const byte *inrow2, const int *p1, const int *p2, int outWidth );
+	// replaces the RGB values of RGBA pixels through table; NULL if the set has none
+	void ( *remapRGB )( byte *data, int pixels, const byte *table );
+	// replaces every byte through table; NULL if the set has none
+	void ( *remapBytes )( byte *data, int count, const byte *table );
+} imageSimdKernels_t;
+
+#define IMAGE_SIMD_MAX_SETS 4
+
+extern const imageSimdKernels_t imageSimdKernels_scalar;
+int R_ImageSimd_Available( const imageSimdKernels_t **list );
+
+#define IMAGE_BENCHMARK_ITERATIONS 4
+
+typedef enum {
+	IMAGE_BENCH_RESAMPLE,
+	IMAGE_BENCH_MIPMAP_BOX,
+	IMAGE_BENCH_MIPMAP_FILTER,
+	IMAGE_BENCH_REMAP_RGB,
+	IMAGE_BENCH_REMAP_BYTES,
+	IMAGE_BENCH_COUNT
+} imageBenchStage_t;
+
+typedef struct {
+	int64_t ticks[IMAGE_BENCH_COUNT];
+	qboolean mismatch[IMAGE_BENCH_COUNT];
+} imageBenchResult_t;
+
+typedef uint64_t ( *imageBenchClock_t )( void );
+
+extern const char *imageBenchStageNames[IMAGE_BENCH_COUNT];
+qboolean R_ImageSimd_HasStage( const imageSimdKernels_t *kernels, imageBenchStage_t stage );
+qboolean R_ImageSimd_BenchImage( const imageSimdKernels_t **list, int count, imageBenchClock_t clock,
+		const byte *pic, int width, int height, const byte *table, imageBenchResult_t *results );
+
+#endif
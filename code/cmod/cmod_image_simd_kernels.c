@@ -0,0 +1,692 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+Copyright (C) 2017 Noah Metzger (chomenor@gmail.com)
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+
+
+#ifdef CMOD_IMAGE_SIMD
+#include "cmod_image_simd.h"
+
+#if defined( __x86_64__ ) || defined( _M_X64 )
+#define IMG_SIMD_SSE2
+#include <emmintrin.h>
+#elif defined( __aarch64__ ) || defined( _M_ARM64 )
+#define IMG_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+/*
+###############################################################################################
+
+SIMD Image Processing Kernels
+
+Vectorized versions of the per-pixel loops used when uploading textures: the 2x2 box and 4x4
+mipmap filters, the ResampleTexture row filter, and the table lookups used for light scaling
+and gamma correction. The image functions in tr_image.c set up the parameters and call these
+kernels on each row or buffer.
+
+All kernels use the same integer operations as the scalar code, so the output is identical.
+Filter sums are done in 16-bit lanes, which can't overflow (the 4x4 filter sum is at most
+36 * 255), and the division by 36 is done with a multiply and shift which is exact over that
+range.
+
+SSE2 has no byte table lookup, so the SSE2 set has no lookup kernels and the scalar ones are
+used on x86. On ARM64 they use the NEON 64-byte table instructions.
+
+This file has no renderer dependencies so it can also be built into the image_simd_bench
+tool. Kernel selection and the "r_imageBenchmark" command are in cmod_image_simd.c.
+
+###############################################################################################
+*/
+
+/* ******************************************************************************** */
+// Scalar
+/* ******************************************************************************** */
+
+static void R_MipMapBox_scalar( byte *out, const byte *in, int outWidth, int outHeight, int inStride ) {
+	int i, j;
+
+	for ( i = 0; i < outHeight; ++i ) {
+		const byte *row = in + i * 2 * inStride;
+		for ( j = 0; j < outWidth; ++j, out += 4, row += 8 ) {
+			out[0] = ( row[0] + row[4] + row[inStride + 0] + row[inStride + 4] ) >> 2;
+			out[1] = ( row[1] + row[5] + row[inStride + 1] + row[inStride + 5] ) >> 2;
+			out[2] = ( row[2] + row[6] + row[inStride + 2] + row[inStride + 6] ) >> 2;
+			out[3] = ( row[3] + row[7] + row[inStride + 3] + row[inStride + 7] ) >> 2;
+		}
+	}
+}
+
+static void R_MipMapFilter_scalar( byte *out, const byte *in, int inWidth, int inHeight ) {
+	int i, j, k;
+	int inWidthMask = inWidth - 1;
+	int inHeightMask = inHeight - 1;
+	int outWidth = inWidth >> 1;
+	int outHeight = inHeight >> 1;
+
+	for ( i = 0; i < outHeight; i++ ) {
+		for ( j = 0; j < outWidth; j++ ) {
+			byte *outpix = out + ( i * outWidth + j ) * 4;
+			for ( k = 0; k < 4; k++ ) {
+#define PIX( y, x ) in[( ( ( y ) & inHeightMask ) * inWidth + ( ( x ) & inWidthMask ) ) * 4 + k]
+				int total =
+					1 * PIX( i*2-1, j*2-1 ) + 2 * PIX( i*2-1, j*2 ) + 2 * PIX( i*2-1, j*2+1 ) + 1 * PIX( i*2-1, j*2+2 ) +
+					2 * PIX( i*2, j*2-1 ) + 4 * PIX( i*2, j*2 ) + 4 * PIX( i*2, j*2+1 ) + 2 * PIX( i*2, j*2+2 ) +
+					2 * PIX( i*2+1, j*2-1 ) + 4 * PIX( i*2+1, j*2 ) + 4 * PIX( i*2+1, j*2+1 ) + 2 * PIX( i*2+1, j*2+2 ) +
+					1 * PIX( i*2+2, j*2-1 ) + 2 * PIX( i*2+2, j*2 ) + 2 * PIX( i*2+2, j*2+1 ) + 1 * PIX( i*2+2, j*2+2 );
+#undef PIX
+				outpix[k] = total / 36;
+			}
+		}
+	}
+}
+
+static void R_ResampleRow_scalar( byte *out, const byte *inrow, const byte *inrow2,
+		const int *p1, const int *p2, int outWidth ) {
+	int j;
+
+	for ( j = 0; j < outWidth; j++, out += 4 ) {
+		const byte *pix1 = inrow + p1[j];
+		const byte *pix2 = inrow + p2[j];
+		const byte *pix3 = inrow2 + p1[j];
+		const byte *pix4 = inrow2 + p2[j];
+		out[0] = ( pix1[0] + pix2[0] + pix3[0] + pix4[0] ) >> 2;
+		out[1] = ( pix1[1] + pix2[1] + pix3[1] + pix4[1] ) >> 2;
+		out[2] = ( pix1[2] + pix2[2] + pix3[2] + pix4[2] ) >> 2;
+		out[3] = ( pix1[3] + pix2[3] + pix3[3] + pix4[3] ) >> 2;
+	}
+}
+
+static void R_RemapRGB_scalar( byte *data, int pixels, const byte *table ) {
+	int i;
+
+	for ( i = 0; i < pixels; i++, data += 4 ) {
+		data[0] = table[data[0]];
+		data[1] = table[data[1]];
+		data[2] = table[data[2]];
+	}
+}
+
+static void R_RemapBytes_scalar( byte *data, int count, const byte *table ) {
+	int i;
+
+	for ( i = 0; i < count; i++ ) {
+		data[i] = table[data[i]];
+	}
+}
+
+const imageSimdKernels_t imageSimdKernels_scalar = {
+	"scalar", R_MipMapBox_scalar, R_MipMapFilter_scalar, R_ResampleRow_scalar,
+	R_RemapRGB_scalar, R_RemapBytes_scalar };
+
+/* ******************************************************************************** */
+// Shared 4x4 filter setup
+/* ******************************************************************************** */
+
+/*
+=================
+R_MipMapFilter_PadRow
+
+Copies vertical sums for each column used by the 4x4 filter into padded, so the sums for
+output pixel j start at padded[j * 8]. Matches the wraparound of the scalar filter.
+=================
+*/
+static void R_MipMapFilter_PadRow( unsigned short *padded, const unsigned short *vert, int inWidth ) {
+	int inWidthMask = inWidth - 1;
+	int count = ( inWidth >> 1 ) * 2 + 2;
+	int k;
+
+	for ( k = 0; k < count; ++k ) {
+		Com_Memcpy( padded + k * 4, vert + ( ( k - 1 ) & inWidthMask ) * 4, 4 * sizeof( *padded ) );
+	}
+}
+
+#ifdef IMG_SIMD_SSE2
+/* ******************************************************************************** */
+// SSE2
+/* ******************************************************************************** */
+
+static void R_MipMapBox_sse2( byte *out, const byte *in, int outWidth, int outHeight, int inStride ) {
+	const __m128i zero = _mm_setzero_si128();
+	int i;
+
+	for ( i = 0; i < outHeight; ++i ) {
+		const byte *row = in + i * 2 * inStride;
+		byte *outRow = out + i * outWidth * 4;
+		int j = 0;
+
+		for ( ; j + 4 <= outWidth; j += 4 ) {
+			__m128i a0 = _mm_loadu_si128( (const __m128i *)( row + j * 8 ) );
+			__m128i a1 = _mm_loadu_si128( (const __m128i *)( row + j * 8 + 16 ) );
+			__m128i b0 = _mm_loadu_si128( (const __m128i *)( row + inStride + j * 8 ) );
+			__m128i b1 = _mm_loadu_si128( (const __m128i *)( row + inStride + j * 8 + 16 ) );
+
+			// vertical sums for input pixels 0-1, 2-3, 4-5, 6-7
+			__m128i s0 = _mm_add_epi16( _mm_unpacklo_epi8( a0, zero ), _mm_unpacklo_epi8( b0, zero ) );
+			__m128i s1 = _mm_add_epi16( _mm_unpackhi_epi8( a0, zero ), _mm_unpackhi_epi8( b0, zero ) );
+			__m128i s2 = _mm_add_epi16( _mm_unpacklo_epi8( a1, zero ), _mm_unpacklo_epi8( b1, zero ) );
+			__m128i s3 = _mm_add_epi16( _mm_unpackhi_epi8( a1, zero ), _mm_unpackhi_epi8( b1, zero ) );
+
+			// add horizontal pairs
+			__m128i h0 = _mm_add_epi16( _mm_unpacklo_epi64( s0, s1 ), _mm_unpackhi_epi64( s0, s1 ) );
+			__m128i h1 = _mm_add_epi16( _mm_unpacklo_epi64( s2, s3 ), _mm_unpackhi_epi64( s2, s3 ) );
+
+			_mm_storeu_si128( (__m128i *)( outRow + j * 4 ),
+					_mm_packus_epi16( _mm_srli_epi16( h0, 2 ), _mm_srli_epi16( h1, 2 ) ) );
+		}
+
+		if ( j < outWidth ) {
+			R_MipMapBox_scalar( outRow + j * 4, row + j * 8, outWidth - j, 1, inStride );
+		}
+	}
+}
+
+static void R_MipMapFilter_sse2( byte *out, const byte *in, int inWidth, int inHeight ) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i weightA = _mm_set_epi16( 2, 2, 2, 2, 1, 1, 1, 1 );
+	const __m128i weightB = _mm_set_epi16( 1, 1, 1, 1, 2, 2, 2, 2 );
+	const __m128i div36 = _mm_set1_epi16( 7282 );	// ( x * 7282 ) >> 18 == x / 36 for x <= 9180
+	int inHeightMask = inHeight - 1;
+	int outWidth = inWidth >> 1;
+	int outHeight = inHeight >> 1;
+	unsigned short *vert, *padded;
+	int i;
+
+	if ( outWidth < 1 || outHeight < 1 ) {
+		return;
+	}
+
+	// use malloc since this can run on image loader threads
+	vert = (unsigned short *)malloc( ( inWidth * 4 + 8 ) * sizeof( *vert ) );
+	padded = (unsigned short *)malloc( ( outWidth * 2 + 2 ) * 4 * sizeof( *padded ) );
+	if ( !vert || !padded ) {
+		free( vert );
+		free( padded );
+		R_MipMapFilter_scalar( out, in, inWidth, inHeight );
+		return;
+	}
+
+	for ( i = 0; i < outHeight; ++i ) {
+		const byte *r0 = in + ( ( i * 2 - 1 ) & inHeightMask ) * inWidth * 4;
+		const byte *r1 = in + ( ( i * 2 ) & inHeightMask ) * inWidth * 4;
+		const byte *r2 = in + ( ( i * 2 + 1 ) & inHeightMask ) * inWidth * 4;
+		const byte *r3 = in + ( ( i * 2 + 2 ) & inHeightMask ) * inWidth * 4;
+		int count = inWidth * 4;
+		int x = 0, j;
+
+		// vertical 1-2-2-1 sums
+		for ( ; x + 8 <= count; x += 8 ) {
+			__m128i v0 = _mm_unpacklo_epi8( _mm_loadl_epi64( (const __m128i *)( r0 + x ) ), zero );
+			__m128i v1 = _mm_unpacklo_epi8( _mm_loadl_epi64( (const __m128i *)( r1 + x ) ), zero );
+			__m128i v2 = _mm_unpacklo_epi8( _mm_loadl_epi64( (const __m128i *)( r2 + x ) ), zero );
+			__m128i v3 = _mm_unpacklo_epi8( _mm_loadl_epi64( (const __m128i *)( r3 + x ) ), zero );
+			__m128i mid = _mm_add_epi16( v1, v2 );
+			_mm_storeu_si128( (__m128i *)( vert + x ),
+					_mm_add_epi16( _mm_add_epi16( v0, v3 ), _mm_add_epi16( mid, mid ) ) );
+		}
+		for ( ; x < count; ++x ) {
+			vert[x] = r0[x] + 2 * r1[x] + 2 * r2[x] + r3[x];
+		}
+
+		R_MipMapFilter_PadRow( padded, vert, inWidth );
+
+		// horizontal 1-2-2-1 sums and division
+		for ( j = 0; j < outWidth; ++j ) {
+			__m128i a = _mm_loadu_si128( (const __m128i *)( padded + j * 8 ) );
+			__m128i b = _mm_loadu_si128( (const __m128i *)( padded + j * 8 + 8 ) );
+			__m128i sum = _mm_add_epi16( _mm_mullo_epi16( a, weightA ), _mm_mullo_epi16( b, weightB ) );
+			__m128i total = _mm_add_epi16( sum, _mm_srli_si128( sum, 8 ) );
+			__m128i result = _mm_srli_epi16( _mm_mulhi_epu16( total, div36 ), 2 );
+			int pixel = _mm_cvtsi128_si32( _mm_packus_epi16( result, result ) );
+			Com_Memcpy( out + ( i * outWidth + j ) * 4, &pixel, 4 );
+		}
+	}
+
+	free( vert );
+	free( padded );
+}
+
+static void R_ResampleRow_sse2( byte *out, const byte *inrow, const byte *inrow2,
+		const int *p1, const int *p2, int outWidth ) {
+	const __m128i zero = _mm_setzero_si128();
+	int j = 0;
+
+	for ( ; j + 4 <= outWidth; j += 4 ) {
+		int v1[4], v2[4], v3[4], v4[4];
+		__m128i a, b, c, d, lo, hi;
+		int k;
+
+		for ( k = 0; k < 4; ++k ) {
+			Com_Memcpy( &v1[k], inrow + p1[j + k], 4 );
+			Com_Memcpy( &v2[k], inrow + p2[j + k], 4 );
+			Com_Memcpy( &v3[k], inrow2 + p1[j + k], 4 );
+			Com_Memcpy( &v4[k], inrow2 + p2[j + k], 4 );
+		}
+		a = _mm_loadu_si128( (const __m128i *)v1 );
+		b = _mm_loadu_si128( (const __m128i *)v2 );
+		c = _mm_loadu_si128( (const __m128i *)v3 );
+		d = _mm_loadu_si128( (const __m128i *)v4 );
+
+		lo = _mm_add_epi16( _mm_add_epi16( _mm_unpacklo_epi8( a, zero ), _mm_unpacklo_epi8( b, zero ) ),
+				_mm_add_epi16( _mm_unpacklo_epi8( c, zero ), _mm_unpacklo_epi8( d, zero ) ) );
+		hi = _mm_add_epi16( _mm_add_epi16( _mm_unpackhi_epi8( a, zero ), _mm_unpackhi_epi8( b, zero ) ),
+				_mm_add_epi16( _mm_unpackhi_epi8( c, zero ), _mm_unpackhi_epi8( d, zero ) ) );
+
+		_mm_storeu_si128( (__m128i *)( out + j * 4 ),
+				_mm_packus_epi16( _mm_srli_epi16( lo, 2 ), _mm_srli_epi16( hi, 2 ) ) );
+	}
+
+	if ( j < outWidth ) {
+		R_ResampleRow_scalar( out + j * 4, inrow, inrow2, p1 + j, p2 + j, outWidth - j );
+	}
+}
+
+// no table lookup kernels; R_ImageSimd_Select uses the scalar ones
+static const imageSimdKernels_t imageSimdKernels_sse2 = {
+	"sse2", R_MipMapBox_sse2, R_MipMapFilter_sse2, R_ResampleRow_sse2, NULL, NULL };
+#endif
+
+#ifdef IMG_SIMD_NEON
+/* ******************************************************************************** */
+// NEON
+/* ******************************************************************************** */
+
+static void R_MipMapBox_neon( byte *out, const byte *in, int outWidth, int outHeight, int inStride ) {
+	int i;
+
+	for ( i = 0; i < outHeight; ++i ) {
+		const byte *row = in + i * 2 * inStride;
+		byte *outRow = out + i * outWidth * 4;
+		int j = 0;
+
+		for ( ; j + 8 <= outWidth; j += 8 ) {
+			// deinterleave 16 input pixels by channel, then add adjacent pixels
+			uint8x16x4_t a = vld4q_u8( row + j * 8 );
+			uint8x16x4_t b = vld4q_u8( row + inStride + j * 8 );
+			uint8x8x4_t result;
+			int c;
+
+			for ( c = 0; c < 4; ++c ) {
+				uint16x8_t sum = vpadalq_u8( vpaddlq_u8( a.val[c] ), b.val[c] );
+				result.val[c] = vshrn_n_u16( sum, 2 );
+			}
+			vst4_u8( outRow + j * 4, result );
+		}
+
+		if ( j < outWidth ) {
+			R_MipMapBox_scalar( outRow + j * 4, row + j * 8, outWidth - j, 1, inStride );
+		}
+	}
+}
+
+static void R_MipMapFilter_neon( byte *out, const byte *in, int inWidth, int inHeight ) {
+	static const uint16_t weightAValues[8] = { 1, 1, 1, 1, 2, 2, 2, 2 };
+	static const uint16_t weightBValues[8] = { 2, 2, 2, 2, 1, 1, 1, 1 };
+	uint16x8_t weightA = vld1q_u16( weightAValues );
+	uint16x8_t weightB = vld1q_u16( weightBValues );
+	int inHeightMask = inHeight - 1;
+	int outWidth = inWidth >> 1;
+	int outHeight = inHeight >> 1;
+	unsigned short *vert, *padded;
+	int i;
+
+	if ( outWidth < 1 || outHeight < 1 ) {
+		return;
+	}
+
+	// use malloc since this can run on image loader threads
+	vert = (unsigned short *)malloc( ( inWidth * 4 + 8 ) * sizeof( *vert ) );
+	padded = (unsigned short *)malloc( ( outWidth * 2 + 2 ) * 4 * sizeof( *padded ) );
+	if ( !vert || !padded ) {
+		free( vert );
+		free( padded );
+		R_MipMapFilter_scalar( out, in, inWidth, inHeight );
+		return;
+	}
+
+	for ( i = 0; i < outHeight; ++i ) {
+		const byte *r0 = in + ( ( i * 2 - 1 ) & inHeightMask ) * inWidth * 4;
+		const byte *r1 = in + ( ( i * 2 ) & inHeightMask ) * inWidth * 4;
+		const byte *r2 = in + ( ( i * 2 + 1 ) & inHeightMask ) * inWidth * 4;
+		const byte *r3 = in + ( ( i * 2 + 2 ) & inHeightMask ) * inWidth * 4;
+		int count = inWidth * 4;
+		int x = 0, j;
+
+		// vertical 1-2-2-1 sums
+		for ( ; x + 8 <= count; x += 8 ) {
+			uint16x8_t outer = vaddl_u8( vld1_u8( r0 + x ), vld1_u8( r3 + x ) );
+			uint16x8_t mid = vaddl_u8( vld1_u8( r1 + x ), vld1_u8( r2 + x ) );
+			vst1q_u16( vert + x, vaddq_u16( outer, vaddq_u16( mid, mid ) ) );
+		}
+		for ( ; x < count; ++x ) {
+			vert[x] = r0[x] + 2 * r1[x] + 2 * r2[x] + r3[x];
+		}
+
+		R_MipMapFilter_PadRow( padded, vert, inWidth );
+
+		// horizontal 1-2-2-1 sums and division
+		for ( j = 0; j < outWidth; ++j ) {
+			uint16x8_t sum = vaddq_u16( vmulq_u16( vld1q_u16( padded + j * 8 ), weightA ),
+					vmulq_u16( vld1q_u16( padded + j * 8 + 8 ), weightB ) );
+			uint16x4_t total = vadd_u16( vget_low_u16( sum ), vget_high_u16( sum ) );
+			uint16x4_t result = vmovn_u32( vshrq_n_u32( vmull_n_u16( total, 7282 ), 18 ) );
+			uint8x8_t bytes = vmovn_u16( vcombine_u16( result, result ) );
+			vst1_lane_u32( (uint32_t *)( out + ( i * outWidth + j ) * 4 ), vreinterpret_u32_u8( bytes ), 0 );
+		}
+	}
+
+	free( vert );
+	free( padded );
+}
+
+static void R_ResampleRow_neon( byte *out, const byte *inrow, const byte *inrow2,
+		const int *p1, const int *p2, int outWidth ) {
+	int j = 0;
+
+	for ( ; j + 4 <= outWidth; j += 4 ) {
+		uint32_t v1[4], v2[4], v3[4], v4[4];
+		uint8x16_t a, b, c, d;
+		uint16x8_t lo, hi;
+		int k;
+
+		for ( k = 0; k < 4; ++k ) {
+			Com_Memcpy( &v1[k], inrow + p1[j + k], 4 );
+			Com_Memcpy( &v2[k], inrow + p2[j + k], 4 );
+			Com_Memcpy( &v3[k], inrow2 + p1[j + k], 4 );
+			Com_Memcpy( &v4[k], inrow2 + p2[j + k], 4 );
+		}
+		a = vreinterpretq_u8_u32( vld1q_u32( v1 ) );
+		b = vreinterpretq_u8_u32( vld1q_u32( v2 ) );
+		c = vreinterpretq_u8_u32( vld1q_u32( v3 ) );
+		d = vreinterpretq_u8_u32( vld1q_u32( v4 ) );
+
+		lo = vaddq_u16( vaddl_u8( vget_low_u8( a ), vget_low_u8( b ) ), vaddl_u8( vget_low_u8( c ), vget_low_u8( d ) ) );
+		hi = vaddq_u16( vaddl_u8( vget_high_u8( a ), vget_high_u8( b ) ), vaddl_u8( vget_high_u8( c ), vget_high_u8( d ) ) );
+		vst1q_u8( out + j * 4, vcombine_u8( vshrn_n_u16( lo, 2 ), vshrn_n_u16( hi, 2 ) ) );
+	}
+
+	if ( j < outWidth ) {
+		R_ResampleRow_scalar( out + j * 4, inrow, inrow2, p1 + j, p2 + j, outWidth - j );
+	}
+}
+
+typedef struct {
+	uint8x16x4_t part[4];
+} neonTable_t;
+
+static ID_INLINE void R_LoadTable_neon( neonTable_t *out, const byte *table ) {
+	int i;
+	for ( i = 0; i < 4; ++i ) {
+		out->part[i] = vld1q_u8_x4( table + i * 64 );
+	}
+}
+
+// out of range indices return 0 from vqtbl4q and keep the previous value for vqtbx4q,
+// so each 64-entry part only affects indices in its range
+static ID_INLINE uint8x16_t R_Lookup_neon( const neonTable_t *table, uint8x16_t index ) {
+	const uint8x16_t step = vdupq_n_u8( 64 );
+	uint8x16_t result = vqtbl4q_u8( table->part[0], index );
+	index = vsubq_u8( index, step );
+	result = vqtbx4q_u8( result, table->part[1], index );
+	index = vsubq_u8( index, step );
+	result = vqtbx4q_u8( result, table->part[2], index );
+	index = vsubq_u8( index, step );
+	return vqtbx4q_u8( result, table->part[3], index );
+}
+
+static void R_RemapRGB_neon( byte *data, int pixels, const byte *table ) {
+	neonTable_t lookup;
+	int i = 0;
+
+	R_LoadTable_neon( &lookup, table );
+	for ( ; i + 16 <= pixels; i += 16 ) {
+		uint8x16x4_t pix = vld4q_u8( data + i * 4 );
+		pix.val[0] = R_Lookup_neon( &lookup, pix.val[0] );
+		pix.val[1] = R_Lookup_neon( &lookup, pix.val[1] );
+		pix.val[2] = R_Lookup_neon( &lookup, pix.val[2] );
+		vst4q_u8( data + i * 4, pix );
+	}
+
+	if ( i < pixels ) {
+		R_RemapRGB_scalar( data + i * 4, pixels - i, table );
+	}
+}
+
+static void R_RemapBytes_neon( byte *data, int count, const byte *table ) {
+	neonTable_t lookup;
+	int i = 0;
+
+	R_LoadTable_neon( &lookup, table );
+	for ( ; i + 16 <= count; i += 16 ) {
+		vst1q_u8( data + i, R_Lookup_neon( &lookup, vld1q_u8( data + i ) ) );
+	}
+
+	if ( i < count ) {
+		R_RemapBytes_scalar( data + i, count - i, table );
+	}
+}
+
+static const imageSimdKernels_t imageSimdKernels_neon = {
+	"neon", R_MipMapBox_neon, R_MipMapFilter_neon, R_ResampleRow_neon,
+	R_RemapRGB_neon, R_RemapBytes_neon };
+#endif
+
+/* ******************************************************************************** */
+// Kernel Sets
+/* ******************************************************************************** */
+
+/*
+=================
+R_ImageSimd_Available
+
+Writes supported kernel sets to list, fastest first. Returns count, which is at least 1.
+Scalar is always last.
+=================
+*/
+int R_ImageSimd_Available( const imageSimdKernels_t **list ) {
+	int count = 0;
+#ifdef IMG_SIMD_SSE2
+	list[count++] = &imageSimdKernels_sse2;
+#endif
+#ifdef IMG_SIMD_NEON
+	list[count++] = &imageSimdKernels_neon;
+#endif
+	list[count++] = &imageSimdKernels_scalar;
+	return count;
+}
+
+/* ******************************************************************************** */
+// Benchmark
+/* ******************************************************************************** */
+
+const char *imageBenchStageNames[IMAGE_BENCH_COUNT] = {
+	"resample", "mip box", "mip 4x4", "light scale", "gamma" };
+
+/*
+=================
+R_ImageSimd_HasStage
+
+Returns whether the kernel set has its own kernel for a benchmark stage.
+=================
+*/
+qboolean R_ImageSimd_HasStage( const imageSimdKernels_t *kernels, imageBenchStage_t stage ) {
+	switch ( stage ) {
+		case IMAGE_BENCH_RESAMPLE:
+			return kernels->resampleRow ? qtrue : qfalse;
+		case IMAGE_BENCH_MIPMAP_BOX:
+			return kernels->mipMapBox ? qtrue : qfalse;
+		case IMAGE_BENCH_MIPMAP_FILTER:
+			return kernels->mipMapFilter ? qtrue : qfalse;
+		case IMAGE_BENCH_REMAP_RGB:
+			return kernels->remapRGB ? qtrue : qfalse;
+		case IMAGE_BENCH_REMAP_BYTES:
+			return kernels->remapBytes ? qtrue : qfalse;
+		default:
+			return qfalse;
+	}
+}
+
+/*
+=================
+R_ImageSimd_BenchResample
+
+Same setup as ResampleTexture, resampling to half width and height plus one pixel so the
+filter positions are uneven.
+=================
+*/
+static void R_ImageSimd_BenchResample( const imageSimdKernels_t *kernels, const byte *in, int inwidth,
+		int inheight, byte *out, int outwidth, int outheight, int *p1, int *p2 ) {
+	int i, frac, fracstep;
+
+	fracstep = inwidth * 0x10000 / outwidth;
+	frac = fracstep >> 2;
+	for ( i = 0; i < outwidth; i++ ) {
+		p1[i] = 4 * ( frac >> 16 );
+		frac += fracstep;
+	}
+	frac = 3 * ( fracstep >> 2 );
+	for ( i = 0; i < outwidth; i++ ) {
+		p2[i] = 4 * ( frac >> 16 );
+		frac += fracstep;
+	}
+
+	for ( i = 0; i < outheight; i++ ) {
+		const byte *inrow = in + 4 * inwidth * (int)( ( i + 0.25 ) * inheight / outheight );
+		const byte *inrow2 = in + 4 * inwidth * (int)( ( i + 0.75 ) * inheight / outheight );
+		kernels->resampleRow( out + i * outwidth * 4, inrow, inrow2, p1, p2, outwidth );
+	}
+}
+
+/*
+=================
+R_ImageSimd_BenchSet
+
+Runs each stage the kernel set has on a copy of the image, accumulating time in result.
+Output of each stage is written to the corresponding buffer in outputs for comparison.
+=================
+*/
+static void R_ImageSimd_BenchSet( const imageSimdKernels_t *kernels, imageBenchClock_t clock,
+		const byte *pic, int width, int height, byte *work, byte *outputs[IMAGE_BENCH_COUNT],
+		const byte *table, int *p1, int *p2, imageBenchResult_t *result ) {
+	int size = width * height * 4;
+	int resampleWidth = width / 2 + 1;
+	int resampleHeight = height / 2 + 1;
+	int iteration;
+
+	for ( iteration = 0; iteration < IMAGE_BENCHMARK_ITERATIONS; ++iteration ) {
+		uint64_t start;
+		int w, h;
+
+		if ( kernels->resampleRow ) {
+			start = clock();
+			R_ImageSimd_BenchResample( kernels, pic, width, height, outputs[IMAGE_BENCH_RESAMPLE],
+					resampleWidth, resampleHeight, p1, p2 );
+			result->ticks[IMAGE_BENCH_RESAMPLE] += clock() - start;
+		}
+
+		// full box filter mip chain, in place
+		if ( kernels->mipMapBox ) {
+			Com_Memcpy( work, pic, size );
+			start = clock();
+			for ( w = width, h = height; w > 1 && h > 1; w >>= 1, h >>= 1 ) {
+				kernels->mipMapBox( work, work, w >> 1, h >> 1, w * 4 );
+			}
+			result->ticks[IMAGE_BENCH_MIPMAP_BOX] += clock() - start;
+			Com_Memcpy( outputs[IMAGE_BENCH_MIPMAP_BOX], work, size );
+		}
+
+		// one level of the 4x4 filter
+		if ( kernels->mipMapFilter ) {
+			start = clock();
+			kernels->mipMapFilter( outputs[IMAGE_BENCH_MIPMAP_FILTER], pic, width, height );
+			result->ticks[IMAGE_BENCH_MIPMAP_FILTER] += clock() - start;
+		}
+
+		if ( kernels->remapRGB ) {
+			Com_Memcpy( outputs[IMAGE_BENCH_REMAP_RGB], pic, size );
+			start = clock();
+			kernels->remapRGB( outputs[IMAGE_BENCH_REMAP_RGB], width * height, table );
+			result->ticks[IMAGE_BENCH_REMAP_RGB] += clock() - start;
+		}
+
+		if ( kernels->remapBytes ) {
+			Com_Memcpy( outputs[IMAGE_BENCH_REMAP_BYTES], pic, size );
+			start = clock();
+			kernels->remapBytes( outputs[IMAGE_BENCH_REMAP_BYTES], size, table );
+			result->ticks[IMAGE_BENCH_REMAP_BYTES] += clock() - start;
+		}
+	}
+}
+
+/*
+=================
+R_ImageSimd_BenchImage
+
+Runs the scalar kernels and each kernel set in list on an RGBA image, adding time to the
+corresponding entry in results and flagging stages which don't match the scalar output.
+Scalar must be the last entry in list, as returned by R_ImageSimd_Available. Returns qfalse
+if buffers couldn't be allocated.
+=================
+*/
+qboolean R_ImageSimd_BenchImage( const imageSimdKernels_t **list, int count, imageBenchClock_t clock,
+		const byte *pic, int width, int height, const byte *table, imageBenchResult_t *results ) {
+	int size = width * height * 4;
+	byte *work = (byte *)malloc( size );
+	byte *reference[IMAGE_BENCH_COUNT], *outputs[IMAGE_BENCH_COUNT];
+	int *p1 = (int *)malloc( ( width / 2 + 1 ) * sizeof( *p1 ) );
+	int *p2 = (int *)malloc( ( width / 2 + 1 ) * sizeof( *p2 ) );
+	qboolean success = work && p1 && p2 ? qtrue : qfalse;
+	int i, k;
+
+	for ( k = 0; k < IMAGE_BENCH_COUNT; ++k ) {
+		reference[k] = (byte *)calloc( size, 1 );
+		outputs[k] = (byte *)calloc( size, 1 );
+		if ( !reference[k] || !outputs[k] ) {
+			success = qfalse;
+		}
+	}
+
+	if ( success ) {
+		R_ImageSimd_BenchSet( list[count - 1], clock, pic, width, height, work, reference, table,
+				p1, p2, &results[count - 1] );
+		for ( i = 0; i < count - 1; ++i ) {
+			R_ImageSimd_BenchSet( list[i], clock, pic, width, height, work, outputs, table,
+					p1, p2, &results[i] );
+			for ( k = 0; k < IMAGE_BENCH_COUNT; ++k ) {
+				if ( R_ImageSimd_HasStage( list[i], (imageBenchStage_t)k ) &&
+						memcmp( outputs[k], reference[k], size ) ) {
+					results[i].mismatch[k] = qtrue;
+				}
+			}
+		}
+	}
+
+	for ( k = 0; k < IMAGE_BENCH_COUNT; ++k ) {
+		free( reference[k] );
+		free( outputs[k] );
+	}
+	free( p1 );
+	free( p2 );
+	free( work );
+	return success;
+}
+
+#endif
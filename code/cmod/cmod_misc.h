@@ -52,11 +52,36 @@ unsigned int cmod_read_token(const char **current, char *buffer, unsigned int bu
 unsigned int cmod_read_token_ws(const char **current, char *buffer, unsigned int buffer_size);
 #endif
 
+#ifdef CMOD_COMMON_THREADS
+typedef struct cmThread_s cmThread_t;
+cmThread_t *CMThread_Create( void ( *func )( void *arg ), void *arg );
+void CMThread_Join( cmThread_t *thread );
+int CMThread_ProcessorCount( void );
+void CMThread_RunParallel( int numThreads, void ( *func )( int threadNum, void *context ), void *context );
+#endif
+
+#ifdef CMOD_MICROSECOND_TIMER
+int64_t Sys_Microseconds( void );
+#endif
+
+#ifdef CMOD_FRAME_TRACE
+extern qboolean cmTraceActive;
+void CMTrace_BeginSpan( const char *name );
+void CMTrace_EndSpan( void );
+void CMTrace_BeginFrame( void );
+void CMTrace_DiscardEvents( void );
+void CMTrace_Init( void );
+// span name must be a static string
+#define CMTRACE_BEGIN( name ) do { if ( cmTraceActive ) CMTrace_BeginSpan( name ); } while ( 0 )
+#define CMTRACE_END() do { if ( cmTraceActive ) CMTrace_EndSpan(); } while ( 0 )
+#endif
+
 #ifdef CMOD_LOGGING_SYSTEM
 // id, name, date mode
 #define CMLogList \
 	CMLogEntry(LOG_SERVER, "server", 1) \
 	CMLogEntry(LOG_RECORD, "record", 1) \
+	CMLogEntry(LOG_HITCH, "hitch", 1) \
 
 #define CMLogEntry(id, name, date_mode) id,
 typedef enum {
@@ -116,6 +141,17 @@ void ClientAltSwap_ModifyCommand( usercmd_t *cmd );
 void ClientAltSwap_SetState( qboolean swap );
 #endif
 
+#ifdef CMOD_DEMO_SEEK
+void CMDemoSeek_OnGamestate( void );
+void CMDemoSeek_Cmd( void );
+#endif
+
+#ifdef CMOD_DEMO_RENDER
+qboolean CMDemoRender_Active( void );
+void CMDemoRender_Frame( void );
+void CMDemoRender_Cmd( void );
+#endif
+
 #ifdef CMOD_FAST_SOUND_RESET
 void S_ResetStaleSounds( void );
 #endif
@@ -164,3 +200,44 @@ int SV_StatusScoresOverride_AdjustScore( int defaultScore, int clientNum );
 #ifdef CMOD_URI_REGISTER_COMMAND
 void Stef_UriCmd( void );
 #endif
+
+#ifdef CMOD_METRICS_ENDPOINT
+void SV_Metrics_Write( cmod_stream_t *stream );
+#endif
+
+#ifdef CMOD_BANDWIDTH_PROFILE
+#define MSG_PROFILE_FIELDS 64
+#define MSG_PROFILE_ENTITY_TYPES 256
+
+typedef struct {
+	int64_t count;
+	int64_t bits;
+} msgProfileCounter_t;
+
+// Encoded bits attributed by MSG_WriteDeltaEntity and MSG_WriteDeltaPlayerstate while msgProfile
+// is set. Player fields are followed by the stats, persistant, ammo, and powerups arrays.
+typedef struct {
+	msgProfileCounter_t entityFields[MSG_PROFILE_FIELDS];
+	msgProfileCounter_t playerFields[MSG_PROFILE_FIELDS];
+	msgProfileCounter_t entityTypes[MSG_PROFILE_ENTITY_TYPES];
+} msgProfile_t;
+
+extern msgProfile_t *msgProfile;
+const char *MSG_ProfileEntityFieldName( int index );
+const char *MSG_ProfilePlayerFieldName( int index );
+#endif
+
+#ifdef CMOD_TRACE_CACHE
+qboolean CMTraceCache_Lookup( trace_t *results, const vec3_t start, const vec3_t end,
+		const vec3_t mins, const vec3_t maxs, clipHandle_t model, int brushmask, int capsule );
+void CMTraceCache_Store( const trace_t *results, const vec3_t start, const vec3_t end,
+		const vec3_t mins, const vec3_t maxs, clipHandle_t model, int brushmask, int capsule );
+void CMTraceCache_Invalidate( void );
+void CMTraceCache_Init( void );
+#endif
+
+#ifdef CMOD_PATCH_COLLIDE_CACHE
+void CMPatchCache_Begin( unsigned int checksum, int numSurfaces );
+struct patchCollide_s *CMPatchCache_Get( int surfaceNum, int width, int height );
+void CMPatchCache_End( void );
+#endif
@@ -0,0 +1,448 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+Copyright (C) 2017 Noah Metzger (chomenor@gmail.com)
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+
+#ifdef CMOD_PATCH_COLLIDE_CACHE
+#include "../qcommon/cm_local.h"
+#include "../qcommon/cm_patch.h"
+
+/*
+###############################################################################################
+
+Patch Collide Cache
+
+Generating patch collision data (CM_GeneratePatchCollide) involves subdividing every curve
+and computing facet bevels, which takes a noticeable part of the load time on curve-heavy
+maps. When enabled by the cm_patchCache cvar, the generated data is written to a file in
+the cache directory keyed by the collision checksum of the bsp (CM_Checksum), and loaded
+from there on subsequent map loads.
+
+The cache is treated as disposable. Any mismatch in the file (version, checksum, patch
+dimensions, or out of range values) causes the affected patches to be regenerated normally,
+and the cache file to be rewritten after the map finishes loading.
+
+File format (all values 32-bit little endian):
+   header: magic, version, bsp checksum, surface count, patch count
+   per patch: surface number, width, height, bounds[6], plane count, facet count,
+      planes[plane count] (plane[4], signbits), facets[facet count] (see CMPatchCache_ReadFacet)
+
+###############################################################################################
+*/
+
+#define PATCH_CACHE_MAGIC 0x43505043	// "CPPC"
+#define PATCH_CACHE_VERSION 1
+#define PATCH_CACHE_HEADER_WORDS 5
+#define PATCH_CACHE_RECORD_WORDS 11
+#define PATCH_CACHE_PLANE_WORDS 5
+#define PATCH_CACHE_FACET_WORDS ( 2 + 3 * ( 4 + 6 + 16 ) )
+
+static void CMPatchCache_Free( void );
+
+static struct {
+	unsigned int checksum;
+	char *data;			// file contents, or null if not loaded
+	int dataWords;
+	int *surfaceOffsets;	// word offset of record for each surface, or -1
+	int *surfaceDims;		// width and height of each patch surface, for writing cache
+	int numSurfaces;
+	qboolean needsWrite;
+} patchCache;
+
+/*
+=================
+CMPatchCache_Path
+=================
+*/
+static const char *CMPatchCache_Path( unsigned int checksum ) {
+	return va( "patchcache/%08x.pcc", checksum );
+}
+
+/*
+=================
+CMPatchCache_Word
+=================
+*/
+static int CMPatchCache_Word( int offset ) {
+	return LittleLong( ( (const int *)patchCache.data )[offset] );
+}
+
+/*
+=================
+CMPatchCache_Float
+=================
+*/
+static float CMPatchCache_Float( int offset ) {
+	floatint_t fi;
+	fi.i = CMPatchCache_Word( offset );
+	return fi.f;
+}
+
+/*
+=================
+CMPatchCache_RecordWords
+
+Returns total length of record at given offset, or -1 if invalid.
+=================
+*/
+static int CMPatchCache_RecordWords( int offset ) {
+	int numPlanes, numFacets;
+
+	if ( offset + PATCH_CACHE_RECORD_WORDS > patchCache.dataWords ) {
+		return -1;
+	}
+
+	numPlanes = CMPatchCache_Word( offset + 9 );
+	numFacets = CMPatchCache_Word( offset + 10 );
+	if ( numPlanes < 0 || numPlanes > MAX_PATCH_PLANES || numFacets < 0 || numFacets > MAX_FACETS ) {
+		return -1;
+	}
+
+	return PATCH_CACHE_RECORD_WORDS + numPlanes * PATCH_CACHE_PLANE_WORDS + numFacets * PATCH_CACHE_FACET_WORDS;
+}
+
+/*
+=================
+CMPatchCache_LoadFile
+
+Returns qtrue if cache file was loaded and header matches current map.
+=================
+*/
+static qboolean CMPatchCache_LoadFile( void ) {
+	char path[FS_MAX_PATH];
+	unsigned int size = 0;
+	int offset;
+	int patchCount;
+	int i;
+
+	if ( !FS_GeneratePathWritedir( XDG_CACHE, CMPatchCache_Path( patchCache.checksum ), NULL,
+			FS_ALLOW_DIRECTORIES, 0, path, sizeof( path ) ) ) {
+		return qfalse;
+	}
+
+	patchCache.data = FS_ReadData( NULL, path, &size, "CMPatchCache_LoadFile" );
+	if ( !patchCache.data ) {
+		return qfalse;
+	}
+	patchCache.dataWords = size / 4;
+
+	if ( patchCache.dataWords < PATCH_CACHE_HEADER_WORDS || CMPatchCache_Word( 0 ) != PATCH_CACHE_MAGIC ||
+			CMPatchCache_Word( 1 ) != PATCH_CACHE_VERSION || (unsigned int)CMPatchCache_Word( 2 ) != patchCache.checksum ||
+			CMPatchCache_Word( 3 ) != patchCache.numSurfaces ) {
+		return qfalse;
+	}
+
+	// index the patch records
+	patchCount = CMPatchCache_Word( 4 );
+	offset = PATCH_CACHE_HEADER_WORDS;
+	for ( i = 0; i < patchCount; ++i ) {
+		int surfaceNum;
+		int length = CMPatchCache_RecordWords( offset );
+		if ( length < 0 || offset + length > patchCache.dataWords ) {
+			return qfalse;
+		}
+
+		surfaceNum = CMPatchCache_Word( offset );
+		if ( surfaceNum < 0 || surfaceNum >= patchCache.numSurfaces ) {
+			return qfalse;
+		}
+
+		patchCache.surfaceOffsets[surfaceNum] = offset;
+		offset += length;
+	}
+
+	return qtrue;
+}
+
+/*
+=================
+CMPatchCache_Begin
+
+Called before loading patches for a new map.
+=================
+*/
+void CMPatchCache_Begin( unsigned int checksum, int numSurfaces ) {
+	int i;
+
+	// clear any state left over from a load that was aborted by an error
+	CMPatchCache_Free();
+	if ( !cm_patchCache->integer ) {
+		return;
+	}
+
+	patchCache.checksum = checksum;
+	patchCache.numSurfaces = numSurfaces;
+	patchCache.surfaceOffsets = (int *)Z_Malloc( sizeof( *patchCache.surfaceOffsets ) * ( numSurfaces + 1 ) );
+	patchCache.surfaceDims = (int *)Z_Malloc( sizeof( *patchCache.surfaceDims ) * 2 * ( numSurfaces + 1 ) );
+	for ( i = 0; i < numSurfaces; ++i ) {
+		patchCache.surfaceOffsets[i] = -1;
+	}
+
+	if ( !CMPatchCache_LoadFile() ) {
+		for ( i = 0; i < numSurfaces; ++i ) {
+			patchCache.surfaceOffsets[i] = -1;
+		}
+		patchCache.needsWrite = qtrue;
+	}
+}
+
+/*
+=================
+CMPatchCache_ReadFacet
+=================
+*/
+static qboolean CMPatchCache_ReadFacet( int offset, facet_t *facet, int numPlanes ) {
+	int i;
+
+	facet->surfacePlane = CMPatchCache_Word( offset++ );
+	facet->numBorders = CMPatchCache_Word( offset++ );
+	if ( facet->surfacePlane < 0 || facet->surfacePlane >= numPlanes ||
+			facet->numBorders < 0 || facet->numBorders > ARRAY_LEN( facet->borderPlanes ) ) {
+		return qfalse;
+	}
+
+	for ( i = 0; i < ARRAY_LEN( facet->borderPlanes ); ++i ) {
+		facet->borderPlanes[i] = CMPatchCache_Word( offset++ );
+		if ( i < facet->numBorders && ( facet->borderPlanes[i] < 0 || facet->borderPlanes[i] >= numPlanes ) ) {
+			return qfalse;
+		}
+	}
+	for ( i = 0; i < ARRAY_LEN( facet->borderInward ); ++i ) {
+		facet->borderInward[i] = CMPatchCache_Word( offset++ );
+	}
+	for ( i = 0; i < ARRAY_LEN( facet->borderNoAdjust ); ++i ) {
+		facet->borderNoAdjust[i] = CMPatchCache_Word( offset++ ) ? qtrue : qfalse;
+	}
+
+	return qtrue;
+}
+
+/*
+=================
+CMPatchCache_Get
+
+Returns cached patch collide for surface, or null if not available. Result is allocated
+on the hunk, the same as CM_GeneratePatchCollide. Should be called for every patch surface.
+=================
+*/
+struct patchCollide_s *CMPatchCache_Get( int surfaceNum, int width, int height ) {
+	int offset;
+	int numPlanes, numFacets;
+	static patchPlane_t planes[MAX_PATCH_PLANES];
+	static facet_t facets[MAX_FACETS];
+	patchCollide_t *pf;
+	int i;
+
+	if ( !patchCache.surfaceOffsets || surfaceNum < 0 || surfaceNum >= patchCache.numSurfaces ) {
+		return NULL;
+	}
+
+	patchCache.surfaceDims[surfaceNum * 2] = width;
+	patchCache.surfaceDims[surfaceNum * 2 + 1] = height;
+
+	offset = patchCache.surfaceOffsets[surfaceNum];
+	if ( offset < 0 ) {
+		patchCache.needsWrite = qtrue;
+		return NULL;
+	}
+
+	if ( CMPatchCache_Word( offset + 1 ) != width || CMPatchCache_Word( offset + 2 ) != height ) {
+		patchCache.needsWrite = qtrue;
+		return NULL;
+	}
+
+	// read planes and facets into temporary storage first, so nothing is allocated
+	// if validation fails
+	numPlanes = CMPatchCache_Word( offset + 9 );
+	numFacets = CMPatchCache_Word( offset + 10 );
+	offset += PATCH_CACHE_RECORD_WORDS;
+
+	for ( i = 0; i < numPlanes; ++i ) {
+		planes[i].plane[0] = CMPatchCache_Float( offset++ );
+		planes[i].plane[1] = CMPatchCache_Float( offset++ );
+		planes[i].plane[2] = CMPatchCache_Float( offset++ );
+		planes[i].plane[3] = CMPatchCache_Float( offset++ );
+		planes[i].signbits = CMPatchCache_Word( offset++ );
+	}
+
+	for ( i = 0; i < numFacets; ++i ) {
+		if ( !CMPatchCache_ReadFacet( offset, &facets[i], numPlanes ) ) {
+			patchCache.needsWrite = qtrue;
+			return NULL;
+		}
+		offset += PATCH_CACHE_FACET_WORDS;
+	}
+
+	offset = patchCache.surfaceOffsets[surfaceNum];
+	pf = Hunk_Alloc( sizeof( *pf ), h_high );
+	for ( i = 0; i < 3; ++i ) {
+		pf->bounds[0][i] = CMPatchCache_Float( offset + 3 + i );
+		pf->bounds[1][i] = CMPatchCache_Float( offset + 6 + i );
+	}
+	pf->numPlanes = numPlanes;
+	pf->numFacets = numFacets;
+	pf->facets = Hunk_Alloc( numFacets * sizeof( *pf->facets ), h_high );
+	Com_Memcpy( pf->facets, facets, numFacets * sizeof( *pf->facets ) );
+	pf->planes = Hunk_Alloc( numPlanes * sizeof( *pf->planes ), h_high );
+	Com_Memcpy( pf->planes, planes, numPlanes * sizeof( *pf->planes ) );
+
+	return pf;
+}
+
+/*
+=================
+CMPatchCache_WriteWords
+=================
+*/
+static void CMPatchCache_WriteWords( fileHandle_t fp, int *words, int count ) {
+	int i;
+	for ( i = 0; i < count; ++i ) {
+		words[i] = LittleLong( words[i] );
+	}
+	FS_Write( words, count * sizeof( *words ), fp );
+}
+
+/*
+=================
+CMPatchCache_FloatWord
+=================
+*/
+static int CMPatchCache_FloatWord( float value ) {
+	floatint_t fi;
+	fi.f = value;
+	return fi.i;
+}
+
+/*
+=================
+CMPatchCache_WriteFile
+=================
+*/
+static void CMPatchCache_WriteFile( void ) {
+	const char *path = CMPatchCache_Path( patchCache.checksum );
+	fileHandle_t fp;
+	int words[PATCH_CACHE_FACET_WORDS];
+	int patchCount = 0;
+	int i, j, k;
+
+	for ( i = 0; i < cm.numSurfaces; ++i ) {
+		if ( cm.surfaces[i] && cm.surfaces[i]->pc ) {
+			++patchCount;
+		}
+	}
+	if ( !patchCount ) {
+		return;
+	}
+
+	fp = FS_BaseDir_FOpenFileWrite( XDG_CACHE, path );
+	if ( !fp ) {
+		Com_DPrintf( "CMPatchCache_WriteFile: failed to open %s\n", path );
+		return;
+	}
+
+	words[0] = PATCH_CACHE_MAGIC;
+	words[1] = PATCH_CACHE_VERSION;
+	words[2] = (int)patchCache.checksum;
+	words[3] = cm.numSurfaces;
+	words[4] = patchCount;
+	CMPatchCache_WriteWords( fp, words, PATCH_CACHE_HEADER_WORDS );
+
+	for ( i = 0; i < cm.numSurfaces; ++i ) {
+		const cPatch_t *patch = cm.surfaces[i];
+		const patchCollide_t *pc;
+		if ( !patch || !patch->pc ) {
+			continue;
+		}
+		pc = patch->pc;
+
+		words[0] = i;
+		words[1] = patchCache.surfaceDims[i * 2];
+		words[2] = patchCache.surfaceDims[i * 2 + 1];
+		for ( j = 0; j < 3; ++j ) {
+			words[3 + j] = CMPatchCache_FloatWord( pc->bounds[0][j] );
+			words[6 + j] = CMPatchCache_FloatWord( pc->bounds[1][j] );
+		}
+		words[9] = pc->numPlanes;
+		words[10] = pc->numFacets;
+		CMPatchCache_WriteWords( fp, words, PATCH_CACHE_RECORD_WORDS );
+
+		for ( j = 0; j < pc->numPlanes; ++j ) {
+			for ( k = 0; k < 4; ++k ) {
+				words[k] = CMPatchCache_FloatWord( pc->planes[j].plane[k] );
+			}
+			words[4] = pc->planes[j].signbits;
+			CMPatchCache_WriteWords( fp, words, PATCH_CACHE_PLANE_WORDS );
+		}
+
+		for ( j = 0; j < pc->numFacets; ++j ) {
+			const facet_t *facet = &pc->facets[j];
+			int count = 0;
+			words[count++] = facet->surfacePlane;
+			words[count++] = facet->numBorders;
+			for ( k = 0; k < ARRAY_LEN( facet->borderPlanes ); ++k ) {
+				words[count++] = facet->borderPlanes[k];
+			}
+			for ( k = 0; k < ARRAY_LEN( facet->borderInward ); ++k ) {
+				words[count++] = facet->borderInward[k];
+			}
+			for ( k = 0; k < ARRAY_LEN( facet->borderNoAdjust ); ++k ) {
+				words[count++] = facet->borderNoAdjust[k];
+			}
+			CMPatchCache_WriteWords( fp, words, count );
+		}
+	}
+
+	FS_FCloseFile( fp );
+	Com_DPrintf( "Wrote patch collide cache %s for %i patches\n", path, patchCount );
+}
+
+/*
+=================
+CMPatchCache_Free
+=================
+*/
+static void CMPatchCache_Free( void ) {
+	if ( patchCache.data ) {
+		FS_FreeData( patchCache.data );
+	}
+	if ( patchCache.surfaceOffsets ) {
+		Z_Free( patchCache.surfaceOffsets );
+	}
+	if ( patchCache.surfaceDims ) {
+		Z_Free( patchCache.surfaceDims );
+	}
+	Com_Memset( &patchCache, 0, sizeof( patchCache ) );
+}
+
+/*
+=================
+CMPatchCache_End
+
+Called after patches are loaded. Writes the cache file if any patches had to be generated.
+=================
+*/
+void CMPatchCache_End( void ) {
+	if ( patchCache.surfaceOffsets && patchCache.needsWrite ) {
+		CMPatchCache_WriteFile();
+	}
+	CMPatchCache_Free();
+}
+#endif
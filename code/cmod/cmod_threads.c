@@ -0,0 +1,186 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+Copyright (C) 2017 Noah Metzger (chomenor@gmail.com)
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+
+#ifdef CMOD_COMMON_THREADS
+#include "../qcommon/q_shared.h"
+#include "../qcommon/qcommon.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+/*
+###############################################################################################
+
+Thread Functions
+
+Minimal wrappers around the platform thread APIs. Thread handles are allocated with malloc
+rather than the zone allocator so these functions are safe to call from any thread.
+
+###############################################################################################
+*/
+
+#define MAX_PARALLEL_THREADS 64
+
+struct cmThread_s {
+	void ( *func )( void *arg );
+	void *arg;
+#ifdef _WIN32
+	HANDLE handle;
+#else
+	pthread_t handle;
+#endif
+};
+
+#ifdef _WIN32
+static DWORD WINAPI CMThread_Entry( LPVOID param ) {
+	cmThread_t *thread = (cmThread_t *)param;
+	thread->func( thread->arg );
+	return 0;
+}
+#else
+static void *CMThread_Entry( void *param ) {
+	cmThread_t *thread = (cmThread_t *)param;
+	thread->func( thread->arg );
+	return NULL;
+}
+#endif
+
+/*
+=================
+CMThread_Create
+
+Starts a new thread running func. Returns NULL on error.
+Returned thread must be released with CMThread_Join.
+=================
+*/
+cmThread_t *CMThread_Create( void ( *func )( void *arg ), void *arg ) {
+	cmThread_t *thread = (cmThread_t *)calloc( 1, sizeof( *thread ) );
+	if ( !thread ) {
+		return NULL;
+	}
+	thread->func = func;
+	thread->arg = arg;
+
+#ifdef _WIN32
+	thread->handle = CreateThread( NULL, 0, CMThread_Entry, (LPVOID)thread, 0, NULL );
+	if ( !thread->handle ) {
+		free( thread );
+		return NULL;
+	}
+#else
+	if ( pthread_create( &thread->handle, NULL, CMThread_Entry, (void *)thread ) ) {
+		free( thread );
+		return NULL;
+	}
+#endif
+
+	return thread;
+}
+
+/*
+=================
+CMThread_Join
+
+Waits for thread to finish and frees it.
+=================
+*/
+void CMThread_Join( cmThread_t *thread ) {
+#ifdef _WIN32
+	WaitForSingleObject( thread->handle, INFINITE );
+	CloseHandle( thread->handle );
+#else
+	pthread_join( thread->handle, NULL );
+#endif
+	free( thread );
+}
+
+/*
+=================
+CMThread_ProcessorCount
+
+Returns number of logical processors available, or 1 if unknown.
+=================
+*/
+int CMThread_ProcessorCount( void ) {
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo( &info );
+	return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+#else
+	long count = sysconf( _SC_NPROCESSORS_ONLN );
+	return count > 0 ? (int)count : 1;
+#endif
+}
+
+typedef struct {
+	void ( *func )( int threadNum, void *context );
+	void *context;
+	int threadNum;
+} parallelJob_t;
+
+static void CMThread_ParallelEntry( void *arg ) {
+	parallelJob_t *job = (parallelJob_t *)arg;
+	job->func( job->threadNum, job->context );
+}
+
+/*
+=================
+CMThread_RunParallel
+
+Calls func once for each thread number from 0 to numThreads-1, running concurrently, and
+waits for all calls to complete. Thread number 0 runs on the calling thread. If a worker
+thread fails to start, its call runs on the calling thread instead.
+=================
+*/
+void CMThread_RunParallel( int numThreads, void ( *func )( int threadNum, void *context ), void *context ) {
+	int i;
+	parallelJob_t jobs[MAX_PARALLEL_THREADS];
+	cmThread_t *threads[MAX_PARALLEL_THREADS];
+
+	if ( numThreads > MAX_PARALLEL_THREADS ) {
+		numThreads = MAX_PARALLEL_THREADS;
+	}
+
+	for ( i = 1; i < numThreads; ++i ) {
+		jobs[i].func = func;
+		jobs[i].context = context;
+		jobs[i].threadNum = i;
+		threads[i] = CMThread_Create( CMThread_ParallelEntry, &jobs[i] );
+	}
+
+	func( 0, context );
+
+	for ( i = 1; i < numThreads; ++i ) {
+		if ( threads[i] ) {
+			CMThread_Join( threads[i] );
+		} else {
+			func( i, context );
+		}
+	}
+}
+
+#endif
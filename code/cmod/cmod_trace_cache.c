@@ -0,0 +1,495 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+Copyright (C) 2017 Noah Metzger (chomenor@gmail.com)
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+
+#ifdef CMOD_TRACE_CACHE
+#include "../qcommon/q_shared.h"
+#include "../qcommon/qcommon.h"
+#include "../qcommon/cm_public.h"
+
+/*
+###############################################################################################
+
+Trace Cache
+
+Bots and game code frequently issue identical CM_BoxTrace calls within the same frame.
+When enabled by the cm_traceCache cvar, results for world and inline model traces are
+memoized in a direct-mapped table keyed on the exact trace inputs.
+
+The table is invalidated every frame and on map changes by advancing the generation
+counter, so stale entries never need to be explicitly cleared. Traces against temporary
+box/capsule models (which represent entities positioned by the caller) bypass the cache,
+since their results depend on state set by CM_TempBoxModel rather than the trace inputs.
+
+###############################################################################################
+*/
+
+#define TRACE_CACHE_SIZE 4096	// must be power of 2
+
+typedef struct {
+	vec3_t start;
+	vec3_t end;
+	vec3_t mins;
+	vec3_t maxs;
+	int model;
+	int brushmask;
+	int capsule;
+} traceCacheKey_t;
+
+typedef struct {
+	traceCacheKey_t key;
+	unsigned int generation;
+	trace_t trace;
+} traceCacheEntry_t;
+
+static struct {
+	traceCacheEntry_t *entries;
+	unsigned int generation;
+
+	// statistics
+	unsigned int hits;
+	unsigned int misses;
+
+	// trace log capture
+	fileHandle_t captureFile;
+	unsigned int captureCount;
+
+	// set during benchmark replay to avoid recording the replayed traces
+	qboolean benchmarkActive;
+} traceCache;
+
+#define TRACELOG_MAGIC 0x4c54434d	// "MCTL"
+#define TRACELOG_VERSION 1
+
+typedef enum {
+	TRACELOG_RECORD_FRAME,
+	TRACELOG_RECORD_TRACE,
+} traceLogRecordType_t;
+
+/*
+=================
+CMTraceCache_GenerateKey
+=================
+*/
+static void CMTraceCache_GenerateKey( traceCacheKey_t *key, const vec3_t start, const vec3_t end,
+		const vec3_t mins, const vec3_t maxs, clipHandle_t model, int brushmask, int capsule ) {
+	Com_Memset( key, 0, sizeof( *key ) );
+	VectorCopy( start, key->start );
+	VectorCopy( end, key->end );
+	if ( mins ) {
+		VectorCopy( mins, key->mins );
+	}
+	if ( maxs ) {
+		VectorCopy( maxs, key->maxs );
+	}
+	key->model = model;
+	key->brushmask = brushmask;
+	key->capsule = capsule;
+}
+
+/*
+=================
+CMTraceCache_HashKey
+
+FNV-1a over the raw key bytes. Exact bit equality is required for a hit, so
+hashing the bit patterns rather than float values is intended.
+=================
+*/
+static unsigned int CMTraceCache_HashKey( const traceCacheKey_t *key ) {
+	const byte *data = (const byte *)key;
+	unsigned int hash = 2166136261u;
+	int i;
+
+	for ( i = 0; i < sizeof( *key ); ++i ) {
+		hash ^= data[i];
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+/*
+=================
+CMTraceCache_Cacheable
+=================
+*/
+static qboolean CMTraceCache_Cacheable( clipHandle_t model ) {
+	// Only world and inline models have results determined entirely by the trace inputs
+	return model >= 0 && model < CM_NumInlineModels() ? qtrue : qfalse;
+}
+
+/*
+=================
+CMTraceCache_CaptureTrace
+=================
+*/
+static void CMTraceCache_CaptureTrace( const traceCacheKey_t *key ) {
+	int data[2 + sizeof( *key ) / 4];
+	const int *src = (const int *)key;
+	int i;
+
+	data[0] = LittleLong( TRACELOG_RECORD_TRACE );
+	data[1] = LittleLong( sizeof( *key ) / 4 );
+	for ( i = 0; i < sizeof( *key ) / 4; ++i ) {
+		data[2 + i] = LittleLong( src[i] );
+	}
+
+	FS_Write( data, sizeof( data ), traceCache.captureFile );
+	++traceCache.captureCount;
+}
+
+/*
+=================
+CMTraceCache_Lookup
+
+Returns qtrue and writes results if a cached result is available.
+=================
+*/
+qboolean CMTraceCache_Lookup( trace_t *results, const vec3_t start, const vec3_t end,
+		const vec3_t mins, const vec3_t maxs, clipHandle_t model, int brushmask, int capsule ) {
+	traceCacheKey_t key;
+	traceCacheEntry_t *entry;
+
+	if ( !CMTraceCache_Cacheable( model ) ) {
+		return qfalse;
+	}
+
+	if ( traceCache.captureFile && !traceCache.benchmarkActive ) {
+		CMTraceCache_GenerateKey( &key, start, end, mins, maxs, model, brushmask, capsule );
+		CMTraceCache_CaptureTrace( &key );
+	}
+
+	if ( !cm_traceCache->integer || !traceCache.entries ) {
+		return qfalse;
+	}
+
+	CMTraceCache_GenerateKey( &key, start, end, mins, maxs, model, brushmask, capsule );
+	entry = &traceCache.entries[CMTraceCache_HashKey( &key ) & ( TRACE_CACHE_SIZE - 1 )];
+	if ( entry->generation == traceCache.generation && !memcmp( &entry->key, &key, sizeof( key ) ) ) {
+		*results = entry->trace;
+		++traceCache.hits;
+		return qtrue;
+	}
+
+	++traceCache.misses;
+	return qfalse;
+}
+
+/*
+=================
+CMTraceCache_Store
+=================
+*/
+void CMTraceCache_Store( const trace_t *results, const vec3_t start, const vec3_t end,
+		const vec3_t mins, const vec3_t maxs, clipHandle_t model, int brushmask, int capsule ) {
+	traceCacheKey_t key;
+	traceCacheEntry_t *entry;
+
+	if ( !cm_traceCache->integer || !CMTraceCache_Cacheable( model ) ) {
+		return;
+	}
+
+	if ( !traceCache.entries ) {
+		traceCache.entries = (traceCacheEntry_t *)Z_Malloc( sizeof( *traceCache.entries ) * TRACE_CACHE_SIZE );
+		traceCache.generation = 1;
+	}
+
+	CMTraceCache_GenerateKey( &key, start, end, mins, maxs, model, brushmask, capsule );
+	entry = &traceCache.entries[CMTraceCache_HashKey( &key ) & ( TRACE_CACHE_SIZE - 1 )];
+	entry->key = key;
+	entry->generation = traceCache.generation;
+	entry->trace = *results;
+}
+
+/*
+=================
+CMTraceCache_Invalidate
+
+Called at the end of every frame and whenever the collision map changes.
+=================
+*/
+void CMTraceCache_Invalidate( void ) {
+	++traceCache.generation;
+	if ( !traceCache.generation ) {
+		// wrapped around; clear the table so old entries can't alias the new generation
+		if ( traceCache.entries ) {
+			Com_Memset( traceCache.entries, 0, sizeof( *traceCache.entries ) * TRACE_CACHE_SIZE );
+		}
+		traceCache.generation = 1;
+	}
+
+	if ( traceCache.captureFile && !traceCache.benchmarkActive ) {
+		int record = LittleLong( TRACELOG_RECORD_FRAME );
+		FS_Write( &record, sizeof( record ), traceCache.captureFile );
+	}
+}
+
+/*
+=================
+CMTraceCache_StopCapture
+=================
+*/
+static void CMTraceCache_StopCapture( void ) {
+	if ( traceCache.captureFile ) {
+		FS_FCloseFile( traceCache.captureFile );
+		traceCache.captureFile = 0;
+		Com_Printf( "Trace capture stopped; %u traces written.\n", traceCache.captureCount );
+	}
+}
+
+/*
+=================
+CMTraceCache_Capture_f
+=================
+*/
+static void CMTraceCache_Capture_f( void ) {
+	char path[MAX_QPATH];
+	int header[2];
+
+	if ( Cmd_Argc() != 2 ) {
+		Com_Printf( "Usage: cm_traceCapture <filename> - start capturing traces to file\n"
+				"       cm_traceCapture stop - stop capturing traces\n" );
+		return;
+	}
+
+	CMTraceCache_StopCapture();
+	if ( !Q_stricmp( Cmd_Argv( 1 ), "stop" ) ) {
+		return;
+	}
+
+	Com_sprintf( path, sizeof( path ), "tracelogs/%s", Cmd_Argv( 1 ) );
+	COM_DefaultExtension( path, sizeof( path ), ".tlog" );
+
+	traceCache.captureFile = FS_FOpenFileWrite_HomeData( path );
+	if ( !traceCache.captureFile ) {
+		Com_Printf( "Failed to open %s for writing.\n", path );
+		return;
+	}
+
+	header[0] = LittleLong( TRACELOG_MAGIC );
+	header[1] = LittleLong( TRACELOG_VERSION );
+	FS_Write( header, sizeof( header ), traceCache.captureFile );
+	traceCache.captureCount = 0;
+	Com_Printf( "Capturing traces to %s.\n", path );
+}
+
+typedef struct {
+	unsigned int traces;
+	unsigned int frames;
+	unsigned int hits;
+	unsigned int misses;
+	int msec;
+} traceBenchmarkResult_t;
+
+/*
+=================
+CMTraceCache_ReplayLog
+
+Replays all traces from a trace log. Returns qfalse if the log is invalid.
+=================
+*/
+static qboolean CMTraceCache_ReplayLog( const int *data, int count, traceBenchmarkResult_t *result ) {
+	int position = 2;
+	int startTime = Sys_Milliseconds();
+	unsigned int startHits = traceCache.hits;
+	unsigned int startMisses = traceCache.misses;
+	int inlineModels = CM_NumInlineModels();
+
+	while ( position < count ) {
+		int type = LittleLong( data[position++] );
+
+		if ( type == TRACELOG_RECORD_FRAME ) {
+			CMTraceCache_Invalidate();
+			++result->frames;
+
+		} else if ( type == TRACELOG_RECORD_TRACE ) {
+			traceCacheKey_t key;
+			int *dst = (int *)&key;
+			trace_t trace;
+			int i;
+
+			if ( position >= count || LittleLong( data[position] ) != sizeof( key ) / 4 ||
+					position + 1 + sizeof( key ) / 4 > count ) {
+				return qfalse;
+			}
+			++position;
+			for ( i = 0; i < sizeof( key ) / 4; ++i ) {
+				dst[i] = LittleLong( data[position++] );
+			}
+
+			if ( key.model < 0 || key.model >= inlineModels ) {
+				continue;
+			}
+			CM_BoxTrace( &trace, key.start, key.end, key.mins, key.maxs, key.model, key.brushmask, key.capsule );
+			++result->traces;
+
+		} else {
+			return qfalse;
+		}
+	}
+
+	result->msec = Sys_Milliseconds() - startTime;
+	result->hits = traceCache.hits - startHits;
+	result->misses = traceCache.misses - startMisses;
+	return qtrue;
+}
+
+/*
+=================
+CMTraceCache_PrintResult
+=================
+*/
+static void CMTraceCache_PrintResult( const char *label, const traceBenchmarkResult_t *result ) {
+	unsigned int lookups = result->hits + result->misses;
+	int msec = result->msec > 0 ? result->msec : 1;
+
+	Com_Printf( "%s: %u traces in %i ms (%.0f traces/sec)", label, result->traces, result->msec,
+			(double)result->traces * 1000.0 / msec );
+	if ( lookups ) {
+		Com_Printf( ", hit rate %.1f%%", (double)result->hits * 100.0 / lookups );
+	}
+	Com_Printf( "\n" );
+}
+
+/*
+=================
+CMTraceCache_Benchmark_f
+
+Replays a captured trace log against the currently loaded map, with and without the cache.
+=================
+*/
+static void CMTraceCache_Benchmark_f( void ) {
+	char path[MAX_QPATH];
+	union {
+		int *i;
+		void *v;
+	} buf;
+	int length;
+	int passes = 1;
+	int i;
+	int oldCacheValue = cm_traceCache->integer;
+	traceBenchmarkResult_t uncached, cached;
+
+	if ( Cmd_Argc() < 2 ) {
+		Com_Printf( "Usage: cm_traceBenchmark <filename> [passes]\n" );
+		return;
+	}
+
+	if ( !CM_NumInlineModels() ) {
+		Com_Printf( "No map loaded.\n" );
+		return;
+	}
+
+	if ( Cmd_Argc() >= 3 ) {
+		passes = atoi( Cmd_Argv( 2 ) );
+		if ( passes < 1 ) {
+			passes = 1;
+		}
+	}
+
+	Com_sprintf( path, sizeof( path ), "tracelogs/%s", Cmd_Argv( 1 ) );
+	COM_DefaultExtension( path, sizeof( path ), ".tlog" );
+
+	length = FS_ReadFile( path, &buf.v );
+	if ( !buf.v ) {
+		Com_Printf( "Failed to read %s.\n", path );
+		return;
+	}
+
+	if ( length < 8 || LittleLong( buf.i[0] ) != TRACELOG_MAGIC || LittleLong( buf.i[1] ) != TRACELOG_VERSION ) {
+		Com_Printf( "%s is not a valid trace log.\n", path );
+		FS_FreeFile( buf.v );
+		return;
+	}
+
+	Com_Memset( &uncached, 0, sizeof( uncached ) );
+	Com_Memset( &cached, 0, sizeof( cached ) );
+	traceCache.benchmarkActive = qtrue;
+
+	for ( i = 0; i < passes; ++i ) {
+		traceBenchmarkResult_t pass;
+
+		Com_Memset( &pass, 0, sizeof( pass ) );
+		Cvar_Set( "cm_traceCache", "0" );
+		if ( !CMTraceCache_ReplayLog( buf.i, length / 4, &pass ) ) {
+			Com_Printf( "%s is truncated or corrupt.\n", path );
+			break;
+		}
+		uncached.traces += pass.traces;
+		uncached.frames += pass.frames;
+		uncached.msec += pass.msec;
+
+		Com_Memset( &pass, 0, sizeof( pass ) );
+		Cvar_Set( "cm_traceCache", "1" );
+		CMTraceCache_Invalidate();
+		CMTraceCache_ReplayLog( buf.i, length / 4, &pass );
+		cached.traces += pass.traces;
+		cached.frames += pass.frames;
+		cached.msec += pass.msec;
+		cached.hits += pass.hits;
+		cached.misses += pass.misses;
+	}
+
+	traceCache.benchmarkActive = qfalse;
+	Cvar_Set( "cm_traceCache", oldCacheValue ? "1" : "0" );
+	CMTraceCache_Invalidate();
+	FS_FreeFile( buf.v );
+
+	if ( i == passes ) {
+		Com_Printf( "Replayed %u frames over %i pass(es)\n", uncached.frames, passes );
+		CMTraceCache_PrintResult( "uncached", &uncached );
+		CMTraceCache_PrintResult( "cached", &cached );
+	}
+}
+
+/*
+=================
+CMTraceCache_Stats_f
+=================
+*/
+static void CMTraceCache_Stats_f( void ) {
+	unsigned int lookups = traceCache.hits + traceCache.misses;
+
+	Com_Printf( "trace cache: %s, %u hits, %u misses", cm_traceCache->integer ? "enabled" : "disabled",
+			traceCache.hits, traceCache.misses );
+	if ( lookups ) {
+		Com_Printf( " (%.1f%% hit rate)", (double)traceCache.hits * 100.0 / lookups );
+	}
+	Com_Printf( "\n" );
+
+	if ( Cmd_Argc() >= 2 && !Q_stricmp( Cmd_Argv( 1 ), "reset" ) ) {
+		traceCache.hits = 0;
+		traceCache.misses = 0;
+	}
+}
+
+/*
+=================
+CMTraceCache_Init
+=================
+*/
+void CMTraceCache_Init( void ) {
+	Cmd_AddCommand( "cm_traceCapture", CMTraceCache_Capture_f );
+	Cmd_AddCommand( "cm_traceBenchmark", CMTraceCache_Benchmark_f );
+	Cmd_AddCommand( "cm_traceCacheStats", CMTraceCache_Stats_f );
+}
+#endif
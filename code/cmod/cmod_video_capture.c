@@ -0,0 +1,566 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+Copyright (C) 2017 Noah Metzger (chomenor@gmail.com)
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+
+#ifdef CMOD_ASYNC_VIDEO_CAPTURE
+#include "../renderergl1/tr_local.h"
+#include "SDL.h"
+
+/*
+###############################################################################################
+
+Asynchronous Video Capture
+
+Replaces the blocking glReadPixels / encode / write sequence in RB_TakeVideoFrameCmd with a
+small pipeline. Each captured frame is read into a pixel buffer object, which lets the GPU
+transfer run in the background. On the following frame the buffer is mapped and copied out,
+and the frame is queued to a set of persistent encoder threads, which apply gamma and encode
+the frame (JPEG or raw BGR). Finished frames are passed to CL_WriteAVIVideoFrame on the
+render thread in capture order, so the AVI writer itself is never called from more than one
+thread. Encoding errors are stored in the slot and reported from the render thread.
+
+The number of frames in flight is set by "r_aviAsyncCapture". The default of 0 keeps the
+original synchronous capture; set it to 2 or more to opt in. The client flushes pending frames via re.FlushVideoFrames before closing the AVI.
+
+###############################################################################################
+*/
+
+#define MAX_CAPTURE_SLOTS 8
+#define MAX_ENCODER_THREADS 4
+
+typedef enum {
+	CAPTURE_SLOT_FREE,
+	CAPTURE_SLOT_READBACK,		// glReadPixels issued to the slot's PBO
+	CAPTURE_SLOT_ENCODING,		// pixels copied out and handed to encoder
+} captureSlotState_t;
+
+typedef struct {
+	captureSlotState_t state;
+	GLuint pbo;
+
+	// frame parameters
+	qboolean motionJpeg;
+	int quality;
+	qboolean gammaCorrect;
+
+	// buffers
+	byte *captureBuffer;		// pixels in glReadPixels layout
+	byte *encodeBuffer;			// encoded frame to pass to the AVI writer
+	int encodeSize;
+	char error[256];			// encoding error, if any
+
+	SDL_atomic_t finished;		// set by encoder when encodeSize and error are valid
+} captureSlot_t;
+
+static struct {
+	qboolean initialized;
+	qboolean supported;
+	qboolean writing;
+
+	captureSlot_t slots[MAX_CAPTURE_SLOTS];
+	int numSlots;
+	int oldest;					// slot of oldest frame in flight
+	int pending;				// number of frames in flight
+
+	// capture layout, shared by all slots
+	int width;
+	int height;
+	int packAlign;
+	int linelen;
+	int padwidth;
+	int avipadwidth;
+
+	// encoder threads
+	int numThreads;
+	struct cmThread_s *threads[MAX_ENCODER_THREADS];
+	SDL_sem *queueSemaphore;	// posted once for each queued slot
+	SDL_sem *doneSemaphore;		// posted once for each encoded slot
+
+	// lock protects the fields below
+	SDL_SpinLock lock;
+	qboolean shutdown;
+	int queue[MAX_CAPTURE_SLOTS];
+	int queueStart;
+	int queueCount;
+} capture;
+
+/* ******************************************************************************** */
+// GL Functions
+/* ******************************************************************************** */
+
+// Using extern because these function pointers are all already defined in sdl_glimp.c
+#define GLE(ret, name, ...) extern name##proc * qgl##name;
+QGL_1_5_PROCS;
+#undef GLE
+
+static void *( APIENTRY *qglMapBuffer )( GLenum target, GLenum access );
+static GLboolean( APIENTRY *qglUnmapBuffer )( GLenum target );
+
+/*
+=================
+R_VideoCapture_LoadFunctions
+
+Returns qtrue if pixel buffer objects are available.
+=================
+*/
+static qboolean R_VideoCapture_LoadFunctions( void ) {
+	if ( !SDL_GL_ExtensionSupported( "GL_ARB_pixel_buffer_object" ) &&
+			!SDL_GL_ExtensionSupported( "GL_EXT_pixel_buffer_object" ) ) {
+		return qfalse;
+	}
+
+	#define GLE(ret, name, ...) qgl##name = (name##proc *) SDL_GL_GetProcAddress("gl" #name);
+	QGL_1_5_PROCS;
+	#undef GLE
+
+	qglMapBuffer = SDL_GL_GetProcAddress( "glMapBuffer" );
+	qglUnmapBuffer = SDL_GL_GetProcAddress( "glUnmapBuffer" );
+
+	return qglBindBuffer && qglDeleteBuffers && qglGenBuffers && qglBufferData &&
+			qglMapBuffer && qglUnmapBuffer ? qtrue : qfalse;
+}
+
+/* ******************************************************************************** */
+// Encoding
+/* ******************************************************************************** */
+
+/*
+=================
+R_VideoCapture_Encode
+
+Applies gamma and encodes a frame. Safe to call from worker threads.
+=================
+*/
+static void R_VideoCapture_Encode( captureSlot_t *slot ) {
+	int padlen = capture.padwidth - capture.linelen;
+	int avipadlen = capture.avipadwidth - capture.linelen;
+	size_t memcount = capture.padwidth * capture.height;
+
+	if ( slot->gammaCorrect ) {
+		R_GammaCorrect( slot->captureBuffer, memcount );
+	}
+
+	if ( slot->motionJpeg ) {
+		slot->encodeSize = RE_SaveJPGToBufferThreaded( slot->encodeBuffer, capture.linelen * capture.height,
+				slot->quality, capture.width, capture.height, slot->captureBuffer, padlen,
+				slot->error, sizeof( slot->error ) );
+	} else {
+		byte *srcptr = slot->captureBuffer;
+		byte *destptr = slot->encodeBuffer;
+		byte *memend = srcptr + memcount;
+
+		// swap R and B and remove line paddings
+		while ( srcptr < memend ) {
+			byte *lineend = srcptr + capture.linelen;
+			while ( srcptr < lineend ) {
+				*destptr++ = srcptr[2];
+				*destptr++ = srcptr[1];
+				*destptr++ = srcptr[0];
+				srcptr += 3;
+			}
+
+			Com_Memset( destptr, '\0', avipadlen );
+			destptr += avipadlen;
+
+			srcptr += padlen;
+		}
+
+		slot->encodeSize = capture.avipadwidth * capture.height;
+	}
+}
+
+/*
+=================
+R_VideoCapture_ThreadMain
+=================
+*/
+static void R_VideoCapture_ThreadMain( void *arg ) {
+	while ( 1 ) {
+		captureSlot_t *slot;
+
+		SDL_SemWait( capture.queueSemaphore );
+
+		SDL_AtomicLock( &capture.lock );
+		if ( capture.shutdown ) {
+			SDL_AtomicUnlock( &capture.lock );
+			break;
+		}
+		slot = &capture.slots[capture.queue[capture.queueStart]];
+		capture.queueStart = ( capture.queueStart + 1 ) % MAX_CAPTURE_SLOTS;
+		--capture.queueCount;
+		SDL_AtomicUnlock( &capture.lock );
+
+		R_VideoCapture_Encode( slot );
+
+		SDL_MemoryBarrierRelease();
+		SDL_AtomicSet( &slot->finished, 1 );
+		SDL_SemPost( capture.doneSemaphore );
+	}
+}
+
+/*
+=================
+R_VideoCapture_StartThreads
+
+Starts encoder threads, if not already running. If no threads can be started frames are
+encoded on the render thread instead.
+=================
+*/
+static void R_VideoCapture_StartThreads( void ) {
+	int numThreads;
+
+	if ( capture.numThreads ) {
+		return;
+	}
+
+	capture.queueSemaphore = SDL_CreateSemaphore( 0 );
+	capture.doneSemaphore = SDL_CreateSemaphore( 0 );
+	if ( !capture.queueSemaphore || !capture.doneSemaphore ) {
+		goto fail;
+	}
+
+	capture.shutdown = qfalse;
+	capture.queueStart = 0;
+	capture.queueCount = 0;
+
+	numThreads = ri.Thread_ProcessorCount() - 1;
+	if ( numThreads < 1 ) {
+		numThreads = 1;
+	}
+	if ( numThreads > MAX_ENCODER_THREADS ) {
+		numThreads = MAX_ENCODER_THREADS;
+	}
+
+	while ( capture.numThreads < numThreads ) {
+		struct cmThread_s *thread = ri.Thread_Create( R_VideoCapture_ThreadMain, NULL );
+		if ( !thread ) {
+			break;
+		}
+		capture.threads[capture.numThreads++] = thread;
+	}
+	if ( capture.numThreads ) {
+		return;
+	}
+
+fail:
+	if ( capture.queueSemaphore ) {
+		SDL_DestroySemaphore( capture.queueSemaphore );
+		capture.queueSemaphore = NULL;
+	}
+	if ( capture.doneSemaphore ) {
+		SDL_DestroySemaphore( capture.doneSemaphore );
+		capture.doneSemaphore = NULL;
+	}
+}
+
+/*
+=================
+R_VideoCapture_StopThreads
+
+Stops encoder threads. Any frames in flight should be flushed first.
+=================
+*/
+static void R_VideoCapture_StopThreads( void ) {
+	int i;
+
+	if ( !capture.numThreads ) {
+		return;
+	}
+
+	SDL_AtomicLock( &capture.lock );
+	capture.shutdown = qtrue;
+	SDL_AtomicUnlock( &capture.lock );
+
+	for ( i = 0; i < capture.numThreads; ++i ) {
+		SDL_SemPost( capture.queueSemaphore );
+	}
+	for ( i = 0; i < capture.numThreads; ++i ) {
+		ri.Thread_Join( capture.threads[i] );
+		capture.threads[i] = NULL;
+	}
+	capture.numThreads = 0;
+
+	SDL_DestroySemaphore( capture.queueSemaphore );
+	capture.queueSemaphore = NULL;
+	SDL_DestroySemaphore( capture.doneSemaphore );
+	capture.doneSemaphore = NULL;
+}
+
+/*
+=================
+R_VideoCapture_StartEncode
+
+Copies pixels out of the slot's PBO and starts encoding them.
+=================
+*/
+static void R_VideoCapture_StartEncode( captureSlot_t *slot ) {
+	void *data;
+
+	qglBindBuffer( GL_PIXEL_PACK_BUFFER_ARB, slot->pbo );
+	data = qglMapBuffer( GL_PIXEL_PACK_BUFFER_ARB, GL_READ_ONLY_ARB );
+	if ( data ) {
+		Com_Memcpy( slot->captureBuffer, data, capture.padwidth * capture.height );
+		qglUnmapBuffer( GL_PIXEL_PACK_BUFFER_ARB );
+	} else {
+		Com_Memset( slot->captureBuffer, 0, capture.padwidth * capture.height );
+	}
+	qglBindBuffer( GL_PIXEL_PACK_BUFFER_ARB, 0 );
+
+	slot->state = CAPTURE_SLOT_ENCODING;
+	slot->error[0] = '\0';
+	SDL_AtomicSet( &slot->finished, 0 );
+
+	if ( !capture.numThreads ) {
+		R_VideoCapture_Encode( slot );
+		SDL_AtomicSet( &slot->finished, 1 );
+		return;
+	}
+
+	SDL_AtomicLock( &capture.lock );
+	capture.queue[( capture.queueStart + capture.queueCount ) % MAX_CAPTURE_SLOTS] = (int)( slot - capture.slots );
+	++capture.queueCount;
+	SDL_AtomicUnlock( &capture.lock );
+
+	SDL_SemPost( capture.queueSemaphore );
+}
+
+/*
+=================
+R_VideoCapture_FinishOldest
+
+Waits for the oldest frame in flight to finish encoding and writes it to the AVI.
+=================
+*/
+static void R_VideoCapture_FinishOldest( void ) {
+	captureSlot_t *slot = &capture.slots[capture.oldest];
+
+	if ( slot->state == CAPTURE_SLOT_READBACK ) {
+		R_VideoCapture_StartEncode( slot );
+	}
+	// each encoded slot posts the semaphore once, so if other slots finish first their
+	// posts are consumed here and they are found finished without waiting later
+	while ( !SDL_AtomicGet( &slot->finished ) ) {
+		SDL_SemWait( capture.doneSemaphore );
+	}
+	SDL_MemoryBarrierAcquire();
+
+	if ( slot->error[0] ) {
+		ri.Printf( PRINT_WARNING, "WARNING: Failed to encode video frame: %s\n", slot->error );
+	}
+
+	// CL_WriteAVIVideoFrame may close and reopen the file when it gets too large, which
+	// calls back into R_VideoCapture_Flush, so block recursion here.
+	capture.writing = qtrue;
+	ri.CL_WriteAVIVideoFrame( slot->encodeBuffer, slot->encodeSize );
+	capture.writing = qfalse;
+
+	slot->state = CAPTURE_SLOT_FREE;
+	capture.oldest = ( capture.oldest + 1 ) % capture.numSlots;
+	--capture.pending;
+}
+
+/* ******************************************************************************** */
+// Slot Management
+/* ******************************************************************************** */
+
+/*
+=================
+R_VideoCapture_FreeSlots
+
+Frees all slots. Any frames in flight should be flushed first.
+=================
+*/
+static void R_VideoCapture_FreeSlots( void ) {
+	int i;
+
+	for ( i = 0; i < capture.numSlots; ++i ) {
+		captureSlot_t *slot = &capture.slots[i];
+		if ( slot->pbo ) {
+			qglDeleteBuffers( 1, &slot->pbo );
+		}
+		if ( slot->captureBuffer ) {
+			ri.Free( slot->captureBuffer );
+		}
+		if ( slot->encodeBuffer ) {
+			ri.Free( slot->encodeBuffer );
+		}
+	}
+
+	Com_Memset( capture.slots, 0, sizeof( capture.slots ) );
+	capture.numSlots = 0;
+	capture.oldest = 0;
+	capture.pending = 0;
+	capture.width = capture.height = 0;
+}
+
+/*
+=================
+R_VideoCapture_AllocSlots
+=================
+*/
+static void R_VideoCapture_AllocSlots( int numSlots, int width, int height, int packAlign ) {
+	int i;
+
+	capture.numSlots = numSlots;
+	capture.width = width;
+	capture.height = height;
+	capture.packAlign = packAlign;
+	capture.linelen = width * 3;
+	capture.padwidth = PAD( capture.linelen, packAlign );
+	capture.avipadwidth = PAD( capture.linelen, AVI_LINE_PADDING );
+
+	for ( i = 0; i < numSlots; ++i ) {
+		captureSlot_t *slot = &capture.slots[i];
+		qglGenBuffers( 1, &slot->pbo );
+		qglBindBuffer( GL_PIXEL_PACK_BUFFER_ARB, slot->pbo );
+		qglBufferData( GL_PIXEL_PACK_BUFFER_ARB, capture.padwidth * height, NULL, GL_STREAM_READ_ARB );
+		slot->captureBuffer = (byte *)ri.Malloc( capture.padwidth * height );
+		slot->encodeBuffer = (byte *)ri.Malloc( capture.avipadwidth * height );
+	}
+	qglBindBuffer( GL_PIXEL_PACK_BUFFER_ARB, 0 );
+}
+
+/* ******************************************************************************** */
+// Interface Functions
+/* ******************************************************************************** */
+
+/*
+=================
+R_VideoCapture_Flush
+
+Writes out all frames in flight.
+=================
+*/
+void R_VideoCapture_Flush( void ) {
+	int i;
+
+	if ( capture.writing || !capture.pending ) {
+		return;
+	}
+
+	// start encoding everything first so remaining frames are encoded in parallel
+	for ( i = 0; i < capture.pending; ++i ) {
+		captureSlot_t *slot = &capture.slots[( capture.oldest + i ) % capture.numSlots];
+		if ( slot->state == CAPTURE_SLOT_READBACK ) {
+			R_VideoCapture_StartEncode( slot );
+		}
+	}
+
+	while ( capture.pending ) {
+		R_VideoCapture_FinishOldest();
+	}
+}
+
+/*
+=================
+R_VideoCapture_Frame
+
+Called from RB_TakeVideoFrameCmd. Returns qtrue if the frame was handled by the capture
+pipeline, or qfalse to use the original synchronous capture.
+=================
+*/
+qboolean R_VideoCapture_Frame( int width, int height, qboolean motionJpeg, int jpegQuality ) {
+	int numSlots = r_aviAsyncCapture->integer;
+	captureSlot_t *slot;
+	GLint packAlign;
+	int i;
+
+	if ( !capture.initialized ) {
+		capture.supported = R_VideoCapture_LoadFunctions();
+		capture.initialized = qtrue;
+		if ( !capture.supported && numSlots > 0 ) {
+			ri.Printf( PRINT_WARNING, "WARNING: r_aviAsyncCapture not supported by this driver; "
+					"using synchronous capture.\n" );
+		}
+	}
+
+	if ( !capture.supported || numSlots <= 0 ) {
+		if ( capture.numSlots ) {
+			R_VideoCapture_Flush();
+			R_VideoCapture_FreeSlots();
+			R_VideoCapture_StopThreads();
+		}
+		return qfalse;
+	}
+
+	// one extra slot so a full set of frames can be encoding while the next is read back
+	numSlots = numSlots + 1 > MAX_CAPTURE_SLOTS ? MAX_CAPTURE_SLOTS : numSlots + 1;
+
+	qglGetIntegerv( GL_PACK_ALIGNMENT, &packAlign );
+	if ( numSlots != capture.numSlots || width != capture.width || height != capture.height ||
+			packAlign != capture.packAlign ) {
+		R_VideoCapture_Flush();
+		R_VideoCapture_FreeSlots();
+		R_VideoCapture_AllocSlots( numSlots, width, height, packAlign );
+		R_VideoCapture_StartThreads();
+	}
+
+	// write out completed frames in order
+	while ( capture.pending && capture.slots[capture.oldest].state == CAPTURE_SLOT_ENCODING &&
+			SDL_AtomicGet( &capture.slots[capture.oldest].finished ) ) {
+		R_VideoCapture_FinishOldest();
+	}
+
+	// make sure a slot is free, blocking on the oldest frame if necessary
+	if ( capture.pending == capture.numSlots ) {
+		R_VideoCapture_FinishOldest();
+	}
+
+	// readbacks issued on previous frames should be complete by now, so start encoding them
+	for ( i = 0; i < capture.pending; ++i ) {
+		captureSlot_t *other = &capture.slots[( capture.oldest + i ) % capture.numSlots];
+		if ( other->state == CAPTURE_SLOT_READBACK ) {
+			R_VideoCapture_StartEncode( other );
+		}
+	}
+
+	// issue readback for this frame
+	slot = &capture.slots[( capture.oldest + capture.pending ) % capture.numSlots];
+	slot->motionJpeg = motionJpeg;
+	slot->quality = jpegQuality;
+	slot->gammaCorrect = glConfig.deviceSupportsGamma;
+
+	qglBindBuffer( GL_PIXEL_PACK_BUFFER_ARB, slot->pbo );
+	qglReadPixels( 0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, NULL );
+	qglBindBuffer( GL_PIXEL_PACK_BUFFER_ARB, 0 );
+
+	slot->state = CAPTURE_SLOT_READBACK;
+	++capture.pending;
+	return qtrue;
+}
+
+/*
+=================
+R_VideoCapture_Shutdown
+
+Called on renderer shutdown, while the GL context is still valid.
+=================
+*/
+void R_VideoCapture_Shutdown( void ) {
+	R_VideoCapture_Flush();
+	R_VideoCapture_FreeSlots();
+	R_VideoCapture_StopThreads();
+	capture.initialized = qfalse;
+	capture.supported = qfalse;
+}
+
+#endif
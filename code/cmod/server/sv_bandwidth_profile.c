@@ -0,0 +1,479 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+Copyright (C) 2017 Noah Metzger (chomenor@gmail.com)
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+
+#ifdef CMOD_BANDWIDTH_PROFILE
+#include "../../server/server.h"
+
+/*
+###############################################################################################
+
+Bandwidth Profile
+
+While sv_bandwidthProfile is enabled, the encoded size of messages sent to each client is
+broken down by message section (snapshot header, playerstate, entities, server commands,
+configstrings, baselines, downloads). Within snapshots, entity deltas are further broken down
+by eType and by entityState_t field, and playerstate deltas by playerState_t field, using the
+msgProfile hook in msg.c.
+
+Sizes are measured after huffman compression, so they reflect actual bandwidth used, except
+for netchan fragment headers. Configstring updates sent as "cs" server commands are counted
+under configstrings rather than server commands.
+
+Stats are kept per client slot until reset, including after the client disconnects, so the
+aggregate includes clients that are no longer connected.
+
+###############################################################################################
+*/
+
+#define BANDWIDTH_PRINT_ROWS 16
+
+typedef struct {
+	char name[MAX_NAME_LENGTH];		// last client name in slot
+	int64_t messages;
+	int64_t messageBits;
+	int64_t categoryBits[SV_BANDWIDTH_CATEGORY_COUNT];
+	msgProfile_t msg;
+} bandwidthClient_t;
+
+static const char *bandwidthCategoryNames[SV_BANDWIDTH_CATEGORY_COUNT] = {
+	"snapshot header", "playerstate", "entities", "server commands", "configstrings", "baselines", "downloads" };
+
+static struct {
+	bandwidthClient_t *clients[MAX_CLIENTS];	// allocated when slot is first profiled
+	qboolean started;
+	int startTime;		// svs.time of first profiled message
+} bandwidth;
+
+/*
+=================
+SV_Bandwidth_GetClient
+
+Returns profile for client, or null if profiling is disabled or client is not a regular
+server client.
+=================
+*/
+static bandwidthClient_t *SV_Bandwidth_GetClient( client_t *client ) {
+	int clientNum = (int)( client - svs.clients );
+	bandwidthClient_t *bc;
+
+	if ( !sv_bandwidthProfile->integer || clientNum < 0 || clientNum >= sv_maxclients->integer ||
+			clientNum >= MAX_CLIENTS ) {
+		return NULL;
+	}
+
+	if ( !bandwidth.started ) {
+		bandwidth.started = qtrue;
+		bandwidth.startTime = svs.time;
+	}
+
+	bc = bandwidth.clients[clientNum];
+	if ( !bc ) {
+		bc = bandwidth.clients[clientNum] = (bandwidthClient_t *)Z_Malloc( sizeof( *bc ) );
+	}
+	Q_strncpyz( bc->name, client->name, sizeof( bc->name ) );
+	return bc;
+}
+
+/*
+=================
+SV_Bandwidth_Record
+
+Adds bits to message section for client.
+=================
+*/
+void SV_Bandwidth_Record( client_t *client, svBandwidthCategory_t category, int bits ) {
+	bandwidthClient_t *bc;
+
+	if ( !sv_bandwidthProfile->integer ) {
+		return;
+	}
+	bc = SV_Bandwidth_GetClient( client );
+	if ( bc ) {
+		bc->categoryBits[category] += bits;
+	}
+}
+
+/*
+=================
+SV_Bandwidth_RecordServerCommand
+
+Adds bits for a reliable server command, counting configstring updates separately.
+=================
+*/
+void SV_Bandwidth_RecordServerCommand( client_t *client, const char *command, int bits ) {
+	if ( !sv_bandwidthProfile->integer ) {
+		return;
+	}
+	if ( !Q_strncmp( command, "cs ", 3 ) || !Q_strncmp( command, "bcs", 3 ) ) {
+		SV_Bandwidth_Record( client, SV_BANDWIDTH_CONFIGSTRINGS, bits );
+	} else {
+		SV_Bandwidth_Record( client, SV_BANDWIDTH_SERVER_COMMANDS, bits );
+	}
+}
+
+/*
+=================
+SV_Bandwidth_RecordMessage
+
+Called with each complete message before it is transmitted.
+=================
+*/
+void SV_Bandwidth_RecordMessage( client_t *client, const msg_t *msg ) {
+	bandwidthClient_t *bc;
+
+	if ( !sv_bandwidthProfile->integer ) {
+		return;
+	}
+	bc = SV_Bandwidth_GetClient( client );
+	if ( bc ) {
+		++bc->messages;
+		bc->messageBits += msg->cursize * 8;
+	}
+}
+
+/*
+=================
+SV_Bandwidth_BeginSnapshot
+
+Enables field and entity type attribution in msg.c for the client's snapshot.
+=================
+*/
+void SV_Bandwidth_BeginSnapshot( client_t *client ) {
+	bandwidthClient_t *bc = SV_Bandwidth_GetClient( client );
+	msgProfile = bc ? &bc->msg : NULL;
+}
+
+/*
+=================
+SV_Bandwidth_EndSnapshot
+=================
+*/
+void SV_Bandwidth_EndSnapshot( void ) {
+	msgProfile = NULL;
+}
+
+/*
+=================
+SV_Bandwidth_Reset
+=================
+*/
+static void SV_Bandwidth_Reset( void ) {
+	int i;
+
+	msgProfile = NULL;
+	for ( i = 0; i < MAX_CLIENTS; ++i ) {
+		if ( bandwidth.clients[i] ) {
+			Z_Free( bandwidth.clients[i] );
+		}
+	}
+	Com_Memset( &bandwidth, 0, sizeof( bandwidth ) );
+}
+
+/*
+=================
+SV_Bandwidth_AddCounters
+=================
+*/
+static void SV_Bandwidth_AddCounters( msgProfileCounter_t *target, const msgProfileCounter_t *source, int count ) {
+	int i;
+	for ( i = 0; i < count; ++i ) {
+		target[i].count += source[i].count;
+		target[i].bits += source[i].bits;
+	}
+}
+
+/*
+=================
+SV_Bandwidth_Sum
+
+Sums stats for client slot, or all slots if clientNum is -1. Returns qfalse if there are
+no stats.
+=================
+*/
+static qboolean SV_Bandwidth_Sum( bandwidthClient_t *out, int clientNum ) {
+	qboolean found = qfalse;
+	int i, j;
+
+	Com_Memset( out, 0, sizeof( *out ) );
+	for ( i = 0; i < MAX_CLIENTS; ++i ) {
+		const bandwidthClient_t *bc = bandwidth.clients[i];
+		if ( !bc || ( clientNum >= 0 && i != clientNum ) ) {
+			continue;
+		}
+
+		found = qtrue;
+		Q_strncpyz( out->name, bc->name, sizeof( out->name ) );
+		out->messages += bc->messages;
+		out->messageBits += bc->messageBits;
+		for ( j = 0; j < SV_BANDWIDTH_CATEGORY_COUNT; ++j ) {
+			out->categoryBits[j] += bc->categoryBits[j];
+		}
+		SV_Bandwidth_AddCounters( out->msg.entityFields, bc->msg.entityFields, MSG_PROFILE_FIELDS );
+		SV_Bandwidth_AddCounters( out->msg.playerFields, bc->msg.playerFields, MSG_PROFILE_FIELDS );
+		SV_Bandwidth_AddCounters( out->msg.entityTypes, bc->msg.entityTypes, MSG_PROFILE_ENTITY_TYPES );
+	}
+
+	return found;
+}
+
+static const msgProfileCounter_t *bandwidthSortCounters;
+
+/*
+=================
+SV_Bandwidth_CompareCounters
+=================
+*/
+static int QDECL SV_Bandwidth_CompareCounters( const void *a, const void *b ) {
+	int64_t bitsA = bandwidthSortCounters[*(const int *)a].bits;
+	int64_t bitsB = bandwidthSortCounters[*(const int *)b].bits;
+	if ( bitsA != bitsB ) {
+		return bitsA > bitsB ? -1 : 1;
+	}
+	return *(const int *)a - *(const int *)b;
+}
+
+/*
+=================
+SV_Bandwidth_PrintCounters
+
+Prints the counters using the most bits, with percentage relative to total.
+=================
+*/
+static void SV_Bandwidth_PrintCounters( const char *title, const msgProfileCounter_t *counters, int count,
+		const char *( *nameFunction )( int index ), int64_t totalBits ) {
+	int order[MSG_PROFILE_ENTITY_TYPES];
+	int used = 0;
+	int i;
+
+	for ( i = 0; i < count; ++i ) {
+		if ( counters[i].bits ) {
+			order[used++] = i;
+		}
+	}
+	if ( !used ) {
+		return;
+	}
+
+	bandwidthSortCounters = counters;
+	qsort( order, used, sizeof( *order ), SV_Bandwidth_CompareCounters );
+
+	Com_Printf( "%-20s %10s %12s %9s %6s\n", title, "count", "bytes", "avg bits", "%" );
+	for ( i = 0; i < used && i < BANDWIDTH_PRINT_ROWS; ++i ) {
+		const msgProfileCounter_t *counter = &counters[order[i]];
+		const char *name = nameFunction ? nameFunction( order[i] ) : va( "eType %i", order[i] );
+		Com_Printf( "  %-18s %10lld %12lld %9.1f %5.1f%%\n", name ? name : "?", (long long)counter->count,
+				(long long)( counter->bits / 8 ), (double)counter->bits / counter->count,
+				totalBits ? 100.0 * counter->bits / totalBits : 0.0 );
+	}
+	if ( used > BANDWIDTH_PRINT_ROWS ) {
+		Com_Printf( "  (%i more)\n", used - BANDWIDTH_PRINT_ROWS );
+	}
+}
+
+/*
+=================
+SV_Bandwidth_Print
+=================
+*/
+static void SV_Bandwidth_Print( int clientNum ) {
+	bandwidthClient_t *stats = (bandwidthClient_t *)Z_Malloc( sizeof( *stats ) );
+	double seconds = ( svs.time - bandwidth.startTime ) / 1000.0;
+	int64_t otherBits;
+	int i;
+
+	if ( !SV_Bandwidth_Sum( stats, clientNum ) ) {
+		Com_Printf( "No bandwidth stats recorded%s.\n", clientNum >= 0 ? " for client" : "" );
+		Z_Free( stats );
+		return;
+	}
+
+	if ( clientNum >= 0 ) {
+		Com_Printf( "Bandwidth profile for client %i (%s):\n", clientNum, stats->name );
+	} else {
+		Com_Printf( "Bandwidth profile for all clients:\n" );
+	}
+	Com_Printf( "%lld messages, %lld bytes in %.1f sec (%.1f bytes/sec)\n", (long long)stats->messages,
+			(long long)( stats->messageBits / 8 ), seconds,
+			seconds > 0.0 ? stats->messageBits / 8 / seconds : 0.0 );
+
+	Com_Printf( "%-20s %12s %6s\n", "section", "bytes", "%" );
+	otherBits = stats->messageBits;
+	for ( i = 0; i < SV_BANDWIDTH_CATEGORY_COUNT; ++i ) {
+		otherBits -= stats->categoryBits[i];
+		Com_Printf( "  %-18s %12lld %5.1f%%\n", bandwidthCategoryNames[i], (long long)( stats->categoryBits[i] / 8 ),
+				stats->messageBits ? 100.0 * stats->categoryBits[i] / stats->messageBits : 0.0 );
+	}
+	Com_Printf( "  %-18s %12lld %5.1f%%\n", "other", (long long)( otherBits / 8 ),
+			stats->messageBits ? 100.0 * otherBits / stats->messageBits : 0.0 );
+
+	SV_Bandwidth_PrintCounters( "entity type", stats->msg.entityTypes, MSG_PROFILE_ENTITY_TYPES, NULL,
+			stats->categoryBits[SV_BANDWIDTH_ENTITIES] );
+	SV_Bandwidth_PrintCounters( "entity field", stats->msg.entityFields, MSG_PROFILE_FIELDS,
+			MSG_ProfileEntityFieldName, stats->categoryBits[SV_BANDWIDTH_ENTITIES] );
+	SV_Bandwidth_PrintCounters( "player field", stats->msg.playerFields, MSG_PROFILE_FIELDS,
+			MSG_ProfilePlayerFieldName, stats->categoryBits[SV_BANDWIDTH_PLAYERSTATE] );
+
+	Z_Free( stats );
+}
+
+/*
+=================
+SV_Bandwidth_ExportCounters
+=================
+*/
+static void SV_Bandwidth_ExportCounters( fileHandle_t fp, const char *prefix, const char *section,
+		const msgProfileCounter_t *counters, int count, const char *( *nameFunction )( int index ) ) {
+	int i;
+	for ( i = 0; i < count; ++i ) {
+		if ( counters[i].bits ) {
+			const char *name = nameFunction ? nameFunction( i ) : va( "%i", i );
+			FS_Printf( fp, "%s,%s,%s,%lld,%lld\n", prefix, section, name ? name : "?",
+					(long long)counters[i].count, (long long)( counters[i].bits / 8 ) );
+		}
+	}
+}
+
+/*
+=================
+SV_Bandwidth_ExportClient
+
+Writes CSV rows for client slot, or aggregate of all slots if clientNum is -1.
+=================
+*/
+static void SV_Bandwidth_ExportClient( fileHandle_t fp, bandwidthClient_t *stats, int clientNum ) {
+	char prefix[MAX_NAME_LENGTH + 16];
+	char name[MAX_NAME_LENGTH];
+	int i;
+
+	if ( !SV_Bandwidth_Sum( stats, clientNum ) ) {
+		return;
+	}
+
+	// strip characters that would break the csv format
+	Q_strncpyz( name, stats->name, sizeof( name ) );
+	for ( i = 0; name[i]; ++i ) {
+		if ( name[i] == ',' || name[i] == '"' || name[i] == '\n' ) {
+			name[i] = ' ';
+		}
+	}
+	if ( clientNum >= 0 ) {
+		Com_sprintf( prefix, sizeof( prefix ), "%i,%s", clientNum, name );
+	} else {
+		Q_strncpyz( prefix, "all,", sizeof( prefix ) );
+	}
+
+	FS_Printf( fp, "%s,message,total,%lld,%lld\n", prefix, (long long)stats->messages,
+			(long long)( stats->messageBits / 8 ) );
+	for ( i = 0; i < SV_BANDWIDTH_CATEGORY_COUNT; ++i ) {
+		FS_Printf( fp, "%s,section,%s,,%lld\n", prefix, bandwidthCategoryNames[i],
+				(long long)( stats->categoryBits[i] / 8 ) );
+	}
+	SV_Bandwidth_ExportCounters( fp, prefix, "entityType", stats->msg.entityTypes, MSG_PROFILE_ENTITY_TYPES, NULL );
+	SV_Bandwidth_ExportCounters( fp, prefix, "entityField", stats->msg.entityFields, MSG_PROFILE_FIELDS,
+			MSG_ProfileEntityFieldName );
+	SV_Bandwidth_ExportCounters( fp, prefix, "playerField", stats->msg.playerFields, MSG_PROFILE_FIELDS,
+			MSG_ProfilePlayerFieldName );
+}
+
+/*
+=================
+SV_Bandwidth_Export
+=================
+*/
+static void SV_Bandwidth_Export( const char *outputName ) {
+	char path[MAX_QPATH];
+	bandwidthClient_t *stats;
+	fileHandle_t fp;
+	int i;
+
+	Com_sprintf( path, sizeof( path ), "bandwidth/%s", outputName );
+	COM_DefaultExtension( path, sizeof( path ), ".csv" );
+	if ( strstr( path, ".." ) ) {
+		Com_Printf( "Invalid path\n" );
+		return;
+	}
+
+	fp = FS_FOpenFileWrite_HomeData( path );
+	if ( !fp ) {
+		Com_Printf( "Failed to open %s for writing.\n", path );
+		return;
+	}
+
+	stats = (bandwidthClient_t *)Z_Malloc( sizeof( *stats ) );
+	FS_Printf( fp, "client,name,section,key,count,bytes\n" );
+	SV_Bandwidth_ExportClient( fp, stats, -1 );
+	for ( i = 0; i < MAX_CLIENTS; ++i ) {
+		SV_Bandwidth_ExportClient( fp, stats, i );
+	}
+	Z_Free( stats );
+
+	FS_FCloseFile( fp );
+	Com_Printf( "Bandwidth profile written to %s\n", path );
+}
+
+/*
+=================
+SV_Bandwidth_f
+=================
+*/
+static void SV_Bandwidth_f( void ) {
+	const char *arg = Cmd_Argv( 1 );
+
+	if ( !Q_stricmp( arg, "reset" ) ) {
+		SV_Bandwidth_Reset();
+		Com_Printf( "Bandwidth profile reset.\n" );
+		return;
+	}
+
+	if ( !Q_stricmp( arg, "export" ) ) {
+		SV_Bandwidth_Export( Cmd_Argc() > 2 ? Cmd_Argv( 2 ) : "bandwidth" );
+		return;
+	}
+
+	if ( *arg ) {
+		int clientNum = atoi( arg );
+		if ( clientNum < 0 || clientNum >= MAX_CLIENTS || !Q_isanumber( arg ) ) {
+			Com_Printf( "Usage: bandwidthProfile [client number | reset | export [file]]\n" );
+			return;
+		}
+		SV_Bandwidth_Print( clientNum );
+		return;
+	}
+
+	if ( !sv_bandwidthProfile->integer && !bandwidth.started ) {
+		Com_Printf( "Set sv_bandwidthProfile to 1 to start profiling.\n" );
+		return;
+	}
+	SV_Bandwidth_Print( -1 );
+}
+
+/*
+=================
+SV_Bandwidth_Init
+=================
+*/
+void SV_Bandwidth_Init( void ) {
+	Cmd_AddCommand( "bandwidthProfile", SV_Bandwidth_f );
+}
+
+#endif
@@ -0,0 +1,593 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+Copyright (C) 2017 Noah Metzger (chomenor@gmail.com)
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+
+#ifdef CMOD_SERVER_BENCHMARK
+#include "../../server/server.h"
+
+/*
+###############################################################################################
+
+Server Benchmark
+
+The "sv_benchmark" command loads a map on a dedicated server, adds a number of bots, and
+then runs server frames back to back without waiting for real time to pass. The time spent
+in each part of the frame is recorded for a fixed number of frames, and the results are
+printed and written to a JSON file for regression tracking.
+
+Each frame is split into phases:
+   network: sending queued packets and processing received packets
+   bots: bot AI frame (BOTAI_START_FRAME)
+   game: game module frame (GAME_RUN_FRAME)
+   snapshots: building snapshots and sending messages to clients (SV_SendClientMessages)
+   other: everything else in the frame, such as command execution
+
+Bot names are taken from the same bot info files the game module uses. After the bots are
+added, frames run without being measured until all the bots have entered the game.
+
+Other load sources, such as record replay, can drive the benchmark through SV_Benchmark_Start
+in place of bots.
+
+###############################################################################################
+*/
+
+#define BENCHMARK_MAX_BOT_NAMES 64
+#define BENCHMARK_BOT_SKILL 4
+#define BENCHMARK_JOIN_TIMEOUT 10000	// msec of server time to wait for bots to enter game
+
+typedef enum {
+	BENCHMARK_IDLE,
+	BENCHMARK_LOADING,		// waiting for map to load
+	BENCHMARK_WARMUP,		// waiting for bots to enter game
+	BENCHMARK_MEASURE
+} benchmarkState_t;
+
+static const char *benchmarkPhaseNames[SV_BENCHMARK_PHASE_COUNT] = {
+	"total", "network", "bots", "game", "snapshots", "other" };
+
+static struct {
+	benchmarkState_t state;
+	const svBenchmarkSource_t *source;
+	char mapName[MAX_QPATH];
+	char outputPath[MAX_QPATH];
+	int numBots;
+	int numFrames;
+
+	int warmupStartTime;		// sv.time when bots were added
+	int lastServerTime;			// to detect map changes
+	int64_t runStart;			// Sys_Microseconds at start of measurement
+
+	int64_t frameStart;
+	int64_t current[SV_BENCHMARK_PHASE_COUNT];
+	int64_t *samples[SV_BENCHMARK_PHASE_COUNT];	// usec for each measured frame
+	int frameCount;
+} benchmark;
+
+static cvar_t *sv_benchmarkQuit;
+
+/*
+=================
+SV_Benchmark_Reset
+=================
+*/
+static void SV_Benchmark_Reset( void ) {
+	int i;
+	if ( benchmark.source && benchmark.source->stop ) {
+		benchmark.source->stop();
+	}
+	for ( i = 0; i < SV_BENCHMARK_PHASE_COUNT; ++i ) {
+		if ( benchmark.samples[i] ) {
+			Z_Free( benchmark.samples[i] );
+		}
+	}
+	Com_Memset( &benchmark, 0, sizeof( benchmark ) );
+}
+
+/*
+=================
+SV_Benchmark_Abort
+=================
+*/
+static void SV_Benchmark_Abort( const char *reason ) {
+	Com_Printf( "Benchmark aborted: %s\n", reason );
+	SV_Benchmark_Reset();
+}
+
+/* ******************************************************************************** */
+// Bot Setup
+/* ******************************************************************************** */
+
+/*
+=================
+SV_Benchmark_ParseBotNames
+
+Adds bot names from bot info file to names. Returns updated name count.
+=================
+*/
+static int SV_Benchmark_ParseBotNames( const char *path, char names[][MAX_NAME_LENGTH], int count ) {
+	char *data;
+	char *text;
+
+	if ( FS_ReadFile( path, (void **)&data ) <= 0 ) {
+		return count;
+	}
+
+	text = data;
+	while ( count < BENCHMARK_MAX_BOT_NAMES ) {
+		char *token = COM_Parse( &text );
+		if ( !*token ) {
+			break;
+		}
+		if ( !Q_stricmp( token, "name" ) ) {
+			token = COM_ParseExt( &text, qfalse );
+			if ( *token && !strchr( token, '"' ) ) {
+				Q_strncpyz( names[count++], token, MAX_NAME_LENGTH );
+			}
+		}
+	}
+
+	FS_FreeFile( data );
+	return count;
+}
+
+/*
+=================
+SV_Benchmark_AddBots
+
+Returns qfalse to abort if no bot names are available.
+=================
+*/
+static qboolean SV_Benchmark_AddBots( void ) {
+	char names[BENCHMARK_MAX_BOT_NAMES][MAX_NAME_LENGTH];
+	const char *botsFile = Cvar_VariableString( "g_botsFile" );
+	char **files;
+	int numFiles;
+	int count;
+	int i;
+
+	count = SV_Benchmark_ParseBotNames( *botsFile ? botsFile : "scripts/bots.txt", names, 0 );
+	files = FS_ListFiles( "scripts", ".bot", &numFiles );
+	for ( i = 0; i < numFiles; ++i ) {
+		count = SV_Benchmark_ParseBotNames( va( "scripts/%s", files[i] ), names, count );
+	}
+	FS_FreeFileList( files );
+
+	if ( !count ) {
+		Com_Printf( "Benchmark: no bot info found.\n" );
+		return qfalse;
+	}
+
+	for ( i = 0; i < benchmark.numBots; ++i ) {
+		Cbuf_AddText( va( "addbot \"%s\" %i\n", names[i % count], BENCHMARK_BOT_SKILL ) );
+	}
+	return qtrue;
+}
+
+/*
+=================
+SV_Benchmark_ActiveClients
+=================
+*/
+static int SV_Benchmark_ActiveClients( qboolean botsOnly ) {
+	int count = 0;
+	int i;
+
+	for ( i = 0; i < sv_maxclients->integer; ++i ) {
+		if ( svs.clients[i].state == CS_ACTIVE &&
+				( !botsOnly || svs.clients[i].netchan.remoteAddress.type == NA_BOT ) ) {
+			++count;
+		}
+	}
+	return count;
+}
+
+/*
+=================
+SV_Benchmark_BotsReady
+
+Returns qtrue once all bots have entered the game, or they have had enough time to.
+=================
+*/
+static qboolean SV_Benchmark_BotsReady( void ) {
+	int activeBots = SV_Benchmark_ActiveClients( qtrue );
+	if ( activeBots < benchmark.numBots ) {
+		if ( sv.time - benchmark.warmupStartTime < BENCHMARK_JOIN_TIMEOUT ) {
+			return qfalse;
+		}
+		Com_Printf( "WARNING: Only %i of %i bots entered game; benchmarking anyway.\n",
+				activeBots, benchmark.numBots );
+	}
+	return qtrue;
+}
+
+static const svBenchmarkSource_t benchmarkBotSource = {
+	"bots", SV_Benchmark_AddBots, SV_Benchmark_BotsReady, NULL, NULL };
+
+/* ******************************************************************************** */
+// Results
+/* ******************************************************************************** */
+
+/*
+=================
+SV_Benchmark_CompareSamples
+=================
+*/
+static int SV_Benchmark_CompareSamples( const void *a, const void *b ) {
+	int64_t x = *(const int64_t *)a;
+	int64_t y = *(const int64_t *)b;
+	return x < y ? -1 : ( x > y ? 1 : 0 );
+}
+
+typedef struct {
+	double mean;
+	double p50;
+	double p95;
+	double p99;
+	double max;
+} benchmarkSummary_t;
+
+/*
+=================
+SV_Benchmark_Percentile
+
+Nearest rank percentile from sorted samples, in msec.
+=================
+*/
+static double SV_Benchmark_Percentile( const int64_t *sorted, int count, int percent ) {
+	int index = ( count * percent + 99 ) / 100 - 1;
+	if ( index < 0 ) {
+		index = 0;
+	}
+	return sorted[index] / 1000.0;
+}
+
+/*
+=================
+SV_Benchmark_Summarize
+
+Sorts samples in place.
+=================
+*/
+static benchmarkSummary_t SV_Benchmark_Summarize( int64_t *samples, int count ) {
+	benchmarkSummary_t summary;
+	int64_t total = 0;
+	int i;
+
+	for ( i = 0; i < count; ++i ) {
+		total += samples[i];
+	}
+	qsort( samples, count, sizeof( *samples ), SV_Benchmark_CompareSamples );
+
+	summary.mean = (double)total / count / 1000.0;
+	summary.p50 = SV_Benchmark_Percentile( samples, count, 50 );
+	summary.p95 = SV_Benchmark_Percentile( samples, count, 95 );
+	summary.p99 = SV_Benchmark_Percentile( samples, count, 99 );
+	summary.max = samples[count - 1] / 1000.0;
+	return summary;
+}
+
+/*
+=================
+SV_Benchmark_JsonString
+
+Escapes string for a JSON string value. Control characters and bytes outside of ASCII are
+written as "\u00NN" so the output is always valid.
+=================
+*/
+static const char *SV_Benchmark_JsonString( const char *string, char *buffer, int size ) {
+	const unsigned char *src = (const unsigned char *)string;
+	int length = 0;
+
+	while ( *src && length < size - 7 ) {
+		if ( *src < 0x20 || *src >= 0x7f ) {
+			Com_sprintf( buffer + length, size - length, "\\u%04x", *src );
+			length += 6;
+		} else {
+			if ( *src == '\\' || *src == '"' ) {
+				buffer[length++] = '\\';
+			}
+			buffer[length++] = *src;
+		}
+		++src;
+	}
+
+	buffer[length] = '\0';
+	return buffer;
+}
+
+/*
+=================
+SV_Benchmark_Finish
+=================
+*/
+static void SV_Benchmark_Finish( void ) {
+	benchmarkSummary_t summaries[SV_BENCHMARK_PHASE_COUNT];
+	double wallMsec = ( Sys_Microseconds() - benchmark.runStart ) / 1000.0;
+	int activeClients = SV_Benchmark_ActiveClients( qfalse );
+	fileHandle_t fp;
+	int i;
+
+	for ( i = 0; i < SV_BENCHMARK_PHASE_COUNT; ++i ) {
+		summaries[i] = SV_Benchmark_Summarize( benchmark.samples[i], benchmark.frameCount );
+	}
+
+	Com_Printf( "Benchmark complete: map %s, %s, %i clients, %i frames in %.1f msec (%.1f frames/sec)\n",
+			benchmark.mapName, benchmark.source->name, activeClients, benchmark.frameCount, wallMsec,
+			benchmark.frameCount * 1000.0 / wallMsec );
+	Com_Printf( "%-10s %9s %9s %9s %9s %9s (msec)\n", "phase", "mean", "p50", "p95", "p99", "max" );
+	for ( i = 0; i < SV_BENCHMARK_PHASE_COUNT; ++i ) {
+		Com_Printf( "%-10s %9.3f %9.3f %9.3f %9.3f %9.3f\n", benchmarkPhaseNames[i], summaries[i].mean,
+				summaries[i].p50, summaries[i].p95, summaries[i].p99, summaries[i].max );
+	}
+
+	fp = FS_FOpenFileWrite_HomeData( benchmark.outputPath );
+	if ( fp ) {
+		char mapName[MAX_QPATH * 6 + 1];
+		char sourceName[64];
+		FS_Printf( fp, "{\n  \"map\": \"%s\",\n  \"source\": \"%s\",\n  \"bots\": %i,\n  \"clients\": %i,\n"
+				"  \"frames\": %i,\n  \"sv_fps\": %i,\n  \"wallMsec\": %.3f,\n  \"phases\": {\n",
+				SV_Benchmark_JsonString( benchmark.mapName, mapName, sizeof( mapName ) ),
+				SV_Benchmark_JsonString( benchmark.source->name, sourceName, sizeof( sourceName ) ),
+				benchmark.numBots, activeClients, benchmark.frameCount, sv_fps->integer, wallMsec );
+		for ( i = 0; i < SV_BENCHMARK_PHASE_COUNT; ++i ) {
+			FS_Printf( fp, "    \"%s\": { \"mean\": %.3f, \"p50\": %.3f, \"p95\": %.3f, \"p99\": %.3f, \"max\": %.3f }%s\n",
+					benchmarkPhaseNames[i], summaries[i].mean, summaries[i].p50, summaries[i].p95,
+					summaries[i].p99, summaries[i].max, i < SV_BENCHMARK_PHASE_COUNT - 1 ? "," : "" );
+		}
+		FS_Printf( fp, "  }\n}\n" );
+		FS_FCloseFile( fp );
+		Com_Printf( "Results written to %s\n", benchmark.outputPath );
+	} else {
+		Com_Printf( "Failed to open %s for writing.\n", benchmark.outputPath );
+	}
+
+	SV_Benchmark_Reset();
+	if ( sv_benchmarkQuit->integer ) {
+		Cbuf_AddText( "quit\n" );
+	}
+}
+
+/* ******************************************************************************** */
+// Frame Hooks
+/* ******************************************************************************** */
+
+/*
+=================
+SV_Benchmark_Running
+
+Returns qtrue if server frames should run without waiting.
+=================
+*/
+qboolean SV_Benchmark_Running( void ) {
+	return benchmark.state != BENCHMARK_IDLE ? qtrue : qfalse;
+}
+
+/*
+=================
+SV_Benchmark_FrameMsec
+
+Returns msec to advance the server each frame, which runs exactly one game frame.
+=================
+*/
+int SV_Benchmark_FrameMsec( void ) {
+	int frameMsec = 1000 / sv_fps->integer * com_timescale->value;
+	return frameMsec < 1 ? 1 : frameMsec;
+}
+
+/*
+=================
+SV_Benchmark_RecordPhase
+
+Adds time since start to phase for the current frame.
+=================
+*/
+void SV_Benchmark_RecordPhase( svBenchmarkPhase_t phase, int64_t start ) {
+	if ( benchmark.state == BENCHMARK_MEASURE ) {
+		benchmark.current[phase] += Sys_Microseconds() - start;
+	}
+}
+
+/*
+=================
+SV_Benchmark_StartFrame
+
+Called in place of the frame wait loop while the benchmark is running.
+=================
+*/
+void SV_Benchmark_StartFrame( void ) {
+	if ( !com_sv_running->integer ) {
+		SV_Benchmark_Abort( "server not running" );
+		return;
+	}
+
+	Com_Memset( benchmark.current, 0, sizeof( benchmark.current ) );
+	benchmark.frameStart = Sys_Microseconds();
+
+	SV_SendQueuedPackets();
+	NET_Sleep( 0 );
+	if ( benchmark.state != BENCHMARK_LOADING && benchmark.source->frame && !benchmark.source->frame() ) {
+		if ( benchmark.frameCount ) {
+			SV_Benchmark_Finish();
+		} else {
+			SV_Benchmark_Abort( "source finished before measurement started" );
+		}
+		return;
+	}
+}
+
+/*
+=================
+SV_Benchmark_EndNetworkPhase
+
+Called after Com_EventLoop, so the network phase covers everything from the start of the
+frame through processing of received packets.
+=================
+*/
+void SV_Benchmark_EndNetworkPhase( void ) {
+	SV_Benchmark_RecordPhase( SV_BENCHMARK_PHASE_NETWORK, benchmark.frameStart );
+}
+
+/*
+=================
+SV_Benchmark_EndFrame
+
+Called after the server frame.
+=================
+*/
+void SV_Benchmark_EndFrame( void ) {
+	if ( benchmark.state == BENCHMARK_IDLE ) {
+		return;
+	}
+	if ( !com_sv_running->integer || sv.state != SS_GAME ) {
+		SV_Benchmark_Abort( "server not running" );
+		return;
+	}
+	if ( benchmark.state != BENCHMARK_LOADING && sv.time < benchmark.lastServerTime ) {
+		SV_Benchmark_Abort( "map changed" );
+		return;
+	}
+	benchmark.lastServerTime = sv.time;
+
+	if ( benchmark.state == BENCHMARK_LOADING ) {
+		benchmark.warmupStartTime = sv.time;
+		benchmark.state = BENCHMARK_WARMUP;
+		if ( !benchmark.source->start() ) {
+			SV_Benchmark_Abort( "failed to start" );
+		}
+		return;
+	}
+
+	if ( benchmark.state == BENCHMARK_WARMUP ) {
+		if ( !benchmark.source->ready() ) {
+			return;
+		}
+		Com_Printf( "Running %i benchmark frames...\n", benchmark.numFrames );
+		benchmark.runStart = Sys_Microseconds();
+		benchmark.state = BENCHMARK_MEASURE;
+		return;
+	}
+
+	if ( benchmark.state == BENCHMARK_MEASURE ) {
+		int64_t *current = benchmark.current;
+		int i;
+
+		current[SV_BENCHMARK_PHASE_TOTAL] = Sys_Microseconds() - benchmark.frameStart;
+		current[SV_BENCHMARK_PHASE_OTHER] = current[SV_BENCHMARK_PHASE_TOTAL];
+		for ( i = SV_BENCHMARK_PHASE_NETWORK; i < SV_BENCHMARK_PHASE_OTHER; ++i ) {
+			current[SV_BENCHMARK_PHASE_OTHER] -= current[i];
+		}
+
+		for ( i = 0; i < SV_BENCHMARK_PHASE_COUNT; ++i ) {
+			benchmark.samples[i][benchmark.frameCount] = current[i];
+		}
+		if ( ++benchmark.frameCount >= benchmark.numFrames ) {
+			SV_Benchmark_Finish();
+		}
+	}
+}
+
+/* ******************************************************************************** */
+// Command
+/* ******************************************************************************** */
+
+/*
+=================
+SV_Benchmark_Start
+
+Loads map and starts benchmark with given load source. Output name is relative to the
+benchmarks directory.
+=================
+*/
+void SV_Benchmark_Start( const char *mapName, int numFrames, const char *outputName,
+		const svBenchmarkSource_t *source ) {
+	int i;
+
+	SV_Benchmark_Reset();
+	Q_strncpyz( benchmark.mapName, mapName, sizeof( benchmark.mapName ) );
+	benchmark.numFrames = numFrames;
+	Com_sprintf( benchmark.outputPath, sizeof( benchmark.outputPath ), "benchmarks/%s", outputName );
+	COM_DefaultExtension( benchmark.outputPath, sizeof( benchmark.outputPath ), ".json" );
+
+	for ( i = 0; i < SV_BENCHMARK_PHASE_COUNT; ++i ) {
+		benchmark.samples[i] = Z_Malloc( numFrames * sizeof( *benchmark.samples[i] ) );
+	}
+
+	// map loads immediately after this command, and the source is started after the first frame
+	benchmark.source = source;
+	benchmark.state = BENCHMARK_LOADING;
+	Cbuf_ExecuteText( EXEC_INSERT, va( "map \"%s\"\n", benchmark.mapName ) );
+}
+
+/*
+=================
+SV_Benchmark_f
+=================
+*/
+static void SV_Benchmark_f( void ) {
+	int numBots;
+	int numFrames;
+
+	if ( !Q_stricmp( Cmd_Argv( 1 ), "stop" ) ) {
+		if ( SV_Benchmark_Running() ) {
+			SV_Benchmark_Abort( "stopped by command" );
+		}
+		return;
+	}
+
+	if ( Cmd_Argc() < 4 ) {
+		Com_Printf( "Usage: sv_benchmark <map> <bots> <frames> [output file] - run server frames at full speed\n"
+				"       sv_benchmark stop - abort benchmark in progress\n" );
+		return;
+	}
+
+	if ( !com_dedicated->integer ) {
+		Com_Printf( "Benchmark requires dedicated server.\n" );
+		return;
+	}
+
+	numBots = atoi( Cmd_Argv( 2 ) );
+	numFrames = atoi( Cmd_Argv( 3 ) );
+	if ( numBots < 0 || numBots > sv_maxclients->integer ) {
+		Com_Printf( "Bot count must be between 0 and sv_maxclients (%i).\n", sv_maxclients->integer );
+		return;
+	}
+	if ( numFrames < 1 || numFrames > SV_BENCHMARK_MAX_FRAMES ) {
+		Com_Printf( "Frame count must be between 1 and %i.\n", SV_BENCHMARK_MAX_FRAMES );
+		return;
+	}
+
+	SV_Benchmark_Start( Cmd_Argv( 1 ), numFrames, Cmd_Argc() > 4 ? Cmd_Argv( 4 ) : "sv_benchmark",
+			&benchmarkBotSource );
+	benchmark.numBots = numBots;
+}
+
+/*
+=================
+SV_Benchmark_Init
+=================
+*/
+void SV_Benchmark_Init( void ) {
+	sv_benchmarkQuit = Cvar_Get( "sv_benchmarkQuit", "0", 0 );
+	Cmd_AddCommand( "sv_benchmark", SV_Benchmark_f );
+}
+
+#endif
@@ -0,0 +1,181 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+Copyright (C) 2017 Noah Metzger (chomenor@gmail.com)
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+
+#include "../../server/server.h"
+#include "../../botlib/botlib.h"
+
+#ifdef CMOD_BOT_THINK_STATS
+/*
+###############################################################################################
+
+Bot Think Stats
+
+Measures the time spent in the game module's bot AI frame (BOTAI_START_FRAME) each server
+frame. Stats are reset when a new map is loaded, so running "bot_thinkStats" after playing
+a map with and without a given bot optimization gives a before/after comparison. A histogram of
+the frame durations is included to show how evenly the bot load is spread over frames.
+
+###############################################################################################
+*/
+
+#define BOT_THINK_HISTOGRAM_BUCKETS 8
+
+// upper bound of each histogram bucket in usec, except the last bucket which is unbounded
+static const int botThinkHistogramLimits[BOT_THINK_HISTOGRAM_BUCKETS - 1] = {
+	250, 500, 1000, 2000, 4000, 8000, 16000 };
+
+typedef struct {
+	int frames;
+	int64_t totalUsec;
+	int64_t maxUsec;
+	int maxFrameTime;		// sv.time of the slowest frame
+	int slowFrames;			// frames over 1 msec
+	int histogram[BOT_THINK_HISTOGRAM_BUCKETS];
+} botThinkStats_t;
+
+static botThinkStats_t botThinkStats;
+
+/*
+=================
+SV_BotThinkStats_Reset
+=================
+*/
+void SV_BotThinkStats_Reset( void ) {
+	Com_Memset( &botThinkStats, 0, sizeof( botThinkStats ) );
+}
+
+/*
+=================
+SV_BotThinkStats_Record
+
+Called with the duration of each bot AI frame.
+=================
+*/
+void SV_BotThinkStats_Record( int64_t usec ) {
+	int bucket = 0;
+	while ( bucket < BOT_THINK_HISTOGRAM_BUCKETS - 1 && usec >= botThinkHistogramLimits[bucket] ) {
+		++bucket;
+	}
+	++botThinkStats.histogram[bucket];
+
+	++botThinkStats.frames;
+	botThinkStats.totalUsec += usec;
+	if ( usec > botThinkStats.maxUsec ) {
+		botThinkStats.maxUsec = usec;
+		botThinkStats.maxFrameTime = sv.time;
+	}
+	if ( usec > 1000 ) {
+		++botThinkStats.slowFrames;
+	}
+}
+
+/*
+=================
+SV_BotThinkStats_f
+=================
+*/
+static void SV_BotThinkStats_f( void ) {
+	int i;
+
+	if ( !Q_stricmp( Cmd_Argv( 1 ), "reset" ) ) {
+		SV_BotThinkStats_Reset();
+		Com_Printf( "Bot think stats reset.\n" );
+		return;
+	}
+
+	if ( !botThinkStats.frames ) {
+		Com_Printf( "No bot frames recorded.\n" );
+		return;
+	}
+
+	Com_Printf( "frames: %i\n", botThinkStats.frames );
+	Com_Printf( "average: %.3f msec\n", (double)botThinkStats.totalUsec / botThinkStats.frames / 1000.0 );
+	Com_Printf( "max: %.3f msec (at server time %i)\n", (double)botThinkStats.maxUsec / 1000.0,
+			botThinkStats.maxFrameTime );
+	Com_Printf( "frames over 1 msec: %i\n", botThinkStats.slowFrames );
+
+	Com_Printf( "histogram:\n" );
+	for ( i = 0; i < BOT_THINK_HISTOGRAM_BUCKETS; ++i ) {
+		char label[32];
+		if ( i < BOT_THINK_HISTOGRAM_BUCKETS - 1 ) {
+			Com_sprintf( label, sizeof( label ), "< %.2f msec", botThinkHistogramLimits[i] / 1000.0 );
+		} else {
+			Com_sprintf( label, sizeof( label ), ">= %.2f msec", botThinkHistogramLimits[i - 1] / 1000.0 );
+		}
+		Com_Printf( "  %-16s %7i (%.1f%%)\n", label, botThinkStats.histogram[i],
+				100.0 * botThinkStats.histogram[i] / botThinkStats.frames );
+	}
+}
+
+/*
+=================
+SV_BotThinkStats_Init
+=================
+*/
+void SV_BotThinkStats_Init( void ) {
+	Cmd_AddCommand( "bot_thinkStats", SV_BotThinkStats_f );
+}
+
+#endif
+
+#ifdef CMOD_BOT_ROUTE_CACHE_BUDGET
+/*
+###############################################################################################
+
+Bot Routing Cache Stats
+
+The stats themselves are maintained by botlib. This command just requests them through the
+"routecachestats" libvar, and they are printed at the start of the next bot frame.
+
+###############################################################################################
+*/
+
+extern botlib_export_t *botlib_export;
+
+/*
+=================
+SV_BotRouteCacheStats_f
+=================
+*/
+static void SV_BotRouteCacheStats_f( void ) {
+	if ( !botlib_export || sv.state != SS_GAME ) {
+		Com_Printf( "Bot routing not active.\n" );
+		return;
+	}
+
+	if ( !Q_stricmp( Cmd_Argv( 1 ), "reset" ) ) {
+		botlib_export->BotLibVarSet( "routecachestats", "2" );
+	} else {
+		botlib_export->BotLibVarSet( "routecachestats", "1" );
+	}
+}
+
+/*
+=================
+SV_BotRouteCacheStats_Init
+=================
+*/
+void SV_BotRouteCacheStats_Init( void ) {
+	Cmd_AddCommand( "bot_routeCacheStats", SV_BotRouteCacheStats_f );
+}
+#endif
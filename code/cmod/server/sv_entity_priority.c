@@ -0,0 +1,316 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+Copyright (C) 2017 Noah Metzger (chomenor@gmail.com)
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+
+#ifdef CMOD_SNAPSHOT_ENTITY_PRIORITY
+#include "../../server/server.h"
+
+/*
+###############################################################################################
+
+Snapshot Entity Priority
+
+When sv_entityPriority is enabled and the entity updates in a snapshot are estimated to exceed
+the client's rate budget for one snapshot interval, the lowest priority entity updates are
+deferred to a later snapshot instead of letting the whole snapshot be rate delayed or
+fragmented.
+
+An update is deferred by storing the entity state from the delta frame into the new frame in
+place of the current state. The entity is then unchanged relative to the delta frame, so
+nothing is written for it, and since the frame holds exactly the state the client will have,
+later snapshots delta compress correctly regardless of which frame the client acknowledges.
+
+The delta frame can be older than the most recently sent frame, which the client may already
+have received. Updates are only deferred if the entity has the same state in the most recently
+sent frame as in the delta frame, so deferring never rolls the client back to an older state.
+
+Only updates to entities the client already has are deferred. Entities entering the snapshot,
+and updates that change eType, eFlags, or event (which carry events and teleports), are always
+sent. An update can be deferred for at most sv_entityPriorityMaxDefer consecutive snapshots.
+
+Priority favors player entities, nearby entities, updates that start a new trajectory (which
+the client can't extrapolate from the old one), and updates that have already been deferred.
+
+###############################################################################################
+*/
+
+#define PRIORITY_OVERHEAD_BYTES 64		// estimate for message header and playerstate
+#define PRIORITY_ESTIMATE_BUFFER 1024
+
+typedef struct {
+	int frameIndex;		// index into new frame entities
+	int oldIndex;		// index into delta frame entities
+	int bits;			// estimated encoded size
+	float priority;
+} priorityCandidate_t;
+
+static priorityCandidate_t priorityCandidates[MAX_SNAPSHOT_ENTITIES];
+
+/*
+=================
+SV_Priority_DeltaFrame
+
+Returns the frame the snapshot will be delta compressed from, or null if it will be sent
+uncompressed. Matches the selection in SV_WriteSnapshotToClient.
+=================
+*/
+static clientSnapshot_t *SV_Priority_DeltaFrame( client_t *client ) {
+	clientSnapshot_t *oldframe;
+
+	if ( client->deltaMessage <= 0 || client->state != CS_ACTIVE ) {
+		return NULL;
+	}
+	if ( client->netchan.outgoingSequence - client->deltaMessage >= ( PACKET_BACKUP - 3 ) ) {
+		return NULL;
+	}
+
+	oldframe = &client->frames[client->deltaMessage & PACKET_MASK];
+	if ( oldframe->first_entity <= svs.nextSnapshotEntities - svs.numSnapshotEntities ) {
+		return NULL;
+	}
+	return oldframe;
+}
+
+/*
+=================
+SV_Priority_LastFrame
+
+Returns the most recently sent frame, or null if its entities are no longer available.
+=================
+*/
+static clientSnapshot_t *SV_Priority_LastFrame( client_t *client ) {
+	clientSnapshot_t *lastframe = &client->frames[( client->netchan.outgoingSequence - 1 ) & PACKET_MASK];
+
+	if ( lastframe->first_entity <= svs.nextSnapshotEntities - svs.numSnapshotEntities ) {
+		return NULL;
+	}
+	return lastframe;
+}
+
+/*
+=================
+SV_Priority_FindEntity
+
+Advances index through the sorted entity list of frame to the given entity number. Returns
+the entity state if frame contains it, otherwise null.
+=================
+*/
+static entityState_t *SV_Priority_FindEntity( clientSnapshot_t *frame, int *index, int number ) {
+	while ( *index < frame->num_entities ) {
+		entityState_t *state = &svs.snapshotEntities[( frame->first_entity + *index ) % svs.numSnapshotEntities];
+		if ( state->number >= number ) {
+			return state->number == number ? state : NULL;
+		}
+		++*index;
+	}
+	return NULL;
+}
+
+/*
+=================
+SV_Priority_BudgetBits
+
+Returns estimated bits available for entity updates in one snapshot interval.
+=================
+*/
+static int SV_Priority_BudgetBits( client_t *client ) {
+	int rate = client->rate;
+	int bytes;
+	int i;
+
+	if ( sv_maxRate->integer >= 1000 && sv_maxRate->integer < rate ) {
+		rate = sv_maxRate->integer;
+	}
+	if ( sv_minRate->integer >= 1000 && sv_minRate->integer > rate ) {
+		rate = sv_minRate->integer;
+	}
+
+	bytes = (int)( (int64_t)rate * client->snapshotMsec / 1000 ) - PRIORITY_OVERHEAD_BYTES;
+
+	// reliable commands pending for the client are sent first in the same message
+	for ( i = client->reliableAcknowledge + 1; i <= client->reliableSequence; ++i ) {
+		bytes -= strlen( client->reliableCommands[i & ( MAX_RELIABLE_COMMANDS - 1 )] ) + 6;
+	}
+
+	return bytes > 0 ? bytes * 8 : 0;
+}
+
+/*
+=================
+SV_Priority_EstimateBits
+
+Returns encoded size of an entity delta.
+=================
+*/
+static int SV_Priority_EstimateBits( entityState_t *from, entityState_t *to ) {
+	byte buffer[PRIORITY_ESTIMATE_BUFFER];
+	msg_t msg;
+
+	MSG_Init( &msg, buffer, sizeof( buffer ) );
+	msg.allowoverflow = qtrue;
+	MSG_WriteDeltaEntity( &msg, from, to, qfalse );
+	return msg.overflowed ? PRIORITY_ESTIMATE_BUFFER * 8 : msg.bit;
+}
+
+/*
+=================
+SV_Priority_CompareCandidates
+
+Sorts lowest priority first.
+=================
+*/
+static int QDECL SV_Priority_CompareCandidates( const void *a, const void *b ) {
+	const priorityCandidate_t *ca = (const priorityCandidate_t *)a;
+	const priorityCandidate_t *cb = (const priorityCandidate_t *)b;
+	if ( ca->priority != cb->priority ) {
+		return ca->priority < cb->priority ? -1 : 1;
+	}
+	return ca->frameIndex - cb->frameIndex;
+}
+
+/*
+=================
+SV_Priority_EntityPriority
+=================
+*/
+static float SV_Priority_EntityPriority( client_t *client, const entityState_t *state, const entityState_t *oldState,
+		const vec3_t viewOrigin ) {
+	vec3_t delta;
+	float priority;
+
+	VectorSubtract( state->pos.trBase, viewOrigin, delta );
+	priority = 1.0f / ( 1.0f + VectorLength( delta ) / 256.0f );
+
+	if ( state->number < sv_maxclients->integer ) {
+		priority *= 4.0f;
+	}
+
+	// recent change, such as a mover starting or an item being thrown
+	if ( state->pos.trType != oldState->pos.trType || state->pos.trTime != oldState->pos.trTime ||
+			state->apos.trType != oldState->apos.trType || state->apos.trTime != oldState->apos.trTime ) {
+		priority *= 2.0f;
+	}
+	priority *= 1 + client->entityDeferCount[state->number];
+
+	return priority;
+}
+
+/*
+=================
+SV_Priority_ProcessSnapshot
+
+Called after the entity states for a client snapshot have been stored, to defer low
+priority entity updates if the snapshot exceeds the client's rate.
+=================
+*/
+void SV_Priority_ProcessSnapshot( client_t *client, clientSnapshot_t *frame ) {
+	clientSnapshot_t *oldframe;
+	clientSnapshot_t *lastframe;
+	int maxDefer = sv_entityPriorityMaxDefer->integer;
+	int budgetBits;
+	int totalBits = 0;
+	int candidateCount = 0;
+	int oldIndex = 0;
+	int lastIndex = 0;
+	vec3_t viewOrigin;
+	int i;
+
+	if ( !sv_entityPriority->integer || !frame->num_entities ) {
+		return;
+	}
+	if ( client->netchan.remoteAddress.type == NA_BOT || client->netchan.remoteAddress.type == NA_LOOPBACK ||
+			( sv_lanForceRate->integer && Sys_IsLANAddress( client->netchan.remoteAddress ) ) ) {
+		return;
+	}
+
+	oldframe = SV_Priority_DeltaFrame( client );
+	if ( !oldframe ) {
+		return;
+	}
+	lastframe = SV_Priority_LastFrame( client );
+	if ( !lastframe ) {
+		return;
+	}
+
+	budgetBits = SV_Priority_BudgetBits( client );
+	VectorCopy( frame->ps.origin, viewOrigin );
+	viewOrigin[2] += frame->ps.viewheight;
+
+	// both entity lists are sorted by entity number
+	for ( i = 0; i < frame->num_entities; ++i ) {
+		entityState_t *state = &svs.snapshotEntities[( frame->first_entity + i ) % svs.numSnapshotEntities];
+		entityState_t *oldState = SV_Priority_FindEntity( oldframe, &oldIndex, state->number );
+		entityState_t *lastState = SV_Priority_FindEntity( lastframe, &lastIndex, state->number );
+		int bits;
+
+		if ( !oldState ) {
+			// new to the client; always sent from baseline, so not counted against the budget
+			client->entityDeferCount[state->number] = 0;
+			continue;
+		}
+
+		bits = SV_Priority_EstimateBits( oldState, state );
+		if ( !bits ) {
+			client->entityDeferCount[state->number] = 0;
+			continue;
+		}
+		totalBits += bits;
+
+		if ( state->eType != oldState->eType || state->eFlags != oldState->eFlags ||
+				state->event != oldState->event || client->entityDeferCount[state->number] >= maxDefer ) {
+			client->entityDeferCount[state->number] = 0;
+			continue;
+		}
+
+		// the client may already have a newer state than the delta frame from the last frame
+		if ( lastframe != oldframe && ( !lastState || memcmp( lastState, oldState, sizeof( *oldState ) ) ) ) {
+			client->entityDeferCount[state->number] = 0;
+			continue;
+		}
+
+		priorityCandidates[candidateCount].frameIndex = i;
+		priorityCandidates[candidateCount].oldIndex = oldIndex;
+		priorityCandidates[candidateCount].bits = bits;
+		priorityCandidates[candidateCount].priority = SV_Priority_EntityPriority( client, state, oldState, viewOrigin );
+		++candidateCount;
+	}
+
+	if ( totalBits > budgetBits ) {
+		qsort( priorityCandidates, candidateCount, sizeof( *priorityCandidates ), SV_Priority_CompareCandidates );
+	}
+
+	for ( i = 0; i < candidateCount; ++i ) {
+		priorityCandidate_t *candidate = &priorityCandidates[i];
+		entityState_t *state = &svs.snapshotEntities[( frame->first_entity + candidate->frameIndex ) % svs.numSnapshotEntities];
+
+		if ( totalBits > budgetBits ) {
+			// defer by keeping the state the client already has
+			*state = svs.snapshotEntities[( oldframe->first_entity + candidate->oldIndex ) % svs.numSnapshotEntities];
+			totalBits -= candidate->bits;
+			++client->entityDeferCount[state->number];
+		} else {
+			client->entityDeferCount[state->number] = 0;
+		}
+	}
+}
+
+#endif
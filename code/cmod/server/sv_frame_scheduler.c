@@ -0,0 +1,346 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+Copyright (C) 2017 Noah Metzger (chomenor@gmail.com)
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+
+#ifdef CMOD_SERVER_FRAME_SCHEDULER
+#include "../../server/server.h"
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+###############################################################################################
+
+Server Frame Scheduler
+
+The standard frame wait loop in Com_Frame works in whole milliseconds, so on a dedicated server
+the start of each server frame (and the snapshots sent at the end of it) can drift by a
+millisecond or more from the ideal cadence.
+
+When sv_preciseFrames is enabled, the wait loop is replaced by one that keeps an absolute
+deadline for each frame on CLOCK_MONOTONIC, in microseconds, advanced by exactly one server
+frame each time. The wait is done on a timerfd armed with the deadline, included in the
+network select() so packets are still processed as they arrive. The msec passed to the server
+is taken from the deadlines rather than the millisecond clock, so each frame advances exactly
+one server frame. If the server falls more than a frame behind, the cadence restarts from the
+current time.
+
+Frame start timing is recorded in both modes, and the "sv_frameJitter" command prints the
+deviation of frame intervals from the server frame time, so the two modes can be compared.
+
+###############################################################################################
+*/
+
+#define JITTER_BUCKETS 10
+
+// upper bound of each jitter bucket in usec, except the last bucket which is unbounded
+static const int jitterBucketLimits[JITTER_BUCKETS - 1] = { 10, 25, 50, 100, 250, 500, 1000, 2500, 5000 };
+
+typedef struct {
+	int frames;
+	int histogram[JITTER_BUCKETS];
+	int64_t totalDeviation;		// absolute deviation, usec
+	int64_t maxDeviation;
+	double sumSquares;			// signed deviation, for standard deviation
+	int64_t totalLate;			// wake time after deadline, precise mode only
+	int64_t maxLate;
+} jitterStats_t;
+
+static struct {
+	int timerFd;				// -1 if not created, -2 if creation failed
+	qboolean scheduled;			// qtrue if the current frame was started by SV_Scheduler_Wait
+	int64_t nextFrame;			// deadline for next frame
+	int64_t frameStart;			// deadline for current frame
+	int64_t lastFrameStart;
+	int64_t residualUsec;		// sub-millisecond remainder not yet passed to server
+
+	// jitter measurement
+	qboolean precise;			// mode of current stats
+	int64_t periodUsec;			// period of current stats
+	int64_t lastActualStart;
+	int64_t lateUsec;			// lateness of current frame in precise mode
+	jitterStats_t stats;
+} sched = { -1 };
+
+/*
+=================
+SV_Scheduler_Now
+
+Returns CLOCK_MONOTONIC time in usec. All scheduler times use this, since the deadlines are
+passed to the timer as absolute times on the same clock.
+=================
+*/
+static int64_t SV_Scheduler_Now( void ) {
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/*
+=================
+SV_Scheduler_PeriodUsec
+=================
+*/
+static int64_t SV_Scheduler_PeriodUsec( void ) {
+	int fps = sv_fps->integer > 0 ? sv_fps->integer : 1;
+	int frameMsec = 1000 / fps;
+	return (int64_t)( frameMsec < 1 ? 1 : frameMsec ) * 1000;
+}
+
+/*
+=================
+SV_Scheduler_Active
+
+Returns qtrue if the precise scheduler should be used for the next frame.
+=================
+*/
+qboolean SV_Scheduler_Active( void ) {
+	if ( !sv_preciseFrames->integer || !com_dedicated->integer || !com_sv_running->integer ||
+			com_timescale->value != 1.0f ) {
+		sched.nextFrame = 0;
+		return qfalse;
+	}
+
+	if ( sched.timerFd == -1 ) {
+		sched.timerFd = timerfd_create( CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC );
+		if ( sched.timerFd < 0 ) {
+			Com_Printf( "WARNING: Failed to create frame timer; sv_preciseFrames disabled.\n" );
+			sched.timerFd = -2;
+		}
+	}
+	return sched.timerFd >= 0 ? qtrue : qfalse;
+}
+
+/*
+=================
+SV_Scheduler_SleepUntil
+
+Waits until time or until a network packet arrives.
+=================
+*/
+static void SV_Scheduler_SleepUntil( int64_t time ) {
+	struct itimerspec spec;
+	uint64_t expirations;
+
+	Com_Memset( &spec, 0, sizeof( spec ) );
+	spec.it_value.tv_sec = time / 1000000;
+	spec.it_value.tv_nsec = ( time % 1000000 ) * 1000;
+	if ( timerfd_settime( sched.timerFd, TFD_TIMER_ABSTIME, &spec, NULL ) < 0 ) {
+		NET_Sleep( 0 );
+		return;
+	}
+
+	// the select timeout is only a fallback; the timer normally wakes it first
+	NET_SleepFd( (int)( ( time - SV_Scheduler_Now() ) / 1000 ) + 1, sched.timerFd );
+
+	// clear timer expiration, if any
+	if ( read( sched.timerFd, &expirations, sizeof( expirations ) ) < 0 ) {
+		expirations = 0;
+	}
+}
+
+/*
+=================
+SV_Scheduler_Wait
+
+Called in place of the frame wait loop when SV_Scheduler_Active returns qtrue.
+=================
+*/
+void SV_Scheduler_Wait( qboolean busyWait ) {
+	int64_t period = SV_Scheduler_PeriodUsec();
+	int64_t now = SV_Scheduler_Now();
+
+	if ( !sched.nextFrame || now - sched.nextFrame > period || sched.nextFrame - now > period ) {
+		// first frame, fell more than a frame behind, or sv_fps changed
+		sched.nextFrame = now;
+	}
+
+	while ( 1 ) {
+		int64_t wake = sched.nextFrame;
+		int queuedMsec = SV_SendQueuedPackets();
+
+		now = SV_Scheduler_Now();
+		if ( now >= sched.nextFrame ) {
+			break;
+		}
+
+		if ( busyWait ) {
+			NET_Sleep( 0 );
+			continue;
+		}
+
+		if ( queuedMsec >= 0 && queuedMsec < INT_MAX && now + (int64_t)queuedMsec * 1000 < wake ) {
+			wake = now + (int64_t)queuedMsec * 1000;
+		}
+		SV_Scheduler_SleepUntil( wake );
+	}
+
+	sched.lateUsec = now - sched.nextFrame;
+	sched.lastFrameStart = sched.frameStart;
+	sched.frameStart = sched.nextFrame;
+	sched.nextFrame += period;
+	sched.scheduled = qtrue;
+}
+
+/*
+=================
+SV_Scheduler_FrameMsec
+
+Returns msec to advance the server for a frame started by SV_Scheduler_Wait, based on frame
+deadlines, or the standard msec otherwise.
+=================
+*/
+int SV_Scheduler_FrameMsec( int msec ) {
+	int64_t elapsed;
+
+	if ( !sched.scheduled ) {
+		sched.lastFrameStart = 0;
+		sched.residualUsec = 0;
+		return msec;
+	}
+	sched.scheduled = qfalse;
+
+	if ( !sched.lastFrameStart ) {
+		// first frame after the scheduler was enabled
+		return msec;
+	}
+
+	elapsed = sched.frameStart - sched.lastFrameStart + sched.residualUsec;
+	sched.residualUsec = elapsed % 1000;
+	return (int)( elapsed / 1000 );
+}
+
+/*
+=================
+SV_Scheduler_ResetStats
+=================
+*/
+static void SV_Scheduler_ResetStats( void ) {
+	Com_Memset( &sched.stats, 0, sizeof( sched.stats ) );
+	sched.lastActualStart = 0;
+}
+
+/*
+=================
+SV_Scheduler_RecordFrameStart
+
+Called after the frame wait on dedicated servers to record frame timing jitter.
+=================
+*/
+void SV_Scheduler_RecordFrameStart( qboolean precise ) {
+	int64_t now = SV_Scheduler_Now();
+	int64_t period = SV_Scheduler_PeriodUsec();
+	int64_t interval = now - sched.lastActualStart;
+	int64_t deviation = interval - period;
+	int64_t absDeviation = deviation < 0 ? -deviation : deviation;
+	jitterStats_t *stats = &sched.stats;
+	int bucket = 0;
+
+	if ( !com_dedicated->integer || !com_sv_running->integer ) {
+		sched.lastActualStart = 0;
+		return;
+	}
+
+	if ( precise != sched.precise || period != sched.periodUsec ) {
+		SV_Scheduler_ResetStats();
+		sched.precise = precise;
+		sched.periodUsec = period;
+	}
+
+	// skip the first frame and any frames following a stall, such as a map change
+	if ( !sched.lastActualStart || interval > period * 4 ) {
+		sched.lastActualStart = now;
+		return;
+	}
+	sched.lastActualStart = now;
+
+	while ( bucket < JITTER_BUCKETS - 1 && absDeviation > jitterBucketLimits[bucket] ) {
+		++bucket;
+	}
+	++stats->histogram[bucket];
+	++stats->frames;
+	stats->totalDeviation += absDeviation;
+	stats->sumSquares += (double)deviation * deviation;
+	if ( absDeviation > stats->maxDeviation ) {
+		stats->maxDeviation = absDeviation;
+	}
+	if ( precise ) {
+		stats->totalLate += sched.lateUsec;
+		if ( sched.lateUsec > stats->maxLate ) {
+			stats->maxLate = sched.lateUsec;
+		}
+	}
+}
+
+/*
+=================
+SV_Scheduler_Jitter_f
+=================
+*/
+static void SV_Scheduler_Jitter_f( void ) {
+	const jitterStats_t *stats = &sched.stats;
+	int i;
+
+	if ( !Q_stricmp( Cmd_Argv( 1 ), "reset" ) ) {
+		SV_Scheduler_ResetStats();
+		Com_Printf( "Frame jitter stats reset.\n" );
+		return;
+	}
+
+	if ( !stats->frames ) {
+		Com_Printf( "No server frames recorded.\n" );
+		return;
+	}
+
+	Com_Printf( "mode: %s, frame time %.1f msec\n", sched.precise ? "precise" : "standard",
+			sched.periodUsec / 1000.0 );
+	Com_Printf( "frames: %i\n", stats->frames );
+	Com_Printf( "interval deviation: mean %.1f usec, stddev %.1f usec, max %lld usec\n",
+			(double)stats->totalDeviation / stats->frames, sqrt( stats->sumSquares / stats->frames ),
+			(long long)stats->maxDeviation );
+	if ( sched.precise ) {
+		Com_Printf( "wake after deadline: mean %.1f usec, max %lld usec\n",
+				(double)stats->totalLate / stats->frames, (long long)stats->maxLate );
+	}
+
+	Com_Printf( "histogram:\n" );
+	for ( i = 0; i < JITTER_BUCKETS; ++i ) {
+		char label[32];
+		if ( i < JITTER_BUCKETS - 1 ) {
+			Com_sprintf( label, sizeof( label ), "<= %i usec", jitterBucketLimits[i] );
+		} else {
+			Com_sprintf( label, sizeof( label ), "> %i usec", jitterBucketLimits[i - 1] );
+		}
+		Com_Printf( "  %-16s %7i (%.1f%%)\n", label, stats->histogram[i], 100.0 * stats->histogram[i] / stats->frames );
+	}
+}
+
+/*
+=================
+SV_Scheduler_Init
+=================
+*/
+void SV_Scheduler_Init( void ) {
+	Cmd_AddCommand( "sv_frameJitter", SV_Scheduler_Jitter_f );
+}
+
+#endif
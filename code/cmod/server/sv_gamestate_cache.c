@@ -0,0 +1,274 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+Copyright (C) 2017 Noah Metzger (chomenor@gmail.com)
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+
+#ifdef CMOD_GAMESTATE_CACHE
+#include "../../server/server.h"
+
+/*
+###############################################################################################
+
+Gamestate Cache
+
+The configstring and baseline sections of the gamestate message are the same for every client,
+so they are encoded once and copied into each client's gamestate message. The cache is rebuilt
+on the next gamestate after a configstring or the baselines change.
+
+Message encoding is a bit stream without any state carried between symbols (the Huffman table
+is fixed), so the encoded sections can be appended at any bit offset. The compatibility
+protocol aligns strings to byte boundaries, so for compatibility clients the cache is only
+used when the message is at a byte boundary, which is normally always the case. The end offset
+of each baseline is kept so the baseline cutoff from the gamestate overflow fix can be
+determined without encoding the baselines again for each client.
+
+Separate caches are kept for the original and compatibility protocols, which encode messages
+differently. If the cache would overflow in a case where the normal gamestate code could
+handle it differently, the normal code is used instead.
+
+###############################################################################################
+*/
+
+typedef struct {
+	qboolean valid;
+	qboolean overflowed;		// use normal gamestate code instead
+
+	byte data[MAX_MSGLEN];		// configstrings followed by baselines
+	int configstringBits;
+
+	int baselineCount;			// baselines stored in cache
+	int baselineTotal;			// baselines including any that didn't fit in cache
+	int baselineNums[MAX_GENTITIES];
+	int baselineEndBits[MAX_GENTITIES];
+} gamestateCache_t;
+
+#ifdef ELITEFORCE
+static gamestateCache_t gamestateCaches[2];
+#else
+static gamestateCache_t gamestateCaches[1];
+#endif
+
+/*
+=================
+SV_GamestateCache_Invalidate
+
+Called when configstrings or baselines change.
+=================
+*/
+void SV_GamestateCache_Invalidate( void ) {
+	int i;
+	for ( i = 0; i < ARRAY_LEN( gamestateCaches ); ++i ) {
+		gamestateCaches[i].valid = qfalse;
+	}
+}
+
+/*
+=================
+SV_GamestateCache_InitMsg
+=================
+*/
+static void SV_GamestateCache_InitMsg( msg_t *msg, byte *buffer, int size, qboolean compat ) {
+#ifdef ELITEFORCE
+	if ( compat ) {
+		MSG_InitOOB( msg, buffer, size );
+		msg->compat = qtrue;
+		return;
+	}
+#endif
+	MSG_Init( msg, buffer, size );
+}
+
+/*
+=================
+SV_GamestateCache_Build
+=================
+*/
+static void SV_GamestateCache_Build( gamestateCache_t *cache, qboolean compat ) {
+	int start;
+	entityState_t *base, nullstate;
+	msg_t msg;
+
+	cache->valid = qtrue;
+	cache->overflowed = qfalse;
+	cache->baselineCount = 0;
+	cache->baselineTotal = 0;
+
+	SV_GamestateCache_InitMsg( &msg, cache->data, sizeof( cache->data ), compat );
+
+	// configstrings
+	for ( start = 0; start < MAX_CONFIGSTRINGS; start++ ) {
+		if ( sv.configstrings[start][0] ) {
+			MSG_WriteByte( &msg, svc_configstring );
+			MSG_WriteShort( &msg, start );
+			MSG_WriteBigString( &msg, sv.configstrings[start] );
+		}
+	}
+	if ( msg.overflowed ) {
+		cache->overflowed = qtrue;
+		return;
+	}
+	cache->configstringBits = msg.bit;
+
+	// baselines
+	Com_Memset( &nullstate, 0, sizeof( nullstate ) );
+	for ( start = 0; start < MAX_GENTITIES; start++ ) {
+		base = &sv.svEntities[start].baseline;
+		if ( !base->number ) {
+			continue;
+		}
+		++cache->baselineTotal;
+		if ( msg.overflowed ) {
+			continue;
+		}
+		MSG_WriteByte( &msg, svc_baseline );
+		MSG_WriteDeltaEntity( &msg, &nullstate, base, qtrue );
+		if ( !msg.overflowed ) {
+			cache->baselineNums[cache->baselineCount] = start;
+			cache->baselineEndBits[cache->baselineCount] = msg.bit;
+			++cache->baselineCount;
+		}
+	}
+
+#ifndef CMOD_GAMESTATE_OVERFLOW_FIX
+	if ( msg.overflowed ) {
+		cache->overflowed = qtrue;
+	}
+#endif
+}
+
+/*
+=================
+SV_GamestateCache_MsgSize
+
+Returns msg->cursize value that the message would have with the given bit position.
+=================
+*/
+static int SV_GamestateCache_MsgSize( const msg_t *msg, int bit ) {
+	if ( msg->oob ) {
+		return ( bit >> 3 ) + ( ( bit & 7 ) ? 1 : 0 );
+	}
+	return ( bit >> 3 ) + 1;
+}
+
+/*
+=================
+SV_GamestateCache_WriteBits
+
+Appends encoded data to message at the current bit position.
+=================
+*/
+static void SV_GamestateCache_WriteBits( msg_t *msg, const byte *data, int bits ) {
+	int endBit = msg->bit + bits;
+	int shift = msg->bit & 7;
+	byte *out = msg->data + ( msg->bit >> 3 );
+	int outBytes = ( ( endBit + 7 ) >> 3 ) - ( msg->bit >> 3 );
+	int i;
+
+	if ( msg->overflowed || bits <= 0 ) {
+		return;
+	}
+	if ( SV_GamestateCache_MsgSize( msg, endBit ) > msg->maxsize ) {
+		msg->overflowed = qtrue;
+		return;
+	}
+
+	if ( !shift ) {
+		Com_Memcpy( out, data, outBytes );
+	} else {
+		for ( i = 0; i < ( bits + 7 ) >> 3; ++i ) {
+			out[i] = ( out[i] & ( ( 1 << shift ) - 1 ) ) | (byte)( data[i] << shift );
+			if ( i + 1 < outBytes ) {
+				out[i + 1] = data[i] >> ( 8 - shift );
+			}
+		}
+	}
+
+	// message writes assume bits past the current position are clear
+	if ( endBit & 7 ) {
+		msg->data[endBit >> 3] &= ( 1 << ( endBit & 7 ) ) - 1;
+	}
+
+	msg->bit = endBit;
+	msg->cursize = SV_GamestateCache_MsgSize( msg, endBit );
+}
+
+/*
+=================
+SV_GamestateCache_Write
+
+Writes the configstring and baseline sections of the gamestate message for client, and sets
+client->baseline_cutoff. Returns qfalse if the cache can't be used, in which case nothing is
+written.
+=================
+*/
+qboolean SV_GamestateCache_Write( client_t *client, msg_t *msg ) {
+#ifdef ELITEFORCE
+	gamestateCache_t *cache = &gamestateCaches[msg->compat ? 1 : 0];
+#else
+	gamestateCache_t *cache = &gamestateCaches[0];
+#endif
+	int start = msg->bit;
+	int count;
+
+	if ( msg->oob && ( msg->bit & 7 ) ) {
+		return qfalse;
+	}
+	if ( !cache->valid ) {
+#ifdef ELITEFORCE
+		SV_GamestateCache_Build( cache, msg->compat ? qtrue : qfalse );
+#else
+		SV_GamestateCache_Build( cache, qfalse );
+#endif
+	}
+	if ( cache->overflowed ) {
+		return qfalse;
+	}
+
+	count = cache->baselineCount;
+#ifdef CMOD_GAMESTATE_OVERFLOW_FIX
+	// same cutoff as sv_calculate_max_baselines
+	for ( count = 0; count < cache->baselineCount; ++count ) {
+		if ( SV_GamestateCache_MsgSize( msg, start + cache->baselineEndBits[count] ) + 24 >= msg->maxsize ) {
+			break;
+		}
+	}
+
+	if ( count != cache->baselineTotal ) {
+		client->baseline_cutoff = count ? cache->baselineNums[count - 1] + 1 : 0;
+#ifdef CMOD_LOGGING_MESSAGES
+		cmLog( LOG_SERVER, LOGFLAG_COM_PRINTF, "Skipping baselines for client %i to avoid gamestate overflow - "
+				"writing %i of %i baselines", (int)( client - svs.clients ), count, cache->baselineTotal );
+#endif
+	} else {
+		client->baseline_cutoff = -1;
+	}
+#endif
+
+	SV_GamestateCache_WriteBits( msg, cache->data, count ? cache->baselineEndBits[count - 1] : cache->configstringBits );
+#ifdef CMOD_BANDWIDTH_PROFILE
+	SV_Bandwidth_Record( client, SV_BANDWIDTH_CONFIGSTRINGS, cache->configstringBits );
+	SV_Bandwidth_Record( client, SV_BANDWIDTH_BASELINES, msg->bit - start - cache->configstringBits );
+#endif
+
+	return qtrue;
+}
+
+#endif
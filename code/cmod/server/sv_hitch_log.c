@@ -0,0 +1,287 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+Copyright (C) 2017 Noah Metzger (chomenor@gmail.com)
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+
+#ifdef CMOD_SERVER_HITCH_LOG
+#include "../../server/server.h"
+
+/*
+###############################################################################################
+
+Server Hitch Log
+
+When sv_hitchThreshold is set on a dedicated server, a breakdown of the time spent in each
+part of the frame is kept for recent frames, along with notes of what was happening during
+the frame, such as commands executed, files read, and clients connecting or disconnecting.
+Whenever a frame takes longer than the threshold, the breakdown of the slow frame and the
+frames leading up to it is written to the hitch log (enabled by cmod_log_hitch).
+
+Phases:
+   network: processing received packets (Com_EventLoop)
+   commands: command buffer execution, including map changes and config execs
+   bots: bot AI frame (BOTAI_START_FRAME)
+   game: game module frame (GAME_RUN_FRAME)
+   snapshots: building snapshots and sending messages to clients (SV_SendClientMessages)
+   record: record writer snapshot processing
+   fileio: file reads through FS_ReadData
+
+Phases can overlap; for example, file reads during a map change are counted in both the
+commands and fileio phases, and the record phase is included in the snapshots phase.
+
+###############################################################################################
+*/
+
+#define HITCH_HISTORY_FRAMES 32		// must be power of 2
+#define HITCH_LOG_FRAMES 8			// preceding frames written with each hitch
+#define HITCH_NOTES_SIZE 1024
+
+typedef struct {
+	int svsTime;
+	int64_t start;
+	int64_t total;
+	int64_t phases[SV_HITCH_PHASE_COUNT];
+	int snapshotUsec[MAX_CLIENTS];
+	char notes[HITCH_NOTES_SIZE];
+	int notesLength;
+	qboolean notesTruncated;
+} hitchFrame_t;
+
+static const char *hitchPhaseNames[SV_HITCH_PHASE_COUNT] = {
+	"network", "commands", "bots", "game", "snapshots", "record", "fileio" };
+
+// qtrue while a frame is being recorded
+qboolean svHitchActive;
+
+static struct {
+	hitchFrame_t frames[HITCH_HISTORY_FRAMES];
+	unsigned int frameCount;		// frames recorded
+	unsigned int lastLogged;		// frameCount when last hitch was logged
+} hitch;
+
+#define HITCH_FRAME( index ) ( &hitch.frames[( index ) & ( HITCH_HISTORY_FRAMES - 1 )] )
+#define HITCH_MSEC( usec ) ( (double)( usec ) / 1000.0 )
+
+/*
+=================
+SV_Hitch_BeginFrame
+
+Called at the start of each frame, after waiting for the frame time.
+=================
+*/
+void SV_Hitch_BeginFrame( void ) {
+	hitchFrame_t *frame;
+
+	// server blocks in SV_Frame while no map is running, so those frames are skipped
+	svHitchActive = sv_hitchThreshold->integer > 0 && com_dedicated->integer && com_sv_running->integer ? qtrue : qfalse;
+	if ( !svHitchActive ) {
+		return;
+	}
+
+	frame = HITCH_FRAME( hitch.frameCount );
+	++hitch.frameCount;
+	Com_Memset( frame, 0, sizeof( *frame ) );
+	frame->svsTime = svs.time;
+	frame->start = Sys_Microseconds();
+}
+
+/*
+=================
+SV_Hitch_RecordPhase
+
+Adds time since start to phase for the current frame.
+=================
+*/
+void SV_Hitch_RecordPhase( svHitchPhase_t phase, int64_t start ) {
+	if ( svHitchActive ) {
+		HITCH_FRAME( hitch.frameCount - 1 )->phases[phase] += Sys_Microseconds() - start;
+	}
+}
+
+/*
+=================
+SV_Hitch_RecordClientSnapshot
+
+Adds time since start to the snapshot time for a client in the current frame.
+=================
+*/
+void SV_Hitch_RecordClientSnapshot( int clientNum, int64_t start ) {
+	if ( svHitchActive && clientNum >= 0 && clientNum < MAX_CLIENTS ) {
+		HITCH_FRAME( hitch.frameCount - 1 )->snapshotUsec[clientNum] += (int)( Sys_Microseconds() - start );
+	}
+}
+
+/*
+=================
+SV_Hitch_Note
+
+Adds a note of activity during the current frame, which is included in the log if a hitch
+occurs. Callers should check svHitchActive first to avoid formatting overhead.
+=================
+*/
+void QDECL SV_Hitch_Note( const char *fmt, ... ) {
+	hitchFrame_t *frame;
+	va_list argptr;
+	char note[256];
+	int length;
+
+	if ( !svHitchActive ) {
+		return;
+	}
+	frame = HITCH_FRAME( hitch.frameCount - 1 );
+	if ( frame->notesTruncated ) {
+		return;
+	}
+
+	va_start( argptr, fmt );
+	Q_vsnprintf( note, sizeof( note ), fmt, argptr );
+	va_end( argptr );
+
+	length = strlen( note );
+	if ( frame->notesLength + length + 2 >= HITCH_NOTES_SIZE ) {
+		frame->notesTruncated = qtrue;
+		return;
+	}
+	if ( frame->notesLength ) {
+		frame->notes[frame->notesLength++] = ';';
+		frame->notes[frame->notesLength++] = ' ';
+	}
+	Com_Memcpy( frame->notes + frame->notesLength, note, length + 1 );
+	frame->notesLength += length;
+}
+
+/*
+=================
+SV_Hitch_LogFrame
+=================
+*/
+static void SV_Hitch_LogFrame( const hitchFrame_t *frame, int offset, qboolean listClients ) {
+	char buffer[1024];
+	int snapshotClients = 0;
+	int maxClient = -1;
+	int i;
+
+	Com_sprintf( buffer, sizeof( buffer ), "  frame %i (svs.time %i): %.2f msec |", offset, frame->svsTime,
+			HITCH_MSEC( frame->total ) );
+	for ( i = 0; i < SV_HITCH_PHASE_COUNT; ++i ) {
+		Q_strcat( buffer, sizeof( buffer ), va( " %s %.2f", hitchPhaseNames[i], HITCH_MSEC( frame->phases[i] ) ) );
+	}
+
+	for ( i = 0; i < MAX_CLIENTS; ++i ) {
+		if ( frame->snapshotUsec[i] ) {
+			++snapshotClients;
+			if ( maxClient < 0 || frame->snapshotUsec[i] > frame->snapshotUsec[maxClient] ) {
+				maxClient = i;
+			}
+		}
+	}
+	if ( maxClient >= 0 ) {
+		Q_strcat( buffer, sizeof( buffer ), va( " | %i client snapshots, slowest %.2f (client %i)",
+				snapshotClients, HITCH_MSEC( frame->snapshotUsec[maxClient] ), maxClient ) );
+	}
+	cmLog( LOG_HITCH, 0, "%s", buffer );
+
+	if ( listClients && maxClient >= 0 ) {
+		Q_strncpyz( buffer, "    client snapshots:", sizeof( buffer ) );
+		for ( i = 0; i < MAX_CLIENTS; ++i ) {
+			if ( frame->snapshotUsec[i] ) {
+				Q_strcat( buffer, sizeof( buffer ), va( " %i=%.2f", i, HITCH_MSEC( frame->snapshotUsec[i] ) ) );
+			}
+		}
+		cmLog( LOG_HITCH, 0, "%s", buffer );
+	}
+
+	if ( frame->notesLength ) {
+		cmLog( LOG_HITCH, 0, "    activity: %s%s", frame->notes, frame->notesTruncated ? "; ..." : "" );
+	}
+}
+
+/*
+=================
+SV_Hitch_ConnectedClients
+=================
+*/
+static int SV_Hitch_ConnectedClients( void ) {
+	int count = 0;
+	int i;
+
+	if ( !com_sv_running->integer ) {
+		return 0;
+	}
+	for ( i = 0; i < sv_maxclients->integer; ++i ) {
+		if ( svs.clients[i].state >= CS_CONNECTED ) {
+			++count;
+		}
+	}
+	return count;
+}
+
+/*
+=================
+SV_Hitch_Log
+
+Writes the current frame and the frames before it to the hitch log. Frames already written
+for a previous hitch are skipped.
+=================
+*/
+static void SV_Hitch_Log( void ) {
+	const hitchFrame_t *frame = HITCH_FRAME( hitch.frameCount - 1 );
+	unsigned int first = hitch.frameCount > HITCH_LOG_FRAMES ? hitch.frameCount - HITCH_LOG_FRAMES : 0;
+	unsigned int i;
+
+	if ( first < hitch.lastLogged ) {
+		first = hitch.lastLogged;
+	}
+
+	Com_Printf( "Server frame hitch: %.1f msec\n", HITCH_MSEC( frame->total ) );
+	cmLog( LOG_HITCH, 0, "hitch: %.2f msec (threshold %i msec), map %s, %i clients",
+			HITCH_MSEC( frame->total ), sv_hitchThreshold->integer,
+			com_sv_running->integer ? sv_mapname->string : "none", SV_Hitch_ConnectedClients() );
+	for ( i = first; i < hitch.frameCount; ++i ) {
+		SV_Hitch_LogFrame( HITCH_FRAME( i ), (int)( i - ( hitch.frameCount - 1 ) ), i == hitch.frameCount - 1 );
+	}
+
+	hitch.lastLogged = hitch.frameCount;
+}
+
+/*
+=================
+SV_Hitch_EndFrame
+
+Called at the end of each frame, or when the frame is aborted by an error.
+=================
+*/
+void SV_Hitch_EndFrame( void ) {
+	hitchFrame_t *frame;
+
+	if ( !svHitchActive ) {
+		return;
+	}
+	svHitchActive = qfalse;
+
+	frame = HITCH_FRAME( hitch.frameCount - 1 );
+	frame->total = Sys_Microseconds() - frame->start;
+	if ( frame->total >= (int64_t)sv_hitchThreshold->integer * 1000 ) {
+		SV_Hitch_Log();
+	}
+}
+
+#endif
@@ -0,0 +1,231 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+Copyright (C) 2017 Noah Metzger (chomenor@gmail.com)
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+
+#ifdef CMOD_METRICS_ENDPOINT
+#include "../../server/server.h"
+
+/*
+###############################################################################################
+
+Server Metrics
+
+Server statistics written in Prometheus text format for the metrics endpoint in net_ip.c.
+Counters are kept from server startup, except for per-client counters which restart when
+the client connects.
+
+###############################################################################################
+*/
+
+#define METRICS_FRAME_BUCKETS 10
+
+// upper bound of each frame time bucket in usec, except the last bucket which is unbounded
+static const int metricsFrameBucketLimits[METRICS_FRAME_BUCKETS - 1] = {
+	500, 1000, 2000, 5000, 10000, 20000, 50000, 100000, 250000 };
+
+static const char *metricsClientStates[] = { "free", "zombie", "connected", "primed", "active" };
+
+svMetrics_t svMetrics;
+
+static struct {
+	int frameBuckets[METRICS_FRAME_BUCKETS];
+	int frameCount;
+	int64_t frameTotalUsec;
+} metricsFrames;
+
+/*
+=================
+SV_Metrics_RecordFrame
+
+Adds time since start to the server frame time histogram.
+=================
+*/
+void SV_Metrics_RecordFrame( int64_t start ) {
+	int64_t usec = Sys_Microseconds() - start;
+	int bucket = 0;
+
+	while ( bucket < METRICS_FRAME_BUCKETS - 1 && usec > metricsFrameBucketLimits[bucket] ) {
+		++bucket;
+	}
+	++metricsFrames.frameBuckets[bucket];
+	++metricsFrames.frameCount;
+	metricsFrames.frameTotalUsec += usec;
+}
+
+/*
+=================
+SV_Metrics_Printf
+=================
+*/
+static void QDECL SV_Metrics_Printf( cmod_stream_t *stream, const char *fmt, ... ) Q_PRINTF_FUNC( 2, 3 );
+static void QDECL SV_Metrics_Printf( cmod_stream_t *stream, const char *fmt, ... ) {
+	va_list argptr;
+	char buffer[1024];
+
+	va_start( argptr, fmt );
+	Q_vsnprintf( buffer, sizeof( buffer ), fmt, argptr );
+	va_end( argptr );
+
+	cmod_stream_append_string( stream, buffer );
+}
+
+/*
+=================
+SV_Metrics_ClientLabels
+
+Writes label string identifying a client, with the name escaped for a label value. Control
+characters and bytes outside of ASCII, which are not valid UTF-8 in names, are written as
+an escaped backslash followed by "xNN" so the output is always valid.
+=================
+*/
+static void SV_Metrics_ClientLabels( const client_t *cl, char *buffer, int size ) {
+	char name[MAX_NAME_LENGTH * 5 + 1];
+	const unsigned char *src = (const unsigned char *)cl->name;
+	int length = 0;
+
+	while ( *src && length < sizeof( name ) - 5 ) {
+		if ( *src < 0x20 || *src >= 0x7f ) {
+			Com_sprintf( name + length, sizeof( name ) - length, "\\\\x%02x", *src );
+			length += 5;
+		} else {
+			if ( *src == '\\' || *src == '"' ) {
+				name[length++] = '\\';
+			}
+			name[length++] = *src;
+		}
+		++src;
+	}
+	name[length] = '\0';
+
+	Com_sprintf( buffer, size, "client=\"%i\",name=\"%s\"", (int)( cl - svs.clients ), name );
+}
+
+/*
+=================
+SV_Metrics_Write
+
+Writes server metrics in Prometheus text format.
+=================
+*/
+void SV_Metrics_Write( cmod_stream_t *stream ) {
+	int stateCounts[ARRAY_LEN( metricsClientStates )];
+	int bots = 0;
+	int downloads = 0;
+	int cumulative = 0;
+	int i;
+
+	Com_Memset( stateCounts, 0, sizeof( stateCounts ) );
+	if ( com_sv_running->integer ) {
+		for ( i = 0; i < sv_maxclients->integer; ++i ) {
+			const client_t *cl = &svs.clients[i];
+			if ( (unsigned int)cl->state < ARRAY_LEN( stateCounts ) ) {
+				++stateCounts[cl->state];
+			}
+			if ( cl->state >= CS_CONNECTED && cl->netchan.remoteAddress.type == NA_BOT ) {
+				++bots;
+			}
+			if ( cl->state >= CS_CONNECTED && *cl->downloadName ) {
+				++downloads;
+			}
+		}
+	}
+
+	SV_Metrics_Printf( stream, "# HELP cmod_server_running Whether a map is currently running.\n"
+			"# TYPE cmod_server_running gauge\ncmod_server_running %i\n", com_sv_running->integer ? 1 : 0 );
+
+	SV_Metrics_Printf( stream, "# HELP cmod_server_frame_seconds Time spent processing each server frame.\n"
+			"# TYPE cmod_server_frame_seconds histogram\n" );
+	for ( i = 0; i < METRICS_FRAME_BUCKETS; ++i ) {
+		cumulative += metricsFrames.frameBuckets[i];
+		if ( i < METRICS_FRAME_BUCKETS - 1 ) {
+			SV_Metrics_Printf( stream, "cmod_server_frame_seconds_bucket{le=\"%g\"} %i\n",
+					metricsFrameBucketLimits[i] / 1000000.0, cumulative );
+		} else {
+			SV_Metrics_Printf( stream, "cmod_server_frame_seconds_bucket{le=\"+Inf\"} %i\n", cumulative );
+		}
+	}
+	SV_Metrics_Printf( stream, "cmod_server_frame_seconds_sum %.6f\ncmod_server_frame_seconds_count %i\n",
+			metricsFrames.frameTotalUsec / 1000000.0, metricsFrames.frameCount );
+
+	SV_Metrics_Printf( stream, "# HELP cmod_clients Client slots in each connection state.\n"
+			"# TYPE cmod_clients gauge\n" );
+	for ( i = 0; i < ARRAY_LEN( metricsClientStates ); ++i ) {
+		SV_Metrics_Printf( stream, "cmod_clients{state=\"%s\"} %i\n", metricsClientStates[i], stateCounts[i] );
+	}
+	SV_Metrics_Printf( stream, "# HELP cmod_bots Connected bot clients.\n# TYPE cmod_bots gauge\ncmod_bots %i\n", bots );
+
+	if ( com_sv_running->integer ) {
+		static const char *clientMetrics[][3] = {
+			{ "cmod_client_ping_milliseconds", "gauge", "Client ping." },
+			{ "cmod_client_rate_bytes", "gauge", "Client rate setting in bytes per second." },
+			{ "cmod_client_snapshots_total", "counter", "Snapshots sent to client since it connected." },
+			{ "cmod_client_snapshot_bytes_total", "counter", "Snapshot bytes sent to client since it connected." },
+		};
+		int metric;
+
+		for ( metric = 0; metric < ARRAY_LEN( clientMetrics ); ++metric ) {
+			SV_Metrics_Printf( stream, "# HELP %s %s\n# TYPE %s %s\n", clientMetrics[metric][0],
+					clientMetrics[metric][2], clientMetrics[metric][0], clientMetrics[metric][1] );
+			for ( i = 0; i < sv_maxclients->integer; ++i ) {
+				const client_t *cl = &svs.clients[i];
+				char labels[256];
+				int64_t value;
+
+				if ( cl->state < CS_CONNECTED || cl->netchan.remoteAddress.type == NA_BOT ) {
+					continue;
+				}
+				switch ( metric ) {
+					case 0:
+						value = cl->ping;
+						break;
+					case 1:
+						value = cl->rate;
+						break;
+					case 2:
+						value = cl->metricsSnapshots;
+						break;
+					default:
+						value = cl->metricsSnapshotBytes;
+						break;
+				}
+				SV_Metrics_ClientLabels( cl, labels, sizeof( labels ) );
+				SV_Metrics_Printf( stream, "%s{%s} %lld\n", clientMetrics[metric][0], labels, (long long)value );
+			}
+		}
+	}
+
+	SV_Metrics_Printf( stream, "# HELP cmod_ratelimited_queries_total Connectionless queries dropped by rate limiting.\n"
+			"# TYPE cmod_ratelimited_queries_total counter\ncmod_ratelimited_queries_total %lld\n",
+			(long long)svMetrics.rateLimitedQueries );
+	SV_Metrics_Printf( stream, "# HELP cmod_downloads Clients currently downloading.\n"
+			"# TYPE cmod_downloads gauge\ncmod_downloads %i\n", downloads );
+	SV_Metrics_Printf( stream, "# HELP cmod_download_bytes_total Download block bytes sent to clients.\n"
+			"# TYPE cmod_download_bytes_total counter\ncmod_download_bytes_total %lld\n",
+			(long long)svMetrics.downloadBytes );
+
+	SV_Metrics_Printf( stream, "# HELP cmod_zone_free_bytes Free zone memory.\n"
+			"# TYPE cmod_zone_free_bytes gauge\ncmod_zone_free_bytes %i\n", Z_AvailableMemory() );
+	SV_Metrics_Printf( stream, "# HELP cmod_hunk_free_bytes Free hunk memory.\n"
+			"# TYPE cmod_hunk_free_bytes gauge\ncmod_hunk_free_bytes %i\n", Hunk_MemoryRemaining() );
+}
+
+#endif
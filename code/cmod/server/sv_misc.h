@@ -49,6 +49,90 @@ qboolean record_process_packet_event(netadr_t *address, msg_t *msg, int qport);
 void cmod_sv_cmd_tools_init(void);
 #endif
 
+#ifdef CMOD_BOT_THINK_STATS
+void SV_BotThinkStats_Reset( void );
+void SV_BotThinkStats_Record( int64_t usec );
+void SV_BotThinkStats_Init( void );
+#endif
+
+#ifdef CMOD_BOT_ROUTE_CACHE_BUDGET
+void SV_BotRouteCacheStats_Init( void );
+#endif
+
+#ifdef CMOD_SERVER_BENCHMARK
+typedef enum {
+	SV_BENCHMARK_PHASE_TOTAL,
+	SV_BENCHMARK_PHASE_NETWORK,
+	SV_BENCHMARK_PHASE_BOTS,
+	SV_BENCHMARK_PHASE_GAME,
+	SV_BENCHMARK_PHASE_SNAPSHOTS,
+	SV_BENCHMARK_PHASE_OTHER,
+	SV_BENCHMARK_PHASE_COUNT
+} svBenchmarkPhase_t;
+
+#define SV_BENCHMARK_MAX_FRAMES 100000
+
+typedef struct {
+	const char *name;
+	qboolean ( *start )( void );	// called once the map is loaded; returns qfalse to abort
+	qboolean ( *ready )( void );	// returns qtrue when measurement can begin
+	qboolean ( *frame )( void );	// optional; called at the start of each frame, returns qfalse when finished
+	void ( *stop )( void );			// optional; called when benchmark ends or is aborted
+} svBenchmarkSource_t;
+
+void SV_Benchmark_Start( const char *mapName, int numFrames, const char *outputName,
+		const svBenchmarkSource_t *source );
+void SV_Benchmark_RecordPhase( svBenchmarkPhase_t phase, int64_t start );
+void SV_Benchmark_Init( void );
+#endif
+
+#ifdef CMOD_SERVER_HITCH_LOG
+void SV_Hitch_RecordClientSnapshot( int clientNum, int64_t start );
+#endif
+
+#ifdef CMOD_METRICS_ENDPOINT
+typedef struct {
+	int64_t rateLimitedQueries;
+	int64_t downloadBytes;
+} svMetrics_t;
+
+extern svMetrics_t svMetrics;
+void SV_Metrics_RecordFrame( int64_t start );
+#endif
+
+#ifdef CMOD_BANDWIDTH_PROFILE
+typedef enum {
+	SV_BANDWIDTH_SNAPSHOT_HEADER,
+	SV_BANDWIDTH_PLAYERSTATE,
+	SV_BANDWIDTH_ENTITIES,
+	SV_BANDWIDTH_SERVER_COMMANDS,
+	SV_BANDWIDTH_CONFIGSTRINGS,
+	SV_BANDWIDTH_BASELINES,
+	SV_BANDWIDTH_DOWNLOADS,
+	SV_BANDWIDTH_CATEGORY_COUNT
+} svBandwidthCategory_t;
+
+void SV_Bandwidth_Record( client_t *client, svBandwidthCategory_t category, int bits );
+void SV_Bandwidth_RecordServerCommand( client_t *client, const char *command, int bits );
+void SV_Bandwidth_RecordMessage( client_t *client, const msg_t *msg );
+void SV_Bandwidth_BeginSnapshot( client_t *client );
+void SV_Bandwidth_EndSnapshot( void );
+void SV_Bandwidth_Init( void );
+#endif
+
+#ifdef CMOD_SNAPSHOT_ENTITY_PRIORITY
+void SV_Priority_ProcessSnapshot( client_t *client, clientSnapshot_t *frame );
+#endif
+
+#ifdef CMOD_SERVER_FRAME_SCHEDULER
+void SV_Scheduler_Init( void );
+#endif
+
+#ifdef CMOD_GAMESTATE_CACHE
+void SV_GamestateCache_Invalidate( void );
+qboolean SV_GamestateCache_Write( client_t *client, msg_t *msg );
+#endif
+
 #ifdef CMOD_MAPTABLE
 typedef struct {
 	char *key;
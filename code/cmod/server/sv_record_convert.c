@@ -148,15 +148,6 @@ static void write_demo_map_restart(record_demo_writer_t *rdw) {
 // Record Stream Reader
 /* ******************************************************************************** */
 
-typedef struct {
-	record_data_stream_t stream;
-	record_state_t *rs;
-
-	record_command_t command;
-	int time;
-	int clientNum;
-} record_stream_reader_t;
-
 static qboolean load_record_file_into_stream(fileHandle_t fp, record_data_stream_t *stream) {
 	// Returns qtrue on success, qfalse otherwise
 	// In the event of qtrue, call free on stream->data
@@ -170,7 +161,7 @@ static qboolean load_record_file_into_stream(fileHandle_t fp, record_data_stream
 	stream->position = 0;
 	return qtrue; }
 
-static qboolean initialize_record_stream_reader(record_stream_reader_t *rsr, const char *path) {
+qboolean initialize_record_stream_reader(record_stream_reader_t *rsr, const char *path) {
 	// Returns qtrue on success, qfalse otherwise
 	// In the event of qtrue, stream needs to be freed by close_record_stream_reader
 	fileHandle_t fp = 0;
@@ -212,7 +203,7 @@ static qboolean initialize_record_stream_reader(record_stream_reader_t *rsr, con
 	record_printf(RP_DEBUG, "stream reader initialized with %i max_clients\n", max_clients);
 	return qtrue; }
 
-static void close_record_stream_reader(record_stream_reader_t *rsr) {
+void close_record_stream_reader(record_stream_reader_t *rsr) {
 	record_free(rsr->stream.data);
 	free_record_state(rsr->rs); }
 
@@ -221,7 +212,7 @@ static void stream_reader_set_clientnum(record_stream_reader_t *rsr, int clientN
 		record_stream_error(&rsr->stream, "stream_reader_set_clientnum: invalid clientnum"); }
 	rsr->clientNum = clientNum; }
 
-static qboolean advance_stream_reader(record_stream_reader_t *rsr) {
+qboolean advance_stream_reader(record_stream_reader_t *rsr) {
 	// Returns qtrue on success, qfalse on error or end of stream
 	if(rsr->stream.position >= rsr->stream.size) return qfalse;
 	rsr->command = *(unsigned char *)record_stream_read_static(1, &rsr->stream);
@@ -133,9 +133,29 @@ void record_stop_cmd(void);
 // Convert
 /* ******************************************************************************** */
 
+typedef struct {
+	record_data_stream_t stream;
+	record_state_t *rs;
+
+	record_command_t command;
+	int time;
+	int clientNum;
+} record_stream_reader_t;
+
+qboolean initialize_record_stream_reader(record_stream_reader_t *rsr, const char *path);
+void close_record_stream_reader(record_stream_reader_t *rsr);
+qboolean advance_stream_reader(record_stream_reader_t *rsr);
 void record_convert_cmd(void);
 void record_scan_cmd(void);
 
+/* ******************************************************************************** */
+// Replay
+/* ******************************************************************************** */
+
+#ifdef CMOD_RECORD_REPLAY
+void record_replay_cmd(void);
+#endif
+
 /* ******************************************************************************** */
 // Spectator
 /* ******************************************************************************** */
@@ -106,6 +106,9 @@ void record_initialize(void) {
 	Cmd_AddCommand("record_stop", record_stop_cmd);
 	Cmd_AddCommand("record_convert", record_convert_cmd);
 	Cmd_AddCommand("record_scan", record_scan_cmd);
+#ifdef CMOD_RECORD_REPLAY
+	Cmd_AddCommand("record_replay", record_replay_cmd);
+#endif
 	Cmd_AddCommand("spect_status", record_spectator_status);
 
 	record_initialized = qtrue; }
@@ -0,0 +1,306 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+Copyright (C) 2017 Noah Metzger (chomenor@gmail.com)
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+
+#ifdef CMOD_RECORD_REPLAY
+#include "sv_record_local.h"
+
+/* ******************************************************************************** */
+// Record Replay
+/* ******************************************************************************** */
+
+// Replays the usercmds from a record file into the server as synthetic clients, using the
+// sv_benchmark system to run frames at full speed and report frame times.
+//
+// Each player in the record is connected with an NA_REPLAY address when it enters the world in
+// the record stream, and goes through the normal gamestate, enter world, and snapshot path,
+// including rate limiting. Packets to NA_REPLAY addresses are discarded by NET_SendPacket.
+// Snapshots are acknowledged immediately so they are delta compressed like for a real client.
+// Usercmds are applied at the same relative time as in the record, and the last recorded
+// usercmd is repeated each frame in between. Since the recorder skips usercmds that only
+// change view angles, movement is not an exact reproduction of the original match, but the
+// player count, weapon fire, and team layout match the record.
+
+typedef struct {
+	int slot;				// server client number, or -1 if not connected
+	int enter_sequence;		// netchan sequence when client entered world
+	int team;				// last team requested by "team" command, or -1
+} record_replay_client_t;
+
+typedef struct {
+	record_stream_reader_t rsr;
+	record_replay_client_t clients[256];
+
+	qboolean have_time_offset;
+	int time_offset;		// record time + time_offset = server time
+	qboolean have_pending_snapshot;
+
+	char name[MAX_QPATH];
+	svBenchmarkSource_t source;
+} record_replay_state_t;
+
+static record_replay_state_t *rrs;
+
+/* ******************************************************************************** */
+// Synthetic Clients
+/* ******************************************************************************** */
+
+static void replay_connect_client(int record_client) {
+	// Based on sv_client.c->SV_DirectConnect
+	char userinfo[MAX_INFO_STRING];
+	netadr_t address;
+	client_t *cl = 0;
+	intptr_t denied;
+	int i;
+
+	if(rrs->clients[record_client].slot >= 0) return;
+
+	for(i=0; i<sv_maxclients->integer; ++i) {
+		if(svs.clients[i].state == CS_FREE) {
+			cl = &svs.clients[i];
+			break; } }
+	if(!cl) {
+		record_printf(RP_ALL, "replay_connect_client: no free client slot for record client %i\n", record_client);
+		return; }
+
+	// Not loopback or LAN, so rate limiting and entity prioritization apply like for a remote client
+	Com_Memset(&address, 0, sizeof(address));
+	address.type = NA_REPLAY;
+
+	Com_sprintf(userinfo, sizeof(userinfo), "\\name\\replay%i\\rate\\90000\\snaps\\%i\\ip\\%s",
+			record_client, sv_fps->integer, NET_AdrToString(address));
+
+	Com_Memset(cl, 0, sizeof(*cl));
+	cl->gentity = SV_GentityNum(i);
+	Netchan_Setup(NS_SERVER, &cl->netchan, address, i, 0, qfalse);
+	cl->netchan_end_queue = &cl->netchan_start_queue;
+	Q_strncpyz(cl->userinfo, userinfo, sizeof(cl->userinfo));
+
+	denied = VM_Call(gvm, GAME_CLIENT_CONNECT, i, qtrue, qfalse);
+	if(denied) {
+		record_printf(RP_ALL, "replay_connect_client: game rejected connection: %s\n",
+				(char *)VM_ExplicitArgPtr(gvm, denied));
+		Com_Memset(cl, 0, sizeof(*cl));
+		return; }
+
+	SV_UserinfoChanged(cl);
+	cl->state = CS_CONNECTED;
+	cl->lastPacketTime = svs.time;
+	cl->lastConnectTime = svs.time;
+	cl->gamestateMessageNum = -1;
+
+	// goes to CS_PRIMED; client enters world on the next frame
+	SV_SendClientGameState(cl);
+
+	rrs->clients[record_client].slot = i;
+	rrs->clients[record_client].team = -1; }
+
+static void replay_drop_client(int record_client, const char *reason) {
+	record_replay_client_t *rrc = &rrs->clients[record_client];
+	if(rrc->slot < 0) return;
+	if(com_sv_running->integer && svs.clients[rrc->slot].state >= CS_CONNECTED) {
+		SV_DropClient(&svs.clients[rrc->slot], reason); }
+	rrc->slot = -1; }
+
+static void replay_update_team(int record_client, client_t *cl) {
+	// Request team change if team in recorded playerstate changed
+	static const char *team_names[] = {"free", "red", "blue", "spectator"};
+	int team = rrs->rsr.rs->clients[record_client].playerstate.persistant[3];	// 3=PERS_TEAM
+	if(team < 0 || team >= ARRAY_LEN(team_names) || team == rrs->clients[record_client].team) return;
+	rrs->clients[record_client].team = team;
+	SV_ExecuteClientCommand(cl, va("team %s", team_names[team]), qtrue); }
+
+static void replay_run_clients(void) {
+	int i;
+	for(i=0; i<rrs->rsr.rs->max_clients; ++i) {
+		record_replay_client_t *rrc = &rrs->clients[i];
+		client_t *cl;
+		usercmd_t cmd;
+
+		if(rrc->slot < 0) continue;
+		cl = &svs.clients[rrc->slot];
+		if(cl->state < CS_PRIMED) {
+			// dropped by server
+			rrc->slot = -1;
+			continue; }
+
+		// acknowledge everything that has been sent
+		cl->lastPacketTime = svs.time;
+		cl->reliableAcknowledge = cl->reliableSequence;
+
+		record_convert_record_usercmd_to_usercmd(&rrs->rsr.rs->clients[i].usercmd, &cmd);
+		cmd.serverTime = sv.time;
+
+		if(cl->state == CS_PRIMED) {
+			SV_ClientEnterWorld(cl, &cmd);
+			rrc->enter_sequence = cl->netchan.outgoingSequence;
+			continue; }
+
+		if(cl->netchan.outgoingSequence > rrc->enter_sequence) {
+			cl->deltaMessage = cl->netchan.outgoingSequence - 1;
+			cl->frames[cl->deltaMessage & PACKET_MASK].messageAcked = svs.time; }
+
+		replay_update_team(i, cl);
+		SV_ClientThink(cl, &cmd); } }
+
+/* ******************************************************************************** */
+// Stream Processing
+/* ******************************************************************************** */
+
+static qboolean replay_advance_stream(void) {
+	// Processes record stream up to current server time
+	// Returns qfalse on error or end of stream
+	rrs->rsr.stream.abort_set = qtrue;
+	if(setjmp(rrs->rsr.stream.abort)) return qfalse;
+
+	while(1) {
+		if(rrs->have_pending_snapshot) {
+			if(rrs->rsr.time + rrs->time_offset > sv.time) break;
+			rrs->have_pending_snapshot = qfalse; }
+
+		if(!advance_stream_reader(&rrs->rsr)) {
+			rrs->rsr.stream.abort_set = qfalse;
+			return qfalse; }
+
+		switch(rrs->rsr.command) {
+			case RC_EVENT_SNAPSHOT:
+				if(!rrs->have_time_offset) {
+					rrs->time_offset = sv.time - rrs->rsr.time;
+					rrs->have_time_offset = qtrue; }
+				rrs->have_pending_snapshot = qtrue;
+				break;
+			case RC_EVENT_CLIENT_ENTER_WORLD:
+				replay_connect_client(rrs->rsr.clientNum);
+				break;
+			case RC_EVENT_CLIENT_DISCONNECT:
+				replay_drop_client(rrs->rsr.clientNum, "disconnected");
+				break;
+			default:
+				break; } }
+
+	rrs->rsr.stream.abort_set = qfalse;
+	return qtrue; }
+
+static qboolean replay_read_header(void) {
+	// Reads initial configstrings and baselines
+	// Returns qfalse on error
+	rrs->rsr.stream.abort_set = qtrue;
+	if(setjmp(rrs->rsr.stream.abort)) return qfalse;
+
+	while(advance_stream_reader(&rrs->rsr)) {
+		if(rrs->rsr.command == RC_EVENT_BASELINES) {
+			rrs->rsr.stream.abort_set = qfalse;
+			return qtrue; } }
+
+	rrs->rsr.stream.abort_set = qfalse;
+	return qfalse; }
+
+/* ******************************************************************************** */
+// Benchmark Source
+/* ******************************************************************************** */
+
+static qboolean replay_start(void) {
+	return qtrue; }
+
+static qboolean replay_ready(void) {
+	return qtrue; }
+
+static qboolean replay_frame(void) {
+	if(!replay_advance_stream()) {
+		record_printf(RP_ALL, "Replay reached end of record.\n");
+		return qfalse; }
+	replay_run_clients();
+	return qtrue; }
+
+static void replay_stop(void) {
+	int i;
+	if(!rrs) return;
+	for(i=0; i<rrs->rsr.rs->max_clients; ++i) {
+		replay_drop_client(i, "replay finished"); }
+	close_record_stream_reader(&rrs->rsr);
+	record_free(rrs);
+	rrs = 0; }
+
+void record_replay_cmd(void) {
+	char path[128];
+	const char *serverinfo;
+	char map_name[MAX_QPATH];
+	int frames = SV_BENCHMARK_MAX_FRAMES;
+	int i;
+
+	if(Cmd_Argc() < 2) {
+		record_printf(RP_ALL, "Usage: record_replay <path within 'records' directory> [frames] [output file]\n"
+			"Example: record_replay source.rec\n");
+		return; }
+
+	if(!com_dedicated->integer) {
+		record_printf(RP_ALL, "Replay requires dedicated server.\n");
+		return; }
+	if(SV_Benchmark_Running()) {
+		record_printf(RP_ALL, "Benchmark already running.\n");
+		return; }
+
+	if(Cmd_Argc() > 2) {
+		frames = atoi(Cmd_Argv(2));
+		if(frames < 1 || frames > SV_BENCHMARK_MAX_FRAMES) {
+			record_printf(RP_ALL, "Frame count must be between 1 and %i.\n", SV_BENCHMARK_MAX_FRAMES);
+			return; } }
+
+	Com_sprintf(path, sizeof(path), "records/%s", Cmd_Argv(1));
+	COM_DefaultExtension(path, sizeof(path), ".rec");
+	if(strstr(path, "..")) {
+		record_printf(RP_ALL, "Invalid path\n");
+		return; }
+
+	rrs = record_calloc(sizeof(*rrs));
+	if(!initialize_record_stream_reader(&rrs->rsr, path)) {
+		record_free(rrs);
+		rrs = 0;
+		return; }
+	for(i=0; i<ARRAY_LEN(rrs->clients); ++i) {
+		rrs->clients[i].slot = -1; }
+
+	if(!replay_read_header()) {
+		record_printf(RP_ALL, "Failed to read record header.\n");
+		replay_stop();
+		return; }
+
+	// Use the map and gametype from the record
+	serverinfo = rrs->rsr.rs->configstrings[CS_SERVERINFO];
+	Q_strncpyz(map_name, Info_ValueForKey(serverinfo, "mapname"), sizeof(map_name));
+	if(!*map_name) {
+		record_printf(RP_ALL, "Record has no map name.\n");
+		replay_stop();
+		return; }
+	if(*Info_ValueForKey(serverinfo, "g_gametype")) {
+		Cvar_Set("g_gametype", Info_ValueForKey(serverinfo, "g_gametype")); }
+
+	Com_sprintf(rrs->name, sizeof(rrs->name), "replay %s", Cmd_Argv(1));
+	rrs->source.name = rrs->name;
+	rrs->source.start = replay_start;
+	rrs->source.ready = replay_ready;
+	rrs->source.frame = replay_frame;
+	rrs->source.stop = replay_stop;
+
+	SV_Benchmark_Start(map_name, frames, Cmd_Argc() > 3 ? Cmd_Argv(3) : "record_replay", &rrs->source); }
+
+#endif
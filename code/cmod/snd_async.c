@@ -0,0 +1,694 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+Copyright (C) 2017 Noah Metzger (chomenor@gmail.com)
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+
+#ifdef CMOD_SOUND_ASYNC_LOAD
+#ifdef USE_INTERNAL_SDL_HEADERS
+#	include "SDL.h"
+#else
+#	include <SDL.h>
+#endif
+
+#include "../client/client.h"
+#include "../client/snd_local.h"
+#include "../client/snd_codec.h"
+
+/*
+###############################################################################################
+
+Asynchronous Sound Loading
+
+When "s_asyncLoad" is enabled, a pool of loader threads decodes and resamples sound effects
+and decodes the music stream ahead of playback, instead of doing this work on the main thread.
+
+Sound effects are opened and read into memory when registered, which is still done on the
+main thread since the filesystem isn't thread safe. This also determines whether the sound
+exists, which the registration result depends on. Decoding and resampling is queued to the
+loader threads, and the result is copied into sound memory by S_AsyncLoad_Update on the main
+thread. Sounds that are started or used as looping sounds while still loading have their
+queue priority raised, and begin playing once they are ready. Sound effects that don't become
+ready within S_ASYNC_MAX_DEFER_MSEC are dropped rather than played late.
+
+The music stream is read into memory when opened and decoded into a ring buffer by loader
+threads. S_UpdateBackgroundTrack reads from the ring buffer, and waits rather than blocking
+if the decoder hasn't caught up.
+
+###############################################################################################
+*/
+
+#define MAX_LOADER_THREADS 4
+#define STREAM_BUFFER_SIZE 262144	// decoded bytes of music to keep ahead; must be power of 2
+#define STREAM_DECODE_CHUNK 16384
+
+typedef enum {
+	JOB_LOAD_SOUND,
+	JOB_DECODE_STREAM
+} soundJobType_t;
+
+typedef enum {
+	JOB_PRIORITY_PRECACHE,		// sound registered but not used yet
+	JOB_PRIORITY_PLAYBACK,		// sound waiting to be played
+	JOB_PRIORITY_STREAM			// music buffer running low
+} soundJobPriority_t;
+
+typedef struct soundJob_s {
+	soundJobType_t type;
+	soundJobPriority_t priority;
+	snd_stream_t *stream;
+
+	// JOB_LOAD_SOUND
+	sfx_t *sfx;
+	short *samples;			// resampled result, or NULL on error
+	int soundLength;
+
+	struct soundJob_s *next;
+} soundJob_t;
+
+static struct {
+	int numThreads;
+	cmThread_t *threads[MAX_LOADER_THREADS];
+	SDL_sem *semaphore;		// posted once for each queued job
+
+	// lock protects the fields below
+	SDL_SpinLock lock;
+	qboolean shutdown;
+	soundJob_t *queue;
+	soundJob_t *finished;
+} soundLoader;
+
+static struct {
+	snd_stream_t *stream;	// NULL if no stream is being decoded ahead
+	soundJob_t job;
+	qboolean jobActive;		// job is queued or running; main thread only
+	int frameSize;
+
+	// ring buffer of decoded data
+	byte buffer[STREAM_BUFFER_SIZE];
+	SDL_atomic_t writePosition;		// written by decode job
+	SDL_atomic_t readPosition;		// written by main thread
+	SDL_atomic_t endOfStream;		// written by decode job
+	SDL_atomic_t jobDone;			// written by decode job
+} soundStream;
+
+static cvar_t *s_asyncLoad;
+
+/* ******************************************************************************** */
+// Job Queue
+/* ******************************************************************************** */
+
+/*
+=================
+S_AsyncLoad_QueueJob
+=================
+*/
+static void S_AsyncLoad_QueueJob( soundJob_t *job ) {
+	soundJob_t **tail;
+
+	job->next = NULL;
+	SDL_AtomicLock( &soundLoader.lock );
+	for ( tail = &soundLoader.queue; *tail; tail = &( *tail )->next ) {
+	}
+	*tail = job;
+	SDL_AtomicUnlock( &soundLoader.lock );
+
+	SDL_SemPost( soundLoader.semaphore );
+}
+
+/*
+=================
+S_AsyncLoad_TakeJob
+
+Removes the highest priority job from the queue, or the oldest if there is a tie.
+Must be called while holding the lock.
+=================
+*/
+static soundJob_t *S_AsyncLoad_TakeJob( void ) {
+	soundJob_t **best = NULL;
+	soundJob_t **position;
+	soundJob_t *job;
+
+	for ( position = &soundLoader.queue; *position; position = &( *position )->next ) {
+		if ( !best || ( *position )->priority > ( *best )->priority ) {
+			best = position;
+		}
+	}
+
+	if ( !best ) {
+		return NULL;
+	}
+
+	job = *best;
+	*best = job->next;
+	job->next = NULL;
+	return job;
+}
+
+/*
+=================
+S_AsyncLoad_CancelJob
+
+Removes a job from the queue. Returns qfalse if the job is not in the queue because it is
+already running or finished.
+=================
+*/
+static qboolean S_AsyncLoad_CancelJob( soundJob_t *job ) {
+	soundJob_t **position;
+	qboolean found = qfalse;
+
+	SDL_AtomicLock( &soundLoader.lock );
+	for ( position = &soundLoader.queue; *position; position = &( *position )->next ) {
+		if ( *position == job ) {
+			*position = job->next;
+			found = qtrue;
+			break;
+		}
+	}
+	SDL_AtomicUnlock( &soundLoader.lock );
+
+	return found;
+}
+
+/* ******************************************************************************** */
+// Loader Threads
+/* ******************************************************************************** */
+
+/*
+=================
+S_AsyncLoad_DecodeSound
+
+Reads the whole stream and resamples it to the output rate.
+=================
+*/
+static void S_AsyncLoad_DecodeSound( soundJob_t *job ) {
+	const snd_info_t *info = &job->stream->info;
+	int frameSize = info->width * info->channels;
+	int size = ( ( info->samples > 0 ? info->samples : 0 ) + 4096 ) * frameSize;
+	int length = 0;
+	byte *data = (byte *)malloc( size );
+
+	while ( data ) {
+		int count;
+
+		if ( size - length < frameSize * 1024 ) {
+			byte *newData = (byte *)realloc( data, size * 2 );
+			if ( !newData ) {
+				free( data );
+				data = NULL;
+				break;
+			}
+			data = newData;
+			size *= 2;
+		}
+
+		count = S_CodecReadStream( job->stream, size - length, data + length );
+		if ( count <= 0 ) {
+			break;
+		}
+		length += count;
+	}
+
+	if ( data ) {
+		job->samples = S_ResampleToBuffer( info->channels, info->rate, info->width, length / frameSize,
+				data, &job->soundLength );
+		free( data );
+	}
+}
+
+/*
+=================
+S_AsyncStream_Decode
+
+Decodes the music stream until the ring buffer is full or the stream ends.
+=================
+*/
+static void S_AsyncStream_Decode( soundJob_t *job ) {
+	// only one stream job can run at a time
+	static byte chunk[STREAM_DECODE_CHUNK];
+
+	while ( 1 ) {
+		unsigned int writePosition = (unsigned int)SDL_AtomicGet( &soundStream.writePosition );
+		unsigned int space = STREAM_BUFFER_SIZE - ( writePosition - (unsigned int)SDL_AtomicGet( &soundStream.readPosition ) );
+		unsigned int offset = writePosition & ( STREAM_BUFFER_SIZE - 1 );
+		int count = (int)MIN( space, STREAM_DECODE_CHUNK );
+		int first;
+
+		count -= count % soundStream.frameSize;
+		if ( count <= 0 ) {
+			break;
+		}
+
+		count = S_CodecReadStream( job->stream, count, chunk );
+		if ( count <= 0 ) {
+			SDL_AtomicSet( &soundStream.endOfStream, 1 );
+			break;
+		}
+
+		first = MIN( count, STREAM_BUFFER_SIZE - (int)offset );
+		Com_Memcpy( soundStream.buffer + offset, chunk, first );
+		Com_Memcpy( soundStream.buffer, chunk + first, count - first );
+
+		SDL_MemoryBarrierRelease();
+		SDL_AtomicSet( &soundStream.writePosition, (int)( writePosition + count ) );
+	}
+}
+
+/*
+=================
+S_AsyncLoad_ThreadMain
+=================
+*/
+static void S_AsyncLoad_ThreadMain( void *arg ) {
+	while ( 1 ) {
+		soundJob_t *job;
+
+		SDL_SemWait( soundLoader.semaphore );
+
+		SDL_AtomicLock( &soundLoader.lock );
+		if ( soundLoader.shutdown ) {
+			SDL_AtomicUnlock( &soundLoader.lock );
+			break;
+		}
+		job = S_AsyncLoad_TakeJob();
+		SDL_AtomicUnlock( &soundLoader.lock );
+
+		if ( !job ) {
+			// job was cancelled
+			continue;
+		}
+
+		if ( job->type == JOB_DECODE_STREAM ) {
+			S_AsyncStream_Decode( job );
+			SDL_AtomicSet( &soundStream.jobDone, 1 );
+			continue;
+		}
+
+		S_AsyncLoad_DecodeSound( job );
+
+		SDL_AtomicLock( &soundLoader.lock );
+		job->next = soundLoader.finished;
+		soundLoader.finished = job;
+		SDL_AtomicUnlock( &soundLoader.lock );
+	}
+}
+
+/* ******************************************************************************** */
+// Sound Effects
+/* ******************************************************************************** */
+
+/*
+=================
+S_AsyncLoad_QueueSound
+
+Called in place of S_memoryLoad when a sound is registered. Returns qfalse if the sound
+should be loaded synchronously instead.
+=================
+*/
+qboolean S_AsyncLoad_QueueSound( sfx_t *sfx ) {
+	snd_stream_t *stream;
+
+	if ( !soundLoader.numThreads || sfx->soundCompressed ) {
+		return qfalse;
+	}
+
+#ifdef CMOD_SOUND_CACHE
+	if ( S_SoundCache_Load( sfx ) ) {
+		return qtrue;
+	}
+#endif
+
+	stream = S_CodecOpenStream( sfx->soundName );
+	if ( !stream ) {
+		// same result as failing to load the sound
+		sfx->defaultSound = qtrue;
+	} else if ( !S_CodecUtilLoadToMemory( stream ) ) {
+		S_CodecCloseStream( stream );
+		return qfalse;
+	} else {
+		soundJob_t *job = (soundJob_t *)calloc( 1, sizeof( *job ) );
+		if ( !job ) {
+			S_CodecCloseStream( stream );
+			return qfalse;
+		}
+
+		job->type = JOB_LOAD_SOUND;
+		job->priority = JOB_PRIORITY_PRECACHE;
+		job->stream = stream;
+		job->sfx = sfx;
+
+		sfx->loadPending = qtrue;
+		sfx->lastTimeUsed = Com_Milliseconds();
+		S_AsyncLoad_QueueJob( job );
+	}
+
+	sfx->inMemory = qtrue;
+#ifdef CMOD_FAST_SOUND_RESET
+	sfx->soundFile = S_PredictSoundFileForPath( sfx->soundName );
+#endif
+	return qtrue;
+}
+
+/*
+=================
+S_AsyncLoad_Prioritize
+
+Called when a sound that is still loading is needed for playback.
+=================
+*/
+void S_AsyncLoad_Prioritize( sfx_t *sfx ) {
+	soundJob_t *job;
+
+	SDL_AtomicLock( &soundLoader.lock );
+	for ( job = soundLoader.queue; job; job = job->next ) {
+		if ( job->sfx == sfx ) {
+			job->priority = JOB_PRIORITY_PLAYBACK;
+			break;
+		}
+	}
+	SDL_AtomicUnlock( &soundLoader.lock );
+}
+
+/*
+=================
+S_AsyncLoad_FreeJob
+=================
+*/
+static void S_AsyncLoad_FreeJob( soundJob_t *job ) {
+	if ( job->sfx ) {
+		job->sfx->loadPending = qfalse;
+	}
+	S_CodecCloseStream( job->stream );
+	free( job->samples );
+	free( job );
+}
+
+/*
+=================
+S_AsyncLoad_FinishSound
+
+Copies a decoded sound into sound memory.
+=================
+*/
+static void S_AsyncLoad_FinishSound( soundJob_t *job ) {
+	sfx_t *sfx = job->sfx;
+	sndBuffer *data = NULL;
+
+	if ( job->samples ) {
+		data = S_CopyToSoundMemory( job->samples, job->soundLength * job->stream->info.channels );
+	}
+
+	// sound data may be read from the audio callback
+	SNDDMA_BeginPainting();
+
+	if ( job->samples ) {
+		sfx->soundCompressionMethod = 0;
+		sfx->soundChannels = job->stream->info.channels;
+		sfx->soundLength = job->soundLength;
+		sfx->soundData = data;
+	} else {
+		Com_Printf( S_COLOR_YELLOW "WARNING: couldn't decode sound %s\n", sfx->soundName );
+		sfx->defaultSound = qtrue;
+		S_DefaultSound( sfx );
+	}
+
+	sfx->loadPending = qfalse;
+
+	SNDDMA_Submit();
+
+#ifdef CMOD_SOUND_CACHE
+	S_SoundCache_Store( sfx );
+#endif
+
+	S_AsyncLoad_FreeJob( job );
+}
+
+/* ******************************************************************************** */
+// Music Stream
+/* ******************************************************************************** */
+
+/*
+=================
+S_AsyncStream_Schedule
+
+Queues the stream decode job if the ring buffer is at least half empty.
+=================
+*/
+static void S_AsyncStream_Schedule( void ) {
+	unsigned int used;
+
+	if ( !soundStream.stream ) {
+		return;
+	}
+
+	if ( soundStream.jobActive && SDL_AtomicGet( &soundStream.jobDone ) ) {
+		soundStream.jobActive = qfalse;
+	}
+
+	if ( soundStream.jobActive || SDL_AtomicGet( &soundStream.endOfStream ) ) {
+		return;
+	}
+
+	used = (unsigned int)SDL_AtomicGet( &soundStream.writePosition ) - (unsigned int)SDL_AtomicGet( &soundStream.readPosition );
+	if ( used <= STREAM_BUFFER_SIZE / 2 ) {
+		soundStream.jobActive = qtrue;
+		SDL_AtomicSet( &soundStream.jobDone, 0 );
+		S_AsyncLoad_QueueJob( &soundStream.job );
+	}
+}
+
+/*
+=================
+S_AsyncStream_Stop
+
+Stops decoding ahead the current stream. Must be called before the stream is closed.
+=================
+*/
+void S_AsyncStream_Stop( void ) {
+	if ( !soundStream.stream ) {
+		return;
+	}
+
+	if ( soundStream.jobActive && !S_AsyncLoad_CancelJob( &soundStream.job ) ) {
+		while ( !SDL_AtomicGet( &soundStream.jobDone ) ) {
+			SDL_Delay( 1 );
+		}
+	}
+
+	soundStream.jobActive = qfalse;
+	soundStream.stream = NULL;
+}
+
+/*
+=================
+S_AsyncStream_Start
+
+Starts decoding ahead a newly opened stream.
+=================
+*/
+void S_AsyncStream_Start( snd_stream_t *stream ) {
+	S_AsyncStream_Stop();
+
+	if ( !soundLoader.numThreads || !S_CodecUtilLoadToMemory( stream ) ) {
+		return;
+	}
+
+	soundStream.stream = stream;
+	soundStream.frameSize = stream->info.width * stream->info.channels;
+	soundStream.job.type = JOB_DECODE_STREAM;
+	soundStream.job.priority = JOB_PRIORITY_STREAM;
+	soundStream.job.stream = stream;
+	SDL_AtomicSet( &soundStream.writePosition, 0 );
+	SDL_AtomicSet( &soundStream.readPosition, 0 );
+	SDL_AtomicSet( &soundStream.endOfStream, 0 );
+
+	S_AsyncStream_Schedule();
+}
+
+/*
+=================
+S_AsyncStream_Read
+
+Replacement for S_CodecReadStream for the music stream. Returns -1 if no data is available
+yet, and 0 at the end of the stream.
+=================
+*/
+int S_AsyncStream_Read( snd_stream_t *stream, int bytes, void *buffer ) {
+	qboolean endOfStream;
+	unsigned int readPosition;
+	unsigned int available;
+	unsigned int offset;
+	int first;
+
+	if ( stream != soundStream.stream ) {
+		return S_CodecReadStream( stream, bytes, buffer );
+	}
+
+	endOfStream = SDL_AtomicGet( &soundStream.endOfStream ) ? qtrue : qfalse;
+	readPosition = (unsigned int)SDL_AtomicGet( &soundStream.readPosition );
+	available = (unsigned int)SDL_AtomicGet( &soundStream.writePosition ) - readPosition;
+	SDL_MemoryBarrierAcquire();
+
+	if ( (unsigned int)bytes > available ) {
+		bytes = (int)available;
+	}
+	bytes -= bytes % soundStream.frameSize;
+
+	if ( bytes <= 0 ) {
+		S_AsyncStream_Schedule();
+		return endOfStream ? 0 : -1;
+	}
+
+	offset = readPosition & ( STREAM_BUFFER_SIZE - 1 );
+	first = MIN( bytes, STREAM_BUFFER_SIZE - (int)offset );
+	Com_Memcpy( buffer, soundStream.buffer + offset, first );
+	Com_Memcpy( (byte *)buffer + first, soundStream.buffer, bytes - first );
+
+	SDL_MemoryBarrierRelease();
+	SDL_AtomicSet( &soundStream.readPosition, (int)( readPosition + bytes ) );
+
+	S_AsyncStream_Schedule();
+	return bytes;
+}
+
+/* ******************************************************************************** */
+// Main Interface
+/* ******************************************************************************** */
+
+/*
+=================
+S_AsyncLoad_Update
+
+Called each frame to finish loaded sounds and keep the music stream decoding.
+=================
+*/
+void S_AsyncLoad_Update( void ) {
+	soundJob_t *job;
+
+	if ( !soundLoader.numThreads ) {
+		return;
+	}
+
+	SDL_AtomicLock( &soundLoader.lock );
+	job = soundLoader.finished;
+	soundLoader.finished = NULL;
+	SDL_AtomicUnlock( &soundLoader.lock );
+
+	while ( job ) {
+		soundJob_t *next = job->next;
+		S_AsyncLoad_FinishSound( job );
+		job = next;
+	}
+
+	S_AsyncStream_Schedule();
+}
+
+/*
+=================
+S_AsyncLoad_Init
+=================
+*/
+void S_AsyncLoad_Init( void ) {
+	int i;
+	int numThreads;
+
+	s_asyncLoad = Cvar_Get( "s_asyncLoad", "1", CVAR_ARCHIVE | CVAR_LATCH );
+
+	Com_Memset( &soundLoader, 0, sizeof( soundLoader ) );
+	Com_Memset( &soundStream, 0, sizeof( soundStream ) );
+
+	if ( !s_asyncLoad->integer ) {
+		return;
+	}
+
+	soundLoader.semaphore = SDL_CreateSemaphore( 0 );
+	if ( !soundLoader.semaphore ) {
+		return;
+	}
+
+	numThreads = CMThread_ProcessorCount() - 1;
+	if ( numThreads < 1 ) {
+		numThreads = 1;
+	}
+	if ( numThreads > MAX_LOADER_THREADS ) {
+		numThreads = MAX_LOADER_THREADS;
+	}
+
+	for ( i = 0; i < numThreads; ++i ) {
+		cmThread_t *thread = CMThread_Create( S_AsyncLoad_ThreadMain, NULL );
+		if ( !thread ) {
+			break;
+		}
+		soundLoader.threads[soundLoader.numThreads++] = thread;
+	}
+
+	if ( !soundLoader.numThreads ) {
+		SDL_DestroySemaphore( soundLoader.semaphore );
+		soundLoader.semaphore = NULL;
+		return;
+	}
+
+	Com_DPrintf( "Sound loader started with %i threads.\n", soundLoader.numThreads );
+}
+
+/*
+=================
+S_AsyncLoad_Shutdown
+
+Stops loader threads and discards any sounds still loading.
+=================
+*/
+void S_AsyncLoad_Shutdown( void ) {
+	int i;
+	soundJob_t *job;
+
+	if ( !soundLoader.numThreads ) {
+		return;
+	}
+
+	S_AsyncStream_Stop();
+
+	SDL_AtomicLock( &soundLoader.lock );
+	soundLoader.shutdown = qtrue;
+	SDL_AtomicUnlock( &soundLoader.lock );
+
+	for ( i = 0; i < soundLoader.numThreads; ++i ) {
+		SDL_SemPost( soundLoader.semaphore );
+	}
+	for ( i = 0; i < soundLoader.numThreads; ++i ) {
+		CMThread_Join( soundLoader.threads[i] );
+	}
+
+	for ( job = soundLoader.queue; job; ) {
+		soundJob_t *next = job->next;
+		S_AsyncLoad_FreeJob( job );
+		job = next;
+	}
+	for ( job = soundLoader.finished; job; ) {
+		soundJob_t *next = job->next;
+		S_AsyncLoad_FreeJob( job );
+		job = next;
+	}
+
+	SDL_DestroySemaphore( soundLoader.semaphore );
+	Com_Memset( &soundLoader, 0, sizeof( soundLoader ) );
+}
+
+#endif
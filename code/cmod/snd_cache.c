@@ -0,0 +1,243 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+Copyright (C) 2017 Noah Metzger (chomenor@gmail.com)
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+
+#ifdef CMOD_SOUND_CACHE
+#include "../filesystem/fslocal.h"
+#include "../client/client.h"
+#include "../client/snd_local.h"
+
+/*
+###############################################################################################
+
+Decoded Sound Cache
+
+Loading a sound involves decoding the source file and resampling it to the mixer rate, which
+is repeated every time the sound system restarts or stale sounds are reset on a map change.
+When enabled by the s_soundCache cvar, the resampled data is written to a file in the cache
+directory after a sound is loaded, and copied directly into sound memory on later loads.
+
+Cache files are keyed by the identity of the source file the sound resolves to (location,
+size, timestamp, and containing pk3 hash) and the mixer rate. The full key is stored in the
+file and compared on load, so a hash collision or any other mismatch just causes the sound
+to be loaded normally and the cache file to be rewritten.
+
+File format (all values little endian):
+   header: magic, version, mixer rate, channels, sample count, key length (32-bit)
+   key: key string, padded to a multiple of 4 bytes
+   data: sample count * channels samples (16-bit)
+
+###############################################################################################
+*/
+
+#define SOUND_CACHE_MAGIC 0x43444e53	// "SNDC"
+#define SOUND_CACHE_VERSION 1
+#define SOUND_CACHE_HEADER_WORDS 6
+#define SOUND_CACHE_MAX_KEY 1024
+
+static cvar_t *s_soundCache;
+
+/*
+=================
+S_SoundCache_Key
+
+Writes the cache key for the file a sound currently resolves to. Returns the file, or null
+if the sound can't be cached.
+=================
+*/
+static const fsc_file_t *S_SoundCache_Key( const sfx_t *sfx, char *key, int keySize ) {
+	const fsc_file_t *file = S_PredictSoundFileForPath( sfx->soundName );
+	const fsc_file_direct_t *baseFile;
+	unsigned int position = 0;
+	char description[FS_FILE_BUFFER_SIZE];
+
+	if ( !file ) {
+		return NULL;
+	}
+	baseFile = FSC_GetBaseFile( file, &fs.index );
+	if ( !baseFile ) {
+		return NULL;
+	}
+	if ( file->sourcetype == FSC_SOURCETYPE_PK3 ) {
+		position = ( (const fsc_file_frompk3_t *)file )->header_position;
+	}
+
+	FS_FileToBuffer( file, description, sizeof( description ), qtrue, qtrue, qtrue, qfalse );
+	Com_sprintf( key, keySize, "%s|%u|%u|%08x|%u|%i", description, file->filesize,
+			baseFile->os_timestamp, baseFile->pk3_hash, position, dma.speed );
+	return file;
+}
+
+/*
+=================
+S_SoundCache_Path
+=================
+*/
+static const char *S_SoundCache_Path( const char *key ) {
+	return va( "soundcache/%08x.ssc", Com_BlockChecksum( key, strlen( key ) ) );
+}
+
+/*
+=================
+S_SoundCache_Load
+
+Loads sound from cache file in place of S_LoadSound. Returns qtrue on success, qfalse if the
+sound needs to be loaded normally.
+=================
+*/
+qboolean S_SoundCache_Load( sfx_t *sfx ) {
+	char key[SOUND_CACHE_MAX_KEY];
+	char path[FS_MAX_PATH];
+	const fsc_file_t *file;
+	unsigned int size = 0;
+	char *data;
+	const int *header;
+	int keyLength, channels, soundLength, dataOffset;
+	short *samples;
+	int i;
+
+	if ( !s_soundCache || !s_soundCache->integer || sfx->soundCompressed ) {
+		return qfalse;
+	}
+
+	file = S_SoundCache_Key( sfx, key, sizeof( key ) );
+	if ( !file ) {
+		return qfalse;
+	}
+
+	if ( !FS_GeneratePathWritedir( XDG_CACHE, S_SoundCache_Path( key ), NULL,
+			FS_ALLOW_DIRECTORIES, 0, path, sizeof( path ) ) ) {
+		return qfalse;
+	}
+
+	data = FS_ReadData( NULL, path, &size, "S_SoundCache_Load" );
+	if ( !data ) {
+		return qfalse;
+	}
+
+	// validate header
+	header = (const int *)data;
+	if ( size < SOUND_CACHE_HEADER_WORDS * 4 || LittleLong( header[0] ) != SOUND_CACHE_MAGIC ||
+			LittleLong( header[1] ) != SOUND_CACHE_VERSION || LittleLong( header[2] ) != dma.speed ) {
+		FS_FreeData( data );
+		return qfalse;
+	}
+
+	channels = LittleLong( header[3] );
+	soundLength = LittleLong( header[4] );
+	keyLength = LittleLong( header[5] );
+	dataOffset = SOUND_CACHE_HEADER_WORDS * 4 + PAD( keyLength, 4 );
+	if ( ( channels != 1 && channels != 2 ) || soundLength <= 0 || soundLength > ( 1 << 26 ) ||
+			keyLength != (int)strlen( key ) || (unsigned int)dataOffset + soundLength * channels * 2 != size ||
+			memcmp( data + SOUND_CACHE_HEADER_WORDS * 4, key, keyLength ) ) {
+		FS_FreeData( data );
+		return qfalse;
+	}
+
+	samples = (short *)( data + dataOffset );
+	for ( i = 0; i < soundLength * channels; ++i ) {
+		samples[i] = LittleShort( samples[i] );
+	}
+
+	sfx->soundCompressionMethod = 0;
+	sfx->soundChannels = channels;
+	sfx->soundLength = soundLength;
+	sfx->soundData = S_CopyToSoundMemory( samples, soundLength * channels );
+	sfx->lastTimeUsed = Com_Milliseconds() + 1;
+	sfx->inMemory = qtrue;
+	sfx->soundFile = file;
+
+	FS_FreeData( data );
+	return qtrue;
+}
+
+/*
+=================
+S_SoundCache_Store
+
+Writes cache file for a sound that was just loaded.
+=================
+*/
+void S_SoundCache_Store( const sfx_t *sfx ) {
+	char key[SOUND_CACHE_MAX_KEY];
+	const char *path;
+	fileHandle_t fp;
+	int header[SOUND_CACHE_HEADER_WORDS];
+	static short buffer[SND_CHUNK_SIZE];
+	const sndBuffer *chunk;
+	int remaining;
+	int keyLength;
+	int i;
+
+	if ( !s_soundCache || !s_soundCache->integer || sfx->defaultSound || sfx->soundCompressionMethod ||
+			!sfx->soundData || sfx->soundLength <= 0 ) {
+		return;
+	}
+
+	if ( !S_SoundCache_Key( sfx, key, sizeof( key ) ) ) {
+		return;
+	}
+	keyLength = strlen( key );
+
+	path = S_SoundCache_Path( key );
+	fp = FS_BaseDir_FOpenFileWrite( XDG_CACHE, path );
+	if ( !fp ) {
+		Com_DPrintf( "S_SoundCache_Store: failed to open %s\n", path );
+		return;
+	}
+
+	header[0] = LittleLong( SOUND_CACHE_MAGIC );
+	header[1] = LittleLong( SOUND_CACHE_VERSION );
+	header[2] = LittleLong( dma.speed );
+	header[3] = LittleLong( sfx->soundChannels );
+	header[4] = LittleLong( sfx->soundLength );
+	header[5] = LittleLong( keyLength );
+	FS_Write( header, sizeof( header ), fp );
+
+	// write key, padded with nulls
+	Com_Memset( buffer, 0, sizeof( buffer ) );
+	FS_Write( key, keyLength, fp );
+	FS_Write( buffer, PAD( keyLength, 4 ) - keyLength, fp );
+
+	remaining = sfx->soundLength * sfx->soundChannels;
+	for ( chunk = sfx->soundData; chunk && remaining > 0; chunk = chunk->next ) {
+		int count = MIN( remaining, SND_CHUNK_SIZE );
+		for ( i = 0; i < count; ++i ) {
+			buffer[i] = LittleShort( chunk->sndChunk[i] );
+		}
+		FS_Write( buffer, count * sizeof( *buffer ), fp );
+		remaining -= count;
+	}
+
+	FS_FCloseFile( fp );
+}
+
+/*
+=================
+S_SoundCache_Init
+=================
+*/
+void S_SoundCache_Init( void ) {
+	s_soundCache = Cvar_Get( "s_soundCache", "1", CVAR_ARCHIVE );
+}
+
+#endif
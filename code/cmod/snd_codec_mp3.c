@@ -95,7 +95,11 @@ int S_MP3_ReadData(snd_stream_t *stream, struct mad_stream *madstream, byte *enc
 
 	// Fill the buffer right to the end
 
+#ifdef CMOD_SOUND_ASYNC_LOAD
+	retval = S_CodecUtilRead(stream, &encbuf[leftover], encbufsize - leftover);
+#else
 	retval = FS_Read(&encbuf[leftover], encbufsize - leftover, stream->file);
+#endif
 
 	if(retval <= 0)
 	{
@@ -205,7 +209,11 @@ int S_MP3_Scanfile(snd_stream_t *stream)
 	}
 
 	// Reset the file pointer so we can do the real decoding.
+#ifdef CMOD_SOUND_ASYNC_LOAD
+	S_CodecUtilSeek(stream, 0, FS_SEEK_SET);
+#else
 	FS_Seek(stream->file, 0, FS_SEEK_SET);
+#endif
 
 	return 0;
 }
@@ -494,12 +502,21 @@ int S_MP3_Decode(snd_stream_t *stream)
 		if(samplecount < pcm->length)
 		{
 			// The pcm buffer was not large enough. Make it bigger.
+#ifdef CMOD_SOUND_ASYNC_LOAD
+			// use malloc since this can run on sound loader threads
+			byte *newbuf = calloc(1, cursize);
+#else
 			byte *newbuf = Z_Malloc(cursize);
+#endif
 
 			if(mp3info->pcmbuf)
 			{
 				memcpy(newbuf, mp3info->pcmbuf, mp3info->buflen);
+#ifdef CMOD_SOUND_ASYNC_LOAD
+				free(mp3info->pcmbuf);
+#else
 				Z_Free(mp3info->pcmbuf);
+#endif
 			}
 
 			mp3info->pcmbuf = newbuf;
@@ -596,7 +613,11 @@ void S_MP3_CodecCloseStream(snd_stream_t *stream)
 		mp3info = stream->ptr;
 
 		if(mp3info->pcmbuf)
+#ifdef CMOD_SOUND_ASYNC_LOAD
+			free(mp3info->pcmbuf);
+#else
 			Z_Free(mp3info->pcmbuf);
+#endif
 
 		mad_synth_finish(&mp3info->madsynth);
 		mad_frame_finish(&mp3info->madframe);
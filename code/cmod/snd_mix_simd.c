@@ -0,0 +1,463 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+Copyright (C) 2017 Noah Metzger (chomenor@gmail.com)
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+
+#ifdef CMOD_SOUND_MIX_SIMD
+#ifdef USE_INTERNAL_SDL_HEADERS
+#	include "SDL.h"
+#else
+#	include <SDL.h>
+#endif
+
+#include "../client/client.h"
+#include "../client/snd_local.h"
+
+#if defined( __x86_64__ ) || defined( _M_X64 )
+#define SND_SIMD_X86
+#include <emmintrin.h>
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define SND_TARGET_AVX2
+#else
+#define SND_TARGET_AVX2 __attribute__( ( target( "avx2" ) ) )
+#endif
+#elif defined( __aarch64__ ) || defined( _M_ARM64 )
+#define SND_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+/*
+###############################################################################################
+
+SIMD Sound Mixing Kernels
+
+Vectorized versions of the inner loops of the DMA sound mixer: scaling 16-bit samples by
+channel volume and adding them to the paint buffer, and converting the paint buffer to 16-bit
+stereo output. The paint functions in snd_mix.c walk the sound chunks and call these kernels
+on each contiguous run of samples.
+
+All kernels use the same integer operations as the scalar code, so the output is identical.
+The volume product always fits in 32 bits (sample * 255 * 255), and the output conversion
+uses saturating packs, which match the scalar clamping.
+
+The kernel set is selected at runtime from the CPU features and the "s_mixSimd" cvar. The
+selection is made on the main thread and published to the mixer, which may be running in the
+audio thread, and the mixer picks it up at the start of each paint. The "s_mixBenchmark"
+command compares the available kernel sets on synthetic data.
+
+###############################################################################################
+*/
+
+// kernels used by the mixer; only accessed by the mixing thread
+sndMixKernels_t sndMixKernels;
+
+// kernels selected by main thread
+static void *selectedKernels;
+
+/* ******************************************************************************** */
+// Scalar
+/* ******************************************************************************** */
+
+static void S_MixPaint16_scalar( portable_samplepair_t *samp, const short *samples, int count,
+		int leftvol, int rightvol, int channels ) {
+	int i;
+
+	if ( channels == 2 ) {
+		for ( i = 0; i < count; ++i ) {
+			samp[i].left += ( samples[i * 2] * leftvol ) >> 8;
+			samp[i].right += ( samples[i * 2 + 1] * rightvol ) >> 8;
+		}
+	} else {
+		for ( i = 0; i < count; ++i ) {
+			int data = samples[i];
+			samp[i].left += ( data * leftvol ) >> 8;
+			samp[i].right += ( data * rightvol ) >> 8;
+		}
+	}
+}
+
+static void S_MixTransfer16_scalar( const int *src, short *dst, int count ) {
+	int i;
+
+	for ( i = 0; i < count; ++i ) {
+		int val = src[i] >> 8;
+		if ( val > 0x7fff ) {
+			dst[i] = 0x7fff;
+		} else if ( val < -32768 ) {
+			dst[i] = -32768;
+		} else {
+			dst[i] = val;
+		}
+	}
+}
+
+static const sndMixKernels_t sndMixKernels_scalar = {
+	"scalar", S_MixPaint16_scalar, S_MixTransfer16_scalar };
+
+#ifdef SND_SIMD_X86
+/* ******************************************************************************** */
+// SSE2
+/* ******************************************************************************** */
+
+// SSE2 has no 32-bit multiply returning the low half, but the low 32 bits of an unsigned
+// product are the same as for a signed one, so _mm_mul_epu32 can be used.
+static ID_INLINE __m128i S_MixMulLo32_sse2( __m128i a, __m128i b ) {
+	__m128i even = _mm_mul_epu32( a, b );
+	__m128i odd = _mm_mul_epu32( _mm_srli_epi64( a, 32 ), _mm_srli_epi64( b, 32 ) );
+	return _mm_unpacklo_epi32( _mm_shuffle_epi32( even, _MM_SHUFFLE( 0, 0, 2, 0 ) ),
+			_mm_shuffle_epi32( odd, _MM_SHUFFLE( 0, 0, 2, 0 ) ) );
+}
+
+static ID_INLINE void S_MixAccumulate_sse2( portable_samplepair_t *samp, __m128i data, __m128i vol ) {
+	__m128i *dst = (__m128i *)samp;
+	__m128i scaled = _mm_srai_epi32( S_MixMulLo32_sse2( data, vol ), 8 );
+	_mm_storeu_si128( dst, _mm_add_epi32( _mm_loadu_si128( dst ), scaled ) );
+}
+
+static void S_MixPaint16_sse2( portable_samplepair_t *samp, const short *samples, int count,
+		int leftvol, int rightvol, int channels ) {
+	__m128i vol = _mm_set_epi32( rightvol, leftvol, rightvol, leftvol );
+	int i = 0;
+
+	if ( channels == 2 ) {
+		for ( ; i + 4 <= count; i += 4 ) {
+			__m128i raw = _mm_loadu_si128( (const __m128i *)( samples + i * 2 ) );
+			S_MixAccumulate_sse2( samp + i, _mm_srai_epi32( _mm_unpacklo_epi16( raw, raw ), 16 ), vol );
+			S_MixAccumulate_sse2( samp + i + 2, _mm_srai_epi32( _mm_unpackhi_epi16( raw, raw ), 16 ), vol );
+		}
+	} else {
+		for ( ; i + 4 <= count; i += 4 ) {
+			__m128i raw = _mm_loadl_epi64( (const __m128i *)( samples + i ) );
+			__m128i data = _mm_srai_epi32( _mm_unpacklo_epi16( raw, raw ), 16 );
+			S_MixAccumulate_sse2( samp + i, _mm_unpacklo_epi32( data, data ), vol );
+			S_MixAccumulate_sse2( samp + i + 2, _mm_unpackhi_epi32( data, data ), vol );
+		}
+	}
+
+	if ( i < count ) {
+		S_MixPaint16_scalar( samp + i, samples + i * channels, count - i, leftvol, rightvol, channels );
+	}
+}
+
+static void S_MixTransfer16_sse2( const int *src, short *dst, int count ) {
+	int i = 0;
+
+	for ( ; i + 8 <= count; i += 8 ) {
+		__m128i a = _mm_srai_epi32( _mm_loadu_si128( (const __m128i *)( src + i ) ), 8 );
+		__m128i b = _mm_srai_epi32( _mm_loadu_si128( (const __m128i *)( src + i + 4 ) ), 8 );
+		_mm_storeu_si128( (__m128i *)( dst + i ), _mm_packs_epi32( a, b ) );
+	}
+
+	if ( i < count ) {
+		S_MixTransfer16_scalar( src + i, dst + i, count - i );
+	}
+}
+
+static const sndMixKernels_t sndMixKernels_sse2 = {
+	"sse2", S_MixPaint16_sse2, S_MixTransfer16_sse2 };
+
+/* ******************************************************************************** */
+// AVX2
+/* ******************************************************************************** */
+
+SND_TARGET_AVX2 static void S_MixPaint16_avx2( portable_samplepair_t *samp, const short *samples,
+		int count, int leftvol, int rightvol, int channels ) {
+	__m256i vol = _mm256_set_epi32( rightvol, leftvol, rightvol, leftvol,
+			rightvol, leftvol, rightvol, leftvol );
+	int i = 0;
+
+	if ( channels == 2 ) {
+		for ( ; i + 4 <= count; i += 4 ) {
+			__m256i *dst = (__m256i *)( samp + i );
+			__m256i data = _mm256_cvtepi16_epi32( _mm_loadu_si128( (const __m128i *)( samples + i * 2 ) ) );
+			__m256i scaled = _mm256_srai_epi32( _mm256_mullo_epi32( data, vol ), 8 );
+			_mm256_storeu_si256( dst, _mm256_add_epi32( _mm256_loadu_si256( dst ), scaled ) );
+		}
+	} else {
+		const __m256i lowIndex = _mm256_set_epi32( 3, 3, 2, 2, 1, 1, 0, 0 );
+		const __m256i highIndex = _mm256_set_epi32( 7, 7, 6, 6, 5, 5, 4, 4 );
+		for ( ; i + 8 <= count; i += 8 ) {
+			__m256i *dst = (__m256i *)( samp + i );
+			__m256i data = _mm256_cvtepi16_epi32( _mm_loadu_si128( (const __m128i *)( samples + i ) ) );
+			__m256i low = _mm256_srai_epi32( _mm256_mullo_epi32(
+					_mm256_permutevar8x32_epi32( data, lowIndex ), vol ), 8 );
+			__m256i high = _mm256_srai_epi32( _mm256_mullo_epi32(
+					_mm256_permutevar8x32_epi32( data, highIndex ), vol ), 8 );
+			_mm256_storeu_si256( dst, _mm256_add_epi32( _mm256_loadu_si256( dst ), low ) );
+			_mm256_storeu_si256( dst + 1, _mm256_add_epi32( _mm256_loadu_si256( dst + 1 ), high ) );
+		}
+	}
+
+	if ( i < count ) {
+		S_MixPaint16_scalar( samp + i, samples + i * channels, count - i, leftvol, rightvol, channels );
+	}
+}
+
+// The 256-bit pack instructions work within 128-bit lanes, so the SSE2 transfer is used.
+static const sndMixKernels_t sndMixKernels_avx2 = {
+	"avx2", S_MixPaint16_avx2, S_MixTransfer16_sse2 };
+
+/*
+=================
+S_MixSimd_CPUSupportsAVX2
+=================
+*/
+static qboolean S_MixSimd_CPUSupportsAVX2( void ) {
+#ifdef _MSC_VER
+	int regs[4];
+	__cpuid( regs, 1 );
+	// check OSXSAVE and AVX, then that the OS saves the YMM registers
+	if ( ( regs[2] & ( 1 << 27 ) ) == 0 || ( regs[2] & ( 1 << 28 ) ) == 0 ) {
+		return qfalse;
+	}
+	if ( ( _xgetbv( 0 ) & 6 ) != 6 ) {
+		return qfalse;
+	}
+	__cpuidex( regs, 7, 0 );
+	return ( regs[1] & ( 1 << 5 ) ) ? qtrue : qfalse;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports( "avx2" ) ? qtrue : qfalse;
+#endif
+}
+#endif
+
+#ifdef SND_SIMD_NEON
+/* ******************************************************************************** */
+// NEON
+/* ******************************************************************************** */
+
+static ID_INLINE void S_MixAccumulate_neon( portable_samplepair_t *samp, int32x4_t data, int32x4_t vol ) {
+	int32_t *dst = (int32_t *)samp;
+	vst1q_s32( dst, vaddq_s32( vld1q_s32( dst ), vshrq_n_s32( vmulq_s32( data, vol ), 8 ) ) );
+}
+
+static void S_MixPaint16_neon( portable_samplepair_t *samp, const short *samples, int count,
+		int leftvol, int rightvol, int channels ) {
+	const int32_t volValues[4] = { leftvol, rightvol, leftvol, rightvol };
+	int32x4_t vol = vld1q_s32( volValues );
+	int i = 0;
+
+	if ( channels == 2 ) {
+		for ( ; i + 4 <= count; i += 4 ) {
+			int16x8_t raw = vld1q_s16( samples + i * 2 );
+			S_MixAccumulate_neon( samp + i, vmovl_s16( vget_low_s16( raw ) ), vol );
+			S_MixAccumulate_neon( samp + i + 2, vmovl_s16( vget_high_s16( raw ) ), vol );
+		}
+	} else {
+		for ( ; i + 4 <= count; i += 4 ) {
+			int32x4_t data = vmovl_s16( vld1_s16( samples + i ) );
+			int32x4x2_t pairs = vzipq_s32( data, data );
+			S_MixAccumulate_neon( samp + i, pairs.val[0], vol );
+			S_MixAccumulate_neon( samp + i + 2, pairs.val[1], vol );
+		}
+	}
+
+	if ( i < count ) {
+		S_MixPaint16_scalar( samp + i, samples + i * channels, count - i, leftvol, rightvol, channels );
+	}
+}
+
+static void S_MixTransfer16_neon( const int *src, short *dst, int count ) {
+	int i = 0;
+
+	for ( ; i + 8 <= count; i += 8 ) {
+		int16x4_t a = vqmovn_s32( vshrq_n_s32( vld1q_s32( src + i ), 8 ) );
+		int16x4_t b = vqmovn_s32( vshrq_n_s32( vld1q_s32( src + i + 4 ), 8 ) );
+		vst1q_s16( dst + i, vcombine_s16( a, b ) );
+	}
+
+	if ( i < count ) {
+		S_MixTransfer16_scalar( src + i, dst + i, count - i );
+	}
+}
+
+static const sndMixKernels_t sndMixKernels_neon = {
+	"neon", S_MixPaint16_neon, S_MixTransfer16_neon };
+#endif
+
+/* ******************************************************************************** */
+// Kernel Selection
+/* ******************************************************************************** */
+
+/*
+=================
+S_MixSimd_Available
+
+Writes supported kernel sets to list, fastest first. Returns count, which is at least 1.
+=================
+*/
+static int S_MixSimd_Available( const sndMixKernels_t **list ) {
+	int count = 0;
+#ifdef SND_SIMD_X86
+	if ( S_MixSimd_CPUSupportsAVX2() ) {
+		list[count++] = &sndMixKernels_avx2;
+	}
+	list[count++] = &sndMixKernels_sse2;
+#endif
+#ifdef SND_SIMD_NEON
+	list[count++] = &sndMixKernels_neon;
+#endif
+	list[count++] = &sndMixKernels_scalar;
+	return count;
+}
+
+/*
+=================
+S_MixSimd_Selected
+=================
+*/
+static const sndMixKernels_t *S_MixSimd_Selected( void ) {
+	const sndMixKernels_t *kernels = (const sndMixKernels_t *)SDL_AtomicGetPtr( &selectedKernels );
+	return kernels ? kernels : &sndMixKernels_scalar;
+}
+
+/*
+=================
+S_MixSimd_Select
+
+Selects mixing kernels based on s_mixSimd and the CPU. Called from the main thread.
+=================
+*/
+void S_MixSimd_Select( void ) {
+	const sndMixKernels_t *available[4];
+	const sndMixKernels_t *kernels;
+	S_MixSimd_Available( available );
+
+	kernels = s_mixSimd->integer ? available[0] : &sndMixKernels_scalar;
+	SDL_AtomicSetPtr( &selectedKernels, (void *)kernels );
+	s_mixSimd->modified = qfalse;
+	Com_DPrintf( "Using %s sound mixing kernels\n", kernels->name );
+}
+
+/*
+=================
+S_MixSimd_Apply
+
+Loads the selected kernels for the mixer. Called from the mixing thread.
+=================
+*/
+void S_MixSimd_Apply( void ) {
+	sndMixKernels = *S_MixSimd_Selected();
+}
+
+/* ******************************************************************************** */
+// Benchmark
+/* ******************************************************************************** */
+
+#define MIX_BENCHMARK_CHANNELS 32
+#define MIX_BENCHMARK_ITERATIONS 100
+
+/*
+=================
+S_MixSimd_BenchmarkKernels
+
+Mixes a set of synthetic channels into output, then converts it to 16-bit in output16.
+Returns elapsed usec.
+=================
+*/
+static int64_t S_MixSimd_BenchmarkKernels( const sndMixKernels_t *kernels, const short *samples,
+		portable_samplepair_t *output, short *output16, int64_t *transferUsec ) {
+	int64_t start, paintEnd;
+	int iteration, channel;
+
+	start = Sys_Microseconds();
+	for ( iteration = 0; iteration < MIX_BENCHMARK_ITERATIONS; ++iteration ) {
+		Com_Memset( output, 0, sizeof( *output ) * PAINTBUFFER_SIZE );
+		for ( channel = 0; channel < MIX_BENCHMARK_CHANNELS; ++channel ) {
+			// vary the channel count, offset, and volume between channels
+			int channels = ( channel & 1 ) + 1;
+			int offset = channel * 37;
+			int leftvol = ( ( channel * 53 ) % 256 ) * 255;
+			int rightvol = ( 255 - ( ( channel * 53 ) % 256 ) ) * 255;
+			kernels->paint16( output, samples + offset, PAINTBUFFER_SIZE - offset % 7, leftvol, rightvol, channels );
+		}
+	}
+	paintEnd = Sys_Microseconds();
+
+	for ( iteration = 0; iteration < MIX_BENCHMARK_ITERATIONS; ++iteration ) {
+		kernels->transfer16( (const int *)output, output16, PAINTBUFFER_SIZE * 2 );
+	}
+	*transferUsec = Sys_Microseconds() - paintEnd;
+
+	return paintEnd - start;
+}
+
+/*
+=================
+S_MixSimd_Benchmark_f
+=================
+*/
+void S_MixSimd_Benchmark_f( void ) {
+	const sndMixKernels_t *available[4];
+	int count = S_MixSimd_Available( available );
+	int sampleCount = PAINTBUFFER_SIZE * 2 + MIX_BENCHMARK_CHANNELS * 37;
+	short *samples = (short *)Z_Malloc( sampleCount * sizeof( *samples ) );
+	portable_samplepair_t *reference = (portable_samplepair_t *)Z_Malloc( sizeof( *reference ) * PAINTBUFFER_SIZE );
+	portable_samplepair_t *output = (portable_samplepair_t *)Z_Malloc( sizeof( *output ) * PAINTBUFFER_SIZE );
+	short *reference16 = (short *)Z_Malloc( PAINTBUFFER_SIZE * 2 * sizeof( short ) );
+	short *output16 = (short *)Z_Malloc( PAINTBUFFER_SIZE * 2 * sizeof( short ) );
+	int64_t scalarUsec, scalarTransferUsec;
+	unsigned int seed = 1;
+	int i;
+
+	// loud random samples, so the output conversion clamps sometimes
+	for ( i = 0; i < sampleCount; ++i ) {
+		seed = seed * 1103515245 + 12345;
+		samples[i] = (short)( seed >> 16 );
+	}
+
+	Com_Printf( "Mixing %i channels of %i samples, %i iterations\n", MIX_BENCHMARK_CHANNELS,
+			PAINTBUFFER_SIZE, MIX_BENCHMARK_ITERATIONS );
+
+	scalarUsec = S_MixSimd_BenchmarkKernels( &sndMixKernels_scalar, samples, reference, reference16,
+			&scalarTransferUsec );
+	Com_Printf( "%-8s paint %8.3f ms  transfer %8.3f ms\n", sndMixKernels_scalar.name,
+			scalarUsec / 1000.0, scalarTransferUsec / 1000.0 );
+
+	for ( i = 0; i < count; ++i ) {
+		int64_t usec, transferUsec;
+		qboolean match;
+		if ( available[i] == &sndMixKernels_scalar ) {
+			continue;
+		}
+
+		usec = S_MixSimd_BenchmarkKernels( available[i], samples, output, output16, &transferUsec );
+		match = !memcmp( output, reference, sizeof( *output ) * PAINTBUFFER_SIZE ) &&
+				!memcmp( output16, reference16, PAINTBUFFER_SIZE * 2 * sizeof( short ) );
+		Com_Printf( "%-8s paint %8.3f ms  transfer %8.3f ms  speedup %.2fx / %.2fx  %s\n", available[i]->name,
+				usec / 1000.0, transferUsec / 1000.0, usec ? (double)scalarUsec / usec : 0.0,
+				transferUsec ? (double)scalarTransferUsec / transferUsec : 0.0,
+				match ? "matches scalar" : S_COLOR_RED "MISMATCH" );
+	}
+
+	Com_Printf( "Current kernels: %s\n", S_MixSimd_Selected()->name );
+
+	Z_Free( samples );
+	Z_Free( reference );
+	Z_Free( output );
+	Z_Free( reference16 );
+	Z_Free( output16 );
+}
+
+#endif
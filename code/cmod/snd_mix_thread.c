@@ -0,0 +1,568 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+Copyright (C) 2017 Noah Metzger (chomenor@gmail.com)
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+
+#ifdef CMOD_SOUND_MIX_THREAD
+#ifdef USE_INTERNAL_SDL_HEADERS
+#	include "SDL.h"
+#else
+#	include <SDL.h>
+#endif
+
+#include "../client/client.h"
+#include "../client/snd_local.h"
+
+/*
+###############################################################################################
+
+Threaded Sound Mixing
+
+When "s_mixThread" is enabled, the DMA sound backend mixes in the SDL audio callback instead
+of the client frame loop. Each callback paints exactly the part of the DMA buffer it is about
+to send to the device, so sound output no longer depends on the client frame rate and low
+framerates or hitches don't cause the sound to skip.
+
+The main thread keeps its own copy of the channel state, which is still used to pick channels
+and calculate volumes. Changes are sent to the audio thread through a single-producer,
+single-consumer message ring. Channel starts are queued by S_Base_StartSoundEx, and volume and
+looping sound changes are queued by S_Base_Respatialize. Messages are published once per frame
+by S_Base_Update, so the audio thread never sees a partially updated frame.
+
+Less frequent operations, such as clearing all sounds or freeing sound data, take the audio
+device lock and update the audio thread state directly. Mixing falls back to the main thread
+while recording video, since video recording needs sound painted in sync with video frames.
+
+###############################################################################################
+*/
+
+#define MIX_RING_SIZE 4096		// must be power of 2
+
+typedef enum {
+	MIXMSG_START,		// index: channel, channel: new channel state
+	MIXMSG_VOLUME,		// index: channel, value1: left volume, value2: right volume
+	MIXMSG_LOOP,		// index: loop channel, channel: new channel state
+	MIXMSG_LOOP_COUNT,	// index: number of loop channels
+	MIXMSG_RAWEND		// index: raw stream, value1: end of raw samples
+} mixMessageType_t;
+
+typedef struct {
+	mixMessageType_t type;
+	int index;
+	int value1;
+	int value2;
+	channel_t channel;
+} mixMessage_t;
+
+static struct {
+	qboolean enabled;		// s_mixThread was set at sound initialization
+	qboolean active;		// mixing in audio thread; only changed while holding audio lock
+	qboolean overflow;		// message was dropped, so full state needs to be resynced
+
+	// message ring
+	mixMessage_t ring[MIX_RING_SIZE];
+	unsigned int writePosition;			// main thread only
+	SDL_atomic_t commitPosition;		// written by main thread
+	SDL_atomic_t readPosition;			// written by audio thread
+	SDL_atomic_t paintedTime;			// s_paintedtime after last audio thread paint
+	SDL_atomic_t soundTime;				// s_soundtime after last audio thread paint
+
+	// last values submitted by main thread
+	int postedLeftVol[MAX_CHANNELS];
+	int postedRightVol[MAX_CHANNELS];
+	channel_t postedLoops[MAX_CHANNELS];
+	int postedNumLoops;
+	int postedRawEnd[MAX_RAW_STREAMS];
+
+	// audio thread state
+	channel_t channels[MAX_CHANNELS];
+	channel_t loops[MAX_CHANNELS];
+	int numLoops;
+	int rawEnd[MAX_RAW_STREAMS];
+} mixThread;
+
+static cvar_t *s_mixThread;
+
+/* ******************************************************************************** */
+// Message Ring
+/* ******************************************************************************** */
+
+/*
+=================
+S_MixThread_NewMessage
+
+Returns a message slot to fill in, or NULL if the ring is full. The message becomes visible
+to the audio thread on the next S_MixThread_Commit.
+=================
+*/
+static mixMessage_t *S_MixThread_NewMessage( mixMessageType_t type, int index ) {
+	mixMessage_t *msg;
+
+	if ( mixThread.overflow ) {
+		return NULL;
+	}
+
+	if ( mixThread.writePosition - (unsigned int)SDL_AtomicGet( &mixThread.readPosition ) >= MIX_RING_SIZE ) {
+		// audio thread isn't keeping up; resync full state on the next update instead
+		mixThread.overflow = qtrue;
+		return NULL;
+	}
+
+	msg = &mixThread.ring[mixThread.writePosition & ( MIX_RING_SIZE - 1 )];
+	msg->type = type;
+	msg->index = index;
+	++mixThread.writePosition;
+	return msg;
+}
+
+/*
+=================
+S_MixThread_Commit
+
+Publishes all messages written so far to the audio thread.
+=================
+*/
+static void S_MixThread_Commit( void ) {
+	SDL_MemoryBarrierRelease();
+	SDL_AtomicSet( &mixThread.commitPosition, (int)mixThread.writePosition );
+}
+
+/*
+=================
+S_MixThread_ProcessMessages
+
+Applies committed messages to the audio thread state. Called from the audio callback, or from
+the main thread while holding the audio lock.
+=================
+*/
+static void S_MixThread_ProcessMessages( void ) {
+	unsigned int position = (unsigned int)SDL_AtomicGet( &mixThread.readPosition );
+	unsigned int end = (unsigned int)SDL_AtomicGet( &mixThread.commitPosition );
+	SDL_MemoryBarrierAcquire();
+
+	while ( position != end ) {
+		const mixMessage_t *msg = &mixThread.ring[position & ( MIX_RING_SIZE - 1 )];
+
+		switch ( msg->type ) {
+			case MIXMSG_START:
+				mixThread.channels[msg->index] = msg->channel;
+				break;
+			case MIXMSG_VOLUME:
+				if ( mixThread.channels[msg->index].thesfx ) {
+					mixThread.channels[msg->index].leftvol = msg->value1;
+					mixThread.channels[msg->index].rightvol = msg->value2;
+				}
+				break;
+			case MIXMSG_LOOP:
+				mixThread.loops[msg->index] = msg->channel;
+				break;
+			case MIXMSG_LOOP_COUNT:
+				mixThread.numLoops = msg->index;
+				break;
+			case MIXMSG_RAWEND:
+				mixThread.rawEnd[msg->index] = msg->value1;
+				break;
+		}
+
+		++position;
+	}
+
+	SDL_MemoryBarrierRelease();
+	SDL_AtomicSet( &mixThread.readPosition, (int)position );
+}
+
+/*
+=================
+S_MixThread_Sync
+
+Replaces the audio thread state with the current main thread state, discarding any messages
+not yet committed. Must be called while holding the audio lock.
+=================
+*/
+static void S_MixThread_Sync( void ) {
+	int i;
+
+	S_MixThread_ProcessMessages();
+	mixThread.writePosition = (unsigned int)SDL_AtomicGet( &mixThread.commitPosition );
+	mixThread.overflow = qfalse;
+
+	Com_Memcpy( mixThread.channels, s_channels, sizeof( mixThread.channels ) );
+	Com_Memcpy( mixThread.loops, loop_channels, sizeof( mixThread.loops ) );
+	mixThread.numLoops = numLoopChannels;
+	Com_Memcpy( mixThread.rawEnd, s_rawend, sizeof( mixThread.rawEnd ) );
+
+	for ( i = 0; i < MAX_CHANNELS; ++i ) {
+		mixThread.postedLeftVol[i] = s_channels[i].leftvol;
+		mixThread.postedRightVol[i] = s_channels[i].rightvol;
+	}
+	Com_Memcpy( mixThread.postedLoops, loop_channels, sizeof( mixThread.postedLoops ) );
+	mixThread.postedNumLoops = numLoopChannels;
+	Com_Memcpy( mixThread.postedRawEnd, s_rawend, sizeof( mixThread.postedRawEnd ) );
+}
+
+/*
+=================
+S_MixThread_Rebase
+
+Shifts all sample times back to avoid 32 bit limits. Must be called while holding the audio
+lock. The offset is a multiple of MAX_RAW_SAMPLES so raw stream buffer positions are kept.
+=================
+*/
+static void S_MixThread_Rebase( void ) {
+	int i;
+	int base = s_paintedtime & ~( MAX_RAW_SAMPLES - 1 );
+
+	S_MixThread_ProcessMessages();
+
+	for ( i = 0; i < MAX_CHANNELS; ++i ) {
+		if ( s_channels[i].thesfx && s_channels[i].startSample != START_SAMPLE_IMMEDIATE ) {
+			s_channels[i].startSample -= base;
+		}
+		if ( mixThread.channels[i].thesfx && mixThread.channels[i].startSample != START_SAMPLE_IMMEDIATE ) {
+			mixThread.channels[i].startSample -= base;
+		}
+	}
+
+	for ( i = 0; i < MAX_RAW_STREAMS; ++i ) {
+		s_rawend[i] -= base;
+		mixThread.rawEnd[i] -= base;
+		mixThread.postedRawEnd[i] -= base;
+	}
+
+	s_paintedtime -= base;
+	s_soundtime = s_paintedtime;
+}
+
+/* ******************************************************************************** */
+// Main Thread Interface
+/* ******************************************************************************** */
+
+/*
+=================
+S_MixThread_Active
+
+Returns qtrue if sound is currently being mixed in the audio thread.
+=================
+*/
+qboolean S_MixThread_Active( void ) {
+	return mixThread.active;
+}
+
+/*
+=================
+S_MixThread_PaintedTime
+
+Returns s_paintedtime for use on the main thread. While the audio thread is mixing this is
+the value published after its last paint, since s_paintedtime itself may be changing.
+=================
+*/
+int S_MixThread_PaintedTime( void ) {
+	return mixThread.active ? SDL_AtomicGet( &mixThread.paintedTime ) : s_paintedtime;
+}
+
+/*
+=================
+S_MixThread_SoundTime
+
+Returns s_soundtime for use on the main thread, as with S_MixThread_PaintedTime.
+=================
+*/
+int S_MixThread_SoundTime( void ) {
+	return mixThread.active ? SDL_AtomicGet( &mixThread.soundTime ) : s_soundtime;
+}
+
+/*
+=================
+S_MixThread_StartChannel
+
+Called after a sound is started on a channel.
+=================
+*/
+void S_MixThread_StartChannel( const channel_t *ch ) {
+	int index = ch - s_channels;
+	mixMessage_t *msg;
+
+	if ( !mixThread.active ) {
+		return;
+	}
+
+	msg = S_MixThread_NewMessage( MIXMSG_START, index );
+	if ( msg ) {
+		msg->channel = *ch;
+		mixThread.postedLeftVol[index] = ch->leftvol;
+		mixThread.postedRightVol[index] = ch->rightvol;
+	}
+}
+
+/*
+=================
+S_MixThread_Respatialize
+
+Called after channel volumes and looping sounds are updated. Queues any changes since the
+last update.
+=================
+*/
+void S_MixThread_Respatialize( void ) {
+	int i;
+	mixMessage_t *msg;
+
+	if ( !mixThread.active ) {
+		return;
+	}
+
+	for ( i = 0; i < MAX_CHANNELS; ++i ) {
+		const channel_t *ch = &s_channels[i];
+		if ( ch->thesfx && ( ch->leftvol != mixThread.postedLeftVol[i] ||
+				ch->rightvol != mixThread.postedRightVol[i] ) ) {
+			msg = S_MixThread_NewMessage( MIXMSG_VOLUME, i );
+			if ( msg ) {
+				msg->value1 = mixThread.postedLeftVol[i] = ch->leftvol;
+				msg->value2 = mixThread.postedRightVol[i] = ch->rightvol;
+			}
+		}
+	}
+
+	for ( i = 0; i < numLoopChannels; ++i ) {
+		if ( i >= mixThread.postedNumLoops || memcmp( &loop_channels[i], &mixThread.postedLoops[i], sizeof( channel_t ) ) ) {
+			msg = S_MixThread_NewMessage( MIXMSG_LOOP, i );
+			if ( msg ) {
+				msg->channel = mixThread.postedLoops[i] = loop_channels[i];
+			}
+		}
+	}
+
+	if ( numLoopChannels != mixThread.postedNumLoops ) {
+		msg = S_MixThread_NewMessage( MIXMSG_LOOP_COUNT, numLoopChannels );
+		if ( msg ) {
+			mixThread.postedNumLoops = numLoopChannels;
+		}
+	}
+}
+
+/*
+=================
+S_MixThread_StopSfx
+
+Removes all audio thread references to a sound before its data is freed.
+=================
+*/
+void S_MixThread_StopSfx( const sfx_t *sfx ) {
+	int i;
+	unsigned int position;
+
+	if ( !mixThread.active ) {
+		return;
+	}
+
+	SNDDMA_BeginPainting();
+	S_MixThread_ProcessMessages();
+
+	for ( i = 0; i < MAX_CHANNELS; ++i ) {
+		if ( mixThread.channels[i].thesfx == sfx ) {
+			mixThread.channels[i].thesfx = NULL;
+		}
+		if ( mixThread.loops[i].thesfx == sfx ) {
+			mixThread.loops[i].thesfx = NULL;
+		}
+	}
+
+	// also clear messages that haven't been committed yet
+	for ( position = (unsigned int)SDL_AtomicGet( &mixThread.commitPosition ); position != mixThread.writePosition; ++position ) {
+		mixMessage_t *msg = &mixThread.ring[position & ( MIX_RING_SIZE - 1 )];
+		if ( ( msg->type == MIXMSG_START || msg->type == MIXMSG_LOOP ) && msg->channel.thesfx == sfx ) {
+			msg->channel.thesfx = NULL;
+		}
+	}
+
+	SNDDMA_Submit();
+}
+
+/*
+=================
+S_MixThread_Clear
+
+Called when all sounds are stopped, while holding the audio lock.
+=================
+*/
+void S_MixThread_Clear( void ) {
+	if ( mixThread.active ) {
+		S_MixThread_Sync();
+	}
+}
+
+/*
+=================
+S_MixThread_Update
+
+Called once per frame in place of the regular sound update. Returns qtrue if sound is being
+mixed in the audio thread, or qfalse to mix in the main thread.
+=================
+*/
+qboolean S_MixThread_Update( void ) {
+	int i;
+	qboolean active;
+	int paintedTime;
+
+	if ( !mixThread.enabled ) {
+		return qfalse;
+	}
+
+	active = CL_VideoRecording() ? qfalse : qtrue;
+
+	// s_paintedtime is advanced by the audio thread while it is mixing, so outside the audio
+	// lock use the value it published instead
+	paintedTime = S_MixThread_PaintedTime();
+
+	if ( active != mixThread.active || mixThread.overflow || paintedTime > 0x40000000 ) {
+		SNDDMA_BeginPainting();
+
+		if ( s_paintedtime > 0x40000000 ) {
+			S_MixThread_Rebase();
+		}
+
+		if ( active ) {
+			S_MixThread_Sync();
+		}
+
+		// continue from the same point when switching threads
+		mixThread.active = active;
+		s_soundtime = s_paintedtime;
+		SDL_AtomicSet( &mixThread.paintedTime, s_paintedtime );
+		SDL_AtomicSet( &mixThread.soundTime, s_soundtime );
+
+		SNDDMA_Submit();
+	}
+
+	if ( !mixThread.active ) {
+		return qfalse;
+	}
+
+	for ( i = 0; i < MAX_RAW_STREAMS; ++i ) {
+		if ( s_rawend[i] != mixThread.postedRawEnd[i] ) {
+			mixMessage_t *msg = S_MixThread_NewMessage( MIXMSG_RAWEND, i );
+			if ( msg ) {
+				msg->value1 = mixThread.postedRawEnd[i] = s_rawend[i];
+			}
+		}
+	}
+
+	S_MixThread_Commit();
+	return qtrue;
+}
+
+/*
+=================
+S_MixThread_Init
+
+Called after the DMA backend is initialized.
+=================
+*/
+void S_MixThread_Init( void ) {
+	s_mixThread = Cvar_Get( "s_mixThread", "0", CVAR_ARCHIVE | CVAR_LATCH );
+
+	Com_Memset( &mixThread, 0, sizeof( mixThread ) );
+	mixThread.enabled = s_mixThread->integer ? qtrue : qfalse;
+
+	if ( mixThread.enabled ) {
+		Com_Printf( "Sound mixing in audio thread enabled.\n" );
+	}
+}
+
+/*
+=================
+S_MixThread_Shutdown
+
+Called after the DMA backend is shut down and the audio callback has stopped.
+=================
+*/
+void S_MixThread_Shutdown( void ) {
+	Com_Memset( &mixThread, 0, sizeof( mixThread ) );
+}
+
+/* ******************************************************************************** */
+// Audio Thread
+/* ******************************************************************************** */
+
+/*
+=================
+S_MixThread_ScanChannelStarts
+
+Audio thread version of S_ScanChannelStarts.
+=================
+*/
+static void S_MixThread_ScanChannelStarts( void ) {
+	int i;
+
+	for ( i = 0; i < MAX_CHANNELS; ++i ) {
+		channel_t *ch = &mixThread.channels[i];
+		if ( !ch->thesfx ) {
+			continue;
+		}
+
+#ifdef CMOD_SOUND_ASYNC_LOAD
+		if ( ch->thesfx->loadPending ) {
+			continue;
+		}
+#endif
+
+		if ( ch->startSample == START_SAMPLE_IMMEDIATE ) {
+			ch->startSample = s_paintedtime;
+			continue;
+		}
+
+		if ( ch->startSample + ch->thesfx->soundLength <= s_paintedtime ) {
+			ch->thesfx = NULL;
+		}
+	}
+}
+
+/*
+=================
+S_MixThread_Paint
+
+Called from the audio callback with the number of samples about to be sent to the device.
+Paints them into the DMA buffer and returns the sample position in the DMA buffer to copy
+from, or -1 if sound is being mixed in the main thread.
+=================
+*/
+int S_MixThread_Paint( int samples ) {
+	int position;
+
+	if ( !mixThread.active ) {
+		return -1;
+	}
+
+	S_MixThread_ProcessMessages();
+	S_MixThread_ScanChannelStarts();
+
+	position = ( (unsigned long long)s_paintedtime * dma.channels ) % dma.samples;
+	S_PaintChannelsFrom( s_paintedtime + samples / dma.channels, mixThread.channels,
+			mixThread.loops, mixThread.numLoops, mixThread.rawEnd );
+
+	// main thread uses this to position raw streams
+	s_soundtime = s_paintedtime;
+	SDL_AtomicSet( &mixThread.paintedTime, s_paintedtime );
+	SDL_AtomicSet( &mixThread.soundTime, s_soundtime );
+
+	return position;
+}
+
+#endif
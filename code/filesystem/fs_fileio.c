@@ -804,7 +804,11 @@ Returns null on error, otherwise result needs to be freed by FS_FreeData.
 Currently file-type read always reads file->filesize, otherwise it is an error and null is returned.
 =================
 */
+#if defined(CMOD_FRAME_TRACE) || defined(CMOD_SERVER_HITCH_LOG)
+static char *FS_ReadDataInternal( const fsc_file_t *file, const char *path, unsigned int *size_out, const char *calling_function ) {
+#else
 char *FS_ReadData( const fsc_file_t *file, const char *path, unsigned int *size_out, const char *calling_function ) {
+#endif
 	cache_entry_t *cache_entry = NULL;
 	char *data = NULL;
 	void *os_path = NULL;
@@ -940,6 +944,45 @@ error:
 	return NULL;
 }
 
+#if defined(CMOD_FRAME_TRACE) || defined(CMOD_SERVER_HITCH_LOG)
+/*
+=================
+FS_ReadData
+
+Records file reads for the frame trace and server hitch log.
+=================
+*/
+char *FS_ReadData( const fsc_file_t *file, const char *path, unsigned int *size_out, const char *calling_function ) {
+	char *data;
+#ifdef CMOD_SERVER_HITCH_LOG
+	int64_t hitchStart = 0;
+	if ( svHitchActive ) {
+		char buffer[FS_FILE_BUFFER_SIZE];
+		if ( file ) {
+			FS_FileToBuffer( file, buffer, sizeof( buffer ), qtrue, qtrue, qtrue, qfalse );
+		} else {
+			Q_strncpyz( buffer, path, sizeof( buffer ) );
+		}
+		SV_Hitch_Note( "read %s", buffer );
+		hitchStart = Sys_Microseconds();
+	}
+#endif
+#ifdef CMOD_FRAME_TRACE
+	CMTRACE_BEGIN( "FS_ReadData" );
+#endif
+	data = FS_ReadDataInternal( file, path, size_out, calling_function );
+#ifdef CMOD_FRAME_TRACE
+	CMTRACE_END();
+#endif
+#ifdef CMOD_SERVER_HITCH_LOG
+	if ( hitchStart ) {
+		SV_Hitch_RecordPhase( SV_HITCH_PHASE_FILEIO, hitchStart );
+	}
+#endif
+	return data;
+}
+#endif
+
 /*
 =================
 FS_FreeData
@@ -558,6 +558,10 @@ void CMod_LoadPatches( lump_t *surfs, lump_t *verts ) {
 		patch->surfaceFlags = cm.shaders[shaderNum].surfaceFlags;
 
 		// create the internal facet structure
+#ifdef CMOD_PATCH_COLLIDE_CACHE
+		patch->pc = CMPatchCache_Get( i, width, height );
+		if ( !patch->pc )
+#endif
 		patch->pc = CM_GeneratePatchCollide( width, height, points );
 	}
 }
@@ -681,7 +685,13 @@ void CM_LoadMap( const char *name, qboolean clientload, int *checksum ) {
 	CMod_LoadNodes (&header.lumps[LUMP_NODES]);
 	CMod_LoadEntityString (&header.lumps[LUMP_ENTITIES]);
 	CMod_LoadVisibility( &header.lumps[LUMP_VISIBILITY] );
+#ifdef CMOD_PATCH_COLLIDE_CACHE
+	CMPatchCache_Begin( CM_Checksum( &header ), header.lumps[LUMP_SURFACES].filelen / sizeof( dsurface_t ) );
+	CMod_LoadPatches( &header.lumps[LUMP_SURFACES], &header.lumps[LUMP_DRAWVERTS] );
+	CMPatchCache_End();
+#else
 	CMod_LoadPatches( &header.lumps[LUMP_SURFACES], &header.lumps[LUMP_DRAWVERTS] );
+#endif
 
 	// we are NOT freeing the file, because it is cached for the ref
 	FS_FreeFile (buf.v);
@@ -694,6 +704,10 @@ void CM_LoadMap( const char *name, qboolean clientload, int *checksum ) {
 	if ( !clientload ) {
 		Q_strncpyz( cm.name, name, sizeof( cm.name ) );
 	}
+
+#ifdef CMOD_TRACE_CACHE
+	CMTraceCache_Invalidate();
+#endif
 }
 
 /*
@@ -704,6 +718,9 @@ CM_ClearMap
 void CM_ClearMap( void ) {
 	Com_Memset( &cm, 0, sizeof( cm ) );
 	CM_ClearLevelPatches();
+#ifdef CMOD_TRACE_CACHE
+	CMTraceCache_Invalidate();
+#endif
 }
 
 /*
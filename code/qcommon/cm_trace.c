@@ -1374,7 +1374,24 @@ CM_BoxTrace
 void CM_BoxTrace( trace_t *results, const vec3_t start, const vec3_t end,
 						  vec3_t mins, vec3_t maxs,
 						  clipHandle_t model, int brushmask, int capsule ) {
+#ifdef CMOD_FRAME_TRACE
+	CMTRACE_BEGIN( "CM_BoxTrace" );
+#endif
+#ifdef CMOD_TRACE_CACHE
+	if ( CMTraceCache_Lookup( results, start, end, mins, maxs, model, brushmask, capsule ) ) {
+#ifdef CMOD_FRAME_TRACE
+		CMTRACE_END();
+#endif
+		return;
+	}
 	CM_Trace( results, start, end, mins, maxs, model, vec3_origin, brushmask, capsule, NULL );
+	CMTraceCache_Store( results, start, end, mins, maxs, model, brushmask, capsule );
+#else
+	CM_Trace( results, start, end, mins, maxs, model, vec3_origin, brushmask, capsule, NULL );
+#endif
+#ifdef CMOD_FRAME_TRACE
+	CMTRACE_END();
+#endif
 }
 
 /*
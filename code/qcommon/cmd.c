@@ -780,6 +780,18 @@ void	Cmd_ExecuteString( const char *text ) {
 		return;		// no tokens
 	}
 
+#ifdef CMOD_SERVER_HITCH_LOG
+	// include the first argument for context (such as map or config name), except for
+	// cvar commands where it would be the value
+	if ( svHitchActive ) {
+		if ( Cmd_Argc() > 1 && Cvar_Flags( cmd_argv[0] ) == CVAR_NONEXISTENT ) {
+			SV_Hitch_Note( "cmd %s %s", cmd_argv[0], cmd_argv[1] );
+		} else {
+			SV_Hitch_Note( "cmd %s", cmd_argv[0] );
+		}
+	}
+#endif
+
 	// check registered command functions	
 	for ( prev = &cmd_functions ; *prev ; prev = &cmd->next ) {
 		cmd = *prev;
@@ -2964,6 +2964,14 @@ void Com_Init( char *commandLine ) {
 	Cmd_AddCommand("uri", Stef_UriCmd);
 #endif
 
+#ifdef CMOD_TRACE_CACHE
+	CMTraceCache_Init();
+#endif
+
+#ifdef CMOD_FRAME_TRACE
+	CMTrace_Init();
+#endif
+
 #ifdef CMOD_SETTINGS
 #ifndef DEDICATED
 	Key_LoadDefaultBinds( qtrue );
@@ -3376,12 +3384,24 @@ void Com_Frame( void ) {
 	int		timeBeforeEvents;
 	int		timeBeforeClient;
 	int		timeAfter;
+#ifdef CMOD_SERVER_HITCH_LOG
+	int64_t	hitchStart;
+#endif
+#ifdef CMOD_SERVER_FRAME_SCHEDULER
+	qboolean	schedulerActive = qfalse;
+#endif
   
 
 #ifdef CMOD_LONGJMP_FIX
 	if ( Q_setjmp (abortframe) ) {
 #else
 	if ( setjmp (abortframe) ) {
+#endif
+#ifdef CMOD_SERVER_HITCH_LOG
+		if ( svHitchActive ) {
+			SV_Hitch_Note( "frame aborted by error" );
+			SV_Hitch_EndFrame();
+		}
 #endif
 		return;			// an ERR_DROP was thrown
 	}
@@ -3405,7 +3425,11 @@ void Com_Frame( void ) {
 	}
 
 	// Figure out how much time we have
+#ifdef CMOD_DEMO_RENDER
+	if(!com_timedemo->integer && !CMDemoRender_Active())
+#else
 	if(!com_timedemo->integer)
+#endif
 	{
 		if(com_dedicated->integer)
 			minMsec = SV_FrameMsec();
@@ -3434,6 +3458,17 @@ void Com_Frame( void ) {
 	else
 		minMsec = 1;
 
+#ifdef CMOD_SERVER_BENCHMARK
+	if ( SV_Benchmark_Running() ) {
+		// run server frames back to back, only polling for network activity
+		SV_Benchmark_StartFrame();
+	} else
+#endif
+#ifdef CMOD_SERVER_FRAME_SCHEDULER
+	if ( ( schedulerActive = SV_Scheduler_Active() ) ) {
+		SV_Scheduler_Wait( com_busyWait->integer ? qtrue : qfalse );
+	} else
+#endif
 	do
 	{
 		if(com_sv_running->integer)
@@ -3453,15 +3488,44 @@ void Com_Frame( void ) {
 		else
 			NET_Sleep(timeVal - 1);
 	} while(Com_TimeVal(minMsec));
+#ifdef CMOD_SERVER_FRAME_SCHEDULER
+	SV_Scheduler_RecordFrameStart( schedulerActive );
+#endif
+
+#ifdef CMOD_FRAME_TRACE
+	// frame span excludes the wait for the next frame
+	CMTrace_BeginFrame();
+#endif
+#ifdef CMOD_SERVER_HITCH_LOG
+	SV_Hitch_BeginFrame();
+#endif
 	
 	IN_Frame();
 
 	lastTime = com_frameTime;
+#ifdef CMOD_SERVER_HITCH_LOG
+	hitchStart = Sys_Microseconds();
+	com_frameTime = Com_EventLoop();
+	SV_Hitch_RecordPhase( SV_HITCH_PHASE_NETWORK, hitchStart );
+#else
 	com_frameTime = Com_EventLoop();
+#endif
+#ifdef CMOD_SERVER_BENCHMARK
+	SV_Benchmark_EndNetworkPhase();
+#endif
 	
 	msec = com_frameTime - lastTime;
+#ifdef CMOD_SERVER_FRAME_SCHEDULER
+	msec = SV_Scheduler_FrameMsec( msec );
+#endif
 
+#ifdef CMOD_SERVER_HITCH_LOG
+	hitchStart = Sys_Microseconds();
+	Cbuf_Execute ();
+	SV_Hitch_RecordPhase( SV_HITCH_PHASE_COMMANDS, hitchStart );
+#else
 	Cbuf_Execute ();
+#endif
 
 	if (com_altivec->modified)
 	{
@@ -3471,6 +3535,11 @@ void Com_Frame( void ) {
 
 	// mess with msec if needed
 	msec = Com_ModifyMsec(msec);
+#ifdef CMOD_SERVER_BENCHMARK
+	if ( SV_Benchmark_Running() ) {
+		msec = SV_Benchmark_FrameMsec();
+	}
+#endif
 
 	//
 	// server side
@@ -3480,6 +3549,9 @@ void Com_Frame( void ) {
 	}
 
 	SV_Frame( msec );
+#ifdef CMOD_SERVER_BENCHMARK
+	SV_Benchmark_EndFrame();
+#endif
 
 	// if "dedicated" has been modified, start up
 	// or shut down the client system.
@@ -3575,6 +3647,15 @@ void Com_Frame( void ) {
 #ifdef CMOD_MULTI_MASTER_QUERY
 	Stef_MultiMasterQuery_RunFrame();
 #endif
+#ifdef CMOD_TRACE_CACHE
+	CMTraceCache_Invalidate();
+#endif
+#ifdef CMOD_SERVER_HITCH_LOG
+	SV_Hitch_EndFrame();
+#endif
+#ifdef CMOD_FRAME_TRACE
+	CMTRACE_END();
+#endif
 }
 
 /*
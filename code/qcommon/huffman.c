@@ -27,7 +27,15 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include "q_shared.h"
 #include "qcommon.h"
 
+#ifdef CMOD_HUFFMAN_THREAD_LOCAL
+#ifdef _MSC_VER
+static __declspec( thread ) int bloc = 0;
+#else
+static __thread int bloc = 0;
+#endif
+#else
 static int			bloc = 0;
+#endif
 
 void	Huff_putBit( int bit, byte *fout, int *offset) {
 	bloc = *offset;
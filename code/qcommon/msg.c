@@ -28,6 +28,11 @@ static qboolean			msgInit = qfalse;
 
 int pcount[256];
 
+#ifdef CMOD_BANDWIDTH_PROFILE
+// set by the server bandwidth profiler while writing messages being profiled
+msgProfile_t *msgProfile;
+#endif
+
 /*
 ==============================================================================
 
@@ -1106,6 +1111,32 @@ netField_t	entityStateFields[] =
 #define	FLOAT_INT_BITS	13
 #define	FLOAT_INT_BIAS	(1<<(FLOAT_INT_BITS-1))
 
+#ifdef CMOD_BANDWIDTH_PROFILE
+/*
+==================
+MSG_ProfileAdd
+==================
+*/
+static void MSG_ProfileAdd( msgProfileCounter_t *counters, int index, int bits ) {
+	++counters[index].count;
+	counters[index].bits += bits;
+}
+
+/*
+==================
+MSG_ProfileEntityFieldName
+
+Returns null if index is out of range.
+==================
+*/
+const char *MSG_ProfileEntityFieldName( int index ) {
+	if ( index >= 0 && index < ARRAY_LEN( entityStateFields ) ) {
+		return entityStateFields[index].name;
+	}
+	return NULL;
+}
+#endif
+
 /*
 ==================
 MSG_WriteDeltaEntity
@@ -1117,8 +1148,13 @@ If force is not set, then nothing at all will be generated if the entity is
 identical, under the assumption that the in-order delta code will catch it.
 ==================
 */
+#ifdef CMOD_BANDWIDTH_PROFILE
+static void MSG_WriteDeltaEntityInternal( msg_t *msg, struct entityState_s *from, struct entityState_s *to,
+						   qboolean force ) {
+#else
 void MSG_WriteDeltaEntity( msg_t *msg, struct entityState_s *from, struct entityState_s *to, 
 						   qboolean force ) {
+#endif
 	int			i, lc;
 	int			numFields;
 	netField_t	*field;
@@ -1129,6 +1165,9 @@ void MSG_WriteDeltaEntity( msg_t *msg, struct entityState_s *from, struct entity
 	byte		vector[PVECTOR_BYTES];
 	int			vectorIndex = -1;
 #endif
+#ifdef CMOD_BANDWIDTH_PROFILE
+	int			fieldStart;
+#endif
 
 	numFields = ARRAY_LEN( entityStateFields );
 
@@ -1244,6 +1283,9 @@ void MSG_WriteDeltaEntity( msg_t *msg, struct entityState_s *from, struct entity
 			continue;
 		}
 
+#ifdef CMOD_BANDWIDTH_PROFILE
+		fieldStart = msg->bit;
+#endif
 #ifdef ELITEFORCE
 		if(!msg->compat)
 #endif
@@ -1295,8 +1337,34 @@ void MSG_WriteDeltaEntity( msg_t *msg, struct entityState_s *from, struct entity
 			}
 #endif
 		}
+#ifdef CMOD_BANDWIDTH_PROFILE
+		if ( msgProfile ) {
+			MSG_ProfileAdd( msgProfile->entityFields, i, msg->bit - fieldStart );
+		}
+#endif
+	}
+}
+
+#ifdef CMOD_BANDWIDTH_PROFILE
+/*
+==================
+MSG_WriteDeltaEntity
+
+Attributes the size of each entity delta to the entity type when profiling.
+==================
+*/
+void MSG_WriteDeltaEntity( msg_t *msg, struct entityState_s *from, struct entityState_s *to,
+						   qboolean force ) {
+	int start = msg->bit;
+
+	MSG_WriteDeltaEntityInternal( msg, from, to, force );
+
+	if ( msgProfile && msg->bit != start ) {
+		const entityState_t *ent = to ? to : from;
+		MSG_ProfileAdd( msgProfile->entityTypes, ent->eType & ( MSG_PROFILE_ENTITY_TYPES - 1 ), msg->bit - start );
 	}
 }
+#endif
 
 /*
 ==================
@@ -1592,6 +1660,28 @@ netField_t	playerStateFields[] =
 };
 #endif
 
+#ifdef CMOD_BANDWIDTH_PROFILE
+/*
+=============
+MSG_ProfilePlayerFieldName
+
+Returns null if index is out of range.
+=============
+*/
+const char *MSG_ProfilePlayerFieldName( int index ) {
+	static const char *arrayNames[] = { "stats", "persistant", "ammo", "powerups" };
+
+	if ( index >= 0 && index < ARRAY_LEN( playerStateFields ) ) {
+		return playerStateFields[index].name;
+	}
+	index -= ARRAY_LEN( playerStateFields );
+	if ( index >= 0 && index < ARRAY_LEN( arrayNames ) ) {
+		return arrayNames[index];
+	}
+	return NULL;
+}
+#endif
+
 /*
 =============
 MSG_WriteDeltaPlayerstate
@@ -1610,6 +1700,9 @@ void MSG_WriteDeltaPlayerstate( msg_t *msg, struct playerState_s *from, struct p
 	int				*fromF, *toF;
 	float			fullFloat;
 	int				trunc, lc;
+#ifdef CMOD_BANDWIDTH_PROFILE
+	int				fieldStart;
+#endif
 
 	if (!from) {
 		from = &dummy;
@@ -1651,6 +1744,9 @@ void MSG_WriteDeltaPlayerstate( msg_t *msg, struct playerState_s *from, struct p
 			continue;
 		}
 
+#ifdef CMOD_BANDWIDTH_PROFILE
+		fieldStart = msg->bit;
+#endif
 		MSG_WriteBits( msg, 1, 1 );	// changed
 //		pcount[i]++;
 
@@ -1673,6 +1769,11 @@ void MSG_WriteDeltaPlayerstate( msg_t *msg, struct playerState_s *from, struct p
 			// integer
 			MSG_WriteBits( msg, *toF, field->bits );
 		}
+#ifdef CMOD_BANDWIDTH_PROFILE
+		if ( msgProfile ) {
+			MSG_ProfileAdd( msgProfile->playerFields, i, msg->bit - fieldStart );
+		}
+#endif
 	}
 
 
@@ -1718,6 +1819,9 @@ void MSG_WriteDeltaPlayerstate( msg_t *msg, struct playerState_s *from, struct p
 #endif
 	MSG_WriteBits( msg, 1, 1 );	// changed
 
+#ifdef CMOD_BANDWIDTH_PROFILE
+	fieldStart = msg->bit;
+#endif
 	if ( statsbits ) {
 		MSG_WriteBits( msg, 1, 1 );	// changed
 		MSG_WriteBits( msg, statsbits, MAX_STATS );
@@ -1727,8 +1831,16 @@ void MSG_WriteDeltaPlayerstate( msg_t *msg, struct playerState_s *from, struct p
 	} else {
 		MSG_WriteBits( msg, 0, 1 );	// no change
 	}
+#ifdef CMOD_BANDWIDTH_PROFILE
+	if ( msgProfile && statsbits ) {
+		MSG_ProfileAdd( msgProfile->playerFields, numFields + 0, msg->bit - fieldStart );
+	}
+#endif
 
 
+#ifdef CMOD_BANDWIDTH_PROFILE
+	fieldStart = msg->bit;
+#endif
 	if ( persistantbits ) {
 		MSG_WriteBits( msg, 1, 1 );	// changed
 		MSG_WriteBits( msg, persistantbits, MAX_PERSISTANT );
@@ -1738,8 +1850,16 @@ void MSG_WriteDeltaPlayerstate( msg_t *msg, struct playerState_s *from, struct p
 	} else {
 		MSG_WriteBits( msg, 0, 1 );	// no change
 	}
+#ifdef CMOD_BANDWIDTH_PROFILE
+	if ( msgProfile && persistantbits ) {
+		MSG_ProfileAdd( msgProfile->playerFields, numFields + 1, msg->bit - fieldStart );
+	}
+#endif
 
 
+#ifdef CMOD_BANDWIDTH_PROFILE
+	fieldStart = msg->bit;
+#endif
 	if ( ammobits ) {
 		MSG_WriteBits( msg, 1, 1 );	// changed
 		MSG_WriteBits( msg, ammobits, MAX_WEAPONS );
@@ -1749,8 +1869,16 @@ void MSG_WriteDeltaPlayerstate( msg_t *msg, struct playerState_s *from, struct p
 	} else {
 		MSG_WriteBits( msg, 0, 1 );	// no change
 	}
+#ifdef CMOD_BANDWIDTH_PROFILE
+	if ( msgProfile && ammobits ) {
+		MSG_ProfileAdd( msgProfile->playerFields, numFields + 2, msg->bit - fieldStart );
+	}
+#endif
 
 
+#ifdef CMOD_BANDWIDTH_PROFILE
+	fieldStart = msg->bit;
+#endif
 	if ( powerupbits ) {
 		MSG_WriteBits( msg, 1, 1 );	// changed
 		MSG_WriteBits( msg, powerupbits, MAX_POWERUPS );
@@ -1760,6 +1888,11 @@ void MSG_WriteDeltaPlayerstate( msg_t *msg, struct playerState_s *from, struct p
 	} else {
 		MSG_WriteBits( msg, 0, 1 );	// no change
 	}
+#ifdef CMOD_BANDWIDTH_PROFILE
+	if ( msgProfile && powerupbits ) {
+		MSG_ProfileAdd( msgProfile->playerFields, numFields + 3, msg->bit - fieldStart );
+	}
+#endif
 }
 
 
@@ -670,6 +670,11 @@ void NET_SendPacket( netsrc_t sock, int length, const void *data, netadr_t to )
 	if ( to.type == NA_BAD ) {
 		return;
 	}
+#ifdef CMOD_RECORD_REPLAY
+	if ( to.type == NA_REPLAY ) {
+		return;
+	}
+#endif
 
 	if ( sock == NS_CLIENT && cl_packetdelay->integer > 0 ) {
 		NET_QueuePacket( length, data, to, cl_packetdelay->integer );
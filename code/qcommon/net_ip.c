@@ -125,6 +125,17 @@ static SOCKET	ip6_socket = INVALID_SOCKET;
 static SOCKET	socks_socket = INVALID_SOCKET;
 static SOCKET	multicast6_socket = INVALID_SOCKET;
 
+#ifdef CMOD_METRICS_ENDPOINT
+static struct {
+	int64_t packetsReceived;
+	int64_t bytesReceived;
+	int64_t packetsSent;
+	int64_t bytesSent;
+} netMetrics;
+
+static void NET_Metrics_Close( void );
+#endif
+
 // Keep track of currently joined multicast group.
 static struct ipv6_mreq curgroup;
 // And the currently bound address.
@@ -472,6 +483,10 @@ const char	*NET_AdrToString (netadr_t a)
 		Com_sprintf (s, sizeof(s), "loopback");
 	else if (a.type == NA_BOT)
 		Com_sprintf (s, sizeof(s), "bot");
+#ifdef CMOD_RECORD_REPLAY
+	else if (a.type == NA_REPLAY)
+		Com_sprintf (s, sizeof(s), "replay");
+#endif
 	else if (a.type == NA_IP || a.type == NA_IP6)
 	{
 		struct sockaddr_storage sadr;
@@ -492,6 +507,10 @@ const char	*NET_AdrToStringwPort (netadr_t a)
 		Com_sprintf (s, sizeof(s), "loopback");
 	else if (a.type == NA_BOT)
 		Com_sprintf (s, sizeof(s), "bot");
+#ifdef CMOD_RECORD_REPLAY
+	else if (a.type == NA_REPLAY)
+		Com_sprintf (s, sizeof(s), "replay");
+#endif
 	else if(a.type == NA_IP)
 		Com_sprintf(s, sizeof(s), "%s:%hu", NET_AdrToString(a), ntohs(a.port));
 	else if(a.type == NA_IP6)
@@ -704,6 +723,12 @@ void Sys_SendPacket( int length, const void *data, netadr_t to ) {
 
 		Com_Printf( "Sys_SendPacket: %s\n", NET_ErrorString() );
 	}
+#ifdef CMOD_METRICS_ENDPOINT
+	else {
+		++netMetrics.packetsSent;
+		netMetrics.bytesSent += length;
+	}
+#endif
 }
 
 
@@ -1616,6 +1641,9 @@ void NET_Shutdown( void ) {
 	}
 
 	NET_Config( qfalse );
+#ifdef CMOD_METRICS_ENDPOINT
+	NET_Metrics_Close();
+#endif
 
 #ifdef _WIN32
 	WSACleanup();
@@ -1643,6 +1671,10 @@ void NET_Event(fd_set *fdr)
 
 		if(NET_GetPacket(&from, &netmsg, fdr))
 		{
+#ifdef CMOD_METRICS_ENDPOINT
+			++netMetrics.packetsReceived;
+			netMetrics.bytesReceived += netmsg.cursize;
+#endif
 			if(net_dropsim->value > 0.0f && net_dropsim->value <= 100.0f)
 			{
 				// com_dropsim->value percent of incoming packets get dropped.
@@ -1660,6 +1692,378 @@ void NET_Event(fd_set *fdr)
 	}
 }
 
+#ifdef CMOD_METRICS_ENDPOINT
+/*
+==============================================================================
+
+METRICS ENDPOINT
+
+Optional TCP listener serving server metrics in Prometheus text format, enabled by setting
+net_metricsPort. The listener and connections are non-blocking and serviced from NET_Sleep,
+so a slow or stalled scraper never holds up the frame. The listener binds to
+net_metricsAddress, which defaults to localhost so the endpoint is only reachable through a
+local collection agent unless explicitly configured otherwise.
+
+Requests for any path other than "/" or "/metrics" get a 404 response. The connection is
+closed after each response.
+
+==============================================================================
+*/
+
+#define METRICS_MAX_CONNECTIONS 4
+#define METRICS_REQUEST_SIZE 2048
+#define METRICS_RESPONSE_SIZE 262144
+#define METRICS_TIMEOUT 5000
+
+#ifdef MSG_NOSIGNAL
+#define METRICS_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define METRICS_SEND_FLAGS 0
+#endif
+
+typedef struct {
+	qboolean active;
+	SOCKET socket;
+	int startTime;
+	char request[METRICS_REQUEST_SIZE];
+	int requestLength;
+	char *response;		// null until request is complete
+	int responseLength;
+	int responseSent;
+} metricsConnection_t;
+
+static struct {
+	qboolean listening;
+	SOCKET listenSocket;
+	int port;						// settings of current listener, to detect changes
+	char address[64];
+	metricsConnection_t connections[METRICS_MAX_CONNECTIONS];
+} metrics;
+
+/*
+====================
+NET_Metrics_CloseConnection
+====================
+*/
+static void NET_Metrics_CloseConnection( metricsConnection_t *conn ) {
+	closesocket( conn->socket );
+	if ( conn->response ) {
+		Z_Free( conn->response );
+	}
+	Com_Memset( conn, 0, sizeof( *conn ) );
+}
+
+/*
+====================
+NET_Metrics_Close
+
+Closes listener and all connections.
+====================
+*/
+static void NET_Metrics_Close( void ) {
+	int i;
+
+	for ( i = 0; i < METRICS_MAX_CONNECTIONS; ++i ) {
+		if ( metrics.connections[i].active ) {
+			NET_Metrics_CloseConnection( &metrics.connections[i] );
+		}
+	}
+	if ( metrics.listening ) {
+		closesocket( metrics.listenSocket );
+		metrics.listening = qfalse;
+	}
+	metrics.port = 0;
+	metrics.address[0] = '\0';
+}
+
+/*
+====================
+NET_Metrics_OpenListener
+====================
+*/
+static void NET_Metrics_OpenListener( int port, const char *addressString ) {
+	struct sockaddr_in address;
+	ioctlarg_t _true = 1;
+	int reuse = 1;
+	SOCKET newsocket;
+
+	Com_Printf( "Opening metrics endpoint: %s:%i\n", addressString, port );
+
+	Com_Memset( &address, 0, sizeof( address ) );
+	if ( !Sys_StringToSockaddr( addressString, (struct sockaddr *)&address, sizeof( address ), AF_INET ) ) {
+		Com_Printf( "WARNING: NET_Metrics_OpenListener: invalid address %s\n", addressString );
+		return;
+	}
+	address.sin_port = htons( (unsigned short)port );
+
+	if ( ( newsocket = socket( PF_INET, SOCK_STREAM, IPPROTO_TCP ) ) == INVALID_SOCKET ) {
+		Com_Printf( "WARNING: NET_Metrics_OpenListener: socket: %s\n", NET_ErrorString() );
+		return;
+	}
+
+	if ( ioctlsocket( newsocket, FIONBIO, &_true ) == SOCKET_ERROR ) {
+		Com_Printf( "WARNING: NET_Metrics_OpenListener: ioctl FIONBIO: %s\n", NET_ErrorString() );
+		closesocket( newsocket );
+		return;
+	}
+
+	setsockopt( newsocket, SOL_SOCKET, SO_REUSEADDR, (char *)&reuse, sizeof( reuse ) );
+
+	if ( bind( newsocket, (struct sockaddr *)&address, sizeof( address ) ) == SOCKET_ERROR ) {
+		Com_Printf( "WARNING: NET_Metrics_OpenListener: bind: %s\n", NET_ErrorString() );
+		closesocket( newsocket );
+		return;
+	}
+
+	if ( listen( newsocket, METRICS_MAX_CONNECTIONS ) == SOCKET_ERROR ) {
+		Com_Printf( "WARNING: NET_Metrics_OpenListener: listen: %s\n", NET_ErrorString() );
+		closesocket( newsocket );
+		return;
+	}
+
+	metrics.listenSocket = newsocket;
+	metrics.listening = qtrue;
+}
+
+/*
+====================
+NET_Metrics_UpdateListener
+
+Opens or closes the listener if settings changed.
+====================
+*/
+static void NET_Metrics_UpdateListener( void ) {
+	int port = net_metricsPort->integer;
+
+	if ( port < 0 || port > 65535 ) {
+		port = 0;
+	}
+	if ( port == metrics.port && !strcmp( net_metricsAddress->string, metrics.address ) ) {
+		return;
+	}
+
+	NET_Metrics_Close();
+	if ( port ) {
+		NET_Metrics_OpenListener( port, net_metricsAddress->string );
+	}
+
+	// record settings even on failure, to avoid retrying every frame
+	metrics.port = port;
+	Q_strncpyz( metrics.address, net_metricsAddress->string, sizeof( metrics.address ) );
+}
+
+/*
+====================
+NET_Metrics_Printf
+====================
+*/
+static void QDECL NET_Metrics_Printf( cmod_stream_t *stream, const char *fmt, ... ) Q_PRINTF_FUNC( 2, 3 );
+static void QDECL NET_Metrics_Printf( cmod_stream_t *stream, const char *fmt, ... ) {
+	va_list argptr;
+	char buffer[1024];
+
+	va_start( argptr, fmt );
+	Q_vsnprintf( buffer, sizeof( buffer ), fmt, argptr );
+	va_end( argptr );
+
+	cmod_stream_append_string( stream, buffer );
+}
+
+/*
+====================
+NET_Metrics_BuildResponse
+====================
+*/
+static void NET_Metrics_BuildResponse( metricsConnection_t *conn ) {
+	cmod_stream_t stream;
+
+	conn->response = (char *)Z_Malloc( METRICS_RESPONSE_SIZE );
+	stream.data = conn->response;
+	stream.position = 0;
+	stream.size = METRICS_RESPONSE_SIZE;
+	stream.overflowed = qfalse;
+
+	if ( !Q_strncmp( conn->request, "GET / ", 6 ) || !Q_strncmp( conn->request, "GET /metrics ", 13 ) ) {
+		cmod_stream_append_string( &stream, "HTTP/1.0 200 OK\r\n"
+				"Content-Type: text/plain; version=0.0.4\r\nConnection: close\r\n\r\n" );
+		SV_Metrics_Write( &stream );
+		NET_Metrics_Printf( &stream, "# HELP cmod_packets_received_total UDP packets received.\n"
+				"# TYPE cmod_packets_received_total counter\ncmod_packets_received_total %lld\n",
+				(long long)netMetrics.packetsReceived );
+		NET_Metrics_Printf( &stream, "# HELP cmod_packets_sent_total UDP packets sent.\n"
+				"# TYPE cmod_packets_sent_total counter\ncmod_packets_sent_total %lld\n",
+				(long long)netMetrics.packetsSent );
+		NET_Metrics_Printf( &stream, "# HELP cmod_received_bytes_total UDP bytes received.\n"
+				"# TYPE cmod_received_bytes_total counter\ncmod_received_bytes_total %lld\n",
+				(long long)netMetrics.bytesReceived );
+		NET_Metrics_Printf( &stream, "# HELP cmod_sent_bytes_total UDP bytes sent.\n"
+				"# TYPE cmod_sent_bytes_total counter\ncmod_sent_bytes_total %lld\n",
+				(long long)netMetrics.bytesSent );
+		if ( stream.overflowed ) {
+			Com_Printf( "WARNING: Metrics response truncated\n" );
+		}
+	} else {
+		cmod_stream_append_string( &stream, "HTTP/1.0 404 Not Found\r\n"
+				"Content-Type: text/plain\r\nConnection: close\r\n\r\nNot Found\n" );
+	}
+
+	conn->responseLength = stream.position;
+}
+
+/*
+====================
+NET_Metrics_Read
+
+Returns qfalse if connection should be closed.
+====================
+*/
+static qboolean NET_Metrics_Read( metricsConnection_t *conn ) {
+	int ret = recv( conn->socket, conn->request + conn->requestLength,
+			METRICS_REQUEST_SIZE - 1 - conn->requestLength, 0 );
+
+	if ( ret == SOCKET_ERROR ) {
+		return socketError == EAGAIN ? qtrue : qfalse;
+	}
+	if ( ret == 0 ) {
+		return qfalse;
+	}
+
+	conn->requestLength += ret;
+	conn->request[conn->requestLength] = '\0';
+	if ( strstr( conn->request, "\r\n\r\n" ) || strstr( conn->request, "\n\n" ) ||
+			conn->requestLength >= METRICS_REQUEST_SIZE - 1 ) {
+		NET_Metrics_BuildResponse( conn );
+	}
+	return qtrue;
+}
+
+/*
+====================
+NET_Metrics_Write
+
+Returns qfalse if connection should be closed.
+====================
+*/
+static qboolean NET_Metrics_Write( metricsConnection_t *conn ) {
+	int ret = send( conn->socket, conn->response + conn->responseSent,
+			conn->responseLength - conn->responseSent, METRICS_SEND_FLAGS );
+
+	if ( ret == SOCKET_ERROR ) {
+		return socketError == EAGAIN ? qtrue : qfalse;
+	}
+	conn->responseSent += ret;
+	return conn->responseSent < conn->responseLength ? qtrue : qfalse;
+}
+
+/*
+====================
+NET_Metrics_Accept
+====================
+*/
+static void NET_Metrics_Accept( void ) {
+	ioctlarg_t _true = 1;
+	SOCKET newsocket;
+	int i;
+
+	newsocket = accept( metrics.listenSocket, NULL, NULL );
+	if ( newsocket == INVALID_SOCKET ) {
+		return;
+	}
+
+	for ( i = 0; i < METRICS_MAX_CONNECTIONS; ++i ) {
+		if ( !metrics.connections[i].active ) {
+			break;
+		}
+	}
+	if ( i == METRICS_MAX_CONNECTIONS || ioctlsocket( newsocket, FIONBIO, &_true ) == SOCKET_ERROR ) {
+		closesocket( newsocket );
+		return;
+	}
+
+#ifdef SO_NOSIGPIPE
+	setsockopt( newsocket, SOL_SOCKET, SO_NOSIGPIPE, (char *)&_true, sizeof( _true ) );
+#endif
+
+	metrics.connections[i].active = qtrue;
+	metrics.connections[i].socket = newsocket;
+	metrics.connections[i].startTime = Sys_Milliseconds();
+}
+
+/*
+====================
+NET_Metrics_AddSockets
+
+Adds metrics sockets to select() sets.
+====================
+*/
+static void NET_Metrics_AddSockets( fd_set *fdr, fd_set *fdw, SOCKET *highestfd ) {
+	int i;
+
+	NET_Metrics_UpdateListener();
+	if ( !metrics.listening ) {
+		return;
+	}
+
+	FD_SET( metrics.listenSocket, fdr );
+	if ( *highestfd == INVALID_SOCKET || metrics.listenSocket > *highestfd ) {
+		*highestfd = metrics.listenSocket;
+	}
+
+	for ( i = 0; i < METRICS_MAX_CONNECTIONS; ++i ) {
+		metricsConnection_t *conn = &metrics.connections[i];
+		if ( !conn->active ) {
+			continue;
+		}
+		FD_SET( conn->socket, conn->response ? fdw : fdr );
+		if ( conn->socket > *highestfd ) {
+			*highestfd = conn->socket;
+		}
+	}
+}
+
+/*
+====================
+NET_Metrics_Event
+
+Services metrics sockets after select().
+====================
+*/
+static void NET_Metrics_Event( fd_set *fdr, fd_set *fdw ) {
+	int time = Sys_Milliseconds();
+	int i;
+
+	if ( !metrics.listening ) {
+		return;
+	}
+
+	for ( i = 0; i < METRICS_MAX_CONNECTIONS; ++i ) {
+		metricsConnection_t *conn = &metrics.connections[i];
+		qboolean keep = qtrue;
+		if ( !conn->active ) {
+			continue;
+		}
+
+		if ( !conn->response && FD_ISSET( conn->socket, fdr ) ) {
+			keep = NET_Metrics_Read( conn );
+			if ( keep && conn->response ) {
+				// most responses fit in the socket buffer, so try sending right away
+				keep = NET_Metrics_Write( conn );
+			}
+		} else if ( conn->response && FD_ISSET( conn->socket, fdw ) ) {
+			keep = NET_Metrics_Write( conn );
+		}
+
+		if ( !keep || time - conn->startTime > METRICS_TIMEOUT ) {
+			NET_Metrics_CloseConnection( conn );
+		}
+	}
+
+	if ( FD_ISSET( metrics.listenSocket, fdr ) ) {
+		NET_Metrics_Accept();
+	}
+}
+#endif
+
 /*
 ====================
 NET_Sleep
@@ -1667,12 +2071,19 @@ NET_Sleep
 Sleeps msec or until something happens on the network
 ====================
 */
+#ifdef CMOD_SERVER_FRAME_SCHEDULER
+static void NET_SleepInternal(int msec, int extraFd)
+#else
 void NET_Sleep(int msec)
+#endif
 {
 	struct timeval timeout;
 	fd_set fdr;
 	int retval;
 	SOCKET highestfd = INVALID_SOCKET;
+#ifdef CMOD_METRICS_ENDPOINT
+	fd_set fdw;
+#endif
 
 	if(msec < 0)
 		msec = 0;
@@ -1693,6 +2104,21 @@ void NET_Sleep(int msec)
 			highestfd = ip6_socket;
 	}
 
+#ifdef CMOD_METRICS_ENDPOINT
+	FD_ZERO(&fdw);
+	NET_Metrics_AddSockets(&fdr, &fdw, &highestfd);
+#endif
+
+#ifdef CMOD_SERVER_FRAME_SCHEDULER
+	if(extraFd >= 0)
+	{
+		FD_SET(extraFd, &fdr);
+
+		if(highestfd == INVALID_SOCKET || extraFd > highestfd)
+			highestfd = extraFd;
+	}
+#endif
+
 #ifdef _WIN32
 	if(highestfd == INVALID_SOCKET)
 	{
@@ -1705,14 +2131,47 @@ void NET_Sleep(int msec)
 	timeout.tv_sec = msec/1000;
 	timeout.tv_usec = (msec%1000)*1000;
 
+#ifdef CMOD_METRICS_ENDPOINT
+	retval = select(highestfd + 1, &fdr, &fdw, NULL, &timeout);
+#else
 	retval = select(highestfd + 1, &fdr, NULL, NULL, &timeout);
+#endif
 
 	if(retval == SOCKET_ERROR)
 		Com_Printf("Warning: select() syscall failed: %s\n", NET_ErrorString());
 	else if(retval > 0)
+	{
+#ifdef CMOD_METRICS_ENDPOINT
+		NET_Metrics_Event(&fdr, &fdw);
+#endif
 		NET_Event(&fdr);
+	}
 }
 
+#ifdef CMOD_SERVER_FRAME_SCHEDULER
+/*
+====================
+NET_Sleep
+====================
+*/
+void NET_Sleep(int msec)
+{
+	NET_SleepInternal(msec, -1);
+}
+
+/*
+====================
+NET_SleepFd
+
+Sleeps up to msec, or until something happens on the network or fd becomes readable.
+====================
+*/
+void NET_SleepFd(int msec, int fd)
+{
+	NET_SleepInternal(msec, fd);
+}
+#endif
+
 /*
 ====================
 NET_Restart_f
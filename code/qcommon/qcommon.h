@@ -167,7 +167,10 @@ typedef enum {
 	NA_IP,
 	NA_IP6,
 	NA_MULTICAST6,
-	NA_UNSPEC
+	NA_UNSPEC,
+#ifdef CMOD_RECORD_REPLAY
+	NA_REPLAY,					// record replay client; packets are discarded
+#endif
 } netadrtype_t;
 
 typedef enum {
@@ -206,6 +209,9 @@ qboolean	NET_GetLoopPacket (netsrc_t sock, netadr_t *net_from, msg_t *net_messag
 void		NET_JoinMulticast6(void);
 void		NET_LeaveMulticast6(void);
 void		NET_Sleep(int msec);
+#ifdef CMOD_SERVER_FRAME_SCHEDULER
+void		NET_SleepFd(int msec, int fd);
+#endif
 
 
 #define	MAX_MSGLEN				16384		// max length of a message, which may
@@ -1157,6 +1163,37 @@ void SV_PacketEvent( netadr_t from, msg_t *msg );
 int SV_FrameMsec(void);
 qboolean SV_GameCommand( void );
 int SV_SendQueuedPackets(void);
+#ifdef CMOD_SERVER_BENCHMARK
+qboolean SV_Benchmark_Running( void );
+int SV_Benchmark_FrameMsec( void );
+void SV_Benchmark_StartFrame( void );
+void SV_Benchmark_EndNetworkPhase( void );
+void SV_Benchmark_EndFrame( void );
+#endif
+#ifdef CMOD_SERVER_FRAME_SCHEDULER
+qboolean SV_Scheduler_Active( void );
+void SV_Scheduler_Wait( qboolean busyWait );
+int SV_Scheduler_FrameMsec( int msec );
+void SV_Scheduler_RecordFrameStart( qboolean precise );
+#endif
+#ifdef CMOD_SERVER_HITCH_LOG
+typedef enum {
+	SV_HITCH_PHASE_NETWORK,
+	SV_HITCH_PHASE_COMMANDS,
+	SV_HITCH_PHASE_BOTS,
+	SV_HITCH_PHASE_GAME,
+	SV_HITCH_PHASE_SNAPSHOTS,
+	SV_HITCH_PHASE_RECORD,
+	SV_HITCH_PHASE_FILEIO,
+	SV_HITCH_PHASE_COUNT
+} svHitchPhase_t;
+
+extern qboolean svHitchActive;
+void SV_Hitch_BeginFrame( void );
+void SV_Hitch_EndFrame( void );
+void SV_Hitch_RecordPhase( svHitchPhase_t phase, int64_t start );
+void QDECL SV_Hitch_Note( const char *fmt, ... ) Q_PRINTF_FUNC( 1, 2 );
+#endif
 
 //
 // UI interface
@@ -879,6 +879,10 @@ intptr_t QDECL VM_Call( vm_t *vm, int callnum, ... )
 	}
 
 	++vm->callLevel;
+#ifdef CMOD_FRAME_TRACE
+	// vm names are stored in vmTable, so they stay valid for the trace dump
+	CMTRACE_BEGIN( vm->name );
+#endif
 	// if we have a dll loaded, call it directly
 	if ( vm->entryPoint ) {
 		//rcg010207 -  see dissertation at top of VM_DllSyscall() in this file.
@@ -922,6 +926,9 @@ intptr_t QDECL VM_Call( vm_t *vm, int callnum, ... )
 			r = VM_CallInterpreted( vm, &a.callnum );
 #endif
 	}
+#ifdef CMOD_FRAME_TRACE
+	CMTRACE_END();
+#endif
 	--vm->callLevel;
 
 	if ( oldVM != NULL )
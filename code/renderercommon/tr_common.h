@@ -131,6 +131,32 @@ void  R_NoiseInit( void );
 
 image_t     *R_FindImageFile( const char *name, imgType_t type, imgFlags_t flags );
 image_t *R_CreateImage( const char *name, byte *pic, int width, int height, imgType_t type, imgFlags_t flags, int internalFormat );
+#ifdef CMOD_PARALLEL_IMAGE_LOAD
+extern cvar_t *r_parallelImageLoad;
+
+typedef struct imageJob_s {
+	void ( *process )( struct imageJob_s *job );	// called on image loader thread
+	void ( *finish )( struct imageJob_s *job );		// called on render thread after processing
+	struct imageJob_s *next;
+} imageJob_t;
+
+image_t *R_CreateImageDeferred( const char *name, byte *pic, int width, int height, imgType_t type, imgFlags_t flags );
+qboolean R_ImageJobs_Active( void );
+void R_ImageJobs_Queue( imageJob_t *job );
+void R_ImageJobs_Poll( void );
+void R_ImageJobs_Flush( void );
+void R_ImageJobs_Init( void );
+void R_ImageJobs_Shutdown( void );
+#endif
+
+#ifdef CMOD_IMAGE_SIMD
+#include "../cmod/cmod_image_simd.h"
+
+extern cvar_t *r_imageSimd;
+extern imageSimdKernels_t imageSimdKernels;
+void R_ImageSimd_Select( void );
+void R_ImageSimd_Benchmark_f( void );
+#endif
 
 void R_IssuePendingRenderCommands( void );
 qhandle_t		 RE_RegisterShaderLightMap( const char *name, int lightmapIndex );
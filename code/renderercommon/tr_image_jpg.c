@@ -50,6 +50,10 @@ typedef struct q_jpeg_error_mgr_s
   struct jpeg_error_mgr pub;  /* "public" fields */
 
   jmp_buf setjmp_buffer;  /* for return to caller */
+#ifdef CMOD_ASYNC_VIDEO_CAPTURE
+  char *errorText;  /* if set, errors are stored here instead of printed */
+  int errorTextSize;
+#endif
 } q_jpeg_error_mgr_t;
 
 static void R_JPGErrorExit(j_common_ptr cinfo)
@@ -61,6 +65,12 @@ static void R_JPGErrorExit(j_common_ptr cinfo)
   
   (*cinfo->err->format_message) (cinfo, buffer);
 
+#ifdef CMOD_ASYNC_VIDEO_CAPTURE
+  if (jerr->errorText) {
+    Q_strncpyz(jerr->errorText, buffer, jerr->errorTextSize);
+    longjmp(jerr->setjmp_buffer, 1);
+  }
+#endif
   ri.Printf(PRINT_ALL, "Error: %s", buffer);
 
   /* Return control to the setjmp point */
@@ -70,6 +80,12 @@ static void R_JPGErrorExit(j_common_ptr cinfo)
 static void R_JPGOutputMessage(j_common_ptr cinfo)
 {
   char buffer[JMSG_LENGTH_MAX];
+
+#ifdef CMOD_ASYNC_VIDEO_CAPTURE
+  if (((q_jpeg_error_mgr_t *)cinfo->err)->errorText) {
+    return;
+  }
+#endif
   
   /* Create the message */
   (*cinfo->err->format_message) (cinfo, buffer);
@@ -131,6 +147,9 @@ void R_LoadJPG(const char *filename, unsigned char **pic, int *width, int *heigh
   cinfo.err = jpeg_std_error(&jerr.pub);
   cinfo.err->error_exit = R_JPGErrorExit;
   cinfo.err->output_message = R_JPGOutputMessage;
+#ifdef CMOD_ASYNC_VIDEO_CAPTURE
+  jerr.errorText = NULL;
+#endif
 
   /* Establish the setjmp return context for R_JPGErrorExit to use. */
   if (setjmp(jerr.setjmp_buffer))
@@ -321,6 +340,15 @@ static boolean
 empty_output_buffer (j_compress_ptr cinfo)
 {
   my_dest_ptr dest = (my_dest_ptr) cinfo->dest;
+
+#ifdef CMOD_ASYNC_VIDEO_CAPTURE
+  q_jpeg_error_mgr_t *jerr = (q_jpeg_error_mgr_t *)cinfo->err;
+  if (jerr->errorText) {
+    Com_sprintf(jerr->errorText, jerr->errorTextSize,
+        "Output buffer for encoded JPEG image has insufficient size of %d bytes", dest->size);
+    longjmp(jerr->setjmp_buffer, 1);
+  }
+#endif
   
   jpeg_destroy_compress(cinfo);
   
@@ -384,8 +412,14 @@ Encodes JPEG from image in image_buffer and writes to buffer.
 Expects RGB input data
 =================
 */
+#ifdef CMOD_ASYNC_VIDEO_CAPTURE
+static size_t R_SaveJPGToBufferInternal(byte *buffer, size_t bufSize, int quality,
+    int image_width, int image_height, byte *image_buffer, int padding,
+    char *errorText, int errorTextSize)
+#else
 size_t RE_SaveJPGToBuffer(byte *buffer, size_t bufSize, int quality,
     int image_width, int image_height, byte *image_buffer, int padding)
+#endif
 {
   struct jpeg_compress_struct cinfo;
   q_jpeg_error_mgr_t jerr;
@@ -398,6 +432,10 @@ size_t RE_SaveJPGToBuffer(byte *buffer, size_t bufSize, int quality,
   cinfo.err = jpeg_std_error(&jerr.pub);
   cinfo.err->error_exit = R_JPGErrorExit;
   cinfo.err->output_message = R_JPGOutputMessage;
+#ifdef CMOD_ASYNC_VIDEO_CAPTURE
+  jerr.errorText = errorText;
+  jerr.errorTextSize = errorTextSize;
+#endif
 
   /* Establish the setjmp return context for R_JPGErrorExit to use. */
   if (setjmp(jerr.setjmp_buffer))
@@ -407,6 +445,11 @@ size_t RE_SaveJPGToBuffer(byte *buffer, size_t bufSize, int quality,
      */
     jpeg_destroy_compress(&cinfo);
 
+#ifdef CMOD_ASYNC_VIDEO_CAPTURE
+    if (errorText) {
+      return 0;
+    }
+#endif
     ri.Printf(PRINT_ALL, "\n");
     return 0;
   }
@@ -461,6 +504,32 @@ size_t RE_SaveJPGToBuffer(byte *buffer, size_t bufSize, int quality,
   return outcount;
 }
 
+#ifdef CMOD_ASYNC_VIDEO_CAPTURE
+size_t RE_SaveJPGToBuffer(byte *buffer, size_t bufSize, int quality,
+    int image_width, int image_height, byte *image_buffer, int padding)
+{
+  return R_SaveJPGToBufferInternal(buffer, bufSize, quality, image_width, image_height,
+      image_buffer, padding, NULL, 0);
+}
+
+/*
+=================
+RE_SaveJPGToBufferThreaded
+
+Same as RE_SaveJPGToBuffer, but safe to call from worker threads. Errors are written to
+errorText instead of printed or raised, and 0 is returned.
+=================
+*/
+size_t RE_SaveJPGToBufferThreaded(byte *buffer, size_t bufSize, int quality,
+    int image_width, int image_height, byte *image_buffer, int padding,
+    char *errorText, int errorTextSize)
+{
+  errorText[0] = '\0';
+  return R_SaveJPGToBufferInternal(buffer, bufSize, quality, image_width, image_height,
+      image_buffer, padding, errorText, errorTextSize);
+}
+#endif
+
 void RE_SaveJPG(char * filename, int quality, int image_width, int image_height, byte *image_buffer, int padding)
 {
   byte *out;
@@ -115,6 +115,10 @@ typedef struct {
 	qboolean (*inPVS)( const vec3_t p1, const vec3_t p2 );
 
 	void (*TakeVideoFrame)( int h, int w, byte* captureBuffer, byte *encodeBuffer, qboolean motionJpeg );
+#ifdef CMOD_ASYNC_VIDEO_CAPTURE
+	// write out any video frames still being processed; may be NULL
+	void (*FlushVideoFrames)( void );
+#endif
 } refexport_t;
 
 //
@@ -204,6 +208,16 @@ typedef struct {
 	const char *(*FS_GetFileExtension)( const fsc_file_t *file );
 	qboolean (*FS_CheckFilesFromSamePk3)( const fsc_file_t *file1, const fsc_file_t *file2 );
 #endif
+#if defined(CMOD_ASYNC_VIDEO_CAPTURE) || defined(CMOD_PARALLEL_IMAGE_LOAD)
+	struct cmThread_s *(*Thread_Create)( void ( *func )( void *arg ), void *arg );
+	void	(*Thread_Join)( struct cmThread_s *thread );
+	int		(*Thread_ProcessorCount)( void );
+#endif
+#ifdef CMOD_FRAME_TRACE
+	// span name must be a static string
+	void	(*Trace_BeginSpan)( const char *name );
+	void	(*Trace_EndSpan)( void );
+#endif
 } refimport_t;
 
 
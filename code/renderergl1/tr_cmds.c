@@ -78,6 +78,11 @@ R_IssueRenderCommands
 void R_IssueRenderCommands( qboolean runPerformanceCounters ) {
 	renderCommandList_t	*cmdList;
 
+#ifdef CMOD_PARALLEL_IMAGE_LOAD
+	// finish uploading any images still being processed
+	R_ImageJobs_Flush();
+#endif
+
 	cmdList = &backEndData->commands;
 	assert(cmdList);
 	// add an end-of-list command
@@ -35,7 +35,9 @@ static	image_t*		hashTable[FILE_HASH_SIZE];
 ** R_GammaCorrect
 */
 void R_GammaCorrect( byte *buffer, int bufSize ) {
+#ifndef CMOD_IMAGE_SIMD
 	int i;
+#endif
 
 #ifdef CMOD_FRAMEBUFFER
 	if ( tr.framebuffer_active ) {
@@ -44,9 +46,13 @@ void R_GammaCorrect( byte *buffer, int bufSize ) {
 	}
 #endif
 
+#ifdef CMOD_IMAGE_SIMD
+	imageSimdKernels.remapBytes( buffer, bufSize, s_gammatable );
+#else
 	for ( i = 0; i < bufSize; i++ ) {
 		buffer[i] = s_gammatable[buffer[i]];
 	}
+#endif
 }
 
 typedef struct {
@@ -306,7 +312,11 @@ before or after.
 */
 static void ResampleTexture( unsigned *in, int inwidth, int inheight, unsigned *out,  
 							int outwidth, int outheight ) {
+#ifdef CMOD_IMAGE_SIMD
+	int		i;
+#else
 	int		i, j;
+#endif
 	unsigned	*inrow, *inrow2;
 	unsigned	frac, fracstep;
 #ifdef CMOD_INCREASE_MAX_TEXTURE_SIZE
@@ -314,7 +324,9 @@ static void ResampleTexture( unsigned *in, int inwidth, int inheight, unsigned *
 #else
 	unsigned	p1[2048], p2[2048];
 #endif
+#ifndef CMOD_IMAGE_SIMD
 	byte		*pix1, *pix2, *pix3, *pix4;
+#endif
 
 #ifdef CMOD_INCREASE_MAX_TEXTURE_SIZE
 	if (outwidth>16384)
@@ -339,6 +351,10 @@ static void ResampleTexture( unsigned *in, int inwidth, int inheight, unsigned *
 	for (i=0 ; i<outheight ; i++, out += outwidth) {
 		inrow = in + inwidth*(int)((i+0.25)*inheight/outheight);
 		inrow2 = in + inwidth*(int)((i+0.75)*inheight/outheight);
+#ifdef CMOD_IMAGE_SIMD
+		imageSimdKernels.resampleRow( (byte *)out, (const byte *)inrow, (const byte *)inrow2,
+				(const int *)p1, (const int *)p2, outwidth );
+#else
 		for (j=0 ; j<outwidth ; j++) {
 			pix1 = (byte *)inrow + p1[j];
 			pix2 = (byte *)inrow + p2[j];
@@ -349,6 +365,7 @@ static void ResampleTexture( unsigned *in, int inwidth, int inheight, unsigned *
 			((byte *)(out+j))[2] = (pix1[2] + pix2[2] + pix3[2] + pix4[2])>>2;
 			((byte *)(out+j))[3] = (pix1[3] + pix2[3] + pix3[3] + pix4[3])>>2;
 		}
+#endif
 	}
 }
 
@@ -362,6 +379,32 @@ lighting range
 */
 void R_LightScaleTexture (unsigned *in, int inwidth, int inheight, qboolean only_gamma )
 {
+#ifdef CMOD_IMAGE_SIMD
+	// combine the lookups into one table, which gives the same result as applying them in order
+	byte	table[256];
+	int		i;
+
+	if ( only_gamma && glConfig.deviceSupportsGamma
+#ifdef CMOD_TEXTURE_GAMMA
+			&& r_textureGamma->value == 1.0f
+#endif
+			) {
+		return;
+	}
+
+	for ( i = 0; i < 256; i++ ) {
+		if ( only_gamma )
+			table[i] = glConfig.deviceSupportsGamma ? i : s_gammatable[i];
+		else
+			table[i] = glConfig.deviceSupportsGamma ? s_intensitytable[i] : s_gammatable[s_intensitytable[i]];
+#ifdef CMOD_TEXTURE_GAMMA
+		if ( r_textureGamma->value != 1.0f )
+			table[i] = 255.0 * pow( table[i]/255.0f, 1.0f/r_textureGamma->value );
+#endif
+	}
+
+	imageSimdKernels.remapRGB( (byte *)in, inwidth * inheight, table );
+#else
 	if ( only_gamma )
 	{
 		if ( !glConfig.deviceSupportsGamma )
@@ -424,6 +467,7 @@ void R_LightScaleTexture (unsigned *in, int inwidth, int inheight, qboolean only
 		}
 	}
 #endif
+#endif
 }
 
 
@@ -436,17 +480,27 @@ Proper linear filter
 ================
 */
 static void R_MipMap2( unsigned *in, int inWidth, int inHeight ) {
+#ifndef CMOD_IMAGE_SIMD
 	int			i, j, k;
 	byte		*outpix;
 	int			inWidthMask, inHeightMask;
 	int			total;
+#endif
 	int			outWidth, outHeight;
 	unsigned	*temp;
 
 	outWidth = inWidth >> 1;
 	outHeight = inHeight >> 1;
+#ifdef CMOD_PARALLEL_IMAGE_LOAD
+	// use malloc since this can run on image loader threads
+	temp = malloc( outWidth * outHeight * 4 );
+#else
 	temp = ri.Hunk_AllocateTempMemory( outWidth * outHeight * 4 );
+#endif
 
+#ifdef CMOD_IMAGE_SIMD
+	imageSimdKernels.mipMapFilter( (byte *)temp, (const byte *)in, inWidth, inHeight );
+#else
 	inWidthMask = inWidth - 1;
 	inHeightMask = inHeight - 1;
 
@@ -478,9 +532,14 @@ static void R_MipMap2( unsigned *in, int inWidth, int inHeight ) {
 			}
 		}
 	}
+#endif
 
 	Com_Memcpy( in, temp, outWidth * outHeight * 4 );
+#ifdef CMOD_PARALLEL_IMAGE_LOAD
+	free( temp );
+#else
 	ri.Hunk_FreeTempMemory( temp );
+#endif
 }
 
 /*
@@ -491,10 +550,14 @@ Operates in place, quartering the size of the texture
 ================
 */
 static void R_MipMap (byte *in, int width, int height) {
+#ifdef CMOD_IMAGE_SIMD
+	int		i;
+#else
 	int		i, j;
+#endif
 	byte	*out;
 	int		row;
-#ifdef CMOD_SUPPORT_NON_POWER_OF_TWO_TEXTURES
+#if defined(CMOD_SUPPORT_NON_POWER_OF_TWO_TEXTURES) && !defined(CMOD_IMAGE_SIMD)
 	byte	*inrow = in;
 #endif
 
@@ -523,6 +586,11 @@ static void R_MipMap (byte *in, int width, int height) {
 		return;
 	}
 
+#ifdef CMOD_IMAGE_SIMD
+	// same as the loop below with CMOD_SUPPORT_NON_POWER_OF_TWO_TEXTURES, which is also
+	// equivalent for power of two sizes
+	imageSimdKernels.mipMapBox( out, in, width, height, row );
+#else
 #ifdef CMOD_SUPPORT_NON_POWER_OF_TWO_TEXTURES
 	for (i=0 ; i<height ; i++, inrow +=row* 2) {
 		for (in = inrow, j=0 ; j<width ; j++, out+=4, in+=8) {
@@ -536,6 +604,7 @@ static void R_MipMap (byte *in, int width, int height) {
 			out[3] = (in[3] + in[7] + in[row+3] + in[row+7])>>2;
 		}
 	}
+#endif
 }
 
 
@@ -587,6 +656,87 @@ byte	mipBlendColors[16][4] = {
 void R_ColorShiftLightingBytes( byte in[4], byte out[4], qboolean external );
 #endif
 
+#ifdef CMOD_PARALLEL_IMAGE_LOAD
+#define MAX_DEFERRED_LEVELS 32
+
+typedef struct {
+	int level;
+	int width;
+	int height;
+	byte *data;
+} deferredLevel_t;
+
+typedef struct {
+	imageJob_t job;
+	image_t *image;
+	byte *pic;
+	qboolean isLightmap;
+	int glWrapClampMode;
+
+	// upload results, set on loader thread
+	int internalFormat;
+	int uploadWidth;
+	int uploadHeight;
+	int numLevels;
+	deferredLevel_t levels[MAX_DEFERRED_LEVELS];
+} imageUploadJob_t;
+
+/*
+================
+R_TexImage
+
+Uploads texture level, or saves a copy to be uploaded later if deferred is set.
+================
+*/
+static void R_TexImage( imageUploadJob_t *deferred, int level, GLenum internalFormat,
+		int width, int height, const void *data ) {
+	if ( deferred ) {
+		deferredLevel_t *out;
+		if ( deferred->numLevels >= MAX_DEFERRED_LEVELS ) {
+			return;
+		}
+		out = &deferred->levels[deferred->numLevels];
+		out->data = malloc( width * height * 4 );
+		if ( !out->data ) {
+			return;
+		}
+		Com_Memcpy( out->data, data, width * height * 4 );
+		out->level = level;
+		out->width = width;
+		out->height = height;
+		++deferred->numLevels;
+		return;
+	}
+
+	qglTexImage2D( GL_TEXTURE_2D, level, internalFormat, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data );
+}
+
+/*
+================
+R_SetUploadFilter
+================
+*/
+static void R_SetUploadFilter( qboolean mipmap ) {
+	if (mipmap)
+	{
+		if ( textureFilterAnisotropic )
+			qglTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT,
+					(GLint)Com_Clamp( 1, maxAnisotropy, r_ext_max_anisotropy->integer ) );
+
+		qglTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, gl_filter_min);
+		qglTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, gl_filter_max);
+	}
+	else
+	{
+		if ( textureFilterAnisotropic )
+			qglTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, 1 );
+
+		qglTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+		qglTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+	}
+}
+#endif
+
 /*
 ===============
 Upload32
@@ -603,7 +753,11 @@ static void Upload32( unsigned *data,
 #endif
 						  qboolean allowCompression,
 						  int *format, 
-						  int *pUploadWidth, int *pUploadHeight )
+						  int *pUploadWidth, int *pUploadHeight
+#ifdef CMOD_PARALLEL_IMAGE_LOAD
+						  , imageUploadJob_t *deferred
+#endif
+						  )
 {
 	int			samples;
 	unsigned	*scaledBuffer = NULL;
@@ -642,7 +796,11 @@ static void Upload32( unsigned *data,
 #endif
 
 	if ( scaled_width != width || scaled_height != height ) {
+#ifdef CMOD_PARALLEL_IMAGE_LOAD
+		resampledBuffer = malloc( scaled_width * scaled_height * 4 );
+#else
 		resampledBuffer = ri.Hunk_AllocateTempMemory( scaled_width * scaled_height * 4 );
+#endif
 		ResampleTexture (data, width, height, resampledBuffer, scaled_width, scaled_height);
 		data = resampledBuffer;
 		width = scaled_width;
@@ -678,7 +836,11 @@ static void Upload32( unsigned *data,
 		scaled_height >>= 1;
 	}
 
+#ifdef CMOD_PARALLEL_IMAGE_LOAD
+	scaledBuffer = malloc( sizeof( unsigned ) * scaled_width * scaled_height );
+#else
 	scaledBuffer = ri.Hunk_AllocateTempMemory( sizeof( unsigned ) * scaled_width * scaled_height );
+#endif
 
 	//
 	// scan the texture for each channel's max values
@@ -804,7 +966,11 @@ static void Upload32( unsigned *data,
 		( scaled_height == height ) ) {
 		if (!mipmap)
 		{
+#ifdef CMOD_PARALLEL_IMAGE_LOAD
+			R_TexImage( deferred, 0, internalFormat, scaled_width, scaled_height, data );
+#else
 			qglTexImage2D (GL_TEXTURE_2D, 0, internalFormat, scaled_width, scaled_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+#endif
 			*pUploadWidth = scaled_width;
 			*pUploadHeight = scaled_height;
 			*format = internalFormat;
@@ -849,7 +1015,11 @@ static void Upload32( unsigned *data,
 	*pUploadHeight = scaled_height;
 	*format = internalFormat;
 
+#ifdef CMOD_PARALLEL_IMAGE_LOAD
+	R_TexImage( deferred, 0, internalFormat, scaled_width, scaled_height, scaledBuffer );
+#else
 	qglTexImage2D (GL_TEXTURE_2D, 0, internalFormat, scaled_width, scaled_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, scaledBuffer );
+#endif
 
 	if (mipmap)
 	{
@@ -871,11 +1041,25 @@ static void Upload32( unsigned *data,
 				R_BlendOverTexture( (byte *)scaledBuffer, scaled_width * scaled_height, mipBlendColors[miplevel] );
 			}
 
+#ifdef CMOD_PARALLEL_IMAGE_LOAD
+			R_TexImage( deferred, miplevel, internalFormat, scaled_width, scaled_height, scaledBuffer );
+#else
 			qglTexImage2D (GL_TEXTURE_2D, miplevel, internalFormat, scaled_width, scaled_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, scaledBuffer );
+#endif
 		}
 	}
 done:
 
+#ifdef CMOD_PARALLEL_IMAGE_LOAD
+	// filter and error checks are handled when deferred upload is finished
+	if ( !deferred ) {
+		R_SetUploadFilter( mipmap );
+		GL_CheckErrors();
+	}
+
+	free( scaledBuffer );
+	free( resampledBuffer );
+#else
 	if (mipmap)
 	{
 		if ( textureFilterAnisotropic )
@@ -900,6 +1084,7 @@ done:
 		ri.Hunk_FreeTempMemory( scaledBuffer );
 	if ( resampledBuffer != 0 )
 		ri.Hunk_FreeTempMemory( resampledBuffer );
+#endif
 }
 
 
@@ -967,7 +1152,11 @@ image_t *R_CreateImage( const char *name, byte *pic, int width, int height,
 								!(image->flags & IMGFLAG_NO_COMPRESSION),
 								&image->internalFormat,
 								&image->uploadWidth,
-								&image->uploadHeight );
+								&image->uploadHeight
+#ifdef CMOD_PARALLEL_IMAGE_LOAD
+								, NULL
+#endif
+								);
 
 	qglTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, glWrapClampMode );
 	qglTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, glWrapClampMode );
@@ -986,6 +1175,142 @@ image_t *R_CreateImage( const char *name, byte *pic, int width, int height,
 	return image;
 }
 
+#ifdef CMOD_PARALLEL_IMAGE_LOAD
+/*
+================
+R_ImageUploadJob_Process
+
+Runs on image loader thread.
+================
+*/
+static void R_ImageUploadJob_Process( imageJob_t *job ) {
+	imageUploadJob_t *upload = (imageUploadJob_t *)job;
+	image_t *image = upload->image;
+
+	Upload32( (unsigned *)upload->pic, image->width, image->height,
+								image->flags & IMGFLAG_MIPMAP,
+								image->flags & IMGFLAG_PICMIP,
+								upload->isLightmap,
+#ifdef CMOD_EXTERNAL_LIGHTMAP_PROCESSING
+								( image->flags & IMGFLAG_EXTERNAL_LIGHTMAP ) ? qtrue : qfalse,
+#endif
+								!(image->flags & IMGFLAG_NO_COMPRESSION),
+								&upload->internalFormat,
+								&upload->uploadWidth,
+								&upload->uploadHeight,
+								upload );
+}
+
+/*
+================
+R_ImageUploadJob_Finish
+
+Uploads the levels generated by the loader thread.
+================
+*/
+static void R_ImageUploadJob_Finish( imageJob_t *job ) {
+	imageUploadJob_t *upload = (imageUploadJob_t *)job;
+	image_t *image = upload->image;
+	int i;
+
+	image->internalFormat = upload->internalFormat;
+	image->uploadWidth = upload->uploadWidth;
+	image->uploadHeight = upload->uploadHeight;
+
+	if ( qglActiveTextureARB ) {
+		GL_SelectTexture( image->TMU );
+	}
+
+	GL_Bind( image );
+
+	for ( i = 0; i < upload->numLevels; ++i ) {
+		deferredLevel_t *level = &upload->levels[i];
+		qglTexImage2D( GL_TEXTURE_2D, level->level, image->internalFormat, level->width, level->height,
+				0, GL_RGBA, GL_UNSIGNED_BYTE, level->data );
+		free( level->data );
+	}
+
+	R_SetUploadFilter( ( image->flags & IMGFLAG_MIPMAP ) ? qtrue : qfalse );
+	GL_CheckErrors();
+
+	qglTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, upload->glWrapClampMode );
+	qglTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, upload->glWrapClampMode );
+
+	glState.currenttextures[glState.currenttmu] = 0;
+	qglBindTexture( GL_TEXTURE_2D, 0 );
+
+	if ( image->TMU == 1 ) {
+		GL_SelectTexture( 0 );
+	}
+
+	ri.Free( upload->pic );
+	free( upload );
+}
+
+/*
+================
+R_CreateImageDeferred
+
+Same as R_CreateImage, except the image is processed on an image loader thread and uploaded
+later by R_ImageJobs_Poll or R_ImageJobs_Flush. Takes ownership of pic, which must be
+allocated by ri.Malloc. Returns NULL if the image couldn't be queued, in which case the
+caller still owns pic.
+================
+*/
+image_t *R_CreateImageDeferred( const char *name, byte *pic, int width, int height,
+		imgType_t type, imgFlags_t flags ) {
+	image_t		*image;
+	imageUploadJob_t *upload;
+	long		hash;
+
+	if ( strlen( name ) >= MAX_QPATH || tr.numImages == MAX_DRAWIMAGES ) {
+		// let R_CreateImage handle errors
+		return NULL;
+	}
+
+	upload = calloc( 1, sizeof( *upload ) );
+	if ( !upload ) {
+		return NULL;
+	}
+
+	image = tr.images[tr.numImages] = ri.Hunk_Alloc( sizeof( image_t ), h_low );
+	qglGenTextures(1, &image->texnum);
+	tr.numImages++;
+
+	image->type = type;
+	image->flags = flags;
+
+	strcpy (image->imgName, name);
+
+	image->width = width;
+	image->height = height;
+
+	upload->image = image;
+	upload->pic = pic;
+	upload->isLightmap = !strncmp( name, "*lightmap", 9 ) ? qtrue : qfalse;
+	if (flags & IMGFLAG_CLAMPTOEDGE)
+		upload->glWrapClampMode = haveClampToEdge ? GL_CLAMP_TO_EDGE : GL_CLAMP;
+	else
+		upload->glWrapClampMode = GL_REPEAT;
+
+	// lightmaps are always allocated on TMU 1
+	if ( qglActiveTextureARB && upload->isLightmap ) {
+		image->TMU = 1;
+	} else {
+		image->TMU = 0;
+	}
+
+	hash = generateHashValue(name);
+	image->next = hashTable[hash];
+	hashTable[hash] = image;
+
+	upload->job.process = R_ImageUploadJob_Process;
+	upload->job.finish = R_ImageUploadJob_Finish;
+	R_ImageJobs_Queue( &upload->job );
+	return image;
+}
+#endif
+
 //===================================================================
 
 typedef struct
@@ -1186,6 +1511,17 @@ image_t	*R_FindImageFile( const char *name, imgType_t type, imgFlags_t flags )
 		return NULL;
 	}
 
+#ifdef CMOD_PARALLEL_IMAGE_LOAD
+	if ( R_ImageJobs_Active() ) {
+		// upload any images that finished processing in the meantime
+		R_ImageJobs_Poll();
+		image = R_CreateImageDeferred( name, pic, width, height, type, flags );
+		if ( image ) {
+			return image;
+		}
+	}
+#endif
+
 	image = R_CreateImage( ( char * ) name, pic, width, height, type, flags, 0 );
 	ri.Free( pic );
 	return image;
@@ -1427,6 +1763,11 @@ void R_SetColorMappings( void ) {
 	}
 #endif
 
+#ifdef CMOD_PARALLEL_IMAGE_LOAD
+	// loader threads use the tables and overbright settings
+	R_ImageJobs_Flush();
+#endif
+
 	// setup the overbright lighting
 #ifdef CMOD_MAP_BRIGHTNESS_SETTINGS
 	tr.overbrightFactor = r_overBrightFactor->value;
@@ -1549,6 +1890,9 @@ R_InitImages
 */
 void	R_InitImages( void ) {
 	Com_Memset(hashTable, 0, sizeof(hashTable));
+#ifdef CMOD_IMAGE_SIMD
+	R_ImageSimd_Select();
+#endif
 #ifdef CMOD_FRAMEBUFFER
 	glConfig.deviceSupportsGamma = (tr.framebuffer_active || !r_ignorehwgamma->integer) ? qtrue : qfalse;
 
@@ -1564,6 +1908,10 @@ void	R_InitImages( void ) {
 
 	// create default texture and white texture
 	R_CreateBuiltinImages();
+
+#ifdef CMOD_PARALLEL_IMAGE_LOAD
+	R_ImageJobs_Init();
+#endif
 }
 
 /*
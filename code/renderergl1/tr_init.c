@@ -211,6 +211,18 @@ cvar_t	*r_autoEnvMapMode;
 cvar_t	*r_framebuffer;
 #endif
 
+#ifdef CMOD_ASYNC_VIDEO_CAPTURE
+cvar_t	*r_aviAsyncCapture;
+#endif
+
+#ifdef CMOD_PARALLEL_IMAGE_LOAD
+cvar_t	*r_parallelImageLoad;
+#endif
+
+#ifdef CMOD_IMAGE_SIMD
+cvar_t	*r_imageSimd;
+#endif
+
 /*
 ** InitOpenGL
 **
@@ -808,6 +820,11 @@ const void *RB_TakeVideoFrameCmd( const void *data )
 	GLint packAlign;
 	
 	cmd = (const videoFrameCommand_t *)data;
+
+#ifdef CMOD_ASYNC_VIDEO_CAPTURE
+	if(R_VideoCapture_Frame(cmd->width, cmd->height, cmd->motionJpeg, r_aviMotionJpegQuality->integer))
+		return (const void *)(cmd + 1);
+#endif
 	
 	qglGetIntegerv(GL_PACK_ALIGNMENT, &packAlign);
 
@@ -1278,6 +1295,26 @@ void R_Register( void )
 	r_framebuffer = ri.Cvar_Get("r_framebuffer", "1", CVAR_ARCHIVE | CVAR_LATCH);
 #endif
 
+#ifdef CMOD_ASYNC_VIDEO_CAPTURE
+	r_aviAsyncCapture = ri.Cvar_Get("r_aviAsyncCapture", "0", CVAR_ARCHIVE);
+	ri.Cvar_CheckRange(r_aviAsyncCapture, 0, 7, qtrue);
+	ri.Cvar_SetDescription(r_aviAsyncCapture, "Number of video frames read back and encoded "
+		"in the background while recording with cl_avi, for example 2. 0 (default) captures each "
+		"frame synchronously.");
+#endif
+
+#ifdef CMOD_PARALLEL_IMAGE_LOAD
+	r_parallelImageLoad = ri.Cvar_Get("r_parallelImageLoad", "1", CVAR_ARCHIVE | CVAR_LATCH);
+	ri.Cvar_SetDescription(r_parallelImageLoad, "Process map textures on background threads while loading. "
+		"Requires vid_restart.");
+#endif
+
+#ifdef CMOD_IMAGE_SIMD
+	r_imageSimd = ri.Cvar_Get("r_imageSimd", "1", CVAR_ARCHIVE | CVAR_LATCH);
+	ri.Cvar_SetDescription(r_imageSimd, "Use SIMD instructions to process textures when loading. "
+		"Requires vid_restart.");
+#endif
+
 	// make sure all the commands added here are also
 	// removed in R_Shutdown
 	ri.Cmd_AddCommand( "imagelist", R_ImageList_f );
@@ -1292,6 +1329,9 @@ void R_Register( void )
 #ifdef CMOD_FRAMEBUFFER
 	ri.Cmd_AddCommand( "fbo_test", framebuffer_test );
 #endif
+#ifdef CMOD_IMAGE_SIMD
+	ri.Cmd_AddCommand( "r_imageBenchmark", R_ImageSimd_Benchmark_f );
+#endif
 }
 
 /*
@@ -1435,10 +1475,19 @@ void RE_Shutdown( qboolean destroyWindow ) {
 #ifdef CMOD_FRAMEBUFFER
 	ri.Cmd_RemoveCommand( "fbo_test" );
 #endif
+#ifdef CMOD_IMAGE_SIMD
+	ri.Cmd_RemoveCommand( "r_imageBenchmark" );
+#endif
 
+#ifdef CMOD_PARALLEL_IMAGE_LOAD
+	R_ImageJobs_Shutdown();
+#endif
 
 	if ( tr.registered ) {
 		R_IssuePendingRenderCommands();
+#ifdef CMOD_ASYNC_VIDEO_CAPTURE
+		R_VideoCapture_Shutdown();
+#endif
 #ifdef CMOD_FRAMEBUFFER
 		framebuffer_shutdown();
 #endif
@@ -1545,6 +1594,9 @@ refexport_t *GetRefAPI ( int apiVersion, refimport_t *rimp ) {
 	re.inPVS = R_inPVS;
 
 	re.TakeVideoFrame = RE_TakeVideoFrame;
+#ifdef CMOD_ASYNC_VIDEO_CAPTURE
+	re.FlushVideoFrames = R_VideoCapture_Flush;
+#endif
 
 	return &re;
 }
@@ -1148,6 +1148,10 @@ extern	cvar_t	*r_autoEnvMapMode;
 extern	cvar_t	*r_framebuffer;
 #endif
 
+#ifdef CMOD_ASYNC_VIDEO_CAPTURE
+extern	cvar_t	*r_aviAsyncCapture;
+#endif
+
 //====================================================================
 
 void R_SwapBuffers( int );
@@ -1674,6 +1678,11 @@ void RE_SaveJPG(char * filename, int quality, int image_width, int image_height,
                 unsigned char *image_buffer, int padding);
 size_t RE_SaveJPGToBuffer(byte *buffer, size_t bufSize, int quality,
 		          int image_width, int image_height, byte *image_buffer, int padding);
+#ifdef CMOD_ASYNC_VIDEO_CAPTURE
+size_t RE_SaveJPGToBufferThreaded(byte *buffer, size_t bufSize, int quality,
+		int image_width, int image_height, byte *image_buffer, int padding,
+		char *errorText, int errorTextSize);
+#endif
 void RE_TakeVideoFrame( int width, int height,
 		byte *captureBuffer, byte *encodeBuffer, qboolean motionJpeg );
 
@@ -1686,6 +1695,12 @@ void ProjectDlightTexture_altivec( void );
 void RB_CalcDiffuseColor_altivec( unsigned char *colors );
 #endif
 
+#ifdef CMOD_ASYNC_VIDEO_CAPTURE
+void R_VideoCapture_Flush( void );
+qboolean R_VideoCapture_Frame( int width, int height, qboolean motionJpeg, int jpegQuality );
+void R_VideoCapture_Shutdown( void );
+#endif
+
 #ifdef CMOD_FRAMEBUFFER
 void framebuffer_shutdown(void);
 void framebuffer_init(void);
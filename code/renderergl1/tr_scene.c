@@ -298,6 +298,9 @@ void RE_RenderScene( const refdef_t *fd ) {
 		return;
 	}
 
+#ifdef CMOD_FRAME_TRACE
+	ri.Trace_BeginSpan( "RE_RenderScene" );
+#endif
 	startTime = ri.Milliseconds();
 
 	if (!tr.world && !( fd->rdflags & RDF_NOWORLDMODEL ) ) {
@@ -410,4 +413,7 @@ void RE_RenderScene( const refdef_t *fd ) {
 	r_firstScenePoly = r_numpolys;
 
 	tr.frontEndMsec += ri.Milliseconds() - startTime;
+#ifdef CMOD_FRAME_TRACE
+	ri.Trace_EndSpan();
+#endif
 }
@@ -1851,6 +1851,9 @@ void RB_ExecuteRenderCommands( const void *data ) {
 	int		t1, t2;
 
 	t1 = ri.Milliseconds ();
+#ifdef CMOD_FRAME_TRACE
+	ri.Trace_BeginSpan( "RB_ExecuteRenderCommands" );
+#endif
 
 	while ( 1 ) {
 		data = PADP(data, sizeof(void *));
@@ -1901,6 +1904,9 @@ void RB_ExecuteRenderCommands( const void *data ) {
 			// stop rendering
 			t2 = ri.Milliseconds ();
 			backEnd.pc.msec = t2 - t1;
+#ifdef CMOD_FRAME_TRACE
+			ri.Trace_EndSpan();
+#endif
 			return;
 		}
 	}
@@ -37,11 +37,15 @@ static	image_t*		hashTable[FILE_HASH_SIZE];
 ** R_GammaCorrect
 */
 void R_GammaCorrect( byte *buffer, int bufSize ) {
+#ifdef CMOD_IMAGE_SIMD
+	imageSimdKernels.remapBytes( buffer, bufSize, s_gammatable );
+#else
 	int i;
 
 	for ( i = 0; i < bufSize; i++ ) {
 		buffer[i] = s_gammatable[buffer[i]];
 	}
+#endif
 }
 
 typedef struct {
@@ -331,7 +335,11 @@ before or after.
 */
 static void ResampleTexture( byte *in, int inwidth, int inheight, byte *out,  
 							int outwidth, int outheight ) {
+#ifdef CMOD_IMAGE_SIMD
+	int		i;
+#else
 	int		i, j;
+#endif
 	byte	*inrow, *inrow2;
 	int		frac, fracstep;
 #ifdef CMOD_INCREASE_MAX_TEXTURE_SIZE
@@ -339,7 +347,9 @@ static void ResampleTexture( byte *in, int inwidth, int inheight, byte *out,
 #else
 	int		p1[2048], p2[2048];
 #endif
+#ifndef CMOD_IMAGE_SIMD
 	byte	*pix1, *pix2, *pix3, *pix4;
+#endif
 
 #ifdef CMOD_INCREASE_MAX_TEXTURE_SIZE
 	if (outwidth>16384)
@@ -364,6 +374,10 @@ static void ResampleTexture( byte *in, int inwidth, int inheight, byte *out,
 	for (i=0 ; i<outheight ; i++) {
 		inrow = in + 4*inwidth*(int)((i+0.25)*inheight/outheight);
 		inrow2 = in + 4*inwidth*(int)((i+0.75)*inheight/outheight);
+#ifdef CMOD_IMAGE_SIMD
+		imageSimdKernels.resampleRow( out, inrow, inrow2, p1, p2, outwidth );
+		out += outwidth * 4;
+#else
 		for (j=0 ; j<outwidth ; j++) {
 			pix1 = inrow + p1[j];
 			pix2 = inrow + p2[j];
@@ -374,6 +388,7 @@ static void ResampleTexture( byte *in, int inwidth, int inheight, byte *out,
 			*out++ = (pix1[2] + pix2[2] + pix3[2] + pix4[2])>>2;
 			*out++ = (pix1[3] + pix2[3] + pix3[3] + pix4[3])>>2;
 		}
+#endif
 	}
 }
 
@@ -1262,6 +1277,32 @@ lighting range
 */
 void R_LightScaleTexture (byte *in, int inwidth, int inheight, qboolean only_gamma )
 {
+#ifdef CMOD_IMAGE_SIMD
+	// combine the lookups into one table, which gives the same result as applying them in order
+	byte	table[256];
+	int		i;
+
+	if ( only_gamma && glConfig.deviceSupportsGamma
+#ifdef CMOD_TEXTURE_GAMMA
+			&& r_textureGamma->value == 1.0f
+#endif
+			) {
+		return;
+	}
+
+	for ( i = 0; i < 256; i++ ) {
+		if ( only_gamma )
+			table[i] = glConfig.deviceSupportsGamma ? i : s_gammatable[i];
+		else
+			table[i] = glConfig.deviceSupportsGamma ? s_intensitytable[i] : s_gammatable[s_intensitytable[i]];
+#ifdef CMOD_TEXTURE_GAMMA
+		if ( r_textureGamma->value != 1.0f )
+			table[i] = 255.0 * pow( table[i]/255.0f, 1.0f/r_textureGamma->value );
+#endif
+	}
+
+	imageSimdKernels.remapRGB( in, inwidth * inheight, table );
+#else
 	if ( only_gamma )
 	{
 		if ( !glConfig.deviceSupportsGamma )
@@ -1324,6 +1365,7 @@ void R_LightScaleTexture (byte *in, int inwidth, int inheight, qboolean only_gam
 		}
 	}
 #endif
+#endif
 }
 
 
@@ -1672,7 +1714,12 @@ static qboolean RawImage_ScaleToPower2( byte **data, int *inout_width, int *inou
 			finalheight >>= 1;
 		}
 
+#ifdef CMOD_PARALLEL_IMAGE_LOAD
+		// use malloc since this can run on image loader threads
+		*resampledBuffer = malloc( finalwidth * finalheight * 4 );
+#else
 		*resampledBuffer = ri.Hunk_AllocateTempMemory( finalwidth * finalheight * 4 );
+#endif
 
 		if (scaled_width != width || scaled_height != height)
 			ResampleTexture (*data, width, height, *resampledBuffer, scaled_width, scaled_height);
@@ -1705,7 +1752,11 @@ static qboolean RawImage_ScaleToPower2( byte **data, int *inout_width, int *inou
 	{
 		if (data && resampledBuffer)
 		{
+#ifdef CMOD_PARALLEL_IMAGE_LOAD
+			*resampledBuffer = malloc( scaled_width * scaled_height * 4 );
+#else
 			*resampledBuffer = ri.Hunk_AllocateTempMemory( scaled_width * scaled_height * 4 );
+#endif
 			ResampleTexture (*data, width, height, *resampledBuffer, scaled_width, scaled_height);
 			*data = *resampledBuffer;
 		}
@@ -2144,23 +2195,79 @@ static void RawImage_UploadTexture(GLuint texture, byte *data, int x, int y, int
 void R_ColorShiftLightingBytes( byte in[4], byte out[4], qboolean external );
 #endif
 
+#ifdef CMOD_PARALLEL_IMAGE_LOAD
+/*
+===============
+RawImage_PrepareUpload
+
+Applies light scaling and swizzling before upload. Can be called from image loader threads.
+===============
+*/
+static void RawImage_PrepareUpload(byte *data, int width, int height, GLenum picFormat, int numMips, imgType_t type, imgFlags_t flags, qboolean scaled)
+{
+	int			i, c;
+	qboolean rgba8 = picFormat == GL_RGBA8 || picFormat == GL_SRGB8_ALPHA8_EXT;
+	qboolean mipmap = !!(flags & IMGFLAG_MIPMAP) && (rgba8 || numMips > 1);
+	qboolean cubemap = !!(flags & IMGFLAG_CUBEMAP);
+
+	// These operations cannot be performed on non-rgba8 images.
+	if (rgba8 && !cubemap)
+	{
+		c = width*height;
+
+		if (type == IMGTYPE_COLORALPHA)
+		{
+
+#ifdef CMOD_EXTERNAL_LIGHTMAP_PROCESSING
+			if ( flags & IMGFLAG_EXTERNAL_LIGHTMAP ) {
+				byte *p = data;
+
+				c = width*height;
+				for (i=0 ; i<c ; i++, p+=4)
+				{
+					R_ColorShiftLightingBytes( p, p, qtrue );
+				}
+			}
+#endif
+
+			// This corresponds to what the OpenGL1 renderer does.
+			if (!(flags & IMGFLAG_NOLIGHTSCALE) && (scaled || mipmap))
+				R_LightScaleTexture(data, width, height, !mipmap);
+		}
+
+		if (glRefConfig.swizzleNormalmap && (type == IMGTYPE_NORMAL || type == IMGTYPE_NORMALHEIGHT))
+			RawImage_SwizzleRA(data, width, height);
+	}
+}
+#endif
+
 /*
 ===============
 Upload32
 
 ===============
 */
+#ifdef CMOD_PARALLEL_IMAGE_LOAD
+static void Upload32(byte *data, int x, int y, int width, int height, GLenum picFormat, GLenum dataFormat, GLenum dataType, int numMips, image_t *image, qboolean scaled, qboolean prepared)
+#else
 static void Upload32(byte *data, int x, int y, int width, int height, GLenum picFormat, GLenum dataFormat, GLenum dataType, int numMips, image_t *image, qboolean scaled)
+#endif
 {
 	int			i, c;
 
 	imgType_t type = image->type;
 	imgFlags_t flags = image->flags;
 	GLenum internalFormat = image->internalFormat;
+#ifndef CMOD_PARALLEL_IMAGE_LOAD
 	qboolean rgba8 = picFormat == GL_RGBA8 || picFormat == GL_SRGB8_ALPHA8_EXT;
 	qboolean mipmap = !!(flags & IMGFLAG_MIPMAP) && (rgba8 || numMips > 1);
+#endif
 	qboolean cubemap = !!(flags & IMGFLAG_CUBEMAP);
 
+#ifdef CMOD_PARALLEL_IMAGE_LOAD
+	if (!prepared)
+		RawImage_PrepareUpload(data, width, height, picFormat, numMips, type, flags, scaled);
+#else
 	// These operations cannot be performed on non-rgba8 images.
 	if (rgba8 && !cubemap)
 	{
@@ -2189,6 +2296,7 @@ static void Upload32(byte *data, int x, int y, int width, int height, GLenum pic
 		if (glRefConfig.swizzleNormalmap && (type == IMGTYPE_NORMAL || type == IMGTYPE_NORMALHEIGHT))
 			RawImage_SwizzleRA(data, width, height);
 	}
+#endif
 
 	if (cubemap)
 	{
@@ -2361,10 +2469,18 @@ image_t *R_CreateImage2( const char *name, byte *pic, int width, int height, GLe
 
 	// Upload data.
 	if (pic)
+#ifdef CMOD_PARALLEL_IMAGE_LOAD
+		Upload32(pic, 0, 0, width, height, picFormat, dataFormat, dataType, numMips, image, scaled, qfalse);
+#else
 		Upload32(pic, 0, 0, width, height, picFormat, dataFormat, dataType, numMips, image, scaled);
+#endif
 
+#ifdef CMOD_PARALLEL_IMAGE_LOAD
+	free(resampledBuffer);
+#else
 	if (resampledBuffer != NULL)
 		ri.Hunk_FreeTempMemory(resampledBuffer);
+#endif
 
 	// Set all necessary texture parameters.
 	qglTextureParameterfEXT(image->texnum, textureTarget, GL_TEXTURE_WRAP_S, glWrapClampMode);
@@ -2419,6 +2535,149 @@ image_t *R_CreateImage(const char *name, byte *pic, int width, int height, imgTy
 	return R_CreateImage2(name, pic, width, height, GL_RGBA8, 0, type, flags, internalFormat);
 }
 
+#ifdef CMOD_PARALLEL_IMAGE_LOAD
+typedef struct {
+	imageJob_t job;
+	image_t *image;
+	byte *pic;
+	qboolean isLightmap;
+
+	// set on loader thread
+	byte *data;
+	byte *resampledBuffer;
+	int width;
+	int height;
+	GLenum internalFormat;
+	qboolean scaled;
+} imageUploadJob_t;
+
+/*
+================
+R_ImageUploadJob_Process
+
+Runs on image loader thread.
+================
+*/
+static void R_ImageUploadJob_Process( imageJob_t *job ) {
+	imageUploadJob_t *upload = (imageUploadJob_t *)job;
+	image_t *image = upload->image;
+
+	upload->internalFormat = RawImage_GetFormat(upload->pic, image->width * image->height, GL_RGBA8,
+			upload->isLightmap, image->type, image->flags);
+
+	upload->data = upload->pic;
+	upload->width = image->width;
+	upload->height = image->height;
+	upload->scaled = RawImage_ScaleToPower2(&upload->data, &upload->width, &upload->height,
+			image->type, image->flags, &upload->resampledBuffer);
+
+	RawImage_PrepareUpload(upload->data, upload->width, upload->height, GL_RGBA8, 0,
+			image->type, image->flags, upload->scaled);
+}
+
+/*
+================
+R_ImageUploadJob_Finish
+
+Allocates texture storage and uploads data prepared by the loader thread.
+================
+*/
+static void R_ImageUploadJob_Finish( imageJob_t *job ) {
+	imageUploadJob_t *upload = (imageUploadJob_t *)job;
+	image_t *image = upload->image;
+	qboolean mipmap = !!(image->flags & IMGFLAG_MIPMAP);
+	GLenum dataFormat = PixelDataFormatFromInternalFormat(upload->internalFormat);
+	int glWrapClampMode = (image->flags & IMGFLAG_CLAMPTOEDGE) ? GL_CLAMP_TO_EDGE : GL_REPEAT;
+	int mipWidth = upload->width;
+	int mipHeight = upload->height;
+	int miplevel = 0;
+	qboolean lastMip;
+
+	image->internalFormat = upload->internalFormat;
+	image->uploadWidth = upload->width;
+	image->uploadHeight = upload->height;
+
+	do
+	{
+		lastMip = !mipmap || (mipWidth == 1 && mipHeight == 1);
+		qglTextureImage2DEXT(image->texnum, GL_TEXTURE_2D, miplevel, image->internalFormat, mipWidth, mipHeight, 0, dataFormat, GL_UNSIGNED_BYTE, NULL);
+		mipWidth  = MAX(1, mipWidth >> 1);
+		mipHeight = MAX(1, mipHeight >> 1);
+		miplevel++;
+	}
+	while (!lastMip);
+
+	Upload32(upload->data, 0, 0, upload->width, upload->height, GL_RGBA8, dataFormat, GL_UNSIGNED_BYTE, 0, image, upload->scaled, qtrue);
+
+	qglTextureParameterfEXT(image->texnum, GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, glWrapClampMode);
+	qglTextureParameterfEXT(image->texnum, GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, glWrapClampMode);
+
+	if (textureFilterAnisotropic)
+		qglTextureParameteriEXT(image->texnum, GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT,
+			mipmap ? (GLint)Com_Clamp(1, maxAnisotropy, r_ext_max_anisotropy->integer) : 1);
+
+	qglTextureParameterfEXT(image->texnum, GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, mipmap ? gl_filter_min : GL_LINEAR);
+	qglTextureParameterfEXT(image->texnum, GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, mipmap ? gl_filter_max : GL_LINEAR);
+
+	GL_CheckErrors();
+
+	free(upload->resampledBuffer);
+	ri.Free(upload->pic);
+	free(upload);
+}
+
+/*
+================
+R_CreateImageDeferred
+
+Same as R_CreateImage, except the image is processed on an image loader thread and uploaded
+later by R_ImageJobs_Poll or R_ImageJobs_Flush. Takes ownership of pic, which must be
+allocated by ri.Malloc. Returns NULL if the image couldn't be queued, in which case the
+caller still owns pic.
+================
+*/
+image_t *R_CreateImageDeferred( const char *name, byte *pic, int width, int height,
+		imgType_t type, imgFlags_t flags ) {
+	image_t    *image;
+	imageUploadJob_t *upload;
+	long        hash;
+
+	// OpenGL ES format conversion and cubemaps are only handled by R_CreateImage2
+	if (strlen(name) >= MAX_QPATH || tr.numImages == MAX_DRAWIMAGES || qglesMajorVersion ||
+			(flags & IMGFLAG_CUBEMAP))
+		return NULL;
+
+	upload = calloc(1, sizeof(*upload));
+	if (!upload)
+		return NULL;
+
+	image = tr.images[tr.numImages] = ri.Hunk_Alloc( sizeof( image_t ), h_low );
+	qglGenTextures(1, &image->texnum);
+	tr.numImages++;
+
+	image->type = type;
+	image->flags = flags;
+
+	strcpy (image->imgName, name);
+
+	image->width = width;
+	image->height = height;
+
+	upload->image = image;
+	upload->pic = pic;
+	upload->isLightmap = !strncmp( name, "*lightmap", 9 ) ? qtrue : qfalse;
+
+	hash = generateHashValue(name);
+	image->next = hashTable[hash];
+	hashTable[hash] = image;
+
+	upload->job.process = R_ImageUploadJob_Process;
+	upload->job.finish = R_ImageUploadJob_Finish;
+	R_ImageJobs_Queue(&upload->job);
+	return image;
+}
+#endif
+
 
 void R_UpdateSubImage( image_t *image, byte *pic, int x, int y, int width, int height, GLenum picFormat )
 {
@@ -2428,7 +2687,11 @@ void R_UpdateSubImage( image_t *image, byte *pic, int x, int y, int width, int h
 	dataFormat = PixelDataFormatFromInternalFormat(image->internalFormat);
 	dataType = picFormat == GL_RGBA16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_BYTE;
 
+#ifdef CMOD_PARALLEL_IMAGE_LOAD
+	Upload32(pic, x, y, width, height, picFormat, dataFormat, dataType, 0, image, qfalse, qfalse);
+#else
 	Upload32(pic, x, y, width, height, picFormat, dataFormat, dataType, 0, image, qfalse);
+#endif
 }
 
 //===================================================================
@@ -2790,6 +3053,17 @@ image_t	*R_FindImageFile( const char *name, imgType_t type, imgFlags_t flags )
 			flags &= ~IMGFLAG_MIPMAP;
 	}
 
+#ifdef CMOD_PARALLEL_IMAGE_LOAD
+	if ( picFormat == GL_RGBA8 && R_ImageJobs_Active() ) {
+		// upload any images that finished processing in the meantime
+		R_ImageJobs_Poll();
+		image = R_CreateImageDeferred( name, pic, width, height, type, flags );
+		if ( image ) {
+			return image;
+		}
+	}
+#endif
+
 	image = R_CreateImage2( ( char * ) name, pic, width, height, picFormat, picNumMips, type, flags, 0 );
 	ri.Free( pic );
 	return image;
@@ -3116,6 +3390,11 @@ void R_SetColorMappings( void ) {
 	}
 #endif
 
+#ifdef CMOD_PARALLEL_IMAGE_LOAD
+	// loader threads use the tables and overbright settings
+	R_ImageJobs_Flush();
+#endif
+
 	// setup the overbright lighting
 #ifdef CMOD_MAP_BRIGHTNESS_SETTINGS
 	tr.overbrightFactor = r_overBrightFactor->value;
@@ -3206,11 +3485,24 @@ R_InitImages
 */
 void	R_InitImages( void ) {
 	Com_Memset(hashTable, 0, sizeof(hashTable));
+#ifdef CMOD_IMAGE_SIMD
+	R_ImageSimd_Select();
+#endif
 	// build brightness translation tables
 	R_SetColorMappings();
 
 	// create default texture and white texture
 	R_CreateBuiltinImages();
+
+#ifdef CMOD_PARALLEL_IMAGE_LOAD
+	{
+		// make sure the R_MipMapsRGB lookup table is set before loader threads use it
+		byte pixel[4] = { 0 };
+		R_MipMapsRGB( pixel, 1, 1 );
+	}
+
+	R_ImageJobs_Init();
+#endif
 }
 
 /*
@@ -276,6 +276,14 @@ cvar_t	*r_autoOverBrightFactorShift;
 cvar_t	*r_autoEnvMapMode;
 #endif
 
+#ifdef CMOD_PARALLEL_IMAGE_LOAD
+cvar_t	*r_parallelImageLoad;
+#endif
+
+#ifdef CMOD_IMAGE_SIMD
+cvar_t	*r_imageSimd;
+#endif
+
 /*
 ** InitOpenGL
 **
@@ -1553,6 +1561,18 @@ void R_Register( void )
 	r_autoEnvMapMode = ri.Cvar_Get("r_autoEnvMapMode", "", 0);
 #endif
 
+#ifdef CMOD_PARALLEL_IMAGE_LOAD
+	r_parallelImageLoad = ri.Cvar_Get("r_parallelImageLoad", "1", CVAR_ARCHIVE | CVAR_LATCH);
+	ri.Cvar_SetDescription(r_parallelImageLoad, "Process map textures on background threads while loading. "
+		"Requires vid_restart.");
+#endif
+
+#ifdef CMOD_IMAGE_SIMD
+	r_imageSimd = ri.Cvar_Get("r_imageSimd", "1", CVAR_ARCHIVE | CVAR_LATCH);
+	ri.Cvar_SetDescription(r_imageSimd, "Use SIMD instructions to process textures when loading. "
+		"Requires vid_restart.");
+#endif
+
 	// make sure all the commands added here are also
 	// removed in R_Shutdown
 	ri.Cmd_AddCommand( "imagelist", R_ImageList_f );
@@ -1566,6 +1586,9 @@ void R_Register( void )
 	ri.Cmd_AddCommand( "minimize", GLimp_Minimize );
 	ri.Cmd_AddCommand( "gfxmeminfo", GfxMemInfo_f );
 	ri.Cmd_AddCommand( "exportCubemaps", R_ExportCubemaps_f );
+#ifdef CMOD_IMAGE_SIMD
+	ri.Cmd_AddCommand( "r_imageBenchmark", R_ImageSimd_Benchmark_f );
+#endif
 }
 
 void R_InitQueries(void)
@@ -1731,7 +1754,13 @@ void RE_Shutdown( qboolean destroyWindow ) {
 	ri.Cmd_RemoveCommand( "minimize" );
 	ri.Cmd_RemoveCommand( "gfxmeminfo" );
 	ri.Cmd_RemoveCommand( "exportCubemaps" );
+#ifdef CMOD_IMAGE_SIMD
+	ri.Cmd_RemoveCommand( "r_imageBenchmark" );
+#endif
 
+#ifdef CMOD_PARALLEL_IMAGE_LOAD
+	R_ImageJobs_Shutdown();
+#endif
 
 	if ( tr.registered ) {
 		R_IssuePendingRenderCommands();
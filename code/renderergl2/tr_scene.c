@@ -474,6 +474,9 @@ void RE_RenderScene( const refdef_t *fd ) {
 		return;
 	}
 
+#ifdef CMOD_FRAME_TRACE
+	ri.Trace_BeginSpan( "RE_RenderScene" );
+#endif
 	startTime = ri.Milliseconds();
 
 	if (!tr.world && !( fd->rdflags & RDF_NOWORLDMODEL ) ) {
@@ -576,4 +579,7 @@ void RE_RenderScene( const refdef_t *fd ) {
 	RE_EndScene();
 
 	tr.frontEndMsec += ri.Milliseconds() - startTime;
+#ifdef CMOD_FRAME_TRACE
+	ri.Trace_EndSpan();
+#endif
 }
@@ -66,7 +66,19 @@ SNDDMA_AudioCallback
 */
 static void SNDDMA_AudioCallback(void *userdata, Uint8 *stream, int len)
 {
-	int pos = (dmapos * (dma.samplebits/8));
+	int pos;
+
+#ifdef CMOD_SOUND_MIX_THREAD
+	// if mixing in the audio thread, paint the samples about to be copied
+	if (snd_inited)
+	{
+		int mixpos = S_MixThread_Paint(len / (dma.samplebits/8));
+		if (mixpos >= 0)
+			dmapos = mixpos;
+	}
+#endif
+
+	pos = (dmapos * (dma.samplebits/8));
 	if (pos >= dmasize)
 		dmapos = pos = 0;
 
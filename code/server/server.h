@@ -210,6 +210,13 @@ typedef struct client_s {
 #ifdef CMOD_PER_CLIENT_DOWNLOAD_MAP
 	void *download_map;
 #endif
+#ifdef CMOD_METRICS_ENDPOINT
+	int metricsSnapshots;
+	int64_t metricsSnapshotBytes;
+#endif
+#ifdef CMOD_SNAPSHOT_ENTITY_PRIORITY
+	byte entityDeferCount[MAX_GENTITIES];	// consecutive snapshots each entity update was deferred
+#endif
 } client_t;
 
 //=============================================================================
@@ -392,6 +399,9 @@ void SV_ExecuteClientMessage( client_t *cl, msg_t *msg );
 void SV_UserinfoChanged( client_t *cl );
 
 void SV_ClientEnterWorld( client_t *client, usercmd_t *cmd );
+#ifdef CMOD_RECORD_REPLAY
+void SV_SendClientGameState( client_t *client );
+#endif
 void SV_FreeClient(client_t *client);
 void SV_DropClient( client_t *drop, const char *reason );
 
@@ -435,7 +435,21 @@ void SV_BotFrame( int time ) {
 	if (!bot_enable) return;
 	//NOTE: maybe the game is already shutdown
 	if (!gvm) return;
+#ifdef CMOD_BOT_ROUTE_CACHE_BUDGET
+	if ( bot_routeCacheMB->modified ) {
+		botlib_export->BotLibVarSet( "routecachemb", bot_routeCacheMB->string );
+		bot_routeCacheMB->modified = qfalse;
+	}
+#endif
+#ifdef CMOD_BOT_THINK_STATS
+	{
+		int64_t start = Sys_Microseconds();
+		VM_Call( gvm, BOTAI_START_FRAME, time );
+		SV_BotThinkStats_Record( Sys_Microseconds() - start );
+	}
+#else
 	VM_Call( gvm, BOTAI_START_FRAME, time );
+#endif
 }
 
 /*
@@ -454,6 +468,12 @@ int SV_BotLibSetup( void ) {
 	}
 
 	botlib_export->BotLibVarSet( "basegame", com_basegame->string );
+#ifdef CMOD_BOT_ROUTE_PRECACHE
+	botlib_export->BotLibVarSet( "routeprecache", bot_routePrecache->string );
+#endif
+#ifdef CMOD_BOT_ROUTE_CACHE_BUDGET
+	botlib_export->BotLibVarSet( "routecachemb", bot_routeCacheMB->string );
+#endif
 
 	return botlib_export->BotLibSetup();
 }
@@ -514,6 +534,49 @@ void SV_BotInitCvars(void) {
 	Cvar_Get("bot_interbreedwrite", "", CVAR_CHEAT);	//write interbreeded bots to this file
 }
 
+#ifdef CMOD_BOT_ROUTE_PRECACHE
+/*
+==================
+BotImport_ProcessorCount
+==================
+*/
+static int BotImport_ProcessorCount( void ) {
+#ifdef CMOD_COMMON_THREADS
+	return CMThread_ProcessorCount();
+#else
+	return 1;
+#endif
+}
+
+/*
+==================
+BotImport_CacheFileOpenRead
+
+Opens a file in the cache directory. Returns file size, or -1 on error.
+==================
+*/
+static int BotImport_CacheFileOpenRead( const char *qpath, fileHandle_t *file ) {
+	char path[FS_MAX_PATH];
+	unsigned int size = 0;
+
+	*file = 0;
+	if ( !FS_GeneratePathWritedir( XDG_CACHE, qpath, NULL, FS_ALLOW_DIRECTORIES, 0, path, sizeof( path ) ) ) {
+		return -1;
+	}
+	*file = FS_DirectReadHandle_Open( NULL, path, &size );
+	return *file ? (int)size : -1;
+}
+
+/*
+==================
+BotImport_CacheFileOpenWrite
+==================
+*/
+static fileHandle_t BotImport_CacheFileOpenWrite( const char *qpath ) {
+	return FS_BaseDir_FOpenFileWrite( XDG_CACHE, qpath );
+}
+#endif
+
 /*
 ==================
 SV_BotInitBotLib
@@ -557,6 +620,19 @@ void SV_BotInitBotLib(void) {
 	botlib_import.DebugPolygonCreate = BotImport_DebugPolygonCreate;
 	botlib_import.DebugPolygonDelete = BotImport_DebugPolygonDelete;
 
+#ifdef CMOD_BOT_ROUTE_PRECACHE
+	//routing cache precompute
+	botlib_import.Milliseconds = Sys_Milliseconds;
+	botlib_import.ProcessorCount = BotImport_ProcessorCount;
+#ifdef CMOD_COMMON_THREADS
+	botlib_import.RunParallel = CMThread_RunParallel;
+#else
+	botlib_import.RunParallel = NULL;
+#endif
+	botlib_import.CacheFileOpenRead = BotImport_CacheFileOpenRead;
+	botlib_import.CacheFileOpenWrite = BotImport_CacheFileOpenWrite;
+#endif
+
 	botlib_export = (botlib_export_t *)GetBotLibAPI( BOTLIB_API_VERSION, &botlib_import );
 	assert(botlib_export); 	// somehow we end up with a zero import.
 }
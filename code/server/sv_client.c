@@ -613,6 +613,11 @@ gotnewcl:
 	NET_OutOfBandPrint(NS_SERVER, from, "connectResponse %d", challenge);
 
 	Com_DPrintf( "Going from CS_FREE to CS_CONNECTED for %s\n", newcl->name );
+#ifdef CMOD_SERVER_HITCH_LOG
+	if ( svHitchActive ) {
+		SV_Hitch_Note( "connect client %i from %s", (int)( newcl - svs.clients ), NET_AdrToString( from ) );
+	}
+#endif
 
 	newcl->state = CS_CONNECTED;
 	newcl->lastSnapshotTime = 0;
@@ -692,6 +697,12 @@ void SV_DropClient( client_t *drop, const char *reason ) {
 		return;		// already dropped
 	}
 
+#ifdef CMOD_SERVER_HITCH_LOG
+	if ( svHitchActive ) {
+		SV_Hitch_Note( "drop client %i (%s)", (int)( drop - svs.clients ), reason );
+	}
+#endif
+
 	if ( !isBot ) {
 		// see if we already have a challenge for this ip
 		challenge = &svs.challenges[0];
@@ -776,11 +787,18 @@ It will be resent if the client acknowledges a later message but has
 the wrong gamestate.
 ================
 */
+#ifdef CMOD_RECORD_REPLAY
+void SV_SendClientGameState( client_t *client ) {
+#else
 static void SV_SendClientGameState( client_t *client ) {
+#endif
 	int			start;
 	entityState_t	*base, nullstate;
 	msg_t		msg;
 	byte		msgBuffer[MAX_MSGLEN];
+#ifdef CMOD_BANDWIDTH_PROFILE
+	int			profileStart;
+#endif
 
  	Com_DPrintf ("SV_SendClientGameState() for %s\n", client->name);
 	Com_DPrintf( "Going from CS_CONNECTED to CS_PRIMED for %s\n", client->name );
@@ -833,7 +851,14 @@ static void SV_SendClientGameState( client_t *client ) {
 	MSG_WriteByte( &msg, svc_gamestate );
 	MSG_WriteLong( &msg, client->reliableSequence );
 
+#ifdef CMOD_GAMESTATE_CACHE
+	// write the configstrings and baselines from the shared encoding if possible
+	if ( !SV_GamestateCache_Write( client, &msg ) ) {
+#endif
 	// write the configstrings
+#ifdef CMOD_BANDWIDTH_PROFILE
+	profileStart = msg.bit;
+#endif
 	for ( start = 0 ; start < MAX_CONFIGSTRINGS ; start++ ) {
 		if (sv.configstrings[start][0]) {
 			MSG_WriteByte( &msg, svc_configstring );
@@ -841,6 +866,9 @@ static void SV_SendClientGameState( client_t *client ) {
 			MSG_WriteBigString( &msg, sv.configstrings[start] );
 		}
 	}
+#ifdef CMOD_BANDWIDTH_PROFILE
+	SV_Bandwidth_Record( client, SV_BANDWIDTH_CONFIGSTRINGS, msg.bit - profileStart );
+#endif
 
 #ifdef CMOD_GAMESTATE_OVERFLOW_FIX
 	// update client->baseline_cutoff
@@ -848,6 +876,9 @@ static void SV_SendClientGameState( client_t *client ) {
 #endif
 
 	// write the baselines
+#ifdef CMOD_BANDWIDTH_PROFILE
+	profileStart = msg.bit;
+#endif
 	Com_Memset( &nullstate, 0, sizeof( nullstate ) );
 	for ( start = 0 ; start < MAX_GENTITIES; start++ ) {
 		base = &sv.svEntities[start].baseline;
@@ -860,6 +891,12 @@ static void SV_SendClientGameState( client_t *client ) {
 		MSG_WriteByte( &msg, svc_baseline );
 		MSG_WriteDeltaEntity( &msg, &nullstate, base, qtrue );
 	}
+#ifdef CMOD_BANDWIDTH_PROFILE
+	SV_Bandwidth_Record( client, SV_BANDWIDTH_BASELINES, msg.bit - profileStart );
+#endif
+#ifdef CMOD_GAMESTATE_CACHE
+	}
+#endif
 
 #ifdef ELITEFORCE
 	if(msg.compat)
@@ -886,6 +923,9 @@ static void SV_SendClientGameState( client_t *client ) {
 #endif
 
 	// deliver this to the client
+#ifdef CMOD_BANDWIDTH_PROFILE
+	SV_Bandwidth_RecordMessage( client, &msg );
+#endif
 	SV_SendMessageToClient( &msg, client );
 }
 
@@ -1317,6 +1357,9 @@ int SV_WriteDownloadToClient(client_t *cl, msg_t *msg)
 	// Write the block
 	if(cl->downloadBlockSize[curindex])
 		MSG_WriteData(msg, cl->downloadBlocks[curindex], cl->downloadBlockSize[curindex]);
+#ifdef CMOD_METRICS_ENDPOINT
+	svMetrics.downloadBytes += cl->downloadBlockSize[curindex];
+#endif
 
 	Com_DPrintf( "clientDownload: %d : writing block %d\n", (int) (cl - svs.clients), cl->downloadXmitBlock );
 
@@ -1376,6 +1419,9 @@ int SV_SendDownloadMessages(void)
 	client_t *cl;
 	msg_t msg;
 	byte msgBuffer[MAX_MSGLEN];
+#ifdef CMOD_BANDWIDTH_PROFILE
+	int profileStart;
+#endif
 	
 	for(i=0; i < sv_maxclients->integer; i++)
 	{
@@ -1399,14 +1445,23 @@ int SV_SendDownloadMessages(void)
 			}
 #endif
 			
+#ifdef CMOD_BANDWIDTH_PROFILE
+			profileStart = msg.bit;
+#endif
 			retval = SV_WriteDownloadToClient(cl, &msg);
 				
 			if(retval)
 			{
+#ifdef CMOD_BANDWIDTH_PROFILE
+				SV_Bandwidth_Record(cl, SV_BANDWIDTH_DOWNLOADS, msg.bit - profileStart);
+#endif
 #ifdef CMOD_DOWNLOAD_PROTOCOL_FIXES
 				if(!cl->compat)
 #endif
 				MSG_WriteByte(&msg, svc_EOF);
+#ifdef CMOD_BANDWIDTH_PROFILE
+				SV_Bandwidth_RecordMessage(cl, &msg);
+#endif
 				SV_Netchan_Transmit(cl, &msg);
 				numDLs += retval;
 			}
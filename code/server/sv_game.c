@@ -293,7 +293,11 @@ SV_GameSystemCalls
 The module is making a system call
 ====================
 */
+#ifdef CMOD_FRAME_TRACE
+static intptr_t SV_GameSystemCallsDispatch( intptr_t *args ) {
+#else
 intptr_t SV_GameSystemCalls( intptr_t *args ) {
+#endif
 #ifdef CMOD_VM_EXTENSIONS
 	intptr_t retval = 0;
 	if ( VMExt_HandleVMSyscall( args, VM_GAME, gvm, &retval ) ) {
@@ -973,6 +977,26 @@ intptr_t SV_GameSystemCalls( intptr_t *args ) {
 	return 0;
 }
 
+#ifdef CMOD_FRAME_TRACE
+/*
+====================
+SV_GameSystemCalls
+
+Records botlib calls as trace spans.
+====================
+*/
+intptr_t SV_GameSystemCalls( intptr_t *args ) {
+	intptr_t retval;
+	if ( !cmTraceActive || args[0] < BOTLIB_SETUP ) {
+		return SV_GameSystemCallsDispatch( args );
+	}
+	CMTrace_BeginSpan( "botlib" );
+	retval = SV_GameSystemCallsDispatch( args );
+	CMTrace_EndSpan();
+	return retval;
+}
+#endif
+
 /*
 ===============
 SV_ShutdownGameProgs
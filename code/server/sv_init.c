@@ -123,6 +123,9 @@ void SV_SetConfigstring (int index, const char *val) {
 	// change the string in sv
 	Z_Free( sv.configstrings[index] );
 	sv.configstrings[index] = CopyString( val );
+#ifdef CMOD_GAMESTATE_CACHE
+	SV_GamestateCache_Invalidate();
+#endif
 
 	// send it to all the clients if we aren't
 	// spawning a new server
@@ -246,6 +249,9 @@ static void SV_CreateBaseline( void ) {
 		//
 		sv.svEntities[entnum].baseline = svent->s;
 	}
+#ifdef CMOD_GAMESTATE_CACHE
+	SV_GamestateCache_Invalidate();
+#endif
 }
 
 
@@ -530,6 +536,10 @@ void SV_SpawnServer( char *server, qboolean killBots ) {
 	// to load during actual gameplay
 	sv.state = SS_LOADING;
 
+#ifdef CMOD_BOT_THINK_STATS
+	SV_BotThinkStats_Reset();
+#endif
+
 	// load and spawn all other entities
 	SV_InitGameProgs();
 
@@ -788,6 +798,21 @@ void SV_Init (void)
 #ifdef CMOD_MAPTABLE
 	cmod_maptable_init();
 #endif
+#ifdef CMOD_BOT_THINK_STATS
+	SV_BotThinkStats_Init();
+#endif
+#ifdef CMOD_BOT_ROUTE_CACHE_BUDGET
+	SV_BotRouteCacheStats_Init();
+#endif
+#ifdef CMOD_SERVER_BENCHMARK
+	SV_Benchmark_Init();
+#endif
+#ifdef CMOD_BANDWIDTH_PROFILE
+	SV_Bandwidth_Init();
+#endif
+#ifdef CMOD_SERVER_FRAME_SCHEDULER
+	SV_Scheduler_Init();
+#endif
 }
 
 
@@ -520,6 +520,9 @@ qboolean SVC_RateLimit( leakyBucket_t *bucket, int burst, int period ) {
 		}
 	}
 
+#ifdef CMOD_METRICS_ENDPOINT
+	++svMetrics.rateLimitedQueries;
+#endif
 	return qtrue;
 }
 
@@ -1142,6 +1145,12 @@ happen before SV_Frame is called
 void SV_Frame( int msec ) {
 	int		frameMsec;
 	int		startTime;
+#ifdef CMOD_SERVER_BENCHMARK
+	int64_t	phaseStart;
+#endif
+#ifdef CMOD_METRICS_ENDPOINT
+	int64_t	metricsStart;
+#endif
 
 	// the menu kills the server with this cvar
 	if ( sv_killserver->integer ) {
@@ -1181,7 +1190,13 @@ void SV_Frame( int msec ) {
 
 	sv.timeResidual += msec;
 
+#ifdef CMOD_SERVER_BENCHMARK
+	phaseStart = Sys_Microseconds();
 	if (!com_dedicated->integer) SV_BotFrame (sv.time + sv.timeResidual);
+	SV_Benchmark_RecordPhase( SV_BENCHMARK_PHASE_BOTS, phaseStart );
+#else
+	if (!com_dedicated->integer) SV_BotFrame (sv.time + sv.timeResidual);
+#endif
 
 	// if time is about to hit the 32nd bit, kick all clients
 	// and clear sv.time, rather
@@ -1229,10 +1244,27 @@ void SV_Frame( int msec ) {
 		startTime = 0;	// quite a compiler warning
 	}
 
+#ifdef CMOD_FRAME_TRACE
+	CMTRACE_BEGIN( "SV_Frame" );
+#endif
+#ifdef CMOD_METRICS_ENDPOINT
+	metricsStart = Sys_Microseconds();
+#endif
+
 	// update ping based on the all received frames
 	SV_CalcPings();
 
+#ifdef CMOD_SERVER_BENCHMARK
+	phaseStart = Sys_Microseconds();
 	if (com_dedicated->integer) SV_BotFrame (sv.time);
+	SV_Benchmark_RecordPhase( SV_BENCHMARK_PHASE_BOTS, phaseStart );
+#ifdef CMOD_SERVER_HITCH_LOG
+	SV_Hitch_RecordPhase( SV_HITCH_PHASE_BOTS, phaseStart );
+#endif
+	phaseStart = Sys_Microseconds();
+#else
+	if (com_dedicated->integer) SV_BotFrame (sv.time);
+#endif
 
 	// run the game simulation in chunks
 	while ( sv.timeResidual >= frameMsec ) {
@@ -1243,6 +1275,12 @@ void SV_Frame( int msec ) {
 		// let everything in the world think and move
 		VM_Call (gvm, GAME_RUN_FRAME, sv.time);
 	}
+#ifdef CMOD_SERVER_BENCHMARK
+	SV_Benchmark_RecordPhase( SV_BENCHMARK_PHASE_GAME, phaseStart );
+#ifdef CMOD_SERVER_HITCH_LOG
+	SV_Hitch_RecordPhase( SV_HITCH_PHASE_GAME, phaseStart );
+#endif
+#endif
 
 	if ( com_speeds->integer ) {
 		time_game = Sys_Milliseconds () - startTime;
@@ -1252,7 +1290,16 @@ void SV_Frame( int msec ) {
 	SV_CheckTimeouts();
 
 	// send messages back to the clients
+#ifdef CMOD_SERVER_BENCHMARK
+	phaseStart = Sys_Microseconds();
+	SV_SendClientMessages();
+	SV_Benchmark_RecordPhase( SV_BENCHMARK_PHASE_SNAPSHOTS, phaseStart );
+#ifdef CMOD_SERVER_HITCH_LOG
+	SV_Hitch_RecordPhase( SV_HITCH_PHASE_SNAPSHOTS, phaseStart );
+#endif
+#else
 	SV_SendClientMessages();
+#endif
 
 	// send a heartbeat to the master if needed
 	SV_MasterHeartbeat(HEARTBEAT_FOR_MASTER);
@@ -1260,6 +1307,12 @@ void SV_Frame( int msec ) {
 	trigger_exec_type(TRIGGER_TIMER);
 	trigger_exec_type(TRIGGER_REPEAT);
 #endif
+#ifdef CMOD_METRICS_ENDPOINT
+	SV_Metrics_RecordFrame( metricsStart );
+#endif
+#ifdef CMOD_FRAME_TRACE
+	CMTRACE_END();
+#endif
 }
 
 /*
@@ -136,6 +136,9 @@ static void SV_WriteSnapshotToClient( client_t *client, msg_t *msg ) {
 	int					lastframe;
 	int					i;
 	int					snapFlags;
+#ifdef CMOD_BANDWIDTH_PROFILE
+	int					profileStart = msg->bit;
+#endif
 
 	// this is the snapshot we are creating
 	frame = &client->frames[ client->netchan.outgoingSequence & PACKET_MASK ];
@@ -204,6 +207,12 @@ static void SV_WriteSnapshotToClient( client_t *client, msg_t *msg ) {
 	MSG_WriteByte (msg, frame->areabytes);
 	MSG_WriteData (msg, frame->areabits, frame->areabytes);
 
+#ifdef CMOD_BANDWIDTH_PROFILE
+	SV_Bandwidth_Record( client, SV_BANDWIDTH_SNAPSHOT_HEADER, msg->bit - profileStart );
+	SV_Bandwidth_BeginSnapshot( client );
+	profileStart = msg->bit;
+#endif
+
 	// delta encode the playerstate
 	if ( oldframe ) {
 		MSG_WriteDeltaPlayerstate( msg, &oldframe->ps, &frame->ps );
@@ -211,6 +220,11 @@ static void SV_WriteSnapshotToClient( client_t *client, msg_t *msg ) {
 		MSG_WriteDeltaPlayerstate( msg, NULL, &frame->ps );
 	}
 
+#ifdef CMOD_BANDWIDTH_PROFILE
+	SV_Bandwidth_Record( client, SV_BANDWIDTH_PLAYERSTATE, msg->bit - profileStart );
+	profileStart = msg->bit;
+#endif
+
 	// delta encode the entities
 #ifdef CMOD_GAMESTATE_OVERFLOW_FIX
 	SV_EmitPacketEntities (oldframe, frame, msg, client->baseline_cutoff);
@@ -218,6 +232,11 @@ static void SV_WriteSnapshotToClient( client_t *client, msg_t *msg ) {
 	SV_EmitPacketEntities (oldframe, frame, msg);
 #endif
 
+#ifdef CMOD_BANDWIDTH_PROFILE
+	SV_Bandwidth_EndSnapshot();
+	SV_Bandwidth_Record( client, SV_BANDWIDTH_ENTITIES, msg->bit - profileStart );
+#endif
+
 	// padding for rate debugging
 	if ( sv_padPackets->integer ) {
 		for ( i = 0 ; i < sv_padPackets->integer ; i++ ) {
@@ -239,9 +258,16 @@ void SV_UpdateServerCommandsToClient( client_t *client, msg_t *msg ) {
 
 	// write any unacknowledged serverCommands
 	for ( i = client->reliableAcknowledge + 1 ; i <= client->reliableSequence ; i++ ) {
+#ifdef CMOD_BANDWIDTH_PROFILE
+		int profileStart = msg->bit;
+#endif
 		MSG_WriteByte( msg, svc_serverCommand );
 		MSG_WriteLong( msg, i );
 		MSG_WriteString( msg, client->reliableCommands[ i & (MAX_RELIABLE_COMMANDS-1) ] );
+#ifdef CMOD_BANDWIDTH_PROFILE
+		SV_Bandwidth_RecordServerCommand( client, client->reliableCommands[ i & (MAX_RELIABLE_COMMANDS-1) ],
+				msg->bit - profileStart );
+#endif
 	}
 	client->reliableSent = client->reliableSequence;
 }
@@ -544,6 +570,10 @@ static void SV_BuildClientSnapshot( client_t *client ) {
 		}
 		frame->num_entities++;
 	}
+
+#ifdef CMOD_SNAPSHOT_ENTITY_PRIORITY
+	SV_Priority_ProcessSnapshot( client, frame );
+#endif
 }
 
 #ifdef USE_VOIP
@@ -673,6 +703,13 @@ void SV_SendClientSnapshot( client_t *client ) {
 		MSG_Clear (&msg);
 	}
 
+#ifdef CMOD_METRICS_ENDPOINT
+	++client->metricsSnapshots;
+	client->metricsSnapshotBytes += msg.cursize;
+#endif
+#ifdef CMOD_BANDWIDTH_PROFILE
+	SV_Bandwidth_RecordMessage( client, &msg );
+#endif
 	SV_SendMessageToClient( &msg, client );
 }
 
@@ -687,6 +724,10 @@ void SV_SendClientMessages(void)
 	int		i;
 	client_t	*c;
 
+#ifdef CMOD_FRAME_TRACE
+	CMTRACE_BEGIN( "SV_SendClientMessages" );
+#endif
+
 	// send a message to each connected client
 	for(i=0; i < sv_maxclients->integer; i++)
 	{
@@ -720,11 +761,28 @@ void SV_SendClientMessages(void)
 		}
 
 		// generate and send a new message
+#ifdef CMOD_SERVER_HITCH_LOG
+		if ( svHitchActive ) {
+			int64_t hitchStart = Sys_Microseconds();
+			SV_SendClientSnapshot(c);
+			SV_Hitch_RecordClientSnapshot( i, hitchStart );
+		} else
+#endif
 		SV_SendClientSnapshot(c);
 		c->lastSnapshotTime = svs.time;
 		c->rateDelayed = qfalse;
 	}
 #ifdef CMOD_RECORD
+#ifdef CMOD_SERVER_HITCH_LOG
+	if ( svHitchActive ) {
+		int64_t hitchStart = Sys_Microseconds();
+		record_process_snapshot();
+		SV_Hitch_RecordPhase( SV_HITCH_PHASE_RECORD, hitchStart );
+	} else
+#endif
 	record_process_snapshot();
 #endif
+#ifdef CMOD_FRAME_TRACE
+	CMTRACE_END();
+#endif
 }
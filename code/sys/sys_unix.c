@@ -616,6 +616,23 @@ int Sys_Milliseconds (void)
 	return curtime;
 }
 
+#ifdef CMOD_MICROSECOND_TIMER
+/*
+================
+Sys_Microseconds
+
+Returns monotonic time in microseconds from an arbitrary base. For profiling purposes only.
+================
+*/
+int64_t Sys_Microseconds( void )
+{
+	struct timespec ts;
+
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+#endif
+
 /*
 ==================
 Sys_RandomBytes
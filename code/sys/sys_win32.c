@@ -311,6 +311,28 @@ int Sys_Milliseconds (void)
 	return sys_curtime;
 }
 
+#ifdef CMOD_MICROSECOND_TIMER
+/*
+================
+Sys_Microseconds
+
+Returns monotonic time in microseconds from an arbitrary base. For profiling purposes only.
+================
+*/
+int64_t Sys_Microseconds( void )
+{
+	static LARGE_INTEGER frequency;
+	LARGE_INTEGER counter;
+
+	if ( !frequency.QuadPart ) {
+		QueryPerformanceFrequency( &frequency );
+	}
+	QueryPerformanceCounter( &counter );
+	return (int64_t)( counter.QuadPart / frequency.QuadPart ) * 1000000 +
+			( counter.QuadPart % frequency.QuadPart ) * 1000000 / frequency.QuadPart;
+}
+#endif
+
 /*
 ================
 Sys_RandomBytes
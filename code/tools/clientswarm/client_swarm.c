@@ -0,0 +1,1351 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+Copyright (C) 2017 Noah Metzger (chomenor@gmail.com)
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+
+#include "../../qcommon/q_shared.h"
+#include "../../qcommon/qcommon.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <setjmp.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <poll.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+/*
+###############################################################################################
+
+Client Swarm
+
+Standalone load testing tool which connects many lightweight clients to a server from one
+process. Each client goes through the real handshake (getchallenge, connect), receives the
+gamestate, parses and acknowledges delta compressed snapshots, and sends scripted usercmds.
+Packets are handled by the engine's net_chan.c, msg.c, and huffman.c, and the handshake and
+message parsing follow cl_main.c, cl_parse.c, and cl_input.c. Nothing is predicted or
+rendered, so hundreds of clients can run on one machine.
+
+Usage: client_swarm [-n clients] [-t seconds] [-r connects/sec] [-c cmds/sec]
+                    [-m idle|run|strafe|random] [-x command] [-o output.json] server[:port]
+
+  -n   number of clients (default 64)
+  -t   test duration in seconds, after the first client starts (default 60)
+  -r   new connections started per second (default 20)
+  -c   usercmd packets sent per second by each client (default 60)
+  -m   movement script (default run)
+  -x   client command sent once after entering the world, e.g. "team free"
+  -o   write per-client results as JSON
+
+Snapshot latency is measured the same way as the client ping: the time from sending a
+usercmd until receiving a snapshot whose playerstate commandTime includes it. Loss is the
+number of server messages skipped in the netchan sequence. Snapshots which couldn't be
+delta decoded because the reference snapshot was no longer held are counted separately.
+
+The server limits challenge requests from each address to a burst of 10 and then one per
+second. When the server is on 127.0.0.1, clients are bound to 127.0.0.2 and up, a few per
+address, so they can connect quickly. This falls back to the default address on systems
+which only route 127.0.0.1 to loopback.
+
+###############################################################################################
+*/
+
+#define SWARM_MAX_CLIENTS 1024
+#define SWARM_FRAME_BACKUP 4				// snapshots held for delta decoding; power of 2
+#define SWARM_RESEND_MSEC 1000
+#define SWARM_TIMEOUT_MSEC 30000
+#define SWARM_CLIENTS_PER_ADDRESS 4
+#define SWARM_LATENCY_BUCKETS 1000			// 1 msec each; last bucket holds everything above
+#define SWARM_RELIABLE_LENGTH 256
+
+typedef enum {
+	SC_WAITING,
+	SC_CHALLENGING,
+	SC_CONNECTING,
+	SC_CONNECTED,		// waiting for gamestate
+	SC_ACTIVE,			// gamestate received
+	SC_DISCONNECTED
+} swarmState_t;
+
+typedef enum {
+	SWARM_MOVE_IDLE,
+	SWARM_MOVE_RUN,
+	SWARM_MOVE_STRAFE,
+	SWARM_MOVE_RANDOM
+} movePattern_t;
+
+typedef struct {
+	qboolean valid;
+	int messageNum;
+	int serverTime;
+	playerState_t ps;
+	int numEntities;
+	entityState_t entities[MAX_SNAPSHOT_ENTITIES];
+} swarmSnapshot_t;
+
+typedef struct {
+	int realtime;
+	int serverTime;
+} swarmOutPacket_t;
+
+typedef struct {
+	int num;
+	int sock;
+	swarmState_t state;
+	char dropReason[128];
+
+	int clientChallenge;
+	int challenge;
+	int qport;
+	int startTime;
+	int activeTime;			// time first snapshot was received
+	int lastSendTime;
+	int lastReceiveTime;
+
+	netchan_t netchan;
+	int serverId;
+	int clientNum;
+	int checksumFeed;
+	int serverMessageSequence;
+	int serverCommandSequence;
+#ifndef ELITEFORCE
+	char lastServerCommand[MAX_STRING_CHARS];
+#endif
+	int reliableSequence;
+	int reliableAcknowledge;
+	char reliableCommands[MAX_RELIABLE_COMMANDS][SWARM_RELIABLE_LENGTH];
+	qboolean sentScriptCommand;
+
+	entityState_t baselines[MAX_GENTITIES];
+	swarmSnapshot_t snapshots[SWARM_FRAME_BACKUP];
+	int lastSnapshotNum;
+	int snapServerTime;
+	int snapReceiveTime;
+	int weapon;
+
+	usercmd_t cmds[2];		// previous and current; both are sent to cover a dropped packet
+	swarmOutPacket_t outPackets[PACKET_BACKUP];
+	int seed;
+	float yaw;
+	int nextMoveChange;
+	int forwardmove;
+	int rightmove;
+	int buttons;
+
+	int snapshotCount;
+	int droppedCount;
+	int deltaFailCount;
+	int bytesReceived;
+	int bytesSent;
+	int latencyCount;
+	int latencySum;
+	int latencyMax;
+} swarmClient_t;
+
+typedef struct {
+	netadr_t server;
+	int numClients;
+	int duration;
+	int connectRate;
+	int cmdRate;
+	movePattern_t pattern;
+	const char *scriptCommand;
+	const char *outPath;
+	qboolean spreadAddresses;
+
+	swarmClient_t *clients[SWARM_MAX_CLIENTS];
+	int numStarted;
+	int latencyHistogram[SWARM_LATENCY_BUCKETS];
+} swarm_t;
+
+static swarm_t swarm;
+
+// client whose socket is used by Sys_SendPacket
+static swarmClient_t *sendClient;
+
+// aborts processing of the current packet on Com_Error
+static jmp_buf *errorJump;
+
+static volatile sig_atomic_t interrupted;
+
+// referenced by msg.c and net_chan.c
+cvar_t *cl_shownet;
+cvar_t *cl_packetdelay;
+cvar_t *sv_packetdelay;
+cvar_t *com_timescale;
+
+/*
+###############################################################################################
+
+Engine Support Functions
+
+###############################################################################################
+*/
+
+void QDECL Com_Printf( const char *fmt, ... ) {
+	va_list argptr;
+	va_start( argptr, fmt );
+	vfprintf( stderr, fmt, argptr );
+	va_end( argptr );
+}
+
+void QDECL Com_DPrintf( const char *fmt, ... ) {
+}
+
+void QDECL Com_Error( int level, const char *error, ... ) {
+	char text[1024];
+	va_list argptr;
+
+	va_start( argptr, error );
+	Q_vsnprintf( text, sizeof( text ), error, argptr );
+	va_end( argptr );
+
+	if ( errorJump ) {
+		if ( sendClient ) {
+			Q_strncpyz( sendClient->dropReason, text, sizeof( sendClient->dropReason ) );
+		}
+		longjmp( *errorJump, 1 );
+	}
+	fprintf( stderr, "error: %s\n", text );
+	exit( 1 );
+}
+
+/*
+=================
+Cvar_Get
+
+Only used for the netchan debug cvars, which are left at their default values.
+=================
+*/
+cvar_t *Cvar_Get( const char *var_name, const char *value, int flags ) {
+	static cvar_t cvars[16];
+	static int numCvars;
+	cvar_t *cvar;
+
+	if ( numCvars >= ARRAY_LEN( cvars ) ) {
+		Com_Error( ERR_FATAL, "Cvar_Get: too many cvars" );
+	}
+	cvar = &cvars[numCvars++];
+	cvar->name = (char *)var_name;
+	cvar->string = (char *)value;
+	cvar->value = atof( value );
+	cvar->integer = atoi( value );
+	return cvar;
+}
+
+#ifdef ZONE_DEBUG
+void *S_MallocDebug( int size, char *label, char *file, int line ) {
+	return calloc( 1, size );
+}
+#else
+void *S_Malloc( int size ) {
+	return calloc( 1, size );
+}
+#endif
+
+void Z_Free( void *ptr ) {
+	free( ptr );
+}
+
+int Sys_Milliseconds( void ) {
+	static struct timespec start;
+	struct timespec now;
+
+	if ( !start.tv_sec && !start.tv_nsec ) {
+		clock_gettime( CLOCK_MONOTONIC, &start );
+	}
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	return (int)( ( now.tv_sec - start.tv_sec ) * 1000 + ( now.tv_nsec - start.tv_nsec ) / 1000000 );
+}
+
+const char *NET_AdrToString( netadr_t a ) {
+	static char s[64];
+	Com_sprintf( s, sizeof( s ), "%i.%i.%i.%i:%i", a.ip[0], a.ip[1], a.ip[2], a.ip[3], BigShort( a.port ) );
+	return s;
+}
+
+qboolean Sys_StringToAdr( const char *s, netadr_t *a, netadrtype_t family ) {
+	struct addrinfo hints;
+	struct addrinfo *res;
+
+	Com_Memset( &hints, 0, sizeof( hints ) );
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_DGRAM;
+	if ( getaddrinfo( s, NULL, &hints, &res ) || !res ) {
+		return qfalse;
+	}
+
+	Com_Memset( a, 0, sizeof( *a ) );
+	a->type = NA_IP;
+	Com_Memcpy( a->ip, &( (struct sockaddr_in *)res->ai_addr )->sin_addr, 4 );
+	freeaddrinfo( res );
+	return qtrue;
+}
+
+/*
+=================
+Sys_SendPacket
+
+Sends on the socket of sendClient, since each client has its own port.
+=================
+*/
+void Sys_SendPacket( int length, const void *data, netadr_t to ) {
+	struct sockaddr_in addr;
+
+	if ( !sendClient || to.type != NA_IP ) {
+		return;
+	}
+
+	Com_Memset( &addr, 0, sizeof( addr ) );
+	addr.sin_family = AF_INET;
+	addr.sin_port = to.port;
+	Com_Memcpy( &addr.sin_addr, to.ip, 4 );
+
+	if ( sendto( sendClient->sock, data, length, 0, (struct sockaddr *)&addr, sizeof( addr ) ) == length ) {
+		sendClient->bytesSent += length;
+	}
+}
+
+/*
+###############################################################################################
+
+Connection
+
+###############################################################################################
+*/
+
+/*
+=================
+SC_Drop
+=================
+*/
+static void SC_Drop( swarmClient_t *cl, const char *reason ) {
+	if ( cl->state == SC_DISCONNECTED ) {
+		return;
+	}
+	if ( !cl->dropReason[0] ) {
+		Q_strncpyz( cl->dropReason, reason, sizeof( cl->dropReason ) );
+	}
+	cl->state = SC_DISCONNECTED;
+	Com_Printf( "client %i: %s\n", cl->num, cl->dropReason );
+}
+
+/*
+=================
+SC_OpenSocket
+
+Opens a non-blocking socket for the client. If spreading is enabled, the socket is bound to
+a loopback address shared by a few clients.
+=================
+*/
+static qboolean SC_OpenSocket( swarmClient_t *cl ) {
+	struct sockaddr_in addr;
+
+	cl->sock = socket( AF_INET, SOCK_DGRAM, IPPROTO_UDP );
+	if ( cl->sock < 0 ) {
+		Com_Printf( "client %i: socket failed: %s\n", cl->num, strerror( errno ) );
+		return qfalse;
+	}
+	fcntl( cl->sock, F_SETFL, fcntl( cl->sock, F_GETFL ) | O_NONBLOCK );
+
+	if ( swarm.spreadAddresses ) {
+		int host = 2 + cl->num / SWARM_CLIENTS_PER_ADDRESS;
+		Com_Memset( &addr, 0, sizeof( addr ) );
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl( ( 127 << 24 ) | ( ( host >> 8 ) << 8 ) | ( host & 255 ) );
+		if ( bind( cl->sock, (struct sockaddr *)&addr, sizeof( addr ) ) < 0 ) {
+			Com_Printf( "Can't bind to 127.x.x.x addresses; using default address for all clients.\n" );
+			swarm.spreadAddresses = qfalse;
+		}
+	}
+
+	return qtrue;
+}
+
+/*
+=================
+SC_Start
+=================
+*/
+static void SC_Start( swarmClient_t *cl, int now ) {
+	cl->clientChallenge = ( ( rand() << 16 ) ^ rand() ) & 0x7fffffff;
+	cl->qport = ( 1000 + cl->num * 7 ) & 0xffff;
+	cl->seed = cl->num * 7919 + 1;
+	cl->yaw = ( cl->num * 37 ) % 360;
+	cl->startTime = now;
+	cl->lastReceiveTime = now;
+	cl->lastSendTime = now - SWARM_RESEND_MSEC;
+	cl->state = SC_CHALLENGING;
+}
+
+/*
+=================
+SC_AddReliableCommand
+=================
+*/
+static void SC_AddReliableCommand( swarmClient_t *cl, const char *cmd ) {
+	if ( cl->reliableSequence - cl->reliableAcknowledge >= MAX_RELIABLE_COMMANDS ) {
+		SC_Drop( cl, "reliable command overflow" );
+		return;
+	}
+	++cl->reliableSequence;
+	Q_strncpyz( cl->reliableCommands[cl->reliableSequence & ( MAX_RELIABLE_COMMANDS - 1 )], cmd,
+			SWARM_RELIABLE_LENGTH );
+}
+
+/*
+=================
+SC_SendHandshake
+
+Based on CL_CheckForResend.
+=================
+*/
+static void SC_SendHandshake( swarmClient_t *cl ) {
+	char info[MAX_INFO_STRING];
+
+	if ( cl->state == SC_CHALLENGING ) {
+		NET_OutOfBandPrint( NS_CLIENT, swarm.server, "getchallenge %d %s", cl->clientChallenge, GAMENAME_FOR_MASTER );
+		return;
+	}
+
+	info[0] = '\0';
+	Info_SetValueForKey( info, "name", va( "swarm%03i", cl->num ) );
+	Info_SetValueForKey( info, "rate", "25000" );
+	Info_SetValueForKey( info, "snaps", "20" );
+	Info_SetValueForKey( info, "protocol", va( "%i", PROTOCOL_VERSION ) );
+	Info_SetValueForKey( info, "qport", va( "%i", cl->qport ) );
+	Info_SetValueForKey( info, "challenge", va( "%i", cl->challenge ) );
+
+#ifdef ELITEFORCE
+	NET_OutOfBandPrint( NS_CLIENT, swarm.server, "connect \"%s\"", info );
+#else
+	{
+		char data[MAX_INFO_STRING + 10];
+		Com_sprintf( data, sizeof( data ), "connect \"%s\"", info );
+		NET_OutOfBandData( NS_CLIENT, swarm.server, (byte *)data, strlen( data ) );
+	}
+#endif
+}
+
+/*
+=================
+SC_ConnectionlessPacket
+
+Based on CL_ConnectionlessPacket.
+=================
+*/
+static void SC_ConnectionlessPacket( swarmClient_t *cl, msg_t *msg ) {
+	char line[MAX_STRING_CHARS];
+	char *text = line;
+	char *token;
+
+	MSG_BeginReadingOOB( msg );
+	MSG_ReadLong( msg );	// skip the -1
+	Q_strncpyz( line, MSG_ReadStringLine( msg ), sizeof( line ) );
+
+	token = COM_Parse( &text );
+	if ( !Q_stricmp( token, "challengeResponse" ) ) {
+		int challenge;
+		if ( cl->state != SC_CHALLENGING ) {
+			return;
+		}
+		challenge = atoi( COM_Parse( &text ) );
+		if ( atoi( COM_Parse( &text ) ) != cl->clientChallenge ) {
+			return;
+		}
+		cl->challenge = challenge;
+		cl->state = SC_CONNECTING;
+		SC_SendHandshake( cl );
+		cl->lastSendTime = Sys_Milliseconds();
+	} else if ( !Q_stricmp( token, "connectResponse" ) ) {
+		if ( cl->state != SC_CONNECTING || atoi( COM_Parse( &text ) ) != cl->challenge ) {
+			return;
+		}
+		Netchan_Setup( NS_CLIENT, &cl->netchan, swarm.server, cl->qport, cl->challenge, qfalse );
+		cl->state = SC_CONNECTED;
+		cl->lastSendTime = -SWARM_RESEND_MSEC;
+	} else if ( !Q_stricmp( token, "print" ) && cl->state < SC_CONNECTED ) {
+		// usually a rejection, such as server full or banned
+		Q_strncpyz( line, MSG_ReadString( msg ), sizeof( line ) );
+		Q_strncpyz( cl->dropReason, line, sizeof( cl->dropReason ) );
+		if ( strchr( cl->dropReason, '\n' ) ) {
+			*strchr( cl->dropReason, '\n' ) = '\0';
+		}
+		SC_Drop( cl, "rejected" );
+	}
+}
+
+/*
+###############################################################################################
+
+Message Parsing
+
+###############################################################################################
+*/
+
+/*
+=================
+SC_DeltaEntity
+
+Based on CL_DeltaEntity.
+=================
+*/
+static void SC_DeltaEntity( msg_t *msg, swarmSnapshot_t *frame, int newnum, entityState_t *old,
+		qboolean unchanged ) {
+	entityState_t *state;
+
+	if ( frame->numEntities >= MAX_SNAPSHOT_ENTITIES ) {
+		Com_Error( ERR_DROP, "SC_DeltaEntity: too many entities" );
+	}
+	state = &frame->entities[frame->numEntities];
+
+	if ( unchanged ) {
+		*state = *old;
+	} else {
+		MSG_ReadDeltaEntity( msg, old, state, newnum );
+	}
+
+	if ( state->number == ( MAX_GENTITIES - 1 ) ) {
+		return;		// entity was delta removed
+	}
+	frame->numEntities++;
+}
+
+/*
+=================
+SC_NextOldEntity
+=================
+*/
+static int SC_NextOldEntity( swarmSnapshot_t *oldframe, int oldindex, entityState_t **oldstate ) {
+	if ( !oldframe || oldindex >= oldframe->numEntities ) {
+		return 99999;
+	}
+	*oldstate = &oldframe->entities[oldindex];
+	return ( *oldstate )->number;
+}
+
+/*
+=================
+SC_ParsePacketEntities
+
+Based on CL_ParsePacketEntities.
+=================
+*/
+static void SC_ParsePacketEntities( swarmClient_t *cl, msg_t *msg, swarmSnapshot_t *oldframe,
+		swarmSnapshot_t *newframe ) {
+	entityState_t *oldstate = NULL;
+	int oldindex = 0;
+	int oldnum = SC_NextOldEntity( oldframe, oldindex, &oldstate );
+	int newnum;
+
+	newframe->numEntities = 0;
+
+	while ( 1 ) {
+		newnum = MSG_ReadBits( msg, GENTITYNUM_BITS );
+		if ( newnum == ( MAX_GENTITIES - 1 ) ) {
+			break;
+		}
+		if ( msg->readcount > msg->cursize ) {
+			Com_Error( ERR_DROP, "SC_ParsePacketEntities: end of message" );
+		}
+
+		while ( oldnum < newnum ) {
+			// one or more entities from the old packet are unchanged
+			SC_DeltaEntity( msg, newframe, oldnum, oldstate, qtrue );
+			oldnum = SC_NextOldEntity( oldframe, ++oldindex, &oldstate );
+		}
+
+		if ( oldnum == newnum ) {
+			// delta from previous state
+			SC_DeltaEntity( msg, newframe, newnum, oldstate, qfalse );
+			oldnum = SC_NextOldEntity( oldframe, ++oldindex, &oldstate );
+		} else {
+			// delta from baseline
+			SC_DeltaEntity( msg, newframe, newnum, &cl->baselines[newnum], qfalse );
+		}
+	}
+
+	// any remaining entities in the old frame are copied over
+	while ( oldnum != 99999 ) {
+		SC_DeltaEntity( msg, newframe, oldnum, oldstate, qtrue );
+		oldnum = SC_NextOldEntity( oldframe, ++oldindex, &oldstate );
+	}
+}
+
+/*
+=================
+SC_RecordLatency
+
+Based on the ping calculation in CL_ParseSnapshot.
+=================
+*/
+static void SC_RecordLatency( swarmClient_t *cl, const playerState_t *ps, int now ) {
+	int i;
+
+	for ( i = 0; i < PACKET_BACKUP; ++i ) {
+		const swarmOutPacket_t *packet = &cl->outPackets[( cl->netchan.outgoingSequence - 1 - i ) & PACKET_MASK];
+		if ( packet->serverTime && ps->commandTime >= packet->serverTime ) {
+			int latency = now - packet->realtime;
+			cl->latencySum += latency;
+			++cl->latencyCount;
+			if ( latency > cl->latencyMax ) {
+				cl->latencyMax = latency;
+			}
+			++swarm.latencyHistogram[latency < SWARM_LATENCY_BUCKETS ? latency : SWARM_LATENCY_BUCKETS - 1];
+			return;
+		}
+	}
+}
+
+/*
+=================
+SC_ParseSnapshot
+
+Based on CL_ParseSnapshot. Snapshots are parsed into a scratch buffer first, since the new
+snapshot can replace its own delta source in the backup ring.
+=================
+*/
+static void SC_ParseSnapshot( swarmClient_t *cl, msg_t *msg, int now ) {
+	static swarmSnapshot_t newSnap;
+	swarmSnapshot_t *old = NULL;
+	swarmSnapshot_t *dest;
+	byte areamask[MAX_MAP_AREA_BYTES];
+	int deltaNum;
+	int len;
+
+	newSnap.valid = qfalse;
+	newSnap.serverTime = MSG_ReadLong( msg );
+	newSnap.messageNum = cl->serverMessageSequence;
+
+	deltaNum = MSG_ReadByte( msg );
+	deltaNum = deltaNum ? newSnap.messageNum - deltaNum : -1;
+	MSG_ReadByte( msg );	// snapFlags
+
+	if ( deltaNum <= 0 ) {
+		newSnap.valid = qtrue;
+	} else {
+		old = &cl->snapshots[deltaNum & ( SWARM_FRAME_BACKUP - 1 )];
+		if ( old->valid && old->messageNum == deltaNum ) {
+			newSnap.valid = qtrue;
+		}
+	}
+
+	len = MSG_ReadByte( msg );
+	if ( len > (int)sizeof( areamask ) ) {
+		Com_Error( ERR_DROP, "SC_ParseSnapshot: invalid size %d for areamask", len );
+	}
+	MSG_ReadData( msg, areamask, len );
+
+	MSG_ReadDeltaPlayerstate( msg, old ? &old->ps : NULL, &newSnap.ps );
+	SC_ParsePacketEntities( cl, msg, old, &newSnap );
+
+	if ( !newSnap.valid ) {
+		++cl->deltaFailCount;
+		return;
+	}
+
+	// only copy the used part of the entity list
+	dest = &cl->snapshots[newSnap.messageNum & ( SWARM_FRAME_BACKUP - 1 )];
+	Com_Memcpy( dest, &newSnap, (size_t)( (byte *)&newSnap.entities[newSnap.numEntities] - (byte *)&newSnap ) );
+
+	cl->lastSnapshotNum = newSnap.messageNum;
+	cl->snapServerTime = newSnap.serverTime;
+	cl->snapReceiveTime = now;
+	cl->weapon = newSnap.ps.weapon;
+	if ( !cl->snapshotCount++ ) {
+		cl->activeTime = now;
+	}
+
+	SC_RecordLatency( cl, &newSnap.ps, now );
+}
+
+/*
+=================
+SC_ParseGamestate
+
+Based on CL_ParseGamestate. Only the server id is kept from the configstrings.
+=================
+*/
+static void SC_ParseGamestate( swarmClient_t *cl, msg_t *msg ) {
+	int cmd;
+
+	Com_Memset( cl->snapshots, 0, sizeof( cl->snapshots ) );
+	Com_Memset( cl->baselines, 0, sizeof( cl->baselines ) );
+	Com_Memset( cl->cmds, 0, sizeof( cl->cmds ) );
+	cl->snapServerTime = 0;
+	cl->serverCommandSequence = MSG_ReadLong( msg );
+
+	while ( 1 ) {
+		cmd = MSG_ReadByte( msg );
+		if ( cmd == svc_EOF ) {
+			break;
+		}
+
+		if ( cmd == svc_configstring ) {
+			int index = MSG_ReadShort( msg );
+			const char *s = MSG_ReadBigString( msg );
+			if ( index < 0 || index >= MAX_CONFIGSTRINGS ) {
+				Com_Error( ERR_DROP, "configstring > MAX_CONFIGSTRINGS" );
+			}
+			if ( index == CS_SYSTEMINFO ) {
+				cl->serverId = atoi( Info_ValueForKey( s, "sv_serverid" ) );
+			}
+		} else if ( cmd == svc_baseline ) {
+			entityState_t nullstate;
+			int newnum = MSG_ReadBits( msg, GENTITYNUM_BITS );
+			if ( newnum < 0 || newnum >= MAX_GENTITIES ) {
+				Com_Error( ERR_DROP, "Baseline number out of range: %i", newnum );
+			}
+			Com_Memset( &nullstate, 0, sizeof( nullstate ) );
+			MSG_ReadDeltaEntity( msg, &nullstate, &cl->baselines[newnum], newnum );
+		} else {
+			Com_Error( ERR_DROP, "SC_ParseGamestate: bad command byte" );
+		}
+	}
+
+	cl->clientNum = MSG_ReadLong( msg );
+	cl->checksumFeed = MSG_ReadLong( msg );
+	cl->state = SC_ACTIVE;
+}
+
+/*
+=================
+SC_ParseCommandString
+
+Configstring changes aren't tracked. If a map_restart changes the server id, the server
+resends the gamestate once it sees the old id.
+=================
+*/
+static void SC_ParseCommandString( swarmClient_t *cl, msg_t *msg ) {
+	int seq = MSG_ReadLong( msg );
+	const char *s = MSG_ReadString( msg );
+
+	// commands are repeated until acknowledged, so skip ones already seen
+	if ( cl->serverCommandSequence >= seq ) {
+		return;
+	}
+	cl->serverCommandSequence = seq;
+#ifndef ELITEFORCE
+	Q_strncpyz( cl->lastServerCommand, s, sizeof( cl->lastServerCommand ) );
+#endif
+
+	if ( !Q_strncmp( s, "disconnect", 10 ) ) {
+		Q_strncpyz( cl->dropReason, s[10] ? s + 11 : "disconnected by server", sizeof( cl->dropReason ) );
+		SC_Drop( cl, "disconnected by server" );
+	}
+}
+
+/*
+=================
+SC_ParseServerMessage
+
+Based on CL_ParseServerMessage.
+=================
+*/
+static void SC_ParseServerMessage( swarmClient_t *cl, msg_t *msg, int now ) {
+	int cmd;
+
+	MSG_Bitstream( msg );
+
+	cl->reliableAcknowledge = MSG_ReadLong( msg );
+	if ( cl->reliableAcknowledge < cl->reliableSequence - MAX_RELIABLE_COMMANDS ) {
+		cl->reliableAcknowledge = cl->reliableSequence;
+	}
+
+	while ( cl->state != SC_DISCONNECTED ) {
+		if ( msg->readcount > msg->cursize ) {
+			Com_Error( ERR_DROP, "SC_ParseServerMessage: read past end of server message" );
+		}
+
+		cmd = MSG_ReadByte( msg );
+		if ( cmd == svc_EOF ) {
+			return;
+		}
+
+		switch ( cmd ) {
+			case svc_nop:
+				break;
+			case svc_serverCommand:
+				SC_ParseCommandString( cl, msg );
+				break;
+			case svc_gamestate:
+				SC_ParseGamestate( cl, msg );
+				break;
+			case svc_snapshot:
+				SC_ParseSnapshot( cl, msg, now );
+				break;
+			case svc_download:
+			case svc_voipSpeex:
+			case svc_voipOpus:
+				// nothing of interest follows
+				return;
+			default:
+				Com_Error( ERR_DROP, "SC_ParseServerMessage: illegible server message" );
+		}
+	}
+}
+
+/*
+=================
+SC_ReadPackets
+=================
+*/
+static void SC_ReadPackets( swarmClient_t *cl, int now ) {
+	byte data[MAX_MSGLEN];
+	struct sockaddr_in from;
+	socklen_t fromLength;
+	jmp_buf jump;
+	msg_t msg;
+	int length;
+
+	sendClient = cl;
+	if ( setjmp( jump ) ) {
+		errorJump = NULL;
+		SC_Drop( cl, "parse error" );
+		return;
+	}
+	errorJump = &jump;
+
+	while ( cl->state != SC_DISCONNECTED ) {
+		fromLength = sizeof( from );
+		length = recvfrom( cl->sock, data, sizeof( data ), 0, (struct sockaddr *)&from, &fromLength );
+		if ( length < 0 ) {
+			break;
+		}
+
+		// ignore anything that isn't from the server
+		if ( from.sin_port != swarm.server.port || memcmp( &from.sin_addr, swarm.server.ip, 4 ) ) {
+			continue;
+		}
+
+		MSG_Init( &msg, data, sizeof( data ) );
+		msg.cursize = length;
+		cl->bytesReceived += length;
+		cl->lastReceiveTime = now;
+
+		if ( length >= 4 && *(int *)data == -1 ) {
+			SC_ConnectionlessPacket( cl, &msg );
+			continue;
+		}
+
+		if ( cl->state < SC_CONNECTED || length < 4 ) {
+			continue;
+		}
+		if ( !Netchan_Process( &cl->netchan, &msg ) ) {
+			continue;
+		}
+		cl->droppedCount += cl->netchan.dropped;
+
+		cl->serverMessageSequence = LittleLong( *(int *)msg.data );
+		SC_ParseServerMessage( cl, &msg, now );
+	}
+
+	errorJump = NULL;
+}
+
+/*
+###############################################################################################
+
+Usercmds
+
+###############################################################################################
+*/
+
+/*
+=================
+SC_BuildCmd
+
+Generates movement from the selected script.
+=================
+*/
+static void SC_BuildCmd( swarmClient_t *cl, usercmd_t *cmd, int now ) {
+	float frametime = 1.0f / swarm.cmdRate;
+
+	Com_Memset( cmd, 0, sizeof( *cmd ) );
+
+	// estimate the server time from the last snapshot; the first commands after a gamestate
+	// just need to be in order, and are only used to enter the world
+	if ( cl->snapServerTime ) {
+		cmd->serverTime = cl->snapServerTime + ( now - cl->snapReceiveTime );
+	}
+	if ( cmd->serverTime <= cl->cmds[1].serverTime ) {
+		cmd->serverTime = cl->cmds[1].serverTime + 1;
+	}
+	cmd->weapon = cl->weapon;
+
+	switch ( swarm.pattern ) {
+		case SWARM_MOVE_IDLE:
+			break;
+		case SWARM_MOVE_RUN:
+			cl->yaw += 90.0f * frametime;
+			cmd->forwardmove = 127;
+			break;
+		case SWARM_MOVE_STRAFE:
+			cmd->forwardmove = 127;
+			cmd->rightmove = ( ( now + cl->num * 250 ) / 1000 ) & 1 ? 127 : -127;
+			cmd->upmove = ( ( now + cl->num * 250 ) % 2000 ) < 100 ? 127 : 0;
+			break;
+		case SWARM_MOVE_RANDOM:
+			if ( now >= cl->nextMoveChange ) {
+				cl->forwardmove = ( Q_rand( &cl->seed ) % 3 - 1 ) * 127;
+				cl->rightmove = ( Q_rand( &cl->seed ) % 3 - 1 ) * 127;
+				cl->buttons = Q_rand( &cl->seed ) & 1 ? BUTTON_ATTACK : 0;
+				cl->yaw = Q_random( &cl->seed ) * 360.0f;
+				cl->nextMoveChange = now + 500 + Q_rand( &cl->seed ) % 1000;
+			}
+			cmd->forwardmove = cl->forwardmove;
+			cmd->rightmove = cl->rightmove;
+			cmd->buttons = cl->buttons;
+			break;
+	}
+
+	cl->yaw = AngleNormalize360( cl->yaw );
+	cmd->angles[YAW] = ANGLE2SHORT( cl->yaw );
+}
+
+/*
+=================
+SC_WritePacket
+
+Based on CL_WritePacket. Sends the reliable commands and, once the gamestate has been
+received, the current and previous usercmds.
+=================
+*/
+static void SC_WritePacket( swarmClient_t *cl, int now ) {
+	byte data[MAX_MSGLEN];
+	swarmOutPacket_t *packet = &cl->outPackets[cl->netchan.outgoingSequence & PACKET_MASK];
+	usercmd_t nullcmd;
+	usercmd_t *oldcmd;
+	msg_t buf;
+	int i;
+
+	MSG_Init( &buf, data, sizeof( data ) );
+	MSG_Bitstream( &buf );
+
+	MSG_WriteLong( &buf, cl->serverId );
+	MSG_WriteLong( &buf, cl->serverMessageSequence );
+	MSG_WriteLong( &buf, cl->serverCommandSequence );
+
+	for ( i = cl->reliableAcknowledge + 1; i <= cl->reliableSequence; ++i ) {
+		MSG_WriteByte( &buf, clc_clientCommand );
+		MSG_WriteLong( &buf, i );
+		MSG_WriteString( &buf, cl->reliableCommands[i & ( MAX_RELIABLE_COMMANDS - 1 )] );
+	}
+
+	packet->serverTime = 0;
+	if ( cl->state == SC_ACTIVE ) {
+		int count = cl->cmds[1].serverTime ? 2 : 1;
+#ifndef ELITEFORCE
+		int key = cl->checksumFeed ^ cl->serverMessageSequence ^ MSG_HashKey( cl->lastServerCommand, 32 );
+#endif
+
+		cl->cmds[0] = cl->cmds[1];
+		SC_BuildCmd( cl, &cl->cmds[1], now );
+
+		// request a full snapshot if the last message couldn't be used as a delta source
+		if ( !cl->snapServerTime || cl->serverMessageSequence != cl->lastSnapshotNum ) {
+			MSG_WriteByte( &buf, clc_moveNoDelta );
+		} else {
+			MSG_WriteByte( &buf, clc_move );
+		}
+		MSG_WriteByte( &buf, count );
+
+		Com_Memset( &nullcmd, 0, sizeof( nullcmd ) );
+		oldcmd = &nullcmd;
+		for ( i = 2 - count; i < 2; ++i ) {
+#ifdef ELITEFORCE
+			MSG_WriteDeltaUsercmd( &buf, oldcmd, &cl->cmds[i] );
+#else
+			MSG_WriteDeltaUsercmdKey( &buf, key, oldcmd, &cl->cmds[i] );
+#endif
+			oldcmd = &cl->cmds[i];
+		}
+
+		packet->realtime = now;
+		packet->serverTime = cl->cmds[1].serverTime;
+	}
+
+	MSG_WriteByte( &buf, clc_EOF );
+	Netchan_Transmit( &cl->netchan, buf.cursize, buf.data );
+	while ( cl->netchan.unsentFragments ) {
+		Netchan_TransmitNextFragment( &cl->netchan );
+	}
+	cl->lastSendTime = now;
+}
+
+/*
+=================
+SC_Frame
+
+Sends any packets that are due.
+=================
+*/
+static void SC_Frame( swarmClient_t *cl, int now ) {
+	sendClient = cl;
+
+	if ( cl->state == SC_WAITING || cl->state == SC_DISCONNECTED ) {
+		return;
+	}
+
+	if ( now - cl->lastReceiveTime > SWARM_TIMEOUT_MSEC ) {
+		SC_Drop( cl, cl->state < SC_CONNECTED ? "no response to connection request" : "timed out" );
+		return;
+	}
+
+	switch ( cl->state ) {
+		case SC_CHALLENGING:
+		case SC_CONNECTING:
+			if ( now - cl->lastSendTime >= SWARM_RESEND_MSEC ) {
+				SC_SendHandshake( cl );
+				cl->lastSendTime = now;
+			}
+			break;
+		case SC_CONNECTED:
+			// the server sends the gamestate in response to any packet
+			if ( now - cl->lastSendTime >= SWARM_RESEND_MSEC ) {
+				SC_WritePacket( cl, now );
+			}
+			break;
+		case SC_ACTIVE:
+			if ( swarm.scriptCommand && !cl->sentScriptCommand && cl->snapshotCount ) {
+				SC_AddReliableCommand( cl, swarm.scriptCommand );
+				cl->sentScriptCommand = qtrue;
+			}
+			if ( now - cl->lastSendTime >= 1000 / swarm.cmdRate ) {
+				SC_WritePacket( cl, now );
+			}
+			break;
+		default:
+			break;
+	}
+}
+
+/*
+=================
+SC_Disconnect
+
+Based on CL_Disconnect, which sends the command several times in case of packet loss.
+=================
+*/
+static void SC_Disconnect( swarmClient_t *cl, int now ) {
+	int i;
+
+	if ( cl->state < SC_CONNECTED || cl->state == SC_DISCONNECTED ) {
+		return;
+	}
+
+	sendClient = cl;
+	SC_AddReliableCommand( cl, "disconnect" );
+	for ( i = 0; i < 3 && cl->state != SC_DISCONNECTED; ++i ) {
+		SC_WritePacket( cl, now );
+	}
+}
+
+/*
+###############################################################################################
+
+Results
+
+###############################################################################################
+*/
+
+/*
+=================
+SC_LatencyPercentile
+=================
+*/
+static int SC_LatencyPercentile( int total, float fraction ) {
+	int target = (int)( total * fraction );
+	int count = 0;
+	int i;
+
+	for ( i = 0; i < SWARM_LATENCY_BUCKETS; ++i ) {
+		count += swarm.latencyHistogram[i];
+		if ( count > target ) {
+			return i;
+		}
+	}
+	return SWARM_LATENCY_BUCKETS - 1;
+}
+
+/*
+=================
+SC_WriteJSONString
+=================
+*/
+static void SC_WriteJSONString( FILE *out, const char *s ) {
+	fputc( '"', out );
+	for ( ; *s; ++s ) {
+		unsigned char c = (unsigned char)*s;
+		if ( c == '"' || c == '\\' ) {
+			fputc( '\\', out );
+			fputc( c, out );
+		} else if ( c < 0x20 ) {
+			fprintf( out, "\\u%04x", c );
+		} else {
+			fputc( c, out );
+		}
+	}
+	fputc( '"', out );
+}
+
+/*
+=================
+SC_WriteResults
+=================
+*/
+static void SC_WriteResults( int elapsed ) {
+	int active = 0;
+	int snapshots = 0;
+	int dropped = 0;
+	int deltaFails = 0;
+	int latencyCount = 0;
+	int latencySum = 0;
+	int latencyMax = 0;
+	double bytesReceived = 0.0;
+	double bytesSent = 0.0;
+	FILE *out = NULL;
+	int i;
+
+	for ( i = 0; i < swarm.numStarted; ++i ) {
+		const swarmClient_t *cl = swarm.clients[i];
+		if ( cl->snapshotCount ) {
+			++active;
+		}
+		snapshots += cl->snapshotCount;
+		dropped += cl->droppedCount;
+		deltaFails += cl->deltaFailCount;
+		latencyCount += cl->latencyCount;
+		latencySum += cl->latencySum;
+		if ( cl->latencyMax > latencyMax ) {
+			latencyMax = cl->latencyMax;
+		}
+		bytesReceived += cl->bytesReceived;
+		bytesSent += cl->bytesSent;
+	}
+
+	if ( elapsed < 1 ) {
+		elapsed = 1;
+	}
+
+	printf( "%i clients started, %i received snapshots over %.1f seconds\n", swarm.numStarted, active,
+			elapsed / 1000.0 );
+	printf( "snapshots: %i received, %i messages dropped (%.2f%%), %i delta failures\n", snapshots, dropped,
+			snapshots + dropped ? dropped * 100.0 / ( snapshots + dropped ) : 0.0, deltaFails );
+	if ( latencyCount ) {
+		printf( "latency: avg %.1f, p50 %i, p95 %i, p99 %i, max %i msec\n", (double)latencySum / latencyCount,
+				SC_LatencyPercentile( latencyCount, 0.5f ), SC_LatencyPercentile( latencyCount, 0.95f ),
+				SC_LatencyPercentile( latencyCount, 0.99f ), latencyMax );
+	}
+	printf( "bandwidth: %.1f KB/s received, %.1f KB/s sent\n", bytesReceived / elapsed, bytesSent / elapsed );
+
+	if ( !swarm.outPath ) {
+		return;
+	}
+	out = fopen( swarm.outPath, "w" );
+	if ( !out ) {
+		Com_Printf( "failed to open output file %s\n", swarm.outPath );
+		return;
+	}
+
+	fprintf( out, "{\"server\":\"%s\",\"clients\":%i,\"elapsedMsec\":%i,\"snapshots\":%i,\"dropped\":%i,"
+			"\"deltaFailures\":%i", NET_AdrToString( swarm.server ), swarm.numStarted, elapsed, snapshots,
+			dropped, deltaFails );
+	if ( latencyCount ) {
+		fprintf( out, ",\"latency\":{\"avg\":%.2f,\"p50\":%i,\"p95\":%i,\"p99\":%i,\"max\":%i}",
+				(double)latencySum / latencyCount, SC_LatencyPercentile( latencyCount, 0.5f ),
+				SC_LatencyPercentile( latencyCount, 0.95f ), SC_LatencyPercentile( latencyCount, 0.99f ),
+				latencyMax );
+	}
+	fputs( ",\"perClient\":[", out );
+	for ( i = 0; i < swarm.numStarted; ++i ) {
+		const swarmClient_t *cl = swarm.clients[i];
+		fprintf( out, "%s\n{\"num\":%i,\"connectMsec\":%i,\"snapshots\":%i,\"dropped\":%i,\"deltaFailures\":%i,"
+				"\"latencyAvg\":%.2f,\"latencyMax\":%i,\"bytesReceived\":%i,\"bytesSent\":%i,\"dropReason\":",
+				i ? "," : "", cl->num, cl->snapshotCount ? cl->activeTime - cl->startTime : -1,
+				cl->snapshotCount, cl->droppedCount, cl->deltaFailCount,
+				cl->latencyCount ? (double)cl->latencySum / cl->latencyCount : 0.0, cl->latencyMax,
+				cl->bytesReceived, cl->bytesSent );
+		SC_WriteJSONString( out, cl->dropReason );
+		fputc( '}', out );
+	}
+	fputs( "]}\n", out );
+	fclose( out );
+}
+
+/*
+###############################################################################################
+
+Main
+
+###############################################################################################
+*/
+
+static void SC_SignalHandler( int sig ) {
+	interrupted = 1;
+}
+
+/*
+=================
+SC_Usage
+=================
+*/
+static void SC_Usage( void ) {
+	fprintf( stderr, "usage: client_swarm [-n clients] [-t seconds] [-r connects/sec] [-c cmds/sec]\n"
+			"                    [-m idle|run|strafe|random] [-x command] [-o output.json] server[:port]\n" );
+	exit( 1 );
+}
+
+int main( int argc, char **argv ) {
+	struct pollfd fds[SWARM_MAX_CLIENTS];
+	int startTime;
+	int now;
+	int i;
+
+	swarm.numClients = 64;
+	swarm.duration = 60;
+	swarm.connectRate = 20;
+	swarm.cmdRate = 60;
+	swarm.pattern = SWARM_MOVE_RUN;
+
+	for ( i = 1; i < argc && argv[i][0] == '-'; ++i ) {
+		if ( i + 1 >= argc ) {
+			SC_Usage();
+		}
+		if ( !strcmp( argv[i], "-n" ) ) {
+			swarm.numClients = atoi( argv[++i] );
+		} else if ( !strcmp( argv[i], "-t" ) ) {
+			swarm.duration = atoi( argv[++i] );
+		} else if ( !strcmp( argv[i], "-r" ) ) {
+			swarm.connectRate = atoi( argv[++i] );
+		} else if ( !strcmp( argv[i], "-c" ) ) {
+			swarm.cmdRate = atoi( argv[++i] );
+		} else if ( !strcmp( argv[i], "-m" ) ) {
+			++i;
+			if ( !strcmp( argv[i], "idle" ) ) {
+				swarm.pattern = SWARM_MOVE_IDLE;
+			} else if ( !strcmp( argv[i], "run" ) ) {
+				swarm.pattern = SWARM_MOVE_RUN;
+			} else if ( !strcmp( argv[i], "strafe" ) ) {
+				swarm.pattern = SWARM_MOVE_STRAFE;
+			} else if ( !strcmp( argv[i], "random" ) ) {
+				swarm.pattern = SWARM_MOVE_RANDOM;
+			} else {
+				SC_Usage();
+			}
+		} else if ( !strcmp( argv[i], "-x" ) ) {
+			swarm.scriptCommand = argv[++i];
+		} else if ( !strcmp( argv[i], "-o" ) ) {
+			swarm.outPath = argv[++i];
+		} else {
+			SC_Usage();
+		}
+	}
+
+	if ( i != argc - 1 ) {
+		SC_Usage();
+	}
+	if ( swarm.numClients < 1 || swarm.numClients > SWARM_MAX_CLIENTS ) {
+		Com_Error( ERR_FATAL, "client count must be between 1 and %i", SWARM_MAX_CLIENTS );
+	}
+	if ( swarm.duration < 1 || swarm.connectRate < 1 || swarm.cmdRate < 1 || swarm.cmdRate > 1000 ) {
+		SC_Usage();
+	}
+
+	// NET_StringToAdr maps "localhost" to the loopback channel, which doesn't exist here
+	if ( !Q_stricmp( argv[i], "localhost" ) || !Q_stricmpn( argv[i], "localhost:", 10 ) ) {
+		NET_StringToAdr( va( "127.0.0.1%s", argv[i] + 9 ), &swarm.server, NA_IP );
+	} else {
+		NET_StringToAdr( argv[i], &swarm.server, NA_IP );
+	}
+	if ( swarm.server.type != NA_IP ) {
+		Com_Error( ERR_FATAL, "couldn't resolve server address %s", argv[i] );
+	}
+	swarm.spreadAddresses = swarm.server.ip[0] == 127 && swarm.server.ip[1] == 0 &&
+			swarm.server.ip[2] == 0 && swarm.server.ip[3] == 1 ? qtrue : qfalse;
+
+	cl_packetdelay = Cvar_Get( "cl_packetdelay", "0", 0 );
+	sv_packetdelay = Cvar_Get( "sv_packetdelay", "0", 0 );
+	com_timescale = Cvar_Get( "timescale", "1", 0 );
+	Netchan_Init( 0 );
+
+	signal( SIGINT, SC_SignalHandler );
+	srand( (unsigned int)time( NULL ) );
+
+	for ( i = 0; i < swarm.numClients; ++i ) {
+		swarmClient_t *cl = (swarmClient_t *)calloc( 1, sizeof( *cl ) );
+		if ( !cl ) {
+			Com_Error( ERR_FATAL, "out of memory" );
+		}
+		cl->num = i;
+		if ( !SC_OpenSocket( cl ) ) {
+			exit( 1 );
+		}
+		swarm.clients[i] = cl;
+		fds[i].fd = cl->sock;
+		fds[i].events = POLLIN;
+	}
+
+	printf( "Connecting %i clients to %s\n", swarm.numClients, NET_AdrToString( swarm.server ) );
+	startTime = now = Sys_Milliseconds();
+
+	while ( !interrupted && now - startTime < swarm.duration * 1000 ) {
+		// start new connections at the requested rate
+		while ( swarm.numStarted < swarm.numClients &&
+				swarm.numStarted <= ( now - startTime ) * swarm.connectRate / 1000 ) {
+			SC_Start( swarm.clients[swarm.numStarted++], now );
+		}
+
+		for ( i = 0; i < swarm.numStarted; ++i ) {
+			SC_Frame( swarm.clients[i], now );
+		}
+
+		if ( poll( fds, swarm.numStarted, 1 ) > 0 ) {
+			now = Sys_Milliseconds();
+			for ( i = 0; i < swarm.numStarted; ++i ) {
+				if ( fds[i].revents & POLLIN ) {
+					SC_ReadPackets( swarm.clients[i], now );
+				}
+			}
+		}
+
+		now = Sys_Milliseconds();
+	}
+
+	for ( i = 0; i < swarm.numStarted; ++i ) {
+		SC_Disconnect( swarm.clients[i], now );
+	}
+
+	SC_WriteResults( now - startTime );
+
+	for ( i = 0; i < swarm.numClients; ++i ) {
+		close( swarm.clients[i]->sock );
+		free( swarm.clients[i] );
+	}
+	return 0;
+}
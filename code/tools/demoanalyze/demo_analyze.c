@@ -0,0 +1,891 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+Copyright (C) 2017 Noah Metzger (chomenor@gmail.com)
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+
+#include "../../qcommon/q_shared.h"
+#include "../../qcommon/qcommon.h"
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+###############################################################################################
+
+Demo Analyzer
+
+Standalone tool which parses demos without the client, renderer, or sound, and writes the
+state of every snapshot to an output file for offline processing. Messages are decoded with
+the engine's msg.c and huffman.c, and snapshots are reconstructed with the same delta logic
+the client uses in cl_parse.c.
+
+Usage: demo_analyze [-j threads] [-f json|bin] [-o outdir] demo...
+
+Each demo produces one output file, written next to the demo or in outdir, named after the
+demo with ".jsonl" or ".dab" appended. Multiple demos are processed in parallel.
+
+JSON output has one object per line:
+  {"gamestate":{...}}     client number and configstrings
+  {"t":..,"cmd":".."}     server command, with the time of the preceding snapshot
+  {"t":..,"ps":{..},"ents":[..]}   snapshot
+
+Binary output starts with "DAB1" followed by records which start with a type byte. All
+values are little endian.
+  1 configstring: u16 index, u16 length, chars
+  2 server command: i32 server time, u16 length, chars
+  3 snapshot: i32 server time, u8 client, f32[3] origin, f32[3] velocity, f32[3] viewangles,
+    u8 weapon, i16 health, i16 score, u16 entity count, then for each entity: u16 number,
+    u8 eType, f32[3] origin, f32[3] angles, u8 weapon, u16 event
+
+###############################################################################################
+*/
+
+#define MAX_PARSE_ENTITIES ( PACKET_BACKUP * MAX_SNAPSHOT_ENTITIES )
+
+typedef enum {
+	FORMAT_JSON,
+	FORMAT_BINARY
+} outputFormat_t;
+
+typedef struct {
+	qboolean valid;
+	int messageNum;
+	int serverTime;
+	playerState_t ps;
+	int numEntities;
+	int parseEntitiesNum;
+} daSnapshot_t;
+
+typedef struct {
+	const char *path;
+	FILE *out;
+	outputFormat_t format;
+	qboolean compat;
+
+	int serverMessageSequence;
+	int serverCommandSequence;
+	int clientNum;
+	int lastServerTime;
+
+	entityState_t baselines[MAX_GENTITIES];
+	daSnapshot_t snapshots[PACKET_BACKUP];
+	entityState_t parseEntities[MAX_PARSE_ENTITIES];
+	int parseEntitiesNum;
+	int lastSnapshotNum;
+
+	int messageCount;
+	int snapshotCount;
+
+	char stringBuffer[BIG_INFO_STRING];
+} demoContext_t;
+
+typedef struct {
+	char **demos;
+	int numDemos;
+	int numThreads;
+	outputFormat_t format;
+	const char *outDir;
+	int failures;
+} analyzeJob_t;
+
+// referenced by msg.c
+cvar_t *cl_shownet;
+
+// not exported from msg.c
+void MSG_RoundBits( msg_t *msg );
+
+#ifdef _MSC_VER
+#define DA_THREADLOCAL __declspec( thread )
+#else
+#define DA_THREADLOCAL __thread
+#endif
+
+// each thread aborts its current demo through this on Com_Error
+static DA_THREADLOCAL jmp_buf *errorJump;
+
+/*
+###############################################################################################
+
+Engine Support Functions
+
+###############################################################################################
+*/
+
+void QDECL Com_Printf( const char *fmt, ... ) {
+	va_list argptr;
+	va_start( argptr, fmt );
+	vfprintf( stderr, fmt, argptr );
+	va_end( argptr );
+}
+
+void QDECL Com_DPrintf( const char *fmt, ... ) {
+}
+
+void QDECL Com_Error( int level, const char *error, ... ) {
+	char text[1024];
+	va_list argptr;
+
+	va_start( argptr, error );
+	Q_vsnprintf( text, sizeof( text ), error, argptr );
+	va_end( argptr );
+
+	fprintf( stderr, "error: %s\n", text );
+	if ( errorJump ) {
+		longjmp( *errorJump, 1 );
+	}
+	exit( 1 );
+}
+
+/*
+###############################################################################################
+
+Output
+
+###############################################################################################
+*/
+
+/*
+=================
+DA_WriteJSONString
+=================
+*/
+static void DA_WriteJSONString( FILE *out, const char *s ) {
+	fputc( '"', out );
+	for ( ; *s; ++s ) {
+		unsigned char c = (unsigned char)*s;
+		if ( c == '"' || c == '\\' ) {
+			fputc( '\\', out );
+			fputc( c, out );
+		} else if ( c < 0x20 ) {
+			fprintf( out, "\\u%04x", c );
+		} else {
+			fputc( c, out );
+		}
+	}
+	fputc( '"', out );
+}
+
+static void DA_WriteU8( FILE *out, int value ) {
+	fputc( value & 255, out );
+}
+
+static void DA_WriteU16( FILE *out, int value ) {
+	fputc( value & 255, out );
+	fputc( ( value >> 8 ) & 255, out );
+}
+
+static void DA_WriteI32( FILE *out, int value ) {
+	unsigned int v = (unsigned int)value;
+	fputc( v & 255, out );
+	fputc( ( v >> 8 ) & 255, out );
+	fputc( ( v >> 16 ) & 255, out );
+	fputc( ( v >> 24 ) & 255, out );
+}
+
+static void DA_WriteVec3( FILE *out, const vec3_t v ) {
+	int i;
+	for ( i = 0; i < 3; ++i ) {
+		floatint_t fi;
+		fi.f = v[i];
+		DA_WriteI32( out, fi.i );
+	}
+}
+
+static void DA_WriteString( FILE *out, const char *s ) {
+	int len = strlen( s );
+	if ( len > 65535 ) {
+		len = 65535;
+	}
+	DA_WriteU16( out, len );
+	fwrite( s, 1, len, out );
+}
+
+/*
+=================
+DA_OutputConfigstring
+=================
+*/
+static void DA_OutputConfigstring( demoContext_t *ctx, int index, const char *s, qboolean *first ) {
+	if ( ctx->format == FORMAT_BINARY ) {
+		DA_WriteU8( ctx->out, 1 );
+		DA_WriteU16( ctx->out, index );
+		DA_WriteString( ctx->out, s );
+	} else {
+		fprintf( ctx->out, "%s\"%i\":", *first ? "" : ",", index );
+		DA_WriteJSONString( ctx->out, s );
+	}
+	*first = qfalse;
+}
+
+/*
+=================
+DA_OutputCommand
+=================
+*/
+static void DA_OutputCommand( demoContext_t *ctx, const char *s ) {
+	if ( ctx->format == FORMAT_BINARY ) {
+		DA_WriteU8( ctx->out, 2 );
+		DA_WriteI32( ctx->out, ctx->lastServerTime );
+		DA_WriteString( ctx->out, s );
+	} else {
+		fprintf( ctx->out, "{\"t\":%i,\"cmd\":", ctx->lastServerTime );
+		DA_WriteJSONString( ctx->out, s );
+		fputs( "}\n", ctx->out );
+	}
+}
+
+/*
+=================
+DA_OutputSnapshot
+=================
+*/
+static void DA_OutputSnapshot( demoContext_t *ctx, const daSnapshot_t *snap ) {
+	const playerState_t *ps = &snap->ps;
+	int i;
+
+	// stats[0] and persistant[0] are health and score in the game modules
+	if ( ctx->format == FORMAT_BINARY ) {
+		DA_WriteU8( ctx->out, 3 );
+		DA_WriteI32( ctx->out, snap->serverTime );
+		DA_WriteU8( ctx->out, ps->clientNum );
+		DA_WriteVec3( ctx->out, ps->origin );
+		DA_WriteVec3( ctx->out, ps->velocity );
+		DA_WriteVec3( ctx->out, ps->viewangles );
+		DA_WriteU8( ctx->out, ps->weapon );
+		DA_WriteU16( ctx->out, ps->stats[0] );
+		DA_WriteU16( ctx->out, ps->persistant[0] );
+		DA_WriteU16( ctx->out, snap->numEntities );
+	} else {
+		fprintf( ctx->out, "{\"t\":%i,\"ps\":{\"client\":%i,\"pm_type\":%i,\"origin\":[%.1f,%.1f,%.1f],"
+				"\"vel\":[%.1f,%.1f,%.1f],\"view\":[%.1f,%.1f,%.1f],\"weapon\":%i,\"health\":%i,\"score\":%i},"
+				"\"ents\":[", snap->serverTime, ps->clientNum, ps->pm_type,
+				ps->origin[0], ps->origin[1], ps->origin[2], ps->velocity[0], ps->velocity[1], ps->velocity[2],
+				ps->viewangles[0], ps->viewangles[1], ps->viewangles[2], ps->weapon, ps->stats[0],
+				ps->persistant[0] );
+	}
+
+	for ( i = 0; i < snap->numEntities; ++i ) {
+		const entityState_t *es = &ctx->parseEntities[( snap->parseEntitiesNum + i ) & ( MAX_PARSE_ENTITIES - 1 )];
+		if ( ctx->format == FORMAT_BINARY ) {
+			DA_WriteU16( ctx->out, es->number );
+			DA_WriteU8( ctx->out, es->eType );
+			DA_WriteVec3( ctx->out, es->pos.trBase );
+			DA_WriteVec3( ctx->out, es->apos.trBase );
+			DA_WriteU8( ctx->out, es->weapon );
+			DA_WriteU16( ctx->out, es->event );
+		} else {
+			fprintf( ctx->out, "%s{\"n\":%i,\"type\":%i,\"origin\":[%.1f,%.1f,%.1f],\"angles\":[%.1f,%.1f,%.1f],"
+					"\"weapon\":%i,\"event\":%i}", i ? "," : "", es->number, es->eType,
+					es->pos.trBase[0], es->pos.trBase[1], es->pos.trBase[2],
+					es->apos.trBase[0], es->apos.trBase[1], es->apos.trBase[2], es->weapon, es->event );
+		}
+	}
+
+	if ( ctx->format == FORMAT_JSON ) {
+		fputs( "]}\n", ctx->out );
+	}
+}
+
+/*
+###############################################################################################
+
+Message Parsing
+
+###############################################################################################
+*/
+
+/*
+=================
+DA_ReadString
+
+Equivalent to MSG_ReadString and MSG_ReadBigString, but reads into the demo context instead
+of the static buffer in msg.c, which is not safe with demos parsed in parallel.
+=================
+*/
+static const char *DA_ReadString( demoContext_t *ctx, msg_t *msg, int maxLength ) {
+	int l = 0;
+	int c;
+
+	if ( maxLength > sizeof( ctx->stringBuffer ) ) {
+		maxLength = sizeof( ctx->stringBuffer );
+	}
+
+#ifdef ELITEFORCE
+	if ( msg->compat ) {
+		MSG_RoundBits( msg );
+	}
+#endif
+
+	while ( 1 ) {
+		c = MSG_ReadByte( msg );	// use ReadByte so -1 is out of bounds
+		if ( c == -1 || c == 0 ) {
+			break;
+		}
+		// translate all fmt spec to avoid crash bugs
+		if ( c == '%' ) {
+			c = '.';
+		}
+#ifndef ELITEFORCE
+		// don't allow higher ascii values
+		if ( c > 127 ) {
+			c = '.';
+		}
+#endif
+		// break only after reading all expected data from bitstream
+		if ( l >= maxLength - 1 ) {
+			break;
+		}
+		ctx->stringBuffer[l++] = c;
+	}
+
+	ctx->stringBuffer[l] = '\0';
+	return ctx->stringBuffer;
+}
+
+/*
+=================
+DA_DeltaEntity
+
+Based on CL_DeltaEntity.
+=================
+*/
+static void DA_DeltaEntity( demoContext_t *ctx, msg_t *msg, daSnapshot_t *frame, int newnum,
+		entityState_t *old, qboolean unchanged ) {
+	entityState_t *state = &ctx->parseEntities[ctx->parseEntitiesNum & ( MAX_PARSE_ENTITIES - 1 )];
+
+	if ( unchanged ) {
+		*state = *old;
+	} else {
+		MSG_ReadDeltaEntity( msg, old, state, newnum );
+	}
+
+	if ( state->number == ( MAX_GENTITIES - 1 ) ) {
+		return;		// entity was delta removed
+	}
+	ctx->parseEntitiesNum++;
+	frame->numEntities++;
+}
+
+/*
+=================
+DA_NextOldEntity
+=================
+*/
+static int DA_NextOldEntity( demoContext_t *ctx, daSnapshot_t *oldframe, int oldindex, entityState_t **oldstate ) {
+	if ( !oldframe || oldindex >= oldframe->numEntities ) {
+		return 99999;
+	}
+	*oldstate = &ctx->parseEntities[( oldframe->parseEntitiesNum + oldindex ) & ( MAX_PARSE_ENTITIES - 1 )];
+	return ( *oldstate )->number;
+}
+
+/*
+=================
+DA_ParsePacketEntities
+
+Based on CL_ParsePacketEntities.
+=================
+*/
+static void DA_ParsePacketEntities( demoContext_t *ctx, msg_t *msg, daSnapshot_t *oldframe, daSnapshot_t *newframe ) {
+	entityState_t *oldstate = NULL;
+	int oldindex = 0;
+	int oldnum = DA_NextOldEntity( ctx, oldframe, oldindex, &oldstate );
+	int newnum;
+
+	newframe->parseEntitiesNum = ctx->parseEntitiesNum;
+	newframe->numEntities = 0;
+
+	while ( 1 ) {
+		newnum = MSG_ReadBits( msg, GENTITYNUM_BITS );
+		if ( newnum == ( MAX_GENTITIES - 1 ) ) {
+			break;
+		}
+		if ( msg->readcount > msg->cursize ) {
+			Com_Error( ERR_DROP, "DA_ParsePacketEntities: end of message" );
+		}
+
+		while ( oldnum < newnum ) {
+			// one or more entities from the old packet are unchanged
+			DA_DeltaEntity( ctx, msg, newframe, oldnum, oldstate, qtrue );
+			oldnum = DA_NextOldEntity( ctx, oldframe, ++oldindex, &oldstate );
+		}
+
+		if ( oldnum == newnum ) {
+			// delta from previous state
+			DA_DeltaEntity( ctx, msg, newframe, newnum, oldstate, qfalse );
+			oldnum = DA_NextOldEntity( ctx, oldframe, ++oldindex, &oldstate );
+		} else {
+			// delta from baseline
+			DA_DeltaEntity( ctx, msg, newframe, newnum, &ctx->baselines[newnum], qfalse );
+		}
+	}
+
+	// any remaining entities in the old frame are copied over
+	while ( oldnum != 99999 ) {
+		DA_DeltaEntity( ctx, msg, newframe, oldnum, oldstate, qtrue );
+		oldnum = DA_NextOldEntity( ctx, oldframe, ++oldindex, &oldstate );
+	}
+}
+
+/*
+=================
+DA_ParseSnapshot
+
+Based on CL_ParseSnapshot.
+=================
+*/
+static void DA_ParseSnapshot( demoContext_t *ctx, msg_t *msg ) {
+	daSnapshot_t newSnap;
+	daSnapshot_t *old = NULL;
+	byte areamask[MAX_MAP_AREA_BYTES];
+	int deltaNum;
+	int len;
+	int i;
+
+#ifdef ELITEFORCE
+	if ( msg->compat ) {
+		MSG_ReadLong( msg );	// reliable acknowledge
+	}
+#endif
+
+	Com_Memset( &newSnap, 0, sizeof( newSnap ) );
+	newSnap.serverTime = MSG_ReadLong( msg );
+	newSnap.messageNum = ctx->serverMessageSequence;
+
+	deltaNum = MSG_ReadByte( msg );
+	deltaNum = deltaNum ? newSnap.messageNum - deltaNum : -1;
+	MSG_ReadByte( msg );	// snapFlags
+
+	if ( deltaNum <= 0 ) {
+		newSnap.valid = qtrue;
+	} else {
+		old = &ctx->snapshots[deltaNum & PACKET_MASK];
+		if ( old->valid && old->messageNum == deltaNum &&
+				ctx->parseEntitiesNum - old->parseEntitiesNum <= MAX_PARSE_ENTITIES - MAX_SNAPSHOT_ENTITIES ) {
+			newSnap.valid = qtrue;
+		}
+	}
+
+	len = MSG_ReadByte( msg );
+	if ( len > (int)sizeof( areamask ) ) {
+		Com_Error( ERR_DROP, "DA_ParseSnapshot: invalid size %d for areamask", len );
+	}
+	MSG_ReadData( msg, areamask, len );
+
+	MSG_ReadDeltaPlayerstate( msg, old ? &old->ps : NULL, &newSnap.ps );
+	DA_ParsePacketEntities( ctx, msg, old, &newSnap );
+
+	if ( !newSnap.valid ) {
+		return;
+	}
+
+	// invalidate skipped frames so they can't be used as delta sources
+	i = ctx->lastSnapshotNum + 1;
+	if ( newSnap.messageNum - i >= PACKET_BACKUP ) {
+		i = newSnap.messageNum - ( PACKET_BACKUP - 1 );
+	}
+	for ( ; i < newSnap.messageNum; ++i ) {
+		ctx->snapshots[i & PACKET_MASK].valid = qfalse;
+	}
+
+	ctx->snapshots[newSnap.messageNum & PACKET_MASK] = newSnap;
+	ctx->lastSnapshotNum = newSnap.messageNum;
+	ctx->lastServerTime = newSnap.serverTime;
+	++ctx->snapshotCount;
+
+	DA_OutputSnapshot( ctx, &newSnap );
+}
+
+/*
+=================
+DA_ParseGamestate
+
+Based on CL_ParseGamestate.
+=================
+*/
+static void DA_ParseGamestate( demoContext_t *ctx, msg_t *msg ) {
+	qboolean first = qtrue;
+	int cmd;
+
+	// a new gamestate resets all snapshot state
+	Com_Memset( ctx->snapshots, 0, sizeof( ctx->snapshots ) );
+	Com_Memset( ctx->baselines, 0, sizeof( ctx->baselines ) );
+	ctx->serverCommandSequence = MSG_ReadLong( msg );
+	ctx->lastSnapshotNum = 0;
+
+	if ( ctx->format == FORMAT_JSON ) {
+		fputs( "{\"gamestate\":{\"cs\":{", ctx->out );
+	}
+
+	while ( 1 ) {
+		cmd = MSG_ReadByte( msg );
+#ifdef ELITEFORCE
+		if ( ( msg->compat && cmd <= 0 ) || cmd == svc_EOF ) {
+#else
+		if ( cmd == svc_EOF ) {
+#endif
+			break;
+		}
+
+		if ( cmd == svc_configstring ) {
+			int index = MSG_ReadShort( msg );
+			if ( index < 0 || index >= MAX_CONFIGSTRINGS ) {
+				Com_Error( ERR_DROP, "configstring > MAX_CONFIGSTRINGS" );
+			}
+			DA_OutputConfigstring( ctx, index, DA_ReadString( ctx, msg, BIG_INFO_STRING ), &first );
+		} else if ( cmd == svc_baseline ) {
+			entityState_t nullstate;
+			int newnum = MSG_ReadBits( msg, GENTITYNUM_BITS );
+			if ( newnum < 0 || newnum >= MAX_GENTITIES ) {
+				Com_Error( ERR_DROP, "Baseline number out of range: %i", newnum );
+			}
+			Com_Memset( &nullstate, 0, sizeof( nullstate ) );
+			MSG_ReadDeltaEntity( msg, &nullstate, &ctx->baselines[newnum], newnum );
+		} else {
+			Com_Error( ERR_DROP, "DA_ParseGamestate: bad command byte" );
+		}
+	}
+
+	ctx->clientNum = -1;
+#ifdef ELITEFORCE
+	if ( !msg->compat )
+#endif
+	{
+		ctx->clientNum = MSG_ReadLong( msg );
+		MSG_ReadLong( msg );	// checksum feed
+	}
+
+	if ( ctx->format == FORMAT_JSON ) {
+		fprintf( ctx->out, "},\"client\":%i}}\n", ctx->clientNum );
+	}
+}
+
+/*
+=================
+DA_ParseCommandString
+=================
+*/
+static void DA_ParseCommandString( demoContext_t *ctx, msg_t *msg ) {
+	int seq = MSG_ReadLong( msg );
+	const char *s = DA_ReadString( ctx, msg, MAX_STRING_CHARS );
+
+	// commands are repeated until acknowledged, so skip ones already seen
+	if ( ctx->serverCommandSequence >= seq ) {
+		return;
+	}
+	ctx->serverCommandSequence = seq;
+	DA_OutputCommand( ctx, s );
+}
+
+/*
+=================
+DA_ParseServerMessage
+
+Based on CL_ParseServerMessage.
+=================
+*/
+static void DA_ParseServerMessage( demoContext_t *ctx, msg_t *msg ) {
+	int cmd;
+
+#ifdef ELITEFORCE
+	if ( !msg->compat )
+#endif
+	{
+		MSG_Bitstream( msg );
+		MSG_ReadLong( msg );	// reliable acknowledge
+	}
+
+	while ( 1 ) {
+		if ( msg->readcount > msg->cursize ) {
+			Com_Error( ERR_DROP, "DA_ParseServerMessage: read past end of server message" );
+		}
+
+		cmd = MSG_ReadByte( msg );
+#ifdef ELITEFORCE
+		if ( cmd == svc_EOF || ( msg->compat && cmd == -1 ) ) {
+#else
+		if ( cmd == svc_EOF ) {
+#endif
+			return;
+		}
+
+		switch ( cmd ) {
+			case svc_nop:
+				break;
+			case svc_serverCommand:
+				DA_ParseCommandString( ctx, msg );
+				break;
+			case svc_gamestate:
+				DA_ParseGamestate( ctx, msg );
+				break;
+			case svc_snapshot:
+				DA_ParseSnapshot( ctx, msg );
+				break;
+			case svc_download:
+			case svc_voipSpeex:
+			case svc_voipOpus:
+				// nothing of interest follows
+				return;
+			default:
+				Com_Error( ERR_DROP, "DA_ParseServerMessage: illegible server message" );
+		}
+	}
+}
+
+/*
+=================
+DA_ParseDemo
+
+Returns qtrue on success.
+=================
+*/
+static qboolean DA_ParseDemo( demoContext_t *ctx, FILE *in ) {
+	byte data[MAX_MSGLEN];
+	jmp_buf jump;
+	msg_t msg;
+
+	if ( setjmp( jump ) ) {
+		errorJump = NULL;
+		return qfalse;
+	}
+	errorJump = &jump;
+
+	while ( 1 ) {
+		int header[2];
+		int length;
+
+		if ( fread( header, 4, 2, in ) != 2 ) {
+			break;
+		}
+		length = LittleLong( header[1] );
+		if ( length == -1 ) {
+			break;
+		}
+		if ( length < 0 || length > (int)sizeof( data ) ) {
+			Com_Error( ERR_DROP, "invalid message length %i", length );
+		}
+
+#ifdef ELITEFORCE
+		if ( ctx->compat ) {
+			MSG_InitOOB( &msg, data, sizeof( data ) );
+			msg.compat = qtrue;
+		} else
+#endif
+		MSG_Init( &msg, data, sizeof( data ) );
+
+		if ( fread( data, 1, length, in ) != (size_t)length ) {
+			Com_Printf( "%s: demo file was truncated\n", ctx->path );
+			break;
+		}
+		msg.cursize = length;
+		ctx->serverMessageSequence = LittleLong( header[0] );
+		++ctx->messageCount;
+
+		DA_ParseServerMessage( ctx, &msg );
+	}
+
+	errorJump = NULL;
+	return qtrue;
+}
+
+/*
+###############################################################################################
+
+Main
+
+###############################################################################################
+*/
+
+/*
+=================
+DA_IsCompatProtocol
+
+Determines whether a demo uses the legacy protocol from its file extension.
+=================
+*/
+static qboolean DA_IsCompatProtocol( const char *path ) {
+	const char *ext = strrchr( path, '.' );
+	if ( !ext ) {
+		return qfalse;
+	}
+#ifdef ELITEFORCE
+	if ( !Q_stricmp( ext, ".efdemo" ) ) {
+		return qtrue;
+	}
+#endif
+	if ( !Q_stricmpn( ext + 1, DEMOEXT, strlen( DEMOEXT ) ) ) {
+		return atoi( ext + 1 + strlen( DEMOEXT ) ) <= PROTOCOL_LEGACY_VERSION;
+	}
+	return qfalse;
+}
+
+/*
+=================
+DA_AnalyzeDemo
+=================
+*/
+static qboolean DA_AnalyzeDemo( const analyzeJob_t *job, const char *path ) {
+	char outPath[MAX_OSPATH];
+	demoContext_t *ctx;
+	FILE *in;
+	qboolean result;
+
+	if ( job->outDir ) {
+		const char *base = strrchr( path, '/' );
+#ifdef _WIN32
+		const char *base2 = strrchr( path, '\\' );
+		if ( base2 > base ) {
+			base = base2;
+		}
+#endif
+		Com_sprintf( outPath, sizeof( outPath ), "%s/%s", job->outDir, base ? base + 1 : path );
+	} else {
+		Q_strncpyz( outPath, path, sizeof( outPath ) );
+	}
+	Q_strcat( outPath, sizeof( outPath ), job->format == FORMAT_BINARY ? ".dab" : ".jsonl" );
+
+	in = fopen( path, "rb" );
+	if ( !in ) {
+		Com_Printf( "%s: failed to open demo\n", path );
+		return qfalse;
+	}
+
+	ctx = (demoContext_t *)calloc( 1, sizeof( *ctx ) );
+	if ( !ctx ) {
+		fclose( in );
+		return qfalse;
+	}
+	ctx->path = path;
+	ctx->format = job->format;
+	ctx->compat = DA_IsCompatProtocol( path );
+
+	ctx->out = fopen( outPath, job->format == FORMAT_BINARY ? "wb" : "w" );
+	if ( !ctx->out ) {
+		Com_Printf( "%s: failed to open output file %s\n", path, outPath );
+		fclose( in );
+		free( ctx );
+		return qfalse;
+	}
+	if ( job->format == FORMAT_BINARY ) {
+		fwrite( "DAB1", 1, 4, ctx->out );
+	}
+
+	result = DA_ParseDemo( ctx, in );
+	Com_Printf( "%s: %i messages, %i snapshots%s\n", path, ctx->messageCount, ctx->snapshotCount,
+			result ? "" : " (parse error)" );
+
+	fclose( ctx->out );
+	fclose( in );
+	free( ctx );
+	return result;
+}
+
+/*
+=================
+DA_ThreadMain
+
+Each thread handles every numThreads'th demo.
+=================
+*/
+static void DA_ThreadMain( int threadNum, void *context ) {
+	analyzeJob_t *job = (analyzeJob_t *)context;
+	int i;
+
+	for ( i = threadNum; i < job->numDemos; i += job->numThreads ) {
+		if ( !DA_AnalyzeDemo( job, job->demos[i] ) ) {
+			// not synchronized, but only used to select the exit code
+			job->failures = 1;
+		}
+	}
+}
+
+/*
+=================
+DA_Usage
+=================
+*/
+static void DA_Usage( void ) {
+	fprintf( stderr, "usage: demo_analyze [-j threads] [-f json|bin] [-o outdir] demo...\n" );
+	exit( 1 );
+}
+
+int main( int argc, char **argv ) {
+	analyzeJob_t job;
+	int i;
+
+	Com_Memset( &job, 0, sizeof( job ) );
+	job.format = FORMAT_JSON;
+#ifdef CMOD_COMMON_THREADS
+	job.numThreads = CMThread_ProcessorCount();
+#else
+	job.numThreads = 1;
+#endif
+
+	for ( i = 1; i < argc && argv[i][0] == '-'; ++i ) {
+		if ( !strcmp( argv[i], "-j" ) && i + 1 < argc ) {
+			job.numThreads = atoi( argv[++i] );
+		} else if ( !strcmp( argv[i], "-f" ) && i + 1 < argc ) {
+			++i;
+			if ( !strcmp( argv[i], "json" ) ) {
+				job.format = FORMAT_JSON;
+			} else if ( !strcmp( argv[i], "bin" ) ) {
+				job.format = FORMAT_BINARY;
+			} else {
+				DA_Usage();
+			}
+		} else if ( !strcmp( argv[i], "-o" ) && i + 1 < argc ) {
+			job.outDir = argv[++i];
+		} else {
+			DA_Usage();
+		}
+	}
+
+	if ( i >= argc ) {
+		DA_Usage();
+	}
+	job.demos = argv + i;
+	job.numDemos = argc - i;
+
+	if ( job.numThreads > job.numDemos ) {
+		job.numThreads = job.numDemos;
+	}
+	if ( job.numThreads < 1 ) {
+		job.numThreads = 1;
+	}
+
+	// initialize the huffman tables before starting any threads
+	{
+		byte dummy[1];
+		msg_t msg;
+		MSG_Init( &msg, dummy, sizeof( dummy ) );
+	}
+
+#ifdef CMOD_COMMON_THREADS
+	CMThread_RunParallel( job.numThreads, DA_ThreadMain, &job );
+#else
+	job.numThreads = 1;
+	DA_ThreadMain( 0, &job );
+#endif
+
+	return job.failures ? 1 : 0;
+}
@@ -0,0 +1,221 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+Copyright (C) 2017 Noah Metzger (chomenor@gmail.com)
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+
+
+#include "../../qcommon/q_shared.h"
+#include "../../cmod/cmod_image_simd.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+/*
+###############################################################################################
+
+Image SIMD Benchmark
+
+Standalone version of the "r_imageBenchmark" command, which runs the texture kernels from
+cmod_image_simd_kernels.c on synthetic noise images without starting the game. Each kernel
+set is timed against the scalar kernels and its output is compared with the scalar output.
+
+Usage: image_simd_bench [size...]
+
+Each size is either N for an NxN image or WxH. The default is 256, 512, 1024 and 2048.
+Exits with status 1 if any kernel output differs from the scalar output.
+
+###############################################################################################
+*/
+
+#define MAX_SIZES 32
+
+/*
+###############################################################################################
+
+Engine Support Functions
+
+###############################################################################################
+*/
+
+void QDECL Com_Printf( const char *fmt, ... ) {
+	va_list argptr;
+	va_start( argptr, fmt );
+	vfprintf( stderr, fmt, argptr );
+	va_end( argptr );
+}
+
+void QDECL Com_Error( int level, const char *error, ... ) {
+	char text[1024];
+	va_list argptr;
+
+	va_start( argptr, error );
+	Q_vsnprintf( text, sizeof( text ), error, argptr );
+	va_end( argptr );
+
+	fprintf( stderr, "error: %s\n", text );
+	exit( 1 );
+}
+
+/*
+###############################################################################################
+
+Benchmark
+
+###############################################################################################
+*/
+
+/*
+=================
+ISB_Clock
+
+Returns time in ISB_ClockFrequency units per second.
+=================
+*/
+static uint64_t ISB_Clock( void ) {
+#ifdef _WIN32
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter( &counter );
+	return (uint64_t)counter.QuadPart;
+#else
+	struct timespec now;
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+#endif
+}
+
+static double ISB_ClockFrequency( void ) {
+#ifdef _WIN32
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency( &frequency );
+	return (double)frequency.QuadPart;
+#else
+	return 1000000000.0;
+#endif
+}
+
+/*
+=================
+ISB_ParseSize
+=================
+*/
+static qboolean ISB_ParseSize( const char *arg, int *width, int *height ) {
+	if ( sscanf( arg, "%ix%i", width, height ) != 2 ) {
+		*width = *height = atoi( arg );
+	}
+	return *width >= 2 && *height >= 2 && *width <= 8192 && *height <= 8192 ? qtrue : qfalse;
+}
+
+/*
+=================
+ISB_Usage
+=================
+*/
+static void ISB_Usage( void ) {
+	fprintf( stderr, "usage: image_simd_bench [size...]\n" );
+	exit( 1 );
+}
+
+int main( int argc, char **argv ) {
+	static const int defaultSizes[] = { 256, 512, 1024, 2048 };
+	const imageSimdKernels_t *available[IMAGE_SIMD_MAX_SETS];
+	int count = R_ImageSimd_Available( available );
+	imageBenchResult_t results[IMAGE_SIMD_MAX_SETS];
+	int widths[MAX_SIZES], heights[MAX_SIZES];
+	int numSizes = 0;
+	int64_t totalPixels = 0;
+	double tickMsec = 1000.0 / ISB_ClockFrequency();
+	qboolean mismatch = qfalse;
+	byte table[256];
+	int i, j, k;
+
+	for ( i = 1; i < argc; ++i ) {
+		if ( numSizes >= MAX_SIZES || !ISB_ParseSize( argv[i], &widths[numSizes], &heights[numSizes] ) ) {
+			ISB_Usage();
+		}
+		++numSizes;
+	}
+	if ( !numSizes ) {
+		for ( ; numSizes < ARRAY_LEN( defaultSizes ); ++numSizes ) {
+			widths[numSizes] = heights[numSizes] = defaultSizes[numSizes];
+		}
+	}
+
+	Com_Memset( results, 0, sizeof( results ) );
+
+	// same lookup table as r_imageBenchmark
+	for ( i = 0; i < 256; ++i ) {
+		table[i] = (byte)( ( i * 167 + 13 ) ^ ( i >> 3 ) );
+	}
+
+	for ( i = 0; i < numSizes; ++i ) {
+		int size = widths[i] * heights[i] * 4;
+		byte *pic = (byte *)malloc( size );
+		unsigned int seed = 1;
+
+		if ( !pic ) {
+			Com_Error( ERR_FATAL, "failed to allocate %ix%i image", widths[i], heights[i] );
+		}
+
+		// synthetic noise image
+		for ( j = 0; j < size; ++j ) {
+			seed = seed * 1103515245 + 12345;
+			pic[j] = (byte)( seed >> 16 );
+		}
+
+		if ( !R_ImageSimd_BenchImage( available, count, ISB_Clock, pic, widths[i], heights[i],
+				table, results ) ) {
+			Com_Error( ERR_FATAL, "failed to allocate buffers for %ix%i image", widths[i], heights[i] );
+		}
+		totalPixels += widths[i] * heights[i];
+		free( pic );
+	}
+
+	printf( "%i images, %.1f megapixels, %i iterations\n", numSizes, totalPixels / 1000000.0,
+			IMAGE_BENCHMARK_ITERATIONS );
+	for ( j = 0; j < count; ++j ) {
+		printf( "%s:\n", available[j]->name );
+		for ( k = 0; k < IMAGE_BENCH_COUNT; ++k ) {
+			double msec = results[j].ticks[k] * tickMsec;
+			double scalarMsec = results[count - 1].ticks[k] * tickMsec;
+			if ( !R_ImageSimd_HasStage( available[j], (imageBenchStage_t)k ) ) {
+				continue;
+			}
+			if ( j == count - 1 ) {
+				printf( "  %-12s %9.3f ms\n", imageBenchStageNames[k], msec );
+			} else {
+				printf( "  %-12s %9.3f ms  speedup %.2fx  %s\n", imageBenchStageNames[k], msec,
+						msec > 0.0 ? scalarMsec / msec : 0.0,
+						results[j].mismatch[k] ? "MISMATCH" : "matches scalar" );
+				if ( results[j].mismatch[k] ) {
+					mismatch = qtrue;
+				}
+			}
+		}
+	}
+
+	return mismatch ? 1 : 0;
+}